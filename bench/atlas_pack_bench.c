@@ -0,0 +1,62 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "atlas_utility.h"
+#include "bench_common.h"
+
+// Packs a few thousand random sprite sized rects and reports time and page occupancy.
+// Headless: only the AtlasPacker is used.
+//
+// usage: atlas_pack_bench [rect_count] [page_size] [padding]
+
+int main(int argc, char** argv)
+{
+    int count = (argc > 1) ? atoi(argv[1]) : 5000;
+    int page_size = (argc > 2) ? atoi(argv[2]) : 2048;
+    int padding = (argc > 3) ? atoi(argv[3]) : 2;
+
+    AtlasRect* rects = (AtlasRect*)malloc(sizeof(AtlasRect) * count);
+    if (!rects)
+        return -1;
+
+    srand(1234);
+    size_t area = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        rects[i].width = 8 + rand() % 57;
+        rects[i].height = 8 + rand() % 57;
+        area += (size_t)(rects[i].width + 2 * padding) * (size_t)(rects[i].height + 2 * padding);
+    }
+
+    AtlasPacker packer;
+    AtlasPacker_Create(&packer, page_size, page_size, padding, 64);
+
+    double start = Bench_Now();
+    int placed = AtlasPacker_PackAll(&packer, rects, count);
+    double elapsed = Bench_Now() - start;
+
+    // sanity check: no two rects on the same page may overlap
+    int overlaps = 0;
+    for (int i = 0; i < count && count <= 20000; ++i)
+    {
+        for (int j = i + 1; j < count; ++j)
+        {
+            const AtlasRect* a = &rects[i];
+            const AtlasRect* b = &rects[j];
+            if (a->page != b->page || a->page < 0)
+                continue;
+            if (a->x - padding < b->x + b->width + padding && b->x - padding < a->x + a->width + padding &&
+                a->y - padding < b->y + b->height + padding && b->y - padding < a->y + a->height + padding)
+                overlaps += 1;
+        }
+    }
+
+    double occupancy = (double)area / ((double)packer.page_count * page_size * page_size);
+
+    printf("rects: %d placed: %d pages: %d (%dx%d, padding %d)\n", count, placed, packer.page_count, page_size, page_size, padding);
+    printf("pack time: %.3f ms | occupancy: %.1f%% | overlaps: %d\n", elapsed * 1000.0, occupancy * 100.0, overlaps);
+
+    AtlasPacker_Delete(&packer);
+    free(rects);
+
+    return (overlaps == 0 && placed == count) ? 0 : -1;
+}
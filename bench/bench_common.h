@@ -0,0 +1,175 @@
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Shared helpers for the headless benchmarks in bench/
+
+// monotonic wall clock in seconds
+static inline double Bench_Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// time stamp counter on x86 (reference cycles, not core clock under frequency scaling), 0 elsewhere
+static inline uint64_t Bench_Cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// keeps the compiler from deleting work whose result is otherwise unused
+static inline void Bench_Use(const void* p)
+{
+    __asm__ __volatile__("" : : "g"(p) : "memory");
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  HARNESS                                   */
+/* -------------------------------------------------------------------------- */
+
+// A benchmark body runs its operation `iterations` times per call. Bench_Measure grows the
+// iteration count until one call takes at least min_sample_ms (this also warms caches and
+// branch predictors), runs `warmup` more calls, then times `samples` calls. Results are per
+// operation.
+
+typedef void (*BenchFunc)(void* data, int iterations);
+
+#define BENCH_MAX_SAMPLES 1024
+
+typedef struct
+{
+    int warmup;
+    int samples;
+    double min_sample_ms;
+
+} BenchConfig;
+
+typedef struct
+{
+    char name[64];
+    int iterations;         // operations per sample
+    int samples;
+
+    double min_ns;
+    double median_ns;
+    double p99_ns;
+    double mean_ns;
+    double median_cycles;   // 0 without a cycle counter
+
+} BenchResult;
+
+static inline BenchConfig Bench_DefaultConfig(void)
+{
+    BenchConfig config = { 3, 31, 1.0 };
+    return config;
+}
+
+static inline int Bench_CompareDouble(const void* a, const void* b)
+{
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static inline BenchResult Bench_Measure(const char* name, BenchFunc func, void* data, const BenchConfig* config)
+{
+    BenchResult result;
+    memset(&result, 0, sizeof(BenchResult));
+    snprintf(result.name, sizeof(result.name), "%s", name);
+
+    int iterations = 1;
+    for (;;)
+    {
+        double start = Bench_Now();
+        func(data, iterations);
+        double ms = (Bench_Now() - start) * 1000.0;
+        if (ms >= config->min_sample_ms || iterations >= (1 << 28))
+            break;
+        iterations *= 2;
+    }
+
+    for (int i = 0; i < config->warmup; ++i)
+        func(data, iterations);
+
+    int samples = config->samples < BENCH_MAX_SAMPLES ? config->samples : BENCH_MAX_SAMPLES;
+    double times[BENCH_MAX_SAMPLES];
+    double cycles[BENCH_MAX_SAMPLES];
+    double sum = 0.0;
+
+    for (int i = 0; i < samples; ++i)
+    {
+        uint64_t c0 = Bench_Cycles();
+        double t0 = Bench_Now();
+        func(data, iterations);
+        double t1 = Bench_Now();
+        uint64_t c1 = Bench_Cycles();
+
+        times[i] = (t1 - t0) * 1e9 / iterations;
+        cycles[i] = (double)(c1 - c0) / iterations;
+        sum += times[i];
+    }
+
+    qsort(times, (size_t)samples, sizeof(double), Bench_CompareDouble);
+    qsort(cycles, (size_t)samples, sizeof(double), Bench_CompareDouble);
+
+    // nearest rank; with few samples p99 is simply the slowest
+    int p99 = (int)((samples * 99 + 99) / 100) - 1;
+
+    result.iterations = iterations;
+    result.samples = samples;
+    result.min_ns = times[0];
+    result.median_ns = times[samples / 2];
+    result.p99_ns = times[p99 < samples ? p99 : samples - 1];
+    result.mean_ns = sum / samples;
+    result.median_cycles = cycles[samples / 2];
+    return result;
+}
+
+static inline void Bench_PrintHeader(void)
+{
+    printf("%-32s %12s %12s %12s %10s %10s\n", "benchmark", "median ns", "p99 ns", "min ns", "cycles", "iters");
+}
+
+static inline void Bench_Print(const BenchResult* r)
+{
+    printf("%-32s %12.2f %12.2f %12.2f %10.1f %10d\n", r->name, r->median_ns, r->p99_ns, r->min_ns, r->median_cycles, r->iterations);
+}
+
+// One benchmark per line so two runs diff cleanly
+static inline void Bench_WriteJSON(FILE* file, const BenchResult* results, int count)
+{
+    fprintf(file, "{\"benchmarks\": [\n");
+    for (int i = 0; i < count; ++i)
+    {
+        const BenchResult* r = &results[i];
+        fprintf(file, "  {\"name\": \"%s\", \"median_ns\": %.3f, \"p99_ns\": %.3f, \"min_ns\": %.3f, \"mean_ns\": %.3f, \"cycles\": %.1f, \"iterations\": %d, \"samples\": %d}%s\n",
+                r->name, r->median_ns, r->p99_ns, r->min_ns, r->mean_ns, r->median_cycles, r->iterations, r->samples, i + 1 < count ? "," : "");
+    }
+    fprintf(file, "]}\n");
+}
+
+// Reads the median of `name` back from a file written by Bench_WriteJSON, -1 when absent
+static inline double Bench_FindMedian(const char* json, const char* name)
+{
+    char key[96];
+    snprintf(key, sizeof(key), "\"name\": \"%s\",", name);
+
+    const char* at = json ? strstr(json, key) : NULL;
+    const char* median = at ? strstr(at, "\"median_ns\": ") : NULL;
+    return median ? atof(median + 13) : -1.0;
+}
+
+#endif
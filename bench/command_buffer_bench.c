@@ -0,0 +1,159 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "command_buffer_utility.h"
+#include "job_utility.h"
+#include "bench_common.h"
+
+// Records N draws (program, texture, vertex array, model matrix, uniform block, draw) into one
+// command list per worker with Job_ParallelFor, then times the GL thread side: merge + sort, and a
+// replay walk over the sorted commands that filters redundant state like the GL replay does.
+// Headless: no GL calls are made.
+//
+// usage: command_buffer_bench [draw_count] [max_threads]
+
+typedef struct
+{
+    CommandQueue* queue;
+    JobSystem* jobs;
+
+} RecordData;
+
+typedef struct
+{
+    Vector4 colour;
+    Vector4 params;
+
+} DrawUniforms;
+
+static void RecordRange(void* data, int begin, int end)
+{
+    RecordData* r = (RecordData*)data;
+    CommandList* list = CommandQueue_List(r->queue, Job_WorkerIndex(r->jobs));
+
+    for (int i = begin; i < end; ++i)
+    {
+        uint32_t program = 1 + (uint32_t)(i * 7 % 8);
+        uint32_t texture = 1 + (uint32_t)(i * 13 % 64);
+        uint32_t mesh = 1 + (uint32_t)(i * 31 % 32);
+
+        Matrix4 model = Math_Mat4Translate((Vector3){ (float)(i % 100), (float)(i / 100 % 100), (float)(i / 10000) });
+        DrawUniforms uniforms = { { 1.0f, 0.5f, 0.25f, 1.0f }, { (float)i, 0.0f, 0.0f, 0.0f } };
+
+        CommandList_Begin(list, CommandKey_Make(0, program, texture, (uint32_t)i));
+        CommandList_BindProgram(list, program);
+        CommandList_BindTexture(list, 0, GL_TEXTURE_2D, texture);
+        CommandList_BindVertexArray(list, mesh);
+        CommandList_UniformMat4(list, 0, &model);
+        CommandList_UniformBlock(list, 0, &uniforms, sizeof(uniforms));
+        CommandList_DrawElements(list, GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0, 1, 0);
+        CommandList_End(list);
+    }
+}
+
+typedef struct
+{
+    uint32_t program, texture, vao;
+    uint32_t draws, changes, skipped;
+    double checksum;
+
+} NullReplay;
+
+static void NullVisit(const CommandHeader* cmd, void* user)
+{
+    NullReplay* r = (NullReplay*)user;
+    switch (cmd->type)
+    {
+        case CMD_BIND_PROGRAM:
+        {
+            uint32_t p = ((const CmdBindProgram*)cmd)->program;
+            if (p == r->program) r->skipped++; else { r->program = p; r->changes++; }
+            break;
+        }
+        case CMD_BIND_TEXTURE:
+        {
+            uint32_t t = ((const CmdBindTexture*)cmd)->texture;
+            if (t == r->texture) r->skipped++; else { r->texture = t; r->changes++; }
+            break;
+        }
+        case CMD_BIND_VERTEX_ARRAY:
+        {
+            uint32_t v = ((const CmdBindVertexArray*)cmd)->vao;
+            if (v == r->vao) r->skipped++; else { r->vao = v; r->changes++; }
+            break;
+        }
+        case CMD_UNIFORM_MAT4:
+            r->checksum += ((const CmdUniformMat4*)cmd)->m[12];
+            break;
+        case CMD_DRAW_ELEMENTS:
+            r->draws++;
+            break;
+        default:
+            break;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int count = (argc > 1) ? atoi(argv[1]) : 100000;
+    int max_threads = (argc > 2) ? atoi(argv[2]) : Thread_HardwareConcurrency();
+
+    if (count < 1 || max_threads < 1)
+        return -1;
+
+    printf("draws: %d | cores: %d | bytes per draw: %zu\n", count, Thread_HardwareConcurrency(),
+           ALIGN_UP(sizeof(CmdBindProgram), alignment) + ALIGN_UP(sizeof(CmdBindTexture), alignment) +
+           ALIGN_UP(sizeof(CmdBindVertexArray), alignment) + ALIGN_UP(sizeof(CmdUniformMat4), alignment) +
+           ALIGN_UP(sizeof(CmdUniformBlock), alignment) + ALIGN_UP(sizeof(CmdDrawElements), alignment));
+
+    int failures = 0;
+    for (int threads = 1; threads <= max_threads; )
+    {
+        JobSystem jobs;
+        Job_Create(&jobs, threads);
+
+        // every list must be able to hold the whole frame, a single worker may end up recording it all
+        CommandQueue queue;
+        if (!CommandQueue_Create(&queue, Job_WorkerCount(&jobs), (size_t)count * 256, (uint32_t)count, (uint32_t)count * COMMAND_UNIFORM_ALIGN))
+            return -1;
+
+        RecordData record = { &queue, &jobs };
+        double best_record = 1e30, best_merge = 1e30, best_replay = 1e30;
+        NullReplay replay;
+
+        for (int rep = 0; rep < 5; ++rep)
+        {
+            CommandQueue_Reset(&queue);
+
+            double start = Bench_Now();
+            Job_ParallelFor(&jobs, count, 256, RecordRange, &record);
+            double recorded = Bench_Now();
+            CommandQueue_Merge(&queue);
+            double merged = Bench_Now();
+            memset(&replay, 0, sizeof(replay));
+            CommandQueue_ForEach(&queue, NullVisit, &replay);
+            double replayed = Bench_Now();
+
+            best_record = (recorded - start < best_record) ? recorded - start : best_record;
+            best_merge = (merged - recorded < best_merge) ? merged - recorded : best_merge;
+            best_replay = (replayed - merged < best_replay) ? replayed - merged : best_replay;
+        }
+
+        // sorted by key: the program never goes back to an earlier value
+        bool sorted = true;
+        for (uint32_t i = 1; i < queue.merged_count; ++i)
+            sorted = sorted && queue.merged[i - 1].key <= queue.merged[i].key;
+
+        bool ok = sorted && replay.draws == (uint32_t)count;
+        failures += !ok;
+
+        printf("threads %2d: record %7.3f ms | merge+sort %7.3f ms | replay walk %7.3f ms | state changes %u, skipped %u | %s\n",
+               threads, best_record * 1000.0, best_merge * 1000.0, best_replay * 1000.0, replay.changes, replay.skipped, ok ? "ok" : "FAILED");
+
+        CommandQueue_Delete(&queue);
+        Job_Delete(&jobs);
+
+        threads = (threads < max_threads && threads * 2 > max_threads) ? max_threads : threads * 2;
+    }
+
+    return failures == 0 ? 0 : -1;
+}
@@ -0,0 +1,393 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "math_utility.h"
+#include "darray_utility.h"
+#include "arena_utility.h"
+#include "string_utility.h"
+#include "file_utility.h"
+#include "mesh_utility.h"
+#include "model_utility.h"
+#include "bench_common.h"
+
+// Microbenchmarks of the core utilities: Math_*, DArray_Push, Arena_Alloc, String_Append,
+// File_Load, the mesh generators and the C OBJ loader. Every benchmark reports median / p99 / min
+// nanoseconds and cycles per operation; --json writes the same as one JSON line per benchmark so
+// results diff between commits, and --compare prints the change against such a file.
+// The input files (1 MB blob, sphere OBJ) are generated into /tmp first. Headless: no GL calls.
+//
+// usage: core_bench [--json out.json] [--compare baseline.json] [--filter substring]
+
+#define INPUT_COUNT 1024    // inputs cycled through so nothing folds into a constant
+
+typedef struct
+{
+    Vector3 vec3[INPUT_COUNT];
+    Matrix4 mat4[INPUT_COUNT];
+    Quaternion quat[INPUT_COUNT];
+    float angle[INPUT_COUNT];
+
+    Arena arena;
+    const char* blob_path;
+    const char* obj_path;
+    double sink;
+
+} BenchData;
+
+/* ----- math ----- */
+
+static void BenchVec3Normalize(void* data, int iterations)
+{
+    BenchData* d = (BenchData*)data;
+    float sum = 0.0f;
+    for (int i = 0; i < iterations; ++i)
+        sum += Math_Vec3Normalize(d->vec3[i & (INPUT_COUNT - 1)]).x;
+    d->sink += sum;
+}
+
+static void BenchVec3Cross(void* data, int iterations)
+{
+    BenchData* d = (BenchData*)data;
+    float sum = 0.0f;
+    for (int i = 0; i < iterations; ++i)
+        sum += Math_Vec3Cross(d->vec3[i & (INPUT_COUNT - 1)], d->vec3[(i + 1) & (INPUT_COUNT - 1)]).y;
+    d->sink += sum;
+}
+
+static void BenchMat4Multiply(void* data, int iterations)
+{
+    BenchData* d = (BenchData*)data;
+    float sum = 0.0f;
+    for (int i = 0; i < iterations; ++i)
+        sum += Math_Mat4Multiply(d->mat4[i & (INPUT_COUNT - 1)], d->mat4[(i + 7) & (INPUT_COUNT - 1)]).m[5];
+    d->sink += sum;
+}
+
+static void BenchMat4Rotate(void* data, int iterations)
+{
+    BenchData* d = (BenchData*)data;
+    float sum = 0.0f;
+    for (int i = 0; i < iterations; ++i)
+        sum += Math_Mat4Rotate(d->angle[i & (INPUT_COUNT - 1)], d->vec3[i & (INPUT_COUNT - 1)]).m[0];
+    d->sink += sum;
+}
+
+static void BenchProjMatrix(void* data, int iterations)
+{
+    BenchData* d = (BenchData*)data;
+    float sum = 0.0f;
+    for (int i = 0; i < iterations; ++i)
+        sum += Math_GetProjMatrix(0.5f + d->angle[i & (INPUT_COUNT - 1)], 16.0f / 9.0f, 0.1f, 100.0f).m[0];
+    d->sink += sum;
+}
+
+static void BenchQuatMultiply(void* data, int iterations)
+{
+    BenchData* d = (BenchData*)data;
+    float sum = 0.0f;
+    for (int i = 0; i < iterations; ++i)
+        sum += Math_QuatMultiply(d->quat[i & (INPUT_COUNT - 1)], d->quat[(i + 3) & (INPUT_COUNT - 1)]).w;
+    d->sink += sum;
+}
+
+static void BenchQuatToMat4(void* data, int iterations)
+{
+    BenchData* d = (BenchData*)data;
+    float sum = 0.0f;
+    for (int i = 0; i < iterations; ++i)
+        sum += Math_QuatConvertToMat4(d->quat[i & (INPUT_COUNT - 1)]).m[10];
+    d->sink += sum;
+}
+
+/* ----- containers and allocators ----- */
+
+// growth from capacity 1 included, the way the loaders use it
+static void BenchDArrayPushInt(void* data, int iterations)
+{
+    (void)data;
+    DArray a = DArray_Create_T(int, 1, NULL);
+    for (int i = 0; i < iterations; ++i)
+        DArray_Push_T(int, &a, i);
+    Bench_Use(a.data);
+    DArray_Free(&a);
+}
+
+static void BenchDArrayPushVertex(void* data, int iterations)
+{
+    (void)data;
+    DArray a = DArray_Create_T(Vertex, 1, NULL);
+    for (int i = 0; i < iterations; ++i)
+    {
+        Vertex v = { { (float)i, 0.0f, 0.0f }, { 0.0f, 1.0f }, { 0.0f, 0.0f, 1.0f } };
+        DArray_Push_T(Vertex, &a, v);
+    }
+    Bench_Use(a.data);
+    DArray_Free(&a);
+}
+
+static void BenchArenaAlloc(void* data, int iterations)
+{
+    BenchData* d = (BenchData*)data;
+    Arena_Reset(&d->arena);
+    for (int i = 0; i < iterations; ++i)
+    {
+        void* p = Arena_Alloc(&d->arena, 48);
+        if (!p)
+        {
+            Arena_Reset(&d->arena);
+            p = Arena_Alloc(&d->arena, 48);
+        }
+        Bench_Use(p);
+    }
+}
+
+static void BenchStringAppend(void* data, int iterations)
+{
+    (void)data;
+    String s = String_Create(16, "", NULL);
+    for (int i = 0; i < iterations; ++i)
+        String_Append(&s, "vertex ");
+    Bench_Use(s.data);
+    String_Free(&s);
+}
+
+/* ----- files and meshes ----- */
+
+static void BenchFileLoad(void* data, int iterations)
+{
+    BenchData* d = (BenchData*)data;
+    for (int i = 0; i < iterations; ++i)
+    {
+        String s = File_Load(d->blob_path);
+        Bench_Use(s.data);
+        String_Free(&s);
+    }
+}
+
+static void BenchMeshCube(void* data, int iterations)
+{
+    BenchData* d = (BenchData*)data;
+    for (int i = 0; i < iterations; ++i)
+    {
+        Mesh mesh;
+        Arena_Reset(&d->arena);
+        Mesh_CreateCube(&mesh, &d->arena);
+        Bench_Use(mesh.vertices.data);
+    }
+}
+
+static void BenchMeshCircle(void* data, int iterations)
+{
+    BenchData* d = (BenchData*)data;
+    for (int i = 0; i < iterations; ++i)
+    {
+        Mesh mesh;
+        Arena_Reset(&d->arena);
+        Mesh_CreateCircle(&mesh, 1.0f, 64, &d->arena);
+        Bench_Use(mesh.vertices.data);
+    }
+}
+
+static void BenchMeshSphere(void* data, int iterations)
+{
+    BenchData* d = (BenchData*)data;
+    for (int i = 0; i < iterations; ++i)
+    {
+        Mesh mesh;
+        Arena_Reset(&d->arena);
+        Mesh_CreateSphere(&mesh, 1.0f, 32, 32, &d->arena);
+        Bench_Use(mesh.vertices.data);
+    }
+}
+
+static void BenchMeshDome(void* data, int iterations)
+{
+    BenchData* d = (BenchData*)data;
+    for (int i = 0; i < iterations; ++i)
+    {
+        Mesh mesh;
+        Arena_Reset(&d->arena);
+        Mesh_CreateDome(&mesh, 1.0f, 16, 32, &d->arena);
+        Bench_Use(mesh.vertices.data);
+    }
+}
+
+static void BenchObjLoad(void* data, int iterations)
+{
+    BenchData* d = (BenchData*)data;
+    for (int i = 0; i < iterations; ++i)
+    {
+        Mesh mesh = { 0 };
+        Arena_Reset(&d->arena);
+        Mesh_CreateModel(&mesh, d->obj_path, &d->arena);
+        Bench_Use(mesh.vertices.data);
+    }
+}
+
+/* ----- inputs ----- */
+
+static bool WriteBlob(const char* path, size_t size)
+{
+    FILE* file = fopen(path, "wb");
+    if (!file)
+        return false;
+
+    for (size_t i = 0; i < size; ++i)
+        fputc((int)('a' + i % 26), file);
+    fclose(file);
+    return true;
+}
+
+// UV sphere with positions, texcoords and normals, triangulated the way the C loader expects
+static bool WriteSphereObj(const char* path, int stacks, int sectors)
+{
+    FILE* file = fopen(path, "w");
+    if (!file)
+        return false;
+
+    for (int i = 0; i <= stacks; ++i)
+    {
+        float phi = 3.14159265f * (float)i / stacks;
+        for (int j = 0; j <= sectors; ++j)
+        {
+            float theta = 2.0f * 3.14159265f * (float)j / sectors;
+            float x = sinf(phi) * cosf(theta), y = cosf(phi), z = sinf(phi) * sinf(theta);
+            fprintf(file, "v %f %f %f\nvt %f %f\nvn %f %f %f\n", x, y, z, (float)j / sectors, (float)i / stacks, x, y, z);
+        }
+    }
+
+    for (int i = 0; i < stacks; ++i)
+    {
+        for (int j = 0; j < sectors; ++j)
+        {
+            int a = i * (sectors + 1) + j + 1, b = a + sectors + 1;
+            fprintf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, b, b, b, a + 1, a + 1, a + 1);
+            fprintf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a + 1, a + 1, a + 1, b, b, b, b + 1, b + 1, b + 1);
+        }
+    }
+
+    fclose(file);
+    return true;
+}
+
+static char* ReadWholeFile(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file)
+        return NULL;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char* text = (char*)malloc((size_t)size + 1);
+    size_t read = text ? fread(text, 1, (size_t)size, file) : 0;
+    if (text)
+        text[read] = '\0';
+    fclose(file);
+    return text;
+}
+
+int main(int argc, char** argv)
+{
+    const char* json_path = NULL;
+    const char* compare_path = NULL;
+    const char* filter = NULL;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--json") == 0) json_path = argv[i + 1];
+        else if (strcmp(argv[i], "--compare") == 0) compare_path = argv[i + 1];
+        else if (strcmp(argv[i], "--filter") == 0) filter = argv[i + 1];
+    }
+
+    BenchData* d = (BenchData*)calloc(1, sizeof(BenchData));
+    d->arena = Arena_Create(16 * 1024 * 1024);
+    d->blob_path = "/tmp/core_bench_blob.bin";
+    d->obj_path = "/tmp/core_bench_sphere.obj";
+
+    srand(1234);
+    for (int i = 0; i < INPUT_COUNT; ++i)
+    {
+        d->vec3[i] = (Vector3){ (float)(rand() % 200 - 100) + 0.5f, (float)(rand() % 200 - 100), (float)(rand() % 200 - 100) };
+        d->angle[i] = (float)(rand() % 628) * 0.01f;
+        d->quat[i] = Math_QuatRotate(Math_Vec3Normalize(d->vec3[i]), d->angle[i]);
+        d->mat4[i] = Math_QuatConvertToMat4(d->quat[i]);
+        d->mat4[i].m[12] = d->vec3[i].x;
+    }
+
+    // the C loader keeps its position/uv/normal tables on the stack, so the sphere stays moderate
+    if (!WriteBlob(d->blob_path, 1 << 20) || !WriteSphereObj(d->obj_path, 32, 48))
+    {
+        printf("Failed to write benchmark inputs to /tmp\n");
+        return -1;
+    }
+
+    struct { const char* name; BenchFunc func; } benches[] = {
+        { "math/vec3_normalize",    BenchVec3Normalize },
+        { "math/vec3_cross",        BenchVec3Cross },
+        { "math/mat4_multiply",     BenchMat4Multiply },
+        { "math/mat4_rotate",       BenchMat4Rotate },
+        { "math/proj_matrix",       BenchProjMatrix },
+        { "math/quat_multiply",     BenchQuatMultiply },
+        { "math/quat_to_mat4",      BenchQuatToMat4 },
+        { "darray/push_int",        BenchDArrayPushInt },
+        { "darray/push_vertex",     BenchDArrayPushVertex },
+        { "arena/alloc_48",         BenchArenaAlloc },
+        { "string/append_7",        BenchStringAppend },
+        { "file/load_1mb",          BenchFileLoad },
+        { "mesh/cube",              BenchMeshCube },
+        { "mesh/circle_64",         BenchMeshCircle },
+        { "mesh/sphere_32x32",      BenchMeshSphere },
+        { "mesh/dome_16x32",        BenchMeshDome },
+        { "obj/sphere_3072_tris",   BenchObjLoad },
+    };
+    const int count = (int)(sizeof(benches) / sizeof(benches[0]));
+
+    char* baseline = compare_path ? ReadWholeFile(compare_path) : NULL;
+    if (compare_path && !baseline)
+        printf("Could not read baseline %s\n", compare_path);
+
+    BenchConfig config = Bench_DefaultConfig();
+    BenchResult results[sizeof(benches) / sizeof(benches[0])];
+    int ran = 0;
+
+    Bench_PrintHeader();
+    for (int i = 0; i < count; ++i)
+    {
+        if (filter && !strstr(benches[i].name, filter))
+            continue;
+
+        results[ran] = Bench_Measure(benches[i].name, benches[i].func, d, &config);
+        Bench_Print(&results[ran]);
+
+        double before = Bench_FindMedian(baseline, benches[i].name);
+        if (before > 0.0)
+            printf("%-32s %+11.1f%% vs baseline (%.2f ns)\n", "", (results[ran].median_ns / before - 1.0) * 100.0, before);
+
+        ran += 1;
+    }
+
+    if (json_path)
+    {
+        FILE* file = fopen(json_path, "w");
+        if (file)
+        {
+            Bench_WriteJSON(file, results, ran);
+            fclose(file);
+            printf("results: %s\n", json_path);
+        }
+        else
+            printf("Failed to write %s\n", json_path);
+    }
+
+    printf("sink: %g\n", d->sink);
+
+    free(baseline);
+    Arena_Free(&d->arena);
+    free(d);
+    remove("/tmp/core_bench_blob.bin");
+    remove("/tmp/core_bench_sphere.obj");
+    return 0;
+}
@@ -0,0 +1,306 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "ecs_utility.h"
+#include "bench_common.h"
+
+// Runs movement, transform, culling and render submission systems over N entities (1M by default),
+// once with component pools in scattered order, once after Ecs_SortPools, and compares both with
+// the same systems over an array of fat per-object structs.
+//
+// usage: ecs_bench [entity_count] [frames]
+
+typedef struct
+{
+    char name[32];
+    Transform transform;
+    Matrix4 model;
+    Velocity velocity;
+    Bounds bounds;
+    MeshRef mesh;
+    MaterialRef material;
+    bool has_mesh;
+    float padding[16];      // stand-in for the per-object state a hand written object carries around
+
+} GameObject;
+
+typedef struct
+{
+    Vector4 planes[6];
+
+} Frustum;
+
+typedef struct
+{
+    double move, transform, cull, submit;
+    uint32_t visible, submitted;
+
+} SystemTimes;
+
+static float RandomRange(float lo, float hi)
+{
+    return lo + (hi - lo) * ((float)rand() / (float)RAND_MAX);
+}
+
+// Gribb/Hartmann plane extraction from a column major view projection
+static Frustum Frustum_FromMatrix(Matrix4 m)
+{
+    Frustum f;
+    for (int i = 0; i < 3; ++i)
+    {
+        for (int s = 0; s < 2; ++s)
+        {
+            float sign = s ? -1.0f : 1.0f;
+            Vector4 p = { m.m[3] + sign * m.m[i], m.m[7] + sign * m.m[4 + i], m.m[11] + sign * m.m[8 + i], m.m[15] + sign * m.m[12 + i] };
+            float length = sqrtf(p.x * p.x + p.y * p.y + p.z * p.z);
+            f.planes[i * 2 + s] = (Vector4){ p.x / length, p.y / length, p.z / length, p.w / length };
+        }
+    }
+    return f;
+}
+
+static bool Frustum_TestSphere(const Frustum* f, const Matrix4* model, const Bounds* b)
+{
+    const float* m = model->m;
+    Vector3 c = { m[0] * b->center.x + m[4] * b->center.y + m[8] * b->center.z + m[12],
+                  m[1] * b->center.x + m[5] * b->center.y + m[9] * b->center.z + m[13],
+                  m[2] * b->center.x + m[6] * b->center.y + m[10] * b->center.z + m[14] };
+
+    float sx = m[0] * m[0] + m[1] * m[1] + m[2] * m[2];
+    float sy = m[4] * m[4] + m[5] * m[5] + m[6] * m[6];
+    float sz = m[8] * m[8] + m[9] * m[9] + m[10] * m[10];
+    float s = sx > sy ? (sx > sz ? sx : sz) : (sy > sz ? sy : sz);
+    float r = b->radius * sqrtf(s);
+
+    for (int i = 0; i < 6; ++i)
+    {
+        const Vector4* p = &f->planes[i];
+        if (p->x * c.x + p->y * c.y + p->z * c.z + p->w < -r)
+            return false;
+    }
+    return true;
+}
+
+static Quaternion Integrate(Quaternion q, Vector3 w, float dt)
+{
+    // q += 0.5 * dt * (w, 0) * q
+    Quaternion d = {
+        -w.x * q.x - w.y * q.y - w.z * q.z,
+         w.x * q.w + w.y * q.z - w.z * q.y,
+         w.y * q.w + w.z * q.x - w.x * q.z,
+         w.z * q.w + w.x * q.y - w.y * q.x };
+    float h = 0.5f * dt;
+    return Math_QuatNormalize((Quaternion){ q.w + h * d.w, q.x + h * d.x, q.y + h * d.y, q.z + h * d.z });
+}
+
+static void RunEcs(EcsWorld* world, const Frustum* frustum, Entity* visible, uint64_t* keys, int frames, SystemTimes* t)
+{
+    const float dt = 1.0f / 60.0f;
+    memset(t, 0, sizeof(SystemTimes));
+
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        double start = Bench_Now();
+        {
+            ComponentId ids[] = { ECS_TRANSFORM, ECS_VELOCITY };
+            EcsQuery q = Ecs_Query(world, ids, 2);
+            while (Ecs_QueryNext(&q))
+            {
+                Transform* tr = Ecs_QueryGet_T(Transform, &q, 0);
+                const Velocity* v = Ecs_QueryGet_T(Velocity, &q, 1);
+                tr->position = Math_Vec3Add(tr->position, Math_Vec3Scale(v->linear, dt));
+                tr->rotation = Integrate(tr->rotation, v->angular, dt);
+            }
+        }
+        double moved = Bench_Now();
+        {
+            ComponentId ids[] = { ECS_TRANSFORM, ECS_MODEL };
+            EcsQuery q = Ecs_Query(world, ids, 2);
+            while (Ecs_QueryNext(&q))
+                *Ecs_QueryGet_T(Matrix4, &q, 1) = Transform_ToMatrix(Ecs_QueryGet_T(Transform, &q, 0));
+        }
+        double transformed = Bench_Now();
+        uint32_t visible_count = 0;
+        {
+            ComponentId ids[] = { ECS_MODEL, ECS_BOUNDS };
+            EcsQuery q = Ecs_Query(world, ids, 2);
+            while (Ecs_QueryNext(&q))
+            {
+                if (Frustum_TestSphere(frustum, Ecs_QueryGet_T(Matrix4, &q, 0), Ecs_QueryGet_T(Bounds, &q, 1)))
+                    visible[visible_count++] = q.entity;
+            }
+        }
+        double culled = Bench_Now();
+        uint32_t submitted = 0;
+        for (uint32_t i = 0; i < visible_count; ++i)
+        {
+            const MeshRef* mesh = Ecs_Get_T(MeshRef, world, visible[i], ECS_MESH);
+            const MaterialRef* material = Ecs_Get_T(MaterialRef, world, visible[i], ECS_MATERIAL);
+            if (mesh && material)
+                keys[submitted++] = ((uint64_t)material->shader << 48) | ((uint64_t)material->texture << 32) | mesh->mesh;
+        }
+        double done = Bench_Now();
+
+        t->move += moved - start;
+        t->transform += transformed - moved;
+        t->cull += culled - transformed;
+        t->submit += done - culled;
+        t->visible = visible_count;
+        t->submitted = submitted;
+    }
+}
+
+static void RunObjects(GameObject* objects, int count, const Frustum* frustum, uint32_t* visible, uint64_t* keys, int frames, SystemTimes* t)
+{
+    const float dt = 1.0f / 60.0f;
+    memset(t, 0, sizeof(SystemTimes));
+
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        double start = Bench_Now();
+        for (int i = 0; i < count; ++i)
+        {
+            GameObject* o = &objects[i];
+            o->transform.position = Math_Vec3Add(o->transform.position, Math_Vec3Scale(o->velocity.linear, dt));
+            o->transform.rotation = Integrate(o->transform.rotation, o->velocity.angular, dt);
+        }
+        double moved = Bench_Now();
+        for (int i = 0; i < count; ++i)
+            objects[i].model = Transform_ToMatrix(&objects[i].transform);
+        double transformed = Bench_Now();
+        uint32_t visible_count = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            if (Frustum_TestSphere(frustum, &objects[i].model, &objects[i].bounds))
+                visible[visible_count++] = (uint32_t)i;
+        }
+        double culled = Bench_Now();
+        uint32_t submitted = 0;
+        for (uint32_t i = 0; i < visible_count; ++i)
+        {
+            const GameObject* o = &objects[visible[i]];
+            if (o->has_mesh)
+                keys[submitted++] = ((uint64_t)o->material.shader << 48) | ((uint64_t)o->material.texture << 32) | o->mesh.mesh;
+        }
+        double done = Bench_Now();
+
+        t->move += moved - start;
+        t->transform += transformed - moved;
+        t->cull += culled - transformed;
+        t->submit += done - culled;
+        t->visible = visible_count;
+        t->submitted = submitted;
+    }
+}
+
+static void PrintTimes(const char* label, const SystemTimes* t, int frames)
+{
+    double total = t->move + t->transform + t->cull + t->submit;
+    printf("%-16s move %7.2f | transform %7.2f | cull %7.2f | submit %7.2f | total %7.2f ms  (visible %u, submitted %u)\n", label,
+           t->move * 1000.0 / frames, t->transform * 1000.0 / frames, t->cull * 1000.0 / frames, t->submit * 1000.0 / frames,
+           total * 1000.0 / frames, t->visible, t->submitted);
+}
+
+int main(int argc, char** argv)
+{
+    int count = (argc > 1) ? atoi(argv[1]) : 1000000;
+    int frames = (argc > 2) ? atoi(argv[2]) : 10;
+
+    if (count < 1 || frames < 1)
+        return -1;
+
+    EcsWorld world;
+    if (!Ecs_Create(&world, (uint32_t)count))
+        return -1;
+
+    GameObject* objects = (GameObject*)calloc((size_t)count, sizeof(GameObject));
+    Entity* entities = (Entity*)malloc(sizeof(Entity) * count);
+    Entity* visible = (Entity*)malloc(sizeof(Entity) * count);
+    uint64_t* keys = (uint64_t*)malloc(sizeof(uint64_t) * count);
+    int* shuffle = (int*)malloc(sizeof(int) * count);
+    if (!objects || !entities || !visible || !keys || !shuffle)
+        return -1;
+
+    srand(1234);
+    for (int i = 0; i < count; ++i)
+    {
+        GameObject* o = &objects[i];
+        o->transform = Transform_Identity();
+        o->transform.position = (Vector3){ RandomRange(-500.0f, 500.0f), RandomRange(-500.0f, 500.0f), RandomRange(-1000.0f, 0.0f) };
+        o->velocity = (Velocity){ { RandomRange(-1.0f, 1.0f), 0.0f, RandomRange(-1.0f, 1.0f) }, { 0.0f, RandomRange(-2.0f, 2.0f), 0.0f } };
+        o->bounds = (Bounds){ { 0.0f, 0.0f, 0.0f }, RandomRange(0.5f, 2.0f) };
+        o->has_mesh = (i % 2) == 0;
+        o->mesh = (MeshRef){ (uint32_t)(rand() % 64), 0 };
+        o->material = (MaterialRef){ (uint32_t)(rand() % 8), (uint32_t)(rand() % 32) };
+        shuffle[i] = i;
+    }
+
+    for (int i = count - 1; i > 0; --i)
+    {
+        int j = rand() % (i + 1);
+        int tmp = shuffle[i]; shuffle[i] = shuffle[j]; shuffle[j] = tmp;
+    }
+
+    double start = Bench_Now();
+    for (int i = 0; i < count; ++i)
+    {
+        entities[i] = Ecs_CreateEntity(&world);
+        Ecs_Add(&world, entities[i], ECS_TRANSFORM, &objects[i].transform);
+        Ecs_Add(&world, entities[i], ECS_MODEL, NULL);
+    }
+
+    // the other pools are filled in a different order, as they would be when components come and go
+    for (int k = 0; k < count; ++k)
+    {
+        int i = shuffle[k];
+        Ecs_Add(&world, entities[i], ECS_BOUNDS, &objects[i].bounds);
+        Ecs_Add(&world, entities[i], ECS_VELOCITY, &objects[i].velocity);
+        if (objects[i].has_mesh)
+        {
+            Ecs_Add(&world, entities[i], ECS_MESH, &objects[i].mesh);
+            Ecs_Add(&world, entities[i], ECS_MATERIAL, &objects[i].material);
+        }
+    }
+    double created = Bench_Now() - start;
+
+    Matrix4 proj = Math_GetProjMatrix(Math_DegToRad(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+    Frustum frustum = Frustum_FromMatrix(proj);
+
+    printf("entities: %d | frames: %d | create + add: %.1f ms | GameObject: %zu bytes\n", count, frames, created * 1000.0, sizeof(GameObject));
+
+    SystemTimes t;
+    RunObjects(objects, count, &frustum, (uint32_t*)visible, keys, frames, &t);
+    PrintTimes("array of structs", &t, frames);
+
+    RunEcs(&world, &frustum, visible, keys, frames, &t);
+    PrintTimes("ecs scattered", &t, frames);
+
+    start = Bench_Now();
+    Ecs_SortPools(&world, ECS_TRANSFORM);
+    double sorted = Bench_Now() - start;
+
+    RunEcs(&world, &frustum, visible, keys, frames, &t);
+    PrintTimes("ecs sorted", &t, frames);
+    printf("Ecs_SortPools: %.1f ms\n", sorted * 1000.0);
+
+    // destroy half and check bookkeeping
+    for (int i = 0; i < count; i += 2)
+        Ecs_DestroyEntity(&world, entities[i]);
+    int errors = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        bool alive = Ecs_IsAlive(&world, entities[i]);
+        if (alive != (i % 2 == 1) || (alive && !Ecs_Has(&world, entities[i], ECS_VELOCITY)))
+            errors += 1;
+    }
+    printf("alive after destroying half: %u | mesh pool: %u | errors: %d\n", world.alive, Ecs_PoolSize(&world, ECS_MESH), errors);
+
+    Ecs_Delete(&world);
+    free(objects);
+    free(entities);
+    free(visible);
+    free(keys);
+    free(shuffle);
+
+    return errors == 0 ? 0 : -1;
+}
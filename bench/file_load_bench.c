@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "file_utility.h"
+#include "bench_common.h"
+
+// Compares the old line by line loader against File_Load and File_Map on a multi-MB text file.
+// Every variant touches all bytes (checksum) so the mmap path pays for its page faults.
+//
+// usage: file_load_bench [size_mb] [path]
+// the file is generated (OBJ-like text) unless it already exists at path
+
+static String LoadLineByLine(const char* name)
+{
+    String contents = String_Create(4096, NULL, NULL);
+
+    FILE* file = fopen(name, "r");
+    if (!file)
+        return contents;
+
+    char line[512];
+    while (fgets(line, sizeof(line), file))
+        String_Append(&contents, line);
+
+    fclose(file);
+    return contents;
+}
+
+static unsigned long Checksum(const char* data, size_t size)
+{
+    unsigned long sum = 0;
+    for (size_t i = 0; i < size; ++i)
+        sum = sum * 31 + (unsigned char)data[i];
+    return sum;
+}
+
+int main(int argc, char** argv)
+{
+    int size_mb = (argc > 1) ? atoi(argv[1]) : 32;
+    const char* path = (argc > 2) ? argv[2] : "/tmp/file_load_bench.txt";
+
+    struct stat st;
+    if (stat(path, &st) != 0 || st.st_size < (off_t)size_mb << 20)
+    {
+        FILE* file = fopen(path, "w");
+        if (!file)
+        {
+            printf("Failed to open file: %s\n", path);
+            return -1;
+        }
+
+        srand(1234);
+        size_t written = 0;
+        while (written < (size_t)size_mb << 20)
+        {
+            int n = fprintf(file, "v %f %f %f\n", rand() / (float)RAND_MAX, rand() / (float)RAND_MAX, rand() / (float)RAND_MAX);
+            written += (size_t)n;
+        }
+
+        fclose(file);
+        stat(path, &st);
+    }
+
+    double mb = (double)st.st_size / (1024.0 * 1024.0);
+    printf("file: %s (%.1f MB)\n", path, mb);
+
+    const int runs = 5;
+    unsigned long reference = 0;
+
+    for (int variant = 0; variant < 3; ++variant)
+    {
+        const char* names[] = { "fgets + String_Append", "File_Load", "File_Map" };
+        double best = 1e30;
+        unsigned long sum = 0;
+
+        for (int run = 0; run < runs; ++run)
+        {
+            double start = Bench_Now();
+
+            if (variant == 2)
+            {
+                FileView view;
+                if (!File_Map(&view, path))
+                    return -1;
+                sum = Checksum(view.data, view.size);
+                File_Unmap(&view);
+            }
+            else
+            {
+                String contents = (variant == 0) ? LoadLineByLine(path) : File_Load(path);
+                sum = Checksum(contents.data, contents.length);
+                String_Free(&contents);
+            }
+
+            double elapsed = Bench_Now() - start;
+            if (elapsed < best)
+                best = elapsed;
+        }
+
+        if (variant == 0)
+            reference = sum;
+
+        printf("%-22s best of %d: %8.2f ms | %7.1f MB/s | %s\n", names[variant], runs, best * 1000.0, mb / best,
+               (sum == reference) ? "match" : "MISMATCH");
+    }
+
+    return 0;
+}
@@ -0,0 +1,301 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "frame_graph_utility.h"
+#include "ecs_utility.h"
+#include "bench_common.h"
+
+// Runs a synthetic frame (input, camera, physics, transforms, culling, command building, GL
+// submission) over an ECS world three ways: the stages called one after another, the frame graph,
+// and the frame graph with simulation of frame N+1 pipelined against submission of frame N.
+// "GL submission" walks the command list and burns a fixed amount of main thread time the way a
+// driver would.
+//
+// Built with FRAMEWORK_PROFILE (make bench_frame_trace) the stages are profiled as well, and
+// FRAMEWORK_TRACE=file.json writes a Chrome trace of the graph runs.
+//
+// usage: frame_graph_bench [entity_count] [frames] [threads] [submit_ms]
+
+typedef struct
+{
+    uint64_t* keys;
+    uint32_t* models;   // index into the Model pool
+    uint32_t count;
+
+} RenderData;
+
+typedef struct
+{
+    JobSystem* jobs;
+    EcsWorld* world;
+
+    Vector4 frustum[6];
+    float camera_angle;
+    uint8_t* visible;
+
+    RenderData render[2];   // double buffered between command building and submission
+    double submit_ms;
+    double checksum;
+
+} FrameData;
+
+/* ----- stages ----- */
+
+static void BusyWait(double ms)
+{
+    double end = Bench_Now() + ms * 1e-3;
+    while (Bench_Now() < end)
+        ;
+}
+
+static void InputStage(void* data, const FrameContext* ctx)
+{
+    (void)data; (void)ctx;
+    BusyWait(0.1);  // window event polling
+}
+
+static void CameraStage(void* data, const FrameContext* ctx)
+{
+    FrameData* f = (FrameData*)data;
+    f->camera_angle = (float)ctx->frame * 0.01f;
+
+    // frustum of a camera at the origin turning around Y
+    Matrix4 proj = Math_GetProjMatrix(Math_DegToRad(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+    Matrix4 m = Math_Mat4Multiply(proj, Math_Mat4RotateY(f->camera_angle));
+    for (int i = 0; i < 3; ++i)
+    {
+        for (int s = 0; s < 2; ++s)
+        {
+            float sign = s ? -1.0f : 1.0f;
+            Vector4 p = { m.m[3] + sign * m.m[i], m.m[7] + sign * m.m[4 + i], m.m[11] + sign * m.m[8 + i], m.m[15] + sign * m.m[12 + i] };
+            float length = sqrtf(p.x * p.x + p.y * p.y + p.z * p.z);
+            f->frustum[i * 2 + s] = (Vector4){ p.x / length, p.y / length, p.z / length, p.w / length };
+        }
+    }
+}
+
+static void PhysicsRange(void* data, int begin, int end)
+{
+    FrameData* f = (FrameData*)data;
+    Transform* transforms = (Transform*)Ecs_PoolData(f->world, ECS_TRANSFORM);
+    const Velocity* velocities = (const Velocity*)Ecs_PoolData(f->world, ECS_VELOCITY);
+
+    for (int i = begin; i < end; ++i)
+        transforms[i].position = Math_Vec3Add(transforms[i].position, Math_Vec3Scale(velocities[i].linear, 1.0f / 60.0f));
+}
+
+static void PhysicsStage(void* data, const FrameContext* ctx)
+{
+    FrameData* f = (FrameData*)data;
+    (void)ctx;
+    Job_ParallelFor(f->jobs, (int)Ecs_PoolSize(f->world, ECS_VELOCITY), 0, PhysicsRange, f);
+}
+
+static void TransformRange(void* data, int begin, int end)
+{
+    FrameData* f = (FrameData*)data;
+    const Transform* transforms = (const Transform*)Ecs_PoolData(f->world, ECS_TRANSFORM);
+    Matrix4* models = (Matrix4*)Ecs_PoolData(f->world, ECS_MODEL);
+
+    for (int i = begin; i < end; ++i)
+        models[i] = Transform_ToMatrix(&transforms[i]);
+}
+
+static void TransformStage(void* data, const FrameContext* ctx)
+{
+    FrameData* f = (FrameData*)data;
+    (void)ctx;
+    Job_ParallelFor(f->jobs, (int)Ecs_PoolSize(f->world, ECS_MODEL), 0, TransformRange, f);
+}
+
+static void CullRange(void* data, int begin, int end)
+{
+    FrameData* f = (FrameData*)data;
+    const Matrix4* models = (const Matrix4*)Ecs_PoolData(f->world, ECS_MODEL);
+    const Bounds* bounds = (const Bounds*)Ecs_PoolData(f->world, ECS_BOUNDS);
+
+    for (int i = begin; i < end; ++i)
+    {
+        const float* m = models[i].m;
+        float r = bounds[i].radius;
+        bool inside = true;
+        for (int p = 0; p < 6 && inside; ++p)
+        {
+            const Vector4* plane = &f->frustum[p];
+            inside = plane->x * m[12] + plane->y * m[13] + plane->z * m[14] + plane->w >= -r;
+        }
+        f->visible[i] = inside;
+    }
+}
+
+static void CullStage(void* data, const FrameContext* ctx)
+{
+    FrameData* f = (FrameData*)data;
+    (void)ctx;
+    Job_ParallelFor(f->jobs, (int)Ecs_PoolSize(f->world, ECS_BOUNDS), 0, CullRange, f);
+}
+
+static void CommandStage(void* data, const FrameContext* ctx)
+{
+    FrameData* f = (FrameData*)data;
+    RenderData* out = &f->render[ctx->write_slot];
+    const MeshRef* meshes = (const MeshRef*)Ecs_PoolData(f->world, ECS_MESH);
+    const MaterialRef* materials = (const MaterialRef*)Ecs_PoolData(f->world, ECS_MATERIAL);
+    uint32_t count = Ecs_PoolSize(f->world, ECS_MESH);
+
+    // pools share the Transform order, so slot i is the same entity everywhere
+    out->count = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (!f->visible[i])
+            continue;
+        out->keys[out->count] = ((uint64_t)materials[i].shader << 48) | ((uint64_t)materials[i].texture << 32) | meshes[i].mesh;
+        out->models[out->count] = i;
+        out->count += 1;
+    }
+}
+
+static void SubmitStage(void* data, const FrameContext* ctx)
+{
+    FrameData* f = (FrameData*)data;
+    const RenderData* in = &f->render[ctx->read_slot];
+
+    double sum = 0.0;
+    for (uint32_t i = 0; i < in->count; ++i)
+        sum += (double)(in->keys[i] & 0xFFFF) + in->models[i];
+    f->checksum += sum;
+
+    BusyWait(f->submit_ms);
+}
+
+/* ----- runs ----- */
+
+static double RunSerial(FrameData* f, int frames)
+{
+    FrameContext ctx = { 0, 0, 0 };
+    double start = Bench_Now();
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        ctx.frame = (uint64_t)frame;
+        InputStage(f, &ctx);
+        CameraStage(f, &ctx);
+        PhysicsStage(f, &ctx);
+        TransformStage(f, &ctx);
+        CullStage(f, &ctx);
+        CommandStage(f, &ctx);
+        SubmitStage(f, &ctx);
+    }
+    return (Bench_Now() - start) * 1000.0 / frames;
+}
+
+static double RunGraph(FrameGraph* graph, int frames)
+{
+    double start = Bench_Now();
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        FrameGraph_Run(graph);
+        PROFILE_FRAME_END();
+    }
+    return (Bench_Now() - start) * 1000.0 / frames;
+}
+
+int main(int argc, char** argv)
+{
+    int count = (argc > 1) ? atoi(argv[1]) : 200000;
+    int frames = (argc > 2) ? atoi(argv[2]) : 60;
+    int threads = (argc > 3) ? atoi(argv[3]) : 0;
+    double submit_ms = (argc > 4) ? atof(argv[4]) : 4.0;
+
+    if (count < 1 || frames < 1)
+        return -1;
+
+#ifdef FRAMEWORK_PROFILE
+    Profiler_InitFromEnv();
+    PROFILE_THREAD("main");
+#endif
+
+    EcsWorld world;
+    if (!Ecs_Create(&world, (uint32_t)count))
+        return -1;
+
+    srand(1234);
+    for (int i = 0; i < count; ++i)
+    {
+        Entity e = Ecs_CreateEntity(&world);
+        Transform t = Transform_Identity();
+        t.position = (Vector3){ (float)(rand() % 2000) - 1000.0f, (float)(rand() % 200) - 100.0f, (float)(rand() % 2000) - 1000.0f };
+        Ecs_Add(&world, e, ECS_TRANSFORM, &t);
+        Ecs_Add(&world, e, ECS_MODEL, NULL);
+        Ecs_Add_T(Velocity, &world, e, ECS_VELOCITY, ((Velocity){ { 1.0f, 0.0f, 0.5f }, { 0.0f, 0.0f, 0.0f } }));
+        Ecs_Add_T(Bounds, &world, e, ECS_BOUNDS, ((Bounds){ { 0.0f, 0.0f, 0.0f }, 1.0f }));
+        Ecs_Add_T(MeshRef, &world, e, ECS_MESH, ((MeshRef){ (uint32_t)(rand() % 64), 0 }));
+        Ecs_Add_T(MaterialRef, &world, e, ECS_MATERIAL, ((MaterialRef){ (uint32_t)(rand() % 8), (uint32_t)(rand() % 32) }));
+    }
+    Ecs_SortPools(&world, ECS_TRANSFORM);
+
+    JobSystem jobs;
+    if (!Job_Create(&jobs, threads))
+        return -1;
+
+    FrameData f;
+    memset(&f, 0, sizeof(f));
+    f.jobs = &jobs;
+    f.world = &world;
+    f.submit_ms = submit_ms;
+    f.visible = (uint8_t*)malloc((size_t)count);
+    for (int i = 0; i < 2; ++i)
+    {
+        f.render[i].keys = (uint64_t*)malloc(sizeof(uint64_t) * count);
+        f.render[i].models = (uint32_t*)malloc(sizeof(uint32_t) * count);
+    }
+
+    // input and submission own the window and the GL context: main thread
+    FrameGraph graph;
+    FrameGraph_Create(&graph, &jobs);
+    int input     = FrameGraph_AddTask(&graph, "input",      InputStage,     &f, FRAME_TASK_MAIN_THREAD);
+    int camera    = FrameGraph_AddTask(&graph, "camera",     CameraStage,    &f, 0);
+    int physics   = FrameGraph_AddTask(&graph, "physics",    PhysicsStage,   &f, 0);
+    int transform = FrameGraph_AddTask(&graph, "transforms", TransformStage, &f, 0);
+    int cull      = FrameGraph_AddTask(&graph, "culling",    CullStage,      &f, 0);
+    int commands  = FrameGraph_AddTask(&graph, "commands",   CommandStage,   &f, 0);
+    int submit    = FrameGraph_AddTask(&graph, "gl submit",  SubmitStage,    &f, FRAME_TASK_MAIN_THREAD | FRAME_TASK_RENDER);
+
+    FrameGraph_AddDependency(&graph, camera, input);
+    FrameGraph_AddDependency(&graph, physics, input);
+    FrameGraph_AddDependency(&graph, transform, physics);
+    FrameGraph_AddDependency(&graph, cull, transform);
+    FrameGraph_AddDependency(&graph, cull, camera);
+    FrameGraph_AddDependency(&graph, commands, cull);
+    FrameGraph_AddDependency(&graph, submit, commands);
+
+    printf("entities: %d | frames: %d | workers: %d | submit cost: %.1f ms\n", count, frames, Job_WorkerCount(&jobs), submit_ms);
+
+    double serial = RunSerial(&f, frames);
+    printf("serial:     %7.3f ms/frame\n", serial);
+
+    double graphed = RunGraph(&graph, frames);
+    printf("graph:      %7.3f ms/frame\n", graphed);
+    FrameGraph_PrintTimings(&graph);
+
+    FrameGraph_SetPipelined(&graph, true);
+    double pipelined = RunGraph(&graph, frames);
+    printf("pipelined:  %7.3f ms/frame\n", pipelined);
+    FrameGraph_PrintTimings(&graph);
+
+    printf("checksum: %.0f\n", f.checksum);
+
+    Job_Delete(&jobs);
+#ifdef FRAMEWORK_PROFILE
+    Profiler_Print(12);
+    Profiler_Shutdown();
+#endif
+    Ecs_Delete(&world);
+    free(f.visible);
+    for (int i = 0; i < 2; ++i)
+    {
+        free(f.render[i].keys);
+        free(f.render[i].models);
+    }
+
+    return 0;
+}
@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "window_utility.h"
+#include "mesh_utility.h"
+#include "shader_utility.h"
+#include "colour_utility.h"
+#include "gpu_profiler_utility.h"
+#include "bench_common.h"
+
+// Per-pass GPU timings from timer queries on a headless context (llvmpipe on CI). Draws a sky dome,
+// a grid of lit opaque meshes and a wireframe pass each frame, each in its own GPU scope, then
+// prints what the query ring resolved. Exits non-zero when a pass never got a timing.
+// llvmpipe bins the whole frame and then rasterises it tile by tile, so its per-pass numbers say
+// little about cost (passes can read close to zero); there the run checks the query path itself.
+// Built with PROFILE=1 the passes also land on the GPU track of FRAMEWORK_TRACE traces.
+//
+// usage: gpu_timer_bench [frames] [grid]
+
+#define GPU_BENCH_WIDTH     640
+#define GPU_BENCH_HEIGHT    360
+
+static Matrix4 ModelMatrix(Vector3 position, float angle, float scale)
+{
+    Matrix4 trs = Math_Mat4Multiply(Math_Mat4Rotate(angle, (Vector3){ 0.3f, 1.0f, 0.0f }), Math_Mat4Scale((Vector3){ scale, scale, scale }));
+    return Math_Mat4Multiply(Math_Mat4Translate(position), trs);
+}
+
+int main(int argc, char** argv)
+{
+    int frames = argc > 1 ? atoi(argv[1]) : 240;
+    int grid = argc > 2 ? atoi(argv[2]) : 8;
+    if (frames < 1 || grid < 1)
+        return -1;
+
+    Window window;
+    if (!Window_CreateEx(&window, GPU_BENCH_WIDTH, GPU_BENCH_HEIGHT, 60.0f, "gpu_timer_bench", WINDOW_MODE_HEADLESS))
+        return -1;
+    Window_EnableDepthTest();
+
+    Arena arena = Arena_Create(8 * 1024 * 1024);
+    Mesh dome, sphere, cube;
+    Mesh_CreateDome(&dome, 1.0f, 24, 48, &arena);
+    Mesh_CreateSphere(&sphere, 1.0f, 24, 32, &arena);
+    Mesh_CreateCube(&cube, &arena);
+    Mesh_Upload(&dome);
+    Mesh_Upload(&sphere);
+    Mesh_Upload(&cube);
+
+    Shader flat, lit;
+    Shader_CreatePermutation(&flat, "shaders/vertex.glsl", "shaders/fragment.glsl", 0);     // unlit uColor
+    Shader_Create(&lit, "shaders/lighting_vertex.glsl", "shaders/lighting_fragment.glsl");
+    if (!flat.program || !lit.program)
+    {
+        printf("Failed to build the bench shaders (run from the repository root)\n");
+        return -1;
+    }
+
+    Vector3 eye = { 0.0f, 2.0f, 14.0f };
+    Matrix4 projection = Math_GetProjMatrix(window.fov, window.aspect, 0.1f, 200.0f);
+    Matrix4 view = Math_Mat4Translate((Vector3){ -eye.x, -eye.y, -eye.z });
+
+    printf("GPU: %s\n", (const char*)glGetString(GL_RENDERER));
+
+    double cpu_ms = 0.0, cpu_max_ms = 0.0;
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        // the readback of earlier frames happens here and must never block
+        double start = Bench_Now();
+        GpuProfiler_BeginFrame();
+        double ms = (Bench_Now() - start) * 1000.0;
+        cpu_ms += ms;
+        cpu_max_ms = ms > cpu_max_ms ? ms : cpu_max_ms;
+
+        float t = (float)frame * 0.02f;
+        Window_Clear(Colour_Black);
+
+        GpuProfiler_Begin("sky dome");
+            Shader_Enable(&flat);
+            Shader_SetUniformMat4(&flat, "uProjection", projection);
+            Shader_SetUniformMat4(&flat, "uView", view);
+            Shader_SetUniformMat4(&flat, "uModel", ModelMatrix(eye, 0.0f, 100.0f));
+            Shader_SetUniform4f(&flat, "uColor", Colour_Navy);
+            Mesh_Draw(&dome);
+        GpuProfiler_End();
+
+        GpuProfiler_Begin("opaque");
+            Shader_Enable(&lit);
+            Shader_SetUniformMat4(&lit, "uProjection", projection);
+            Shader_SetUniformMat4(&lit, "uView", view);
+            Shader_SetUniform3f(&lit, "viewPos", eye);
+            for (int i = 0; i < grid * grid; ++i)
+            {
+                Vector3 position = { -7.0f + 14.0f * (float)(i % grid) / grid, -3.0f + 7.0f * (float)(i / grid) / grid, 2.0f };
+                Shader_SetUniformMat4(&lit, "uModel", ModelMatrix(position, t + 0.1f * (float)i, 1.2f));
+                Shader_SetUniform4f(&lit, "uColor", (i & 1) ? Colour_Bronze : Colour_Teal);
+                Mesh_Draw((i & 1) ? &cube : &sphere);
+            }
+        GpuProfiler_End();
+
+        GpuProfiler_Begin("wireframe");
+            Shader_Enable(&flat);
+            Shader_SetUniform4f(&flat, "uColor", Colour_Lime);
+            for (int i = 0; i < grid; ++i)
+            {
+                Vector3 position = { -8.0f + 16.0f * (float)i / grid, 4.0f, 0.0f };
+                Shader_SetUniformMat4(&flat, "uModel", ModelMatrix(position, -t, 0.8f));
+                Mesh_DrawWireFrame(&sphere);
+            }
+        GpuProfiler_End();
+
+        Shader_Disable();
+        GpuProfiler_EndFrame();
+        Window_SwapBuffers(window);
+    }
+
+    GpuProfiler_Flush();
+    GpuProfiler_Print();
+    printf("CPU cost of BeginFrame (query readback): avg %.4f ms, max %.4f ms\n", cpu_ms / frames, cpu_max_ms);
+
+    // every pass must have been timed at least once
+    const char* passes[] = { "sky dome", "opaque", "wireframe" };
+    int missing = 0;
+    for (int i = 0; i < 3; ++i)
+    {
+        bool found = false;
+        for (int s = 0; s < GpuProfiler_State.scope_count; ++s)
+            found |= strcmp(GpuProfiler_State.scopes[s].name, passes[i]) == 0 && GpuProfiler_State.scopes[s].samples > 0;
+        if (!found)
+        {
+            printf("no GPU timing for '%s'\n", passes[i]);
+            missing += 1;
+        }
+    }
+    bool supported = GpuProfiler_State.supported;
+
+    Shader_Delete(&flat);
+    Shader_Delete(&lit);
+    Mesh_Delete(&dome);
+    Mesh_Delete(&sphere);
+    Mesh_Delete(&cube);
+    Arena_Free(&arena);
+    GpuProfiler_Delete();
+    Window_Delete();
+
+    return (supported && missing == 0) ? 0 : -1;
+}
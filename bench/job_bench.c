@@ -0,0 +1,227 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "job_utility.h"
+#include "bench_common.h"
+
+// Checks the job system (parallel_for sums, nested jobs, dependency chains, submissions from an
+// outside thread) and then measures Job_ParallelFor scaling from 1 thread up to every core.
+// Build with `make tsan` to run the same checks under ThreadSanitizer.
+//
+// usage: job_bench [element_count] [max_threads]
+
+/* ----- parallel_for ----- */
+
+typedef struct
+{
+    const float* input;
+    float* output;
+
+} KernelData;
+
+static void Kernel(void* data, int begin, int end)
+{
+    KernelData* k = (KernelData*)data;
+    for (int i = begin; i < end; ++i)
+    {
+        float x = k->input[i];
+        k->output[i] = sqrtf(x) * sinf(x) + cosf(x * 0.5f);
+    }
+}
+
+/* ----- nested jobs ----- */
+
+typedef struct
+{
+    JobSystem* system;
+    int depth;
+    int* leaves;
+
+} TreeData;
+
+static void TreeJob(void* data, int begin, int end)
+{
+    TreeData* tree = (TreeData*)data;
+    (void)begin; (void)end;
+
+    if (tree->depth == 0)
+    {
+        __atomic_add_fetch(tree->leaves, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    TreeData children[2];
+    JobCounter counter;
+    JobCounter_Create(&counter);
+
+    for (int i = 0; i < 2; ++i)
+    {
+        children[i] = *tree;
+        children[i].depth = tree->depth - 1;
+        Job_Run(tree->system, TreeJob, &children[i], 0, 1, &counter);
+    }
+
+    Job_Wait(tree->system, &counter);
+}
+
+/* ----- dependencies ----- */
+
+typedef struct
+{
+    int stage;
+    int order[3];
+    int errors;
+
+} ChainData;
+
+static void ChainStage(void* data, int begin, int end)
+{
+    ChainData* chain = (ChainData*)data;
+    (void)end;
+
+    // every stage must see all previous stages finished
+    int seen = __atomic_fetch_add(&chain->stage, 1, __ATOMIC_ACQ_REL);
+    chain->order[begin] = seen;
+    if (seen != begin)
+        __atomic_add_fetch(&chain->errors, 1, __ATOMIC_RELAXED);
+}
+
+/* ----- outside submitter ----- */
+
+typedef struct
+{
+    JobSystem* system;
+    JobCounter* counter;
+    int* hits;
+
+} SubmitterData;
+
+static void CountJob(void* data, int begin, int end)
+{
+    __atomic_add_fetch((int*)data, end - begin, __ATOMIC_RELAXED);
+}
+
+static void* SubmitterThread(void* arg)
+{
+    SubmitterData* s = (SubmitterData*)arg;
+    for (int i = 0; i < 500; ++i)
+        Job_Run(s->system, CountJob, s->hits, 0, 1, s->counter);
+    return NULL;
+}
+
+static int CheckSystem(JobSystem* system, const float* input, float* output, const float* reference, int count)
+{
+    int errors = 0;
+
+    // parallel_for against the serial result
+    KernelData k = { input, output };
+    memset(output, 0, sizeof(float) * count);
+    Job_ParallelFor(system, count, 0, Kernel, &k);
+    for (int i = 0; i < count; ++i)
+        errors += (output[i] != reference[i]);
+
+    // 2^10 leaves spawned recursively from inside jobs
+    int leaves = 0;
+    TreeData root = { system, 10, &leaves };
+    JobCounter counter;
+    JobCounter_Create(&counter);
+    Job_Run(system, TreeJob, &root, 0, 1, &counter);
+    Job_Wait(system, &counter);
+    errors += (leaves != 1024);
+
+    // A -> B -> C through Job_RunAfter
+    for (int round = 0; round < 100; ++round)
+    {
+        ChainData chain;
+        memset(&chain, 0, sizeof(chain));
+        JobCounter a, b, c;
+        JobCounter_Create(&a);
+        JobCounter_Create(&b);
+        JobCounter_Create(&c);
+
+        Job_Run(system, ChainStage, &chain, 0, 1, &a);
+        Job_RunAfter(system, &a, ChainStage, &chain, 1, 2, &b);
+        Job_RunAfter(system, &b, ChainStage, &chain, 2, 3, &c);
+        Job_Wait(system, &c);
+        Job_Wait(system, &b);
+        Job_Wait(system, &a);
+        errors += chain.errors;
+    }
+
+    // jobs submitted from a thread that is not a worker
+    int hits = 0;
+    JobCounter outside;
+    JobCounter_Create(&outside);
+    SubmitterData s = { system, &outside, &hits };
+    Thread submitter;
+    Thread_Create(&submitter, SubmitterThread, &s);
+    Thread_Join(&submitter);
+    Job_Wait(system, &outside);
+    errors += (__atomic_load_n(&hits, __ATOMIC_RELAXED) != 500);
+
+    return errors;
+}
+
+int main(int argc, char** argv)
+{
+    int count = (argc > 1) ? atoi(argv[1]) : 4000000;
+    int max_threads = (argc > 2) ? atoi(argv[2]) : Thread_HardwareConcurrency();
+
+    if (count < 1 || max_threads < 1)
+        return -1;
+
+    float* input = (float*)malloc(sizeof(float) * count);
+    float* output = (float*)malloc(sizeof(float) * count);
+    float* reference = (float*)malloc(sizeof(float) * count);
+    if (!input || !output || !reference)
+        return -1;
+
+    for (int i = 0; i < count; ++i)
+        input[i] = (float)(i % 10000) * 0.01f;
+
+    // best of five like the threaded runs, the first pass also faults the output pages in
+    KernelData k = { input, reference };
+    double start, serial = 1e30;
+    for (int rep = 0; rep < 5; ++rep)
+    {
+        start = Bench_Now();
+        Kernel(&k, 0, count);
+        double elapsed = Bench_Now() - start;
+        serial = (elapsed < serial) ? elapsed : serial;
+    }
+
+    printf("elements: %d | cores: %d | serial: %.2f ms\n", count, Thread_HardwareConcurrency(), serial * 1000.0);
+
+    int failures = 0;
+    for (int threads = 1; threads <= max_threads; )
+    {
+        JobSystem system;
+        if (!Job_Create(&system, threads))
+            return -1;
+
+        int errors = CheckSystem(&system, input, output, reference, count);
+        failures += errors;
+
+        KernelData run = { input, output };
+        double best = 1e30;
+        for (int rep = 0; rep < 5; ++rep)
+        {
+            start = Bench_Now();
+            Job_ParallelFor(&system, count, 0, Kernel, &run);
+            double elapsed = Bench_Now() - start;
+            best = (elapsed < best) ? elapsed : best;
+        }
+
+        printf("threads %2d: %8.2f ms | speedup %5.2fx | checks %s\n", threads, best * 1000.0, serial / best, errors ? "FAILED" : "ok");
+        Job_Delete(&system);
+
+        // powers of two, then the requested maximum
+        threads = (threads < max_threads && threads * 2 > max_threads) ? max_threads : threads * 2;
+    }
+
+    free(input);
+    free(output);
+    free(reference);
+
+    return failures == 0 ? 0 : -1;
+}
@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <stdlib.h>
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include "headless_utility.h"
+#include "readback_utility.h"
+#include "bench_common.h"
+
+// Reads back every frame of an offscreen render: synchronous glReadPixels against the PBO ring
+// with 1..4 slots, reporting ms/frame, throughput and how often a capture had to wait. Every frame
+// is cleared to a colour encoding its number, which the receiving side checks. Finally a few frames
+// go through the writer thread as PNG and one is loaded back with stb_image.
+// Needs EGL (runs on llvmpipe without a display).
+//
+// usage: readback_bench [width] [height] [frames] [output_prefix]
+
+typedef struct
+{
+    uint64_t received;
+    uint64_t mismatches;
+
+} FrameCheck;
+
+static void DrawFrame(uint64_t frame, int width, int height)
+{
+    glDisable(GL_SCISSOR_TEST);
+    glClearColor((float)(frame & 0xFF) / 255.0f, (float)((frame >> 8) & 0xFF) / 255.0f, 0.5f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // a moving bar so consecutive frames differ across the image, not just in the corner we check
+    glEnable(GL_SCISSOR_TEST);
+    glScissor((int)(frame * 8 % (uint64_t)width), height / 4, width / 8, height / 2);
+    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDisable(GL_SCISSOR_TEST);
+}
+
+static bool CheckPixel(const uint8_t* pixels, uint64_t frame)
+{
+    // bottom left pixel, rounding may differ by one step between drivers
+    return abs((int)pixels[0] - (int)(frame & 0xFF)) <= 1 && abs((int)pixels[1] - (int)((frame >> 8) & 0xFF)) <= 1;
+}
+
+static void CheckFrame(void* user, const ReadbackImage* image)
+{
+    FrameCheck* check = (FrameCheck*)user;
+    check->received += 1;
+    check->mismatches += !CheckPixel(image->pixels, image->frame);
+}
+
+int main(int argc, char** argv)
+{
+    int width = (argc > 1) ? atoi(argv[1]) : 1920;
+    int height = (argc > 2) ? atoi(argv[2]) : 1080;
+    int frames = (argc > 3) ? atoi(argv[3]) : 240;
+    const char* prefix = (argc > 4) ? argv[4] : "/tmp/readback_bench";
+
+    if (width < 1 || height < 1 || frames < 1)
+        return -1;
+
+    HeadlessContext ctx;
+    if (!Headless_Create(&ctx, width, height))
+        return -1;
+
+    double megabytes = (double)width * height * 4 / (1024.0 * 1024.0);
+    printf("%dx%d, %d frames, %.1f MB per frame\n", width, height, frames, megabytes);
+
+    int failures = 0;
+
+    // synchronous: the CPU waits for every frame before rendering the next
+    {
+        uint8_t* pixels = (uint8_t*)malloc((size_t)width * height * 4);
+        uint64_t mismatches = 0;
+
+        double start = Bench_Now();
+        for (int frame = 0; frame < frames; ++frame)
+        {
+            DrawFrame((uint64_t)frame, width, height);
+            glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+            mismatches += !CheckPixel(pixels, (uint64_t)frame);
+        }
+        double elapsed = Bench_Now() - start;
+
+        failures += mismatches != 0;
+        printf("glReadPixels:  %7.3f ms/frame | %8.1f MB/s | %s\n", elapsed * 1000.0 / frames,
+               megabytes * frames / elapsed, mismatches == 0 ? "ok" : "FAILED");
+        free(pixels);
+    }
+
+    for (int slots = 1; slots <= 4; ++slots)
+    {
+        ReadbackRing ring;
+        FrameCheck check = { 0, 0 };
+        if (!ReadbackRing_Create(&ring, slots, width, height))
+            return -1;
+        ReadbackRing_SetCallback(&ring, CheckFrame, &check);
+
+        double start = Bench_Now();
+        for (int frame = 0; frame < frames; ++frame)
+        {
+            DrawFrame((uint64_t)frame, width, height);
+            ReadbackRing_Capture(&ring, 0, 0, width, height, (uint64_t)frame);
+            ReadbackRing_Poll(&ring);
+        }
+        ReadbackRing_Flush(&ring);
+        double elapsed = Bench_Now() - start;
+
+        bool ok = check.received == (uint64_t)frames && check.mismatches == 0;
+        failures += !ok;
+        printf("PBO ring x%d:  %7.3f ms/frame | %8.1f MB/s | stalls %4llu | %s\n", slots, elapsed * 1000.0 / frames,
+               megabytes * frames / elapsed, (unsigned long long)ring.stalls, ok ? "ok" : "FAILED");
+
+        ReadbackRing_Delete(&ring);
+    }
+
+    // writer thread, PNG
+    {
+        int written_frames = frames < 16 ? frames : 16;
+        ReadbackRing ring;
+        ReadbackWriter writer;
+        if (!ReadbackRing_Create(&ring, 3, width, height) || !ReadbackWriter_Create(&writer, prefix, IMAGE_FORMAT_PNG, 4))
+            return -1;
+        ReadbackRing_SetWriter(&ring, &writer);
+
+        double start = Bench_Now();
+        for (int frame = 0; frame < written_frames; ++frame)
+        {
+            DrawFrame((uint64_t)frame, width, height);
+            ReadbackRing_Capture(&ring, 0, 0, width, height, (uint64_t)frame);
+            ReadbackRing_Poll(&ring);
+        }
+        ReadbackRing_Flush(&ring);
+        ReadbackWriter_WaitIdle(&writer);
+        double elapsed = Bench_Now() - start;
+
+        // the PNG is top row first: the checked pixel is now in the last row
+        char path[320];
+        snprintf(path, sizeof(path), "%s_%06d.png", prefix, written_frames - 1);
+        int w = 0, h = 0, channels = 0;
+        uint8_t* loaded = stbi_load(path, &w, &h, &channels, 4);
+        bool ok = writer.written == (uint64_t)written_frames && loaded && w == width && h == height &&
+                  CheckPixel(loaded + (size_t)(h - 1) * w * 4, (uint64_t)(written_frames - 1));
+        failures += !ok;
+
+        printf("PNG writer:    %7.3f ms/frame | %8.1f MB/s | %llu files (%s_*.png) | %s\n", elapsed * 1000.0 / written_frames,
+               megabytes * written_frames / elapsed, (unsigned long long)writer.written, prefix, ok ? "ok" : "FAILED");
+
+        if (loaded)
+            stbi_image_free(loaded);
+        ReadbackWriter_Delete(&writer);
+        ReadbackRing_Delete(&ring);
+    }
+
+    Headless_Destroy(&ctx);
+    return failures == 0 ? 0 : -1;
+}
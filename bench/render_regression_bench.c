@@ -0,0 +1,412 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "window_utility.h"
+#include "mesh_utility.h"
+#include "model_utility.h"
+#include "shader_utility.h"
+#include "colour_utility.h"
+#include "readback_utility.h"
+#include "gl_stats_utility.h"
+#include "bench_common.h"
+
+// Golden-image and performance regression run. Renders canned scenes headless (the shapes from
+// mesh_utility.h, the lighting shaders, a textured OBJ model), compares the last frame of each against
+// bench/golden/<scene>.png with a per-channel tolerance, and writes frame times, draw calls and GL
+// call counts to a JSON report. Exits non-zero when an image differs or a golden is missing.
+// On a mismatch <scene>_actual.png and <scene>_diff.png are written next to the report.
+//
+// Goldens are recorded with llvmpipe; re-record them with --update after an intended change.
+//
+// usage: render_regression_bench [frames] [report.json] [--update]
+
+#define REGRESSION_WIDTH        320
+#define REGRESSION_HEIGHT       180
+#define REGRESSION_TOLERANCE    8       // per channel, absorbs rasteriser and driver rounding
+#define REGRESSION_MAX_BAD      0.002   // fraction of pixels allowed above the tolerance
+#define REGRESSION_GOLDEN_DIR   "bench/golden"
+#define REGRESSION_MODEL        "bench/models/torus.obj"
+
+typedef struct
+{
+    Arena arena;
+    Mesh shapes[6];     // triangle, rectangle, circle, cube, sphere, dome
+    Mesh model;         // REGRESSION_MODEL through the OBJ loader
+    Shader flat;        // vertex.glsl + fragment.glsl, no features
+    Shader lit;         // lighting_vertex.glsl + lighting_fragment.glsl
+    Shader textured;    // vertex.glsl + fragment.glsl with texture and lighting
+    Texture checker;
+
+    Matrix4 projection;
+    Matrix4 view;
+    Vector3 eye;
+
+} Scenes;
+
+typedef void (*SceneDraw)(Scenes* scenes);
+
+typedef struct
+{
+    const char* name;
+    SceneDraw draw;
+
+    // results
+    double frame_avg_ms, frame_min_ms, frame_max_ms;
+    GLStats stats;          // one frame
+    int bad_pixels;
+    int max_diff;
+    const char* status;
+
+} SceneResult;
+
+static Matrix4 ModelMatrix(Vector3 position, float angle, Vector3 axis, float scale)
+{
+    Matrix4 trs = Math_Mat4Multiply(Math_Mat4Rotate(angle, axis), Math_Mat4Scale((Vector3){ scale, scale, scale }));
+    return Math_Mat4Multiply(Math_Mat4Translate(position), trs);
+}
+
+static void SetCamera(Scenes* s, Shader* shader)
+{
+    Shader_SetUniformMat4(shader, "uProjection", s->projection);
+    Shader_SetUniformMat4(shader, "uView", s->view);
+    Shader_SetUniform3f(shader, "viewPos", s->eye);
+}
+
+static void DrawShapes(Scenes* s)
+{
+    const Vector4 colours[6] = { Colour_Red, Colour_Orange, Colour_Gold, Colour_Lime, Colour_SkyBlue, Colour_Violet };
+
+    Window_Clear(Colour_DarkGray);
+    Shader_Enable(&s->flat);
+    SetCamera(s, &s->flat);
+
+    for (int i = 0; i < 6; ++i)
+    {
+        Vector3 position = { -2.4f + 2.4f * (float)(i % 3), (i < 3) ? 1.2f : -1.2f, 0.0f };
+        float scale = (i < 3) ? 1.6f : 0.9f;    // the 2D shapes are unit sized, the 3D ones radius 1
+        Shader_SetUniformMat4(&s->flat, "uModel", ModelMatrix(position, 0.6f, (Vector3){ 1.0f, 1.0f, 0.0f }, scale));
+        Shader_SetUniform4f(&s->flat, "uColor", colours[i]);
+        Mesh_Draw(&s->shapes[i]);
+    }
+}
+
+static void DrawLighting(Scenes* s)
+{
+    Window_Clear(Colour_Black);
+    Shader_Enable(&s->lit);
+    SetCamera(s, &s->lit);
+
+    // a row of spheres and cubes under the shader's fixed point light
+    for (int i = 0; i < 5; ++i)
+    {
+        Vector3 position = { -3.0f + 1.5f * (float)i, (i & 1) ? -0.8f : 0.8f, 0.0f };
+        Mesh* mesh = (i & 1) ? &s->shapes[3] : &s->shapes[4];
+        Shader_SetUniformMat4(&s->lit, "uModel", ModelMatrix(position, 0.4f * (float)i, (Vector3){ 0.0f, 1.0f, 0.0f }, 0.7f));
+        Shader_SetUniform4f(&s->lit, "uColor", (i & 1) ? Colour_Bronze : Colour_Teal);
+        Mesh_Draw(mesh);
+    }
+}
+
+static void DrawTextured(Scenes* s)
+{
+    Window_Clear(Colour_Navy);
+    Shader_Enable(&s->textured);
+    SetCamera(s, &s->textured);
+    Shader_SetUniform3f(&s->textured, "lightPos", (Vector3){ 4.0f, 4.0f, 4.0f });
+    Shader_SetUniform3f(&s->textured, "lightColor", (Vector3){ 0.5f, 0.5f, 0.5f });
+    Shader_SetUniform1i(&s->textured, "uTexture", 0);
+    Texture_Enable(&s->checker, 0);
+
+    // the model twice, tilted differently, so both faces of the torus are covered
+    Shader_SetUniform4f(&s->textured, "uColor", Colour_White);
+    Shader_SetUniformMat4(&s->textured, "uModel", ModelMatrix((Vector3){ -1.5f, 0.0f, 0.0f }, 1.1f, (Vector3){ 1.0f, 0.0f, 0.0f }, 1.1f));
+    Mesh_Draw(&s->model);
+    Shader_SetUniformMat4(&s->textured, "uModel", ModelMatrix((Vector3){ 1.5f, 0.0f, 0.0f }, 0.5f, (Vector3){ 1.0f, 1.0f, 0.0f }, 1.1f));
+    Mesh_Draw(&s->model);
+
+    Texture_Disable();
+}
+
+static bool Scenes_Create(Scenes* s)
+{
+    memset(s, 0, sizeof(Scenes));
+    s->arena = Arena_Create(4 * 1024 * 1024);
+
+    Mesh_CreateTriangle(&s->shapes[0], &s->arena);
+    Mesh_CreateRectangle(&s->shapes[1], &s->arena);
+    Mesh_CreateCircle(&s->shapes[2], 0.5f, 48, &s->arena);
+    Mesh_CreateCube(&s->shapes[3], &s->arena);
+    Mesh_CreateSphere(&s->shapes[4], 1.0f, 24, 32, &s->arena);
+    Mesh_CreateDome(&s->shapes[5], 1.0f, 16, 32, &s->arena);
+    for (int i = 0; i < 6; ++i)
+        Mesh_Upload(&s->shapes[i]);
+
+    Mesh_CreateModel(&s->model, REGRESSION_MODEL, &s->arena);
+    if (!s->model.initialized)
+    {
+        printf("Failed to load %s (run from the repository root)\n", REGRESSION_MODEL);
+        return false;
+    }
+    Mesh_Upload(&s->model);
+
+    Shader_CreatePermutation(&s->flat, "shaders/vertex.glsl", "shaders/fragment.glsl", 0);
+    Shader_Create(&s->lit, "shaders/lighting_vertex.glsl", "shaders/lighting_fragment.glsl");
+    Shader_CreatePermutation(&s->textured, "shaders/vertex.glsl", "shaders/fragment.glsl", SHADER_FEATURE_TEXTURE | SHADER_FEATURE_LIGHTING);
+    if (!s->flat.program || !s->lit.program || !s->textured.program)
+    {
+        printf("Failed to build the regression shaders (run from the repository root)\n");
+        return false;
+    }
+
+    // 8x8 checker with a colour ramp, generated so the run needs no asset files
+    const int size = 128;
+    unsigned char* pixels = (unsigned char*)malloc((size_t)size * size * 4);
+    for (int y = 0; y < size; ++y)
+    {
+        for (int x = 0; x < size; ++x)
+        {
+            unsigned char* p = pixels + ((size_t)y * size + x) * 4;
+            bool dark = ((x / 16) + (y / 16)) & 1;
+            p[0] = (unsigned char)(dark ? 40 : 120 + x);
+            p[1] = (unsigned char)(dark ? 40 : 120 + y);
+            p[2] = (unsigned char)(dark ? 90 : 230);
+            p[3] = 255;
+        }
+    }
+
+    s->checker.params = Texture_DefaultParams();
+    s->checker.width = size;
+    s->checker.height = size;
+    s->checker.bits_per_pixel = 4;
+    s->checker.path = String_Create(32, "checker", NULL);
+    Texture_Upload(&s->checker, pixels);
+    free(pixels);
+
+    s->eye = (Vector3){ 0.0f, 0.0f, 7.0f };
+    s->projection = Math_GetProjMatrix(Math_DegToRad(45.0f), (float)REGRESSION_WIDTH / REGRESSION_HEIGHT, 0.1f, 100.0f);
+    s->view = Math_Mat4Translate((Vector3){ -s->eye.x, -s->eye.y, -s->eye.z });
+
+    return true;
+}
+
+static void Scenes_Delete(Scenes* s)
+{
+    for (int i = 0; i < 6; ++i)
+        Mesh_Delete(&s->shapes[i]);
+    Mesh_Delete(&s->model);
+    Shader_Delete(&s->flat);
+    Shader_Delete(&s->lit);
+    Shader_Delete(&s->textured);
+    Texture_Delete(&s->checker);
+    Arena_Free(&s->arena);
+}
+
+static void CopyFrame(void* user, const ReadbackImage* image)
+{
+    memcpy(user, image->pixels, (size_t)image->width * image->height * 4);
+}
+
+// Compares GL ordered (bottom row first) pixels against a top-down golden
+static void CompareImages(SceneResult* result, const uint8_t* actual, const uint8_t* golden, uint8_t* diff)
+{
+    result->bad_pixels = 0;
+    result->max_diff = 0;
+
+    for (int y = 0; y < REGRESSION_HEIGHT; ++y)
+    {
+        const uint8_t* a = actual + (size_t)(REGRESSION_HEIGHT - 1 - y) * REGRESSION_WIDTH * 4;
+        const uint8_t* g = golden + (size_t)y * REGRESSION_WIDTH * 4;
+        uint8_t* d = diff + (size_t)(REGRESSION_HEIGHT - 1 - y) * REGRESSION_WIDTH * 4;
+
+        for (int x = 0; x < REGRESSION_WIDTH * 4; x += 4)
+        {
+            int worst = 0;
+            for (int c = 0; c < 3; ++c)
+            {
+                int delta = abs((int)a[x + c] - (int)g[x + c]);
+                worst = delta > worst ? delta : worst;
+            }
+
+            result->max_diff = worst > result->max_diff ? worst : result->max_diff;
+            result->bad_pixels += worst > REGRESSION_TOLERANCE;
+
+            // differences in red, amplified, over a dimmed copy of the golden
+            uint8_t amplified = (uint8_t)(worst * 8 > 255 ? 255 : worst * 8);
+            d[x + 0] = worst > REGRESSION_TOLERANCE ? 255 : amplified;
+            d[x + 1] = (uint8_t)(g[x + 1] / 4);
+            d[x + 2] = (uint8_t)(g[x + 2] / 4);
+            d[x + 3] = 255;
+        }
+    }
+}
+
+static void WriteReport(const char* path, const char* renderer, int frames, const SceneResult* results, int count)
+{
+    FILE* file = fopen(path, "w");
+    if (!file)
+    {
+        printf("Failed to write report %s\n", path);
+        return;
+    }
+
+    fprintf(file, "{\n  \"renderer\": \"%s\",\n  \"width\": %d,\n  \"height\": %d,\n  \"frames\": %d,\n  \"tolerance\": %d,\n  \"scenes\": [\n",
+            renderer, REGRESSION_WIDTH, REGRESSION_HEIGHT, frames, REGRESSION_TOLERANCE);
+
+    for (int i = 0; i < count; ++i)
+    {
+        const SceneResult* r = &results[i];
+        fprintf(file, "    {\n      \"name\": \"%s\",\n      \"status\": \"%s\",\n", r->name, r->status);
+        fprintf(file, "      \"frame_ms\": { \"avg\": %.4f, \"min\": %.4f, \"max\": %.4f },\n", r->frame_avg_ms, r->frame_min_ms, r->frame_max_ms);
+        fprintf(file, "      \"draw_calls\": %llu,\n      \"vertices\": %llu,\n", (unsigned long long)r->stats.draws, (unsigned long long)r->stats.vertices);
+        fprintf(file, "      \"gl_calls\": { \"total\": %llu, \"state\": %llu, \"uniforms\": %llu, \"uniform_lookups\": %llu, \"uploads\": %llu, \"clears\": %llu },\n",
+                (unsigned long long)r->stats.calls, (unsigned long long)r->stats.state, (unsigned long long)r->stats.uniforms,
+                (unsigned long long)r->stats.queries, (unsigned long long)r->stats.uploads, (unsigned long long)r->stats.clears);
+        fprintf(file, "      \"bad_pixels\": %d,\n      \"max_diff\": %d\n    }%s\n", r->bad_pixels, r->max_diff, i + 1 < count ? "," : "");
+    }
+
+    fprintf(file, "  ]\n}\n");
+    fclose(file);
+}
+
+int main(int argc, char** argv)
+{
+    int frames = 60;
+    const char* report = "render_report.json";
+    bool update = false;
+
+    for (int i = 1, positional = 0; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--update") == 0)
+            update = true;
+        else if (positional++ == 0)
+            frames = atoi(argv[i]);
+        else
+            report = argv[i];
+    }
+
+    if (frames < 1)
+        return -1;
+
+    Window window;
+    if (!Window_CreateEx(&window, REGRESSION_WIDTH, REGRESSION_HEIGHT, 45.0f, "render_regression", WINDOW_MODE_HEADLESS))
+        return -1;
+    Window_EnableDepthTest();
+
+    Scenes scenes;
+    if (!Scenes_Create(&scenes))
+        return -1;
+
+    ReadbackRing ring;
+    uint8_t* actual = (uint8_t*)malloc((size_t)REGRESSION_WIDTH * REGRESSION_HEIGHT * 4);
+    uint8_t* diff = (uint8_t*)malloc((size_t)REGRESSION_WIDTH * REGRESSION_HEIGHT * 4);
+    ReadbackRing_Create(&ring, 1, REGRESSION_WIDTH, REGRESSION_HEIGHT);
+    ReadbackRing_SetCallback(&ring, CopyFrame, actual);
+
+    // the report sits next to the failure images
+    char out_dir[256] = ".";
+    const char* slash = strrchr(report, '/');
+    if (slash)
+        snprintf(out_dir, sizeof(out_dir), "%.*s", (int)(slash - report), report);
+
+    SceneResult results[] = {
+        { "shapes",   DrawShapes },
+        { "lighting", DrawLighting },
+        { "textured", DrawTextured },
+    };
+    const int count = (int)(sizeof(results) / sizeof(results[0]));
+
+    char renderer[128];
+    snprintf(renderer, sizeof(renderer), "%s", (const char*)glGetString(GL_RENDERER));
+
+    GLStats_Install();
+
+    int failures = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        SceneResult* r = &results[i];
+        r->frame_min_ms = 1e30;
+
+        // first frame outside the timings: shader and texture first use
+        r->draw(&scenes);
+        glFinish();
+
+        double total = 0.0;
+        for (int frame = 0; frame < frames; ++frame)
+        {
+            GLStats_Reset();
+            double start = Bench_Now();
+            r->draw(&scenes);
+            Window_SwapBuffers(window);
+            glFinish();
+            double ms = (Bench_Now() - start) * 1000.0;
+
+            total += ms;
+            r->frame_min_ms = ms < r->frame_min_ms ? ms : r->frame_min_ms;
+            r->frame_max_ms = ms > r->frame_max_ms ? ms : r->frame_max_ms;
+            r->stats = GLStats_Get();
+        }
+        r->frame_avg_ms = total / frames;
+
+        ReadbackRing_Capture(&ring, 0, 0, REGRESSION_WIDTH, REGRESSION_HEIGHT, (uint64_t)i);
+        ReadbackRing_Flush(&ring);
+
+        char golden_path[256];
+        snprintf(golden_path, sizeof(golden_path), "%s/%s.png", REGRESSION_GOLDEN_DIR, r->name);
+
+        if (update)
+        {
+            r->status = Image_WritePNG(golden_path, actual, REGRESSION_WIDTH, REGRESSION_HEIGHT, true) ? "updated" : "failed";
+            failures += strcmp(r->status, "updated") != 0;
+        }
+        else
+        {
+            int w = 0, h = 0, channels = 0;
+            stbi_set_flip_vertically_on_load(false);
+            unsigned char* golden = stbi_load(golden_path, &w, &h, &channels, 4);
+
+            if (!golden || w != REGRESSION_WIDTH || h != REGRESSION_HEIGHT)
+            {
+                r->status = "missing";
+                r->bad_pixels = REGRESSION_WIDTH * REGRESSION_HEIGHT;
+            }
+            else
+            {
+                CompareImages(r, actual, golden, diff);
+                r->status = (r->bad_pixels <= (int)(REGRESSION_MAX_BAD * REGRESSION_WIDTH * REGRESSION_HEIGHT)) ? "pass" : "fail";
+            }
+
+            if (strcmp(r->status, "pass") != 0)
+            {
+                char path[320];
+                snprintf(path, sizeof(path), "%s/%s_actual.png", out_dir, r->name);
+                Image_WritePNG(path, actual, REGRESSION_WIDTH, REGRESSION_HEIGHT, true);
+                if (golden)
+                {
+                    snprintf(path, sizeof(path), "%s/%s_diff.png", out_dir, r->name);
+                    Image_WritePNG(path, diff, REGRESSION_WIDTH, REGRESSION_HEIGHT, true);
+                }
+                failures += 1;
+            }
+
+            if (golden)
+                stbi_image_free(golden);
+        }
+
+        printf("%-10s %-8s | %7.3f ms/frame (min %7.3f) | draws %3llu | GL calls %4llu | bad pixels %6d (max diff %3d)\n",
+               r->name, r->status, r->frame_avg_ms, r->frame_min_ms, (unsigned long long)r->stats.draws,
+               (unsigned long long)r->stats.calls, r->bad_pixels, r->max_diff);
+    }
+
+    GLStats_Uninstall();
+    WriteReport(report, renderer, frames, results, count);
+    printf("report: %s\n", report);
+
+    ReadbackRing_Delete(&ring);
+    free(actual);
+    free(diff);
+    Scenes_Delete(&scenes);
+    Window_Delete();
+
+    return failures == 0 ? 0 : -1;
+}
@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "scene_utility.h"
+#include "bench_common.h"
+
+// Builds a scene of N nodes (a few roots, each node with up to `fanout` children) and compares a
+// full world matrix recompute against incremental updates where only a fraction of the nodes move.
+// The incremental result is checked against a full recompute at the end.
+//
+// usage: scene_graph_bench [node_count] [fanout] [dirty_percent]
+
+#define FRAMES 200
+
+static float RandomFloat(void)
+{
+    return (float)rand() / (float)RAND_MAX;
+}
+
+static void AnimateNode(Scene* scene, SceneNode node, int frame)
+{
+    float t = (float)frame * 0.01f + (float)node;
+    Scene_SetRotation(scene, node, Math_QuatRotate((Vector3){0.0f, 1.0f, 0.0f}, t));
+}
+
+int main(int argc, char** argv)
+{
+    int count = (argc > 1) ? atoi(argv[1]) : 50000;
+    int fanout = (argc > 2) ? atoi(argv[2]) : 4;
+    float dirty_percent = (argc > 3) ? (float)atof(argv[3]) : 1.0f;
+
+    if (count < 1 || fanout < 1)
+        return -1;
+
+    Scene scene;
+    if (!Scene_Create(&scene, count))
+        return -1;
+
+    srand(1234);
+    SceneNode* nodes = (SceneNode*)malloc(sizeof(SceneNode) * count);
+    if (!nodes)
+        return -1;
+
+    for (int i = 0; i < count; ++i)
+    {
+        SceneNode parent = (i < 8) ? SCENE_NO_NODE : nodes[(i - 8) / fanout];
+        nodes[i] = Scene_CreateNode(&scene, parent);
+        Scene_SetLocal(&scene, nodes[i], (Transform){
+            (Vector3){ RandomFloat() * 2.0f - 1.0f, RandomFloat(), RandomFloat() * 2.0f - 1.0f },
+            Math_QuatRotate((Vector3){0.0f, 0.0f, 1.0f}, RandomFloat() * 6.28f),
+            (Vector3){ 1.0f, 1.0f, 1.0f } });
+    }
+    Scene_Update(&scene);
+
+    int max_depth = 0;
+    for (int i = 0; i < scene.count; ++i)
+        max_depth = (scene.depth[i] > max_depth) ? scene.depth[i] : max_depth;
+
+    int moving = (int)((float)count * dirty_percent / 100.0f);
+    if (moving < 1)
+        moving = 1;
+
+    printf("nodes: %d | fanout: %d | depth: %d | moving per frame: %d (%.2f%%)\n", count, fanout, max_depth, moving, dirty_percent);
+
+    // full: every node recomputed every frame
+    double start = Bench_Now();
+    int full_updated = 0;
+    for (int frame = 0; frame < FRAMES; ++frame)
+    {
+        for (int i = 0; i < moving; ++i)
+            AnimateNode(&scene, nodes[(i * 7919) % count], frame);
+        Scene_MarkAllDirty(&scene);
+        full_updated = Scene_Update(&scene);
+    }
+    double full = (Bench_Now() - start) / FRAMES;
+
+    // incremental: only moved nodes and their subtrees; the moving set is random leaves and inner nodes
+    srand(99);
+    int* movers = (int*)malloc(sizeof(int) * moving);
+    if (!movers)
+        return -1;
+    for (int i = 0; i < moving; ++i)
+        movers[i] = rand() % count;
+
+    start = Bench_Now();
+    long incremental_updated = 0;
+    for (int frame = 0; frame < FRAMES; ++frame)
+    {
+        for (int i = 0; i < moving; ++i)
+            AnimateNode(&scene, nodes[movers[i]], frame);
+        incremental_updated += Scene_Update(&scene);
+    }
+    double incremental = (Bench_Now() - start) / FRAMES;
+
+    // single leaf: the best case for the dirty walk
+    start = Bench_Now();
+    for (int frame = 0; frame < FRAMES; ++frame)
+    {
+        AnimateNode(&scene, nodes[count - 1], frame);
+        Scene_Update(&scene);
+    }
+    double leaf = (Bench_Now() - start) / FRAMES;
+
+    // verify: incremental state must match a full recompute
+    Matrix4* incremental_world = (Matrix4*)malloc(sizeof(Matrix4) * count);
+    if (!incremental_world)
+        return -1;
+    for (int i = 0; i < count; ++i)
+        incremental_world[i] = Scene_GetWorld(&scene, nodes[i]);
+
+    Scene_MarkAllDirty(&scene);
+    Scene_Update(&scene);
+
+    float max_error = 0.0f;
+    for (int i = 0; i < count; ++i)
+    {
+        Matrix4 world = Scene_GetWorld(&scene, nodes[i]);
+        for (int k = 0; k < 16; ++k)
+        {
+            float error = fabsf(world.m[k] - incremental_world[i].m[k]);
+            max_error = (error > max_error) ? error : max_error;
+        }
+    }
+
+    printf("full:        %8.3f ms/frame (%d nodes)\n", full * 1000.0, full_updated);
+    printf("incremental: %8.3f ms/frame (%.0f nodes avg) | %.1fx\n", incremental * 1000.0, (double)incremental_updated / FRAMES, full / incremental);
+    printf("single leaf: %8.3f ms/frame\n", leaf * 1000.0);
+    printf("max error vs full: %g\n", max_error);
+
+    free(incremental_world);
+    free(movers);
+    free(nodes);
+    Scene_Delete(&scene);
+
+    return max_error < 1e-4f ? 0 : -1;
+}
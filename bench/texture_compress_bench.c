@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "texture_compress_utility.h"
+#include "bench_common.h"
+
+// Encodes one image to BC1/BC3/BC5/BC7 with 1..N threads, reporting throughput and PSNR
+// of the decoded result. Headless: encode and decode are pure CPU.
+//
+// usage: texture_compress_bench [image] [max_threads]
+// without an image a 1024x1024 synthetic gradient + noise image is used
+
+static unsigned char* SyntheticImage(int width, int height)
+{
+    unsigned char* pixels = (unsigned char*)malloc((size_t)width * height * 4);
+    if (!pixels)
+        return NULL;
+
+    srand(1234);
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            unsigned char* p = pixels + ((size_t)y * width + x) * 4;
+            float fx = (float)x / width, fy = (float)y / height;
+            int noise = rand() % 16;
+            p[0] = (unsigned char)(fx * 220.0f + noise);
+            p[1] = (unsigned char)(fy * 220.0f + noise);
+            p[2] = (unsigned char)(127.5f + 120.0f * sinf(fx * 20.0f) * cosf(fy * 13.0f));
+            p[3] = (unsigned char)(((x / 64 + y / 64) & 1) ? 255 : 96 + noise);
+        }
+    }
+
+    return pixels;
+}
+
+int main(int argc, char** argv)
+{
+    int width = 1024, height = 1024, channels = 0;
+    unsigned char* pixels = NULL;
+
+    if (argc > 1)
+        pixels = stbi_load(argv[1], &width, &height, &channels, 4);
+    else
+        pixels = SyntheticImage(width, height);
+
+    if (!pixels)
+    {
+        printf("Failed to load image: %s\n", (argc > 1) ? argv[1] : "(synthetic)");
+        return -1;
+    }
+
+    int max_threads = (argc > 2) ? atoi(argv[2]) : Thread_HardwareConcurrency();
+    if (max_threads < 1)
+        max_threads = 1;
+
+    const TextureFormat formats[] = { TEXTURE_FORMAT_BC1, TEXTURE_FORMAT_BC3, TEXTURE_FORMAT_BC5, TEXTURE_FORMAT_BC7 };
+    const char* names[] = { "BC1", "BC3", "BC5", "BC7" };
+    const int psnr_channels[] = { 3, 4, 2, 4 };
+
+    double megapixels = (double)width * height / 1e6;
+    printf("image: %dx%d (%.2f MP), RGBA8 %.2f MB\n", width, height, megapixels, megapixels * 4.0);
+
+    unsigned char* decoded = (unsigned char*)malloc((size_t)width * height * 4);
+
+    for (int f = 0; f < 4; ++f)
+    {
+        size_t size = TextureFormat_LevelSize(formats[f], width, height);
+        unsigned char* out = (unsigned char*)malloc(size);
+        if (!out || !decoded)
+            return -1;
+
+        for (int threads = 1; threads <= max_threads; threads *= 2)
+        {
+            double start = Bench_Now();
+            TextureCompress_Encode(formats[f], pixels, width, height, out, threads);
+            double elapsed = Bench_Now() - start;
+
+            printf("%s threads %2d: %8.2f ms | %7.1f MP/s\n", names[f], threads, elapsed * 1000.0, megapixels / elapsed);
+        }
+
+        TextureCompress_Decode(formats[f], out, width, height, decoded);
+        printf("%s size: %.2f MB (%.1f:1) | PSNR: %.2f dB\n\n", names[f], (double)size / 1e6,
+               (double)width * height * 4.0 / (double)size, TextureCompress_PSNR(pixels, decoded, width, height, psnr_channels[f]));
+
+        free(out);
+    }
+
+    free(decoded);
+    free(pixels);
+
+    return 0;
+}
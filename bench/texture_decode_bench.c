@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include "texture_loader_utility.h"
+#include "darray_utility.h"
+#include "bench_common.h"
+
+// Decodes every image in a directory with 1..N workers and reports the total load time.
+// Headless: only the TextureDecodePool is used, no GL context is created.
+//
+// usage: texture_decode_bench [directory] [max_workers]
+
+static bool HasImageExtension(const char* name)
+{
+    const char* ext = strrchr(name, '.');
+    if (!ext)
+        return false;
+
+    const char* known[] = { ".png", ".PNG", ".jpg", ".JPG", ".jpeg", ".JPEG", ".bmp", ".tga", ".hdr" };
+    for (size_t i = 0; i < sizeof(known) / sizeof(known[0]); ++i)
+    {
+        if (strcmp(ext, known[i]) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+int main(int argc, char** argv)
+{
+    const char* directory = (argc > 1) ? argv[1] : "assets/textures";
+    int max_workers = (argc > 2) ? atoi(argv[2]) : Thread_HardwareConcurrency();
+    if (max_workers < 1)
+        max_workers = 1;
+
+    DIR* dir = opendir(directory);
+    if (!dir)
+    {
+        printf("Failed to open directory: %s\n", directory);
+        return -1;
+    }
+
+    DArray paths = DArray_Create_T(String, 64, NULL);
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (!HasImageExtension(entry->d_name))
+            continue;
+
+        String path = String_Create(512, directory, NULL);
+        String_Append(&path, "/");
+        String_Append(&path, entry->d_name);
+        DArray_Push_T(String, &paths, path);
+    }
+    closedir(dir);
+
+    size_t image_count = DArray_Size(&paths);
+    if (image_count == 0)
+    {
+        printf("No images found in %s\n", directory);
+        DArray_Free(&paths);
+        return -1;
+    }
+
+    printf("Decoding %zu images from %s\n", image_count, directory);
+    printf("%8s %12s %12s %10s\n", "workers", "total (ms)", "MB decoded", "speedup");
+
+    double baseline = 0.0;
+
+    for (int workers = 1; workers <= max_workers; ++workers)
+    {
+        TextureDecodePool pool;
+        if (!TextureDecodePool_Create(&pool, workers))
+            return -1;
+
+        double start = Bench_Now();
+
+        for (size_t i = 0; i < image_count; ++i)
+            TextureDecodePool_Submit(&pool, DArray_Get_T(String, &paths, i).data, false, NULL, 0);
+
+        TextureDecodePool_WaitIdle(&pool);
+
+        double elapsed = Bench_Now() - start;
+
+        size_t bytes = 0;
+        DecodedImage* image;
+        while ((image = TextureDecodePool_Pop(&pool)) != NULL)
+        {
+            bytes += (size_t)image->width * (size_t)image->height * 4;
+            DecodedImage_Free(image);
+        }
+
+        TextureDecodePool_Delete(&pool);
+
+        if (workers == 1)
+            baseline = elapsed;
+
+        printf("%8d %12.2f %12.2f %9.2fx\n", workers, elapsed * 1000.0,
+               (double)bytes / (1024.0 * 1024.0), baseline / elapsed);
+    }
+
+    for (size_t i = 0; i < image_count; ++i)
+        String_Free((String*)DArray_Get(&paths, i));
+    DArray_Free(&paths);
+
+    return 0;
+}
@@ -0,0 +1,509 @@
+#ifndef ATLAS_UTILITY_H
+#define ATLAS_UTILITY_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "math_utility.h"
+#include "texture_utility.h"
+#include "mesh_utility.h"
+
+// Texture atlases: a skyline bottom-left rectangle packer (no GL) plus an Atlas that
+// packs whole images into one or more GL pages and hands out TextureRegions.
+
+/* -------------------------------------------------------------------------- */
+/*                                  PACKER                                    */
+/* -------------------------------------------------------------------------- */
+
+typedef struct
+{
+    int width, height;          // input: size in pixels, padding is added by the packer
+    int x, y;                   // output: min corner of the image inside its page (padding excluded)
+    int page;                   // output: page index, -1 if it could not be packed
+
+} AtlasRect;
+
+typedef struct
+{
+    int x, y, width;
+
+} SkylineNode;
+
+typedef struct
+{
+    SkylineNode* nodes;
+    int node_count;
+
+} SkylinePage;
+
+typedef struct
+{
+    int page_width, page_height;
+    int padding;                // border around every rect, filled by edge extrusion in Atlas
+    int max_pages;
+
+    SkylinePage* pages;
+    int page_count;
+
+} AtlasPacker;
+
+static inline bool AtlasPacker_Create(AtlasPacker* packer, int page_width, int page_height, int padding, int max_pages)
+{
+    packer->page_width = page_width;
+    packer->page_height = page_height;
+    packer->padding = padding;
+    packer->max_pages = (max_pages > 0) ? max_pages : 1;
+    packer->page_count = 0;
+
+    packer->pages = (SkylinePage*)calloc(packer->max_pages, sizeof(SkylinePage));
+    if (!packer->pages)
+    {
+        fprintf(stderr, "Failed to allocate atlas packer pages\n");
+        return false;
+    }
+
+    return true;
+}
+
+static inline void AtlasPacker_Delete(AtlasPacker* packer)
+{
+    for (int i = 0; i < packer->page_count; ++i)
+        free(packer->pages[i].nodes);
+
+    free(packer->pages);
+    packer->pages = NULL;
+    packer->page_count = 0;
+}
+
+static inline bool AtlasPacker_AddPage(AtlasPacker* packer)
+{
+    if (packer->page_count >= packer->max_pages)
+        return false;
+
+    SkylinePage* page = &packer->pages[packer->page_count];
+
+    // a skyline can never have more nodes than pixels across
+    page->nodes = (SkylineNode*)malloc(sizeof(SkylineNode) * (packer->page_width + 1));
+    if (!page->nodes)
+    {
+        fprintf(stderr, "Failed to allocate skyline for atlas page\n");
+        return false;
+    }
+
+    page->nodes[0] = (SkylineNode){0, 0, packer->page_width};
+    page->node_count = 1;
+    packer->page_count += 1;
+
+    return true;
+}
+
+// y at which a w wide rect fits when its left edge sits on node index, -1 if it does not fit
+static inline int Skyline_Fit(const SkylinePage* page, int index, int w, int h, int page_width, int page_height)
+{
+    int x = page->nodes[index].x;
+    if (x + w > page_width)
+        return -1;
+
+    int y = 0;
+    int remaining = w;
+
+    for (int i = index; remaining > 0 && i < page->node_count; ++i)
+    {
+        if (page->nodes[i].y > y)
+            y = page->nodes[i].y;
+        if (y + h > page_height)
+            return -1;
+        remaining -= page->nodes[i].width;
+    }
+
+    return y;
+}
+
+static inline void Skyline_Insert(SkylinePage* page, int index, int x, int y, int w, int h)
+{
+    memmove(&page->nodes[index + 1], &page->nodes[index], sizeof(SkylineNode) * (page->node_count - index));
+    page->nodes[index] = (SkylineNode){x, y + h, w};
+    page->node_count += 1;
+
+    // trim the nodes now covered by the new one
+    for (int i = index + 1; i < page->node_count; ++i)
+    {
+        SkylineNode* prev = &page->nodes[i - 1];
+        SkylineNode* node = &page->nodes[i];
+
+        if (node->x >= prev->x + prev->width)
+            break;
+
+        int shrink = prev->x + prev->width - node->x;
+        node->x += shrink;
+        node->width -= shrink;
+
+        if (node->width > 0)
+            break;
+
+        memmove(node, node + 1, sizeof(SkylineNode) * (page->node_count - i - 1));
+        page->node_count -= 1;
+        i -= 1;
+    }
+
+    // merge neighbours at the same height
+    for (int i = 0; i < page->node_count - 1; ++i)
+    {
+        if (page->nodes[i].y == page->nodes[i + 1].y)
+        {
+            page->nodes[i].width += page->nodes[i + 1].width;
+            memmove(&page->nodes[i + 1], &page->nodes[i + 2], sizeof(SkylineNode) * (page->node_count - i - 2));
+            page->node_count -= 1;
+            i -= 1;
+        }
+    }
+}
+
+// bottom-left heuristic: lowest top edge, then narrowest node
+static inline bool AtlasPacker_PackOnPage(AtlasPacker* packer, int page_index, AtlasRect* rect)
+{
+    SkylinePage* page = &packer->pages[page_index];
+    int w = rect->width + 2 * packer->padding;
+    int h = rect->height + 2 * packer->padding;
+
+    int best_index = -1, best_top = packer->page_height + 1, best_width = 0, best_y = 0;
+
+    for (int i = 0; i < page->node_count; ++i)
+    {
+        int y = Skyline_Fit(page, i, w, h, packer->page_width, packer->page_height);
+        if (y < 0)
+            continue;
+
+        if (y + h < best_top || (y + h == best_top && page->nodes[i].width < best_width))
+        {
+            best_index = i;
+            best_top = y + h;
+            best_width = page->nodes[i].width;
+            best_y = y;
+        }
+    }
+
+    if (best_index < 0)
+        return false;
+
+    int x = page->nodes[best_index].x;
+    Skyline_Insert(page, best_index, x, best_y, w, h);
+
+    rect->x = x + packer->padding;
+    rect->y = best_y + packer->padding;
+    rect->page = page_index;
+
+    return true;
+}
+
+// Online packing: places one rect, opening a new page when none of the existing ones fit
+static inline bool AtlasPacker_Add(AtlasPacker* packer, AtlasRect* rect)
+{
+    rect->page = -1;
+
+    if (rect->width + 2 * packer->padding > packer->page_width ||
+        rect->height + 2 * packer->padding > packer->page_height)
+    {
+        fprintf(stderr, "Atlas rect %dx%d does not fit a %dx%d page\n", rect->width, rect->height, packer->page_width, packer->page_height);
+        return false;
+    }
+
+    for (int i = 0; i < packer->page_count; ++i)
+    {
+        if (AtlasPacker_PackOnPage(packer, i, rect))
+            return true;
+    }
+
+    if (!AtlasPacker_AddPage(packer))
+        return false;
+
+    return AtlasPacker_PackOnPage(packer, packer->page_count - 1, rect);
+}
+
+static inline int AtlasPacker_CompareHeight(const void* a, const void* b)
+{
+    const AtlasRect* ra = *(const AtlasRect* const*)a;
+    const AtlasRect* rb = *(const AtlasRect* const*)b;
+
+    if (ra->height != rb->height)
+        return rb->height - ra->height;
+    return rb->width - ra->width;
+}
+
+// Offline packing: sorts by height (tallest first) which packs far tighter than arrival order.
+// rects keep their order, only x/y/page are written. Empty rects (0 wide or high) take no space
+// and stay unplaced with page -1. Returns the number of rects placed.
+static inline int AtlasPacker_PackAll(AtlasPacker* packer, AtlasRect* rects, int count)
+{
+    AtlasRect** order = (AtlasRect**)malloc(sizeof(AtlasRect*) * count);
+    if (!order)
+    {
+        fprintf(stderr, "Failed to allocate atlas sort buffer\n");
+        return 0;
+    }
+
+    int sorted = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        rects[i].page = -1;
+        if (rects[i].width > 0 && rects[i].height > 0)
+            order[sorted++] = &rects[i];
+    }
+
+    qsort(order, sorted, sizeof(AtlasRect*), AtlasPacker_CompareHeight);
+
+    int placed = 0;
+    for (int i = 0; i < sorted; ++i)
+    {
+        if (AtlasPacker_Add(packer, order[i]))
+            placed += 1;
+    }
+
+    free(order);
+    return placed;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   ATLAS                                    */
+/* -------------------------------------------------------------------------- */
+
+typedef struct
+{
+    Texture* texture;           // atlas page the region lives on, NULL when its image was not placed
+    Vector2 uv_min;
+    Vector2 uv_max;
+    int width, height;          // size in pixels
+
+} TextureRegion;
+
+typedef struct
+{
+    Texture* pages;
+    int page_count;
+
+    AtlasRect* rects;           // one per source image, in input order
+    TextureRegion* regions;     // UV remap table, one per source image
+    int count;
+
+    int page_width, page_height;
+
+} Atlas;
+
+// Blits src into page at (x, y) and extrudes its edge pixels into the padding so bilinear
+// filtering and the smaller mips sample the image's own colours instead of its neighbours'
+static inline void Atlas_Blit(unsigned char* page, int page_width, int page_height,
+                              const unsigned char* src, int w, int h, int x, int y, int padding)
+{
+    for (int row = -padding; row < h + padding; ++row)
+    {
+        int py = y + row;
+        if (py < 0 || py >= page_height)
+            continue;
+
+        int sy = (row < 0) ? 0 : ((row >= h) ? h - 1 : row);
+        const unsigned char* src_row = src + (size_t)sy * w * 4;
+        unsigned char* dst_row = page + (size_t)py * page_width * 4;
+
+        // the packer reserves the padding inside the page, so x - padding >= 0 always holds
+        for (int col = -padding; col < 0; ++col)
+            memcpy(dst_row + (size_t)(x + col) * 4, src_row, 4);
+
+        memcpy(dst_row + (size_t)x * 4, src_row, (size_t)w * 4);
+
+        for (int col = w; col < w + padding; ++col)
+            memcpy(dst_row + (size_t)(x + col) * 4, src_row + (size_t)(w - 1) * 4, 4);
+    }
+}
+
+static inline void Atlas_ComputeRegions(Atlas* atlas)
+{
+    for (int i = 0; i < atlas->count; ++i)
+    {
+        const AtlasRect* r = &atlas->rects[i];
+        TextureRegion* region = &atlas->regions[i];
+
+        region->texture = (r->page >= 0) ? &atlas->pages[r->page] : NULL;
+        region->width = r->width;
+        region->height = r->height;
+        region->uv_min = (Vector2){ (float)r->x / atlas->page_width, (float)r->y / atlas->page_height };
+        region->uv_max = (Vector2){ (float)(r->x + r->width) / atlas->page_width, (float)(r->y + r->height) / atlas->page_height };
+    }
+}
+
+static inline void Atlas_Delete(Atlas* atlas);
+
+static inline void Atlas_FreeImages(unsigned char** images, int count)
+{
+    for (int i = 0; images && i < count; ++i)
+    {
+        if (images[i])
+            stbi_image_free(images[i]);
+    }
+    free(images);
+}
+
+// Loads every image in paths, packs them onto page_size x page_size pages and uploads the pages.
+// params may be NULL for Texture_DefaultParams(); keep padding >= 2^(mip levels sampled) to avoid bleeding.
+// On failure everything is released and the atlas is left empty.
+static inline bool Atlas_Create(Atlas* atlas, const char** paths, int count, int page_size, int padding,
+                                bool flip_vert, const TextureParams* params)
+{
+    memset(atlas, 0, sizeof(Atlas));
+    atlas->page_width = page_size;
+    atlas->page_height = page_size;
+    atlas->count = count;
+
+    unsigned char** images = (unsigned char**)calloc(count, sizeof(unsigned char*));
+    atlas->rects = (AtlasRect*)calloc(count, sizeof(AtlasRect));
+    atlas->regions = (TextureRegion*)calloc(count, sizeof(TextureRegion));
+
+    if (!images || !atlas->rects || !atlas->regions)
+    {
+        fprintf(stderr, "Failed to allocate atlas tables\n");
+        free(images);
+        Atlas_Delete(atlas);
+        return false;
+    }
+
+    stbi_set_flip_vertically_on_load(flip_vert);
+    for (int i = 0; i < count; ++i)
+    {
+        int channels = 0;
+        images[i] = Image_Load(paths[i], &atlas->rects[i].width, &atlas->rects[i].height, &channels, 4);
+        if (!images[i])
+        {
+            // left out of the pages, its region has no texture
+            printf("Failed to load texture: %s\n", paths[i]);
+            atlas->rects[i].width = atlas->rects[i].height = 0;
+        }
+    }
+
+    AtlasPacker packer;
+    if (!AtlasPacker_Create(&packer, page_size, page_size, padding, count > 0 ? count : 1))
+    {
+        Atlas_FreeImages(images, count);
+        Atlas_Delete(atlas);
+        return false;
+    }
+
+    AtlasPacker_PackAll(&packer, atlas->rects, count);
+
+    int page_count = packer.page_count;
+    size_t page_bytes = (size_t)page_size * page_size * 4;
+    atlas->pages = (Texture*)calloc(page_count > 0 ? page_count : 1, sizeof(Texture));
+    unsigned char* page_pixels = (unsigned char*)malloc(page_bytes);
+    AtlasPacker_Delete(&packer);
+
+    if (!atlas->pages || !page_pixels)
+    {
+        fprintf(stderr, "Failed to allocate %d atlas pages\n", page_count);
+        free(page_pixels);
+        Atlas_FreeImages(images, count);
+        Atlas_Delete(atlas);
+        return false;
+    }
+    atlas->page_count = page_count;
+
+    for (int p = 0; p < atlas->page_count; ++p)
+    {
+        memset(page_pixels, 0, page_bytes);
+
+        for (int i = 0; i < count; ++i)
+        {
+            const AtlasRect* r = &atlas->rects[i];
+            if (images[i] && r->page == p)
+                Atlas_Blit(page_pixels, page_size, page_size, images[i], r->width, r->height, r->x, r->y, padding);
+        }
+
+        Texture* page = &atlas->pages[p];
+        page->path = String_Create(64, "atlas page", NULL);
+        page->local_buffer = NULL;
+        page->width = page_size;
+        page->height = page_size;
+        page->bits_per_pixel = 4;
+        page->params = params ? *params : Texture_DefaultParams();
+        Texture_Upload(page, page_pixels);
+    }
+
+    free(page_pixels);
+    Atlas_FreeImages(images, count);
+
+    Atlas_ComputeRegions(atlas);
+    return true;
+}
+
+static inline TextureRegion Atlas_GetRegion(const Atlas* atlas, int index)
+{
+    return atlas->regions[index];
+}
+
+// Writes the UV remap table as text: "index page u_min v_min u_max v_max width height"
+static inline bool Atlas_SaveTable(const Atlas* atlas, const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (!file)
+    {
+        printf("Failed to open file: %s\n", path);
+        return false;
+    }
+
+    for (int i = 0; i < atlas->count; ++i)
+    {
+        const TextureRegion* r = &atlas->regions[i];
+        fprintf(file, "%d %d %f %f %f %f %d %d\n", i, atlas->rects[i].page,
+                r->uv_min.x, r->uv_min.y, r->uv_max.x, r->uv_max.y, r->width, r->height);
+    }
+
+    fclose(file);
+    return true;
+}
+
+static inline void Atlas_Delete(Atlas* atlas)
+{
+    for (int i = 0; i < atlas->page_count; ++i)
+        Texture_Delete(&atlas->pages[i]);
+
+    free(atlas->pages);
+    free(atlas->rects);
+    free(atlas->regions);
+    memset(atlas, 0, sizeof(Atlas));
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              MESH / SPRITE HELPERS                         */
+/* -------------------------------------------------------------------------- */
+
+// Rewrites a mesh's 0..1 UVs into the region's sub-rectangle. Call before Mesh_Upload.
+static inline void Mesh_RemapUVs(Mesh* mesh, const TextureRegion* region)
+{
+    Vector2 size = Math_Vec2Sub(region->uv_max, region->uv_min);
+
+    for (size_t i = 0; i < DArray_Size(&mesh->vertices); ++i)
+    {
+        Vertex* v = (Vertex*)DArray_Get(&mesh->vertices, i);
+        v->uv.x = region->uv_min.x + v->uv.x * size.x;
+        v->uv.y = region->uv_min.y + v->uv.y * size.y;
+    }
+}
+
+// For shaders/sprite_vertex.glsl: binds the page and sets uUVRect (xy = min, zw = size).
+// False for a region that was never placed (its image failed to load or did not fit).
+static inline bool Shader_SetTextureRegion(Shader* shader, const TextureRegion* region, unsigned int slot)
+{
+    if (!region->texture)
+    {
+        printf("Shader_SetTextureRegion: region is not on an atlas page\n");
+        return false;
+    }
+
+    Texture_Enable(region->texture, slot);
+    Shader_SetUniform1i(shader, "uTexture", (int)slot);
+    Shader_SetUniform4f(shader, "uUVRect", (Vector4){ region->uv_min.x, region->uv_min.y,
+                                                      region->uv_max.x - region->uv_min.x,
+                                                      region->uv_max.y - region->uv_min.y });
+    return true;
+}
+
+#endif
@@ -7,6 +7,9 @@
 
 #include <stdbool.h>
 
+#define CAMERA_MOUSE_SENSITIVITY    0.003f  // radians per pixel of mouse look
+#define CAMERA_SCROLL_STEP          1.1f    // speed (3D) or zoom (2D) factor per scroll notch
+
 typedef struct
 {
     float speed;
@@ -154,6 +157,18 @@ static inline void Camera3D_Update(Window* window, Camera3D* camera, float dt)
     if (IsKeyPressed(window, GLFW_KEY_L))
         Camera3D_Yaw(camera, rotationAmt);
 
+    // Mouse look while the right button is held, scroll changes the fly speed
+    if (Input_MouseDown(GLFW_MOUSE_BUTTON_RIGHT))
+    {
+        Vector2 look = Input_CursorDelta();
+        Camera3D_Yaw(camera, look.x * CAMERA_MOUSE_SENSITIVITY);
+        Camera3D_Pitch(camera, -look.y * CAMERA_MOUSE_SENSITIVITY);
+    }
+
+    float scroll = Input_ScrollDelta().y;
+    if (scroll != 0.0f)
+        camera->speed *= powf(CAMERA_SCROLL_STEP, scroll);
+
     // // Roll
     // if (IsKeyPressed(window, GLFW_KEY_U))
     //     Camera3D_Roll(camera, -rotationAmt);
@@ -239,6 +254,10 @@ static inline void Camera2D_Update(const Window* window, Camera2D* cam, float dt
         if (IsKeyPressed(window, GLFW_KEY_E)) cam->zoom -= dt;       // zoom out
         if (cam->zoom < 0.1f) cam->zoom = 0.1f;                      // clamp
         if (IsKeyPressed(window, GLFW_KEY_Q)) cam->zoom += dt;       // zoom in
+
+        float scroll = Input_ScrollDelta().y;
+        if (scroll != 0.0f)
+            cam->zoom = fmaxf(0.1f, cam->zoom * powf(CAMERA_SCROLL_STEP, scroll));
     }
 
     // Optional: rotation controls
@@ -0,0 +1,595 @@
+#ifndef COMMAND_BUFFER_UTILITY_H
+#define COMMAND_BUFFER_UTILITY_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <glad/glad.h>
+#include "arena_utility.h"
+#include "math_utility.h"
+
+// Draw recording off the GL thread. A CommandList is a thread's private recording target: an arena
+// of packed commands (bind program, bind texture, bind vertex array, uniform block range, mat4
+// uniform, draw) grouped into packets, each packet with a 64 bit sort key. Commands only carry
+// object names and plain data, nothing GL specific happens while recording.
+//
+// Once the workers are done, the GL thread gives the lists to CommandQueue_Submit: the packets of
+// all lists are merged and radix sorted by key, the uniform data staged by every list is uploaded
+// in one buffer, and the commands are replayed in a single switch loop that skips redundant binds.
+//
+// One list per recording thread (Job_WorkerIndex makes a good index); lists are reset every frame.
+
+#define COMMAND_MAX_TEXTURE_UNITS   16
+#define COMMAND_UNIFORM_ALIGN       256     // largest GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT in the wild
+
+typedef enum
+{
+    CMD_BIND_PROGRAM = 1,
+    CMD_BIND_TEXTURE,
+    CMD_BIND_VERTEX_ARRAY,
+    CMD_UNIFORM_BLOCK,
+    CMD_UNIFORM_MAT4,
+    CMD_DRAW_ARRAYS,
+    CMD_DRAW_ELEMENTS,
+
+} CommandType;
+
+typedef struct
+{
+    uint16_t type;
+    uint16_t size;      // bytes to the next command, header included
+
+} CommandHeader;
+
+typedef struct { CommandHeader header; uint32_t program; } CmdBindProgram;
+typedef struct { CommandHeader header; uint32_t unit, target, texture; } CmdBindTexture;
+typedef struct { CommandHeader header; uint32_t vao; } CmdBindVertexArray;
+typedef struct { CommandHeader header; uint32_t binding, offset, size, list; } CmdUniformBlock;    // offset into the list's staging
+typedef struct { CommandHeader header; int32_t location; float m[16]; } CmdUniformMat4;
+typedef struct { CommandHeader header; uint32_t mode, first, count, instances; } CmdDrawArrays;
+typedef struct { CommandHeader header; uint32_t mode, count, type, offset, instances; int32_t base_vertex; } CmdDrawElements;
+
+typedef struct
+{
+    uint64_t key;
+    const uint8_t* commands;
+    uint32_t size;
+
+} CommandPacket;
+
+typedef struct
+{
+    Arena arena;            // commands and uniform staging
+    CommandPacket* packets;
+    uint32_t count;
+    uint32_t capacity;
+
+    uint8_t* uniforms;
+    uint32_t uniform_size;
+    uint32_t uniform_capacity;
+
+    uint32_t index;         // position in the queue, stamped into uniform block commands
+    const uint8_t* open;    // first command of the packet being recorded
+    uint32_t open_uniforms; // uniform_size when that packet began
+    bool dropped;           // the open packet lost a command and will be rolled back
+    bool overflow;          // some packet was dropped since the last reset
+
+} CommandList;
+
+// 8 bit layer, 16 bit program, 16 bit material, 24 bit depth: state changes sort away first
+static inline uint64_t CommandKey_Make(uint32_t layer, uint32_t program, uint32_t material, uint32_t depth)
+{
+    return ((uint64_t)(layer & 0xFF) << 56) | ((uint64_t)(program & 0xFFFF) << 40) |
+           ((uint64_t)(material & 0xFFFF) << 24) | (uint64_t)(depth & 0xFFFFFF);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 RECORDING                                  */
+/* -------------------------------------------------------------------------- */
+
+static inline bool CommandList_Create(CommandList* list, size_t command_bytes, uint32_t max_packets, uint32_t uniform_bytes)
+{
+    memset(list, 0, sizeof(CommandList));
+
+    list->arena = Arena_Create(command_bytes + sizeof(CommandPacket) * max_packets + uniform_bytes + 2 * COMMAND_UNIFORM_ALIGN);
+    if (!list->arena.start)
+    {
+        fprintf(stderr, "Failed to allocate command list\n");
+        return false;
+    }
+
+    list->packets = (CommandPacket*)Arena_Alloc(&list->arena, sizeof(CommandPacket) * max_packets);
+    list->capacity = max_packets;
+
+    // staging starts on an aligned boundary so list relative offsets stay aligned once rebased
+    uint8_t* raw = (uint8_t*)Arena_Alloc(&list->arena, uniform_bytes + COMMAND_UNIFORM_ALIGN);
+    list->uniforms = (uint8_t*)(((uintptr_t)raw + COMMAND_UNIFORM_ALIGN - 1) & ~(uintptr_t)(COMMAND_UNIFORM_ALIGN - 1));
+    list->uniform_capacity = uniform_bytes;
+
+    return true;
+}
+
+static inline void CommandList_Delete(CommandList* list)
+{
+    Arena_Free(&list->arena);
+    memset(list, 0, sizeof(CommandList));
+}
+
+// commands are recorded after the fixed tables, which survive the reset
+static inline void CommandList_Reset(CommandList* list)
+{
+    list->arena.current = list->uniforms + list->uniform_capacity;
+    list->count = 0;
+    list->uniform_size = 0;
+    list->open = NULL;
+    list->dropped = false;
+    list->overflow = false;
+}
+
+static inline void* CommandList_Alloc(CommandList* list, CommandType type, size_t size)
+{
+    size_t aligned = ALIGN_UP(size, alignment);
+    CommandHeader* header = (CommandHeader*)Arena_Alloc(&list->arena, aligned);
+    if (!header)
+    {
+        list->dropped = true;
+        list->overflow = true;
+        return NULL;
+    }
+
+    header->type = (uint16_t)type;
+    header->size = (uint16_t)aligned;
+    return header;
+}
+
+static inline void CommandList_Begin(CommandList* list, uint64_t key)
+{
+    list->open = (const uint8_t*)list->arena.current;
+    list->open_uniforms = list->uniform_size;
+    list->dropped = false;
+
+    if (list->count >= list->capacity)
+    {
+        list->dropped = true;
+        list->overflow = true;
+        return;
+    }
+
+    list->packets[list->count].key = key;
+}
+
+static inline void CommandList_End(CommandList* list)
+{
+    if (!list->open)
+        return;
+
+    // a packet that ran out of space is dropped whole and its space handed back, so the
+    // packets after it can still fit
+    if (list->dropped)
+    {
+        list->arena.current = (void*)list->open;
+        list->uniform_size = list->open_uniforms;
+    }
+    else
+    {
+        CommandPacket* packet = &list->packets[list->count++];
+        packet->commands = list->open;
+        packet->size = (uint32_t)((const uint8_t*)list->arena.current - list->open);
+    }
+    list->open = NULL;
+    list->dropped = false;
+}
+
+static inline void CommandList_BindProgram(CommandList* list, uint32_t program)
+{
+    CmdBindProgram* cmd = (CmdBindProgram*)CommandList_Alloc(list, CMD_BIND_PROGRAM, sizeof(CmdBindProgram));
+    if (cmd)
+        cmd->program = program;
+}
+
+static inline void CommandList_BindTexture(CommandList* list, uint32_t unit, uint32_t target, uint32_t texture)
+{
+    CmdBindTexture* cmd = (CmdBindTexture*)CommandList_Alloc(list, CMD_BIND_TEXTURE, sizeof(CmdBindTexture));
+    if (cmd)
+    {
+        cmd->unit = unit;
+        cmd->target = target;
+        cmd->texture = texture;
+    }
+}
+
+static inline void CommandList_BindVertexArray(CommandList* list, uint32_t vao)
+{
+    CmdBindVertexArray* cmd = (CmdBindVertexArray*)CommandList_Alloc(list, CMD_BIND_VERTEX_ARRAY, sizeof(CmdBindVertexArray));
+    if (cmd)
+        cmd->vao = vao;
+}
+
+// Copies size bytes into the list's uniform staging and binds that range to `binding` at replay
+static inline void CommandList_UniformBlock(CommandList* list, uint32_t binding, const void* data, uint32_t size)
+{
+    uint32_t offset = (uint32_t)ALIGN_UP((size_t)list->uniform_size, (size_t)COMMAND_UNIFORM_ALIGN);
+    if (offset + size > list->uniform_capacity)
+    {
+        list->dropped = true;
+        list->overflow = true;
+        return;
+    }
+
+    CmdUniformBlock* cmd = (CmdUniformBlock*)CommandList_Alloc(list, CMD_UNIFORM_BLOCK, sizeof(CmdUniformBlock));
+    if (!cmd)
+        return;
+
+    memcpy(list->uniforms + offset, data, size);
+    list->uniform_size = offset + size;
+
+    cmd->binding = binding;
+    cmd->offset = offset;
+    cmd->size = size;
+    cmd->list = list->index;
+}
+
+static inline void CommandList_UniformMat4(CommandList* list, int location, const Matrix4* m)
+{
+    CmdUniformMat4* cmd = (CmdUniformMat4*)CommandList_Alloc(list, CMD_UNIFORM_MAT4, sizeof(CmdUniformMat4));
+    if (cmd)
+    {
+        cmd->location = location;
+        memcpy(cmd->m, m->m, sizeof(cmd->m));
+    }
+}
+
+static inline void CommandList_DrawArrays(CommandList* list, uint32_t mode, uint32_t first, uint32_t count, uint32_t instances)
+{
+    CmdDrawArrays* cmd = (CmdDrawArrays*)CommandList_Alloc(list, CMD_DRAW_ARRAYS, sizeof(CmdDrawArrays));
+    if (cmd)
+    {
+        cmd->mode = mode;
+        cmd->first = first;
+        cmd->count = count;
+        cmd->instances = instances;
+    }
+}
+
+// offset in bytes into the bound element buffer
+static inline void CommandList_DrawElements(CommandList* list, uint32_t mode, uint32_t count, uint32_t type, uint32_t offset, uint32_t instances, int32_t base_vertex)
+{
+    CmdDrawElements* cmd = (CmdDrawElements*)CommandList_Alloc(list, CMD_DRAW_ELEMENTS, sizeof(CmdDrawElements));
+    if (cmd)
+    {
+        cmd->mode = mode;
+        cmd->count = count;
+        cmd->type = type;
+        cmd->offset = offset;
+        cmd->instances = instances;
+        cmd->base_vertex = base_vertex;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                    QUEUE                                   */
+/* -------------------------------------------------------------------------- */
+
+typedef struct
+{
+    CommandList* lists;
+    int list_count;
+
+    CommandPacket* merged;
+    CommandPacket* scratch;
+    uint32_t merged_count;
+    uint32_t merged_capacity;
+
+    uint32_t uniform_base[64];  // per list offset inside the uploaded buffer
+    unsigned int ubo;
+    uint32_t ubo_size;
+
+    // last submit
+    uint32_t draws;
+    uint32_t state_changes;
+    uint32_t skipped;           // redundant binds filtered out
+
+} CommandQueue;
+
+static inline void CommandQueue_Delete(CommandQueue* queue);
+
+static inline bool CommandQueue_Create(CommandQueue* queue, int list_count, size_t command_bytes, uint32_t max_packets, uint32_t uniform_bytes)
+{
+    memset(queue, 0, sizeof(CommandQueue));
+
+    if (list_count < 1 || list_count > 64)
+    {
+        fprintf(stderr, "CommandQueue_Create: 1 to 64 lists, got %d\n", list_count);
+        return false;
+    }
+
+    queue->lists = (CommandList*)calloc((size_t)list_count, sizeof(CommandList));
+    if (!queue->lists)
+        return false;
+
+    queue->list_count = list_count;
+    for (int i = 0; i < list_count; ++i)
+    {
+        if (!CommandList_Create(&queue->lists[i], command_bytes, max_packets, uniform_bytes))
+        {
+            CommandQueue_Delete(queue);
+            return false;
+        }
+        queue->lists[i].index = (uint32_t)i;
+        CommandList_Reset(&queue->lists[i]);
+    }
+
+    return true;
+}
+
+static inline void CommandQueue_Delete(CommandQueue* queue)
+{
+    for (int i = 0; i < queue->list_count; ++i)
+        CommandList_Delete(&queue->lists[i]);
+
+    if (queue->ubo)
+        glDeleteBuffers(1, &queue->ubo);
+
+    free(queue->lists);
+    free(queue->merged);
+    free(queue->scratch);
+    memset(queue, 0, sizeof(CommandQueue));
+}
+
+static inline CommandList* CommandQueue_List(CommandQueue* queue, int index)
+{
+    return &queue->lists[(index >= 0 && index < queue->list_count) ? index : 0];
+}
+
+static inline void CommandQueue_Reset(CommandQueue* queue)
+{
+    for (int i = 0; i < queue->list_count; ++i)
+        CommandList_Reset(&queue->lists[i]);
+}
+
+// LSD radix sort on the keys, 8 bits a pass, passes where every key has the same byte are skipped
+static inline void CommandQueue_Sort(CommandQueue* queue)
+{
+    uint32_t n = queue->merged_count;
+    CommandPacket* src = queue->merged;
+    CommandPacket* dst = queue->scratch;
+
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        uint32_t histogram[256] = {0};
+        for (uint32_t i = 0; i < n; ++i)
+            histogram[(src[i].key >> shift) & 0xFF] += 1;
+
+        if (n == 0 || histogram[(src[0].key >> shift) & 0xFF] == n)
+            continue;
+
+        uint32_t sum = 0;
+        for (int b = 0; b < 256; ++b)
+        {
+            uint32_t c = histogram[b];
+            histogram[b] = sum;
+            sum += c;
+        }
+
+        for (uint32_t i = 0; i < n; ++i)
+            dst[histogram[(src[i].key >> shift) & 0xFF]++] = src[i];
+
+        CommandPacket* tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    queue->merged = src;
+    queue->scratch = dst;
+}
+
+// Gathers the packets of every list and sorts them. No GL calls; safe to time on its own.
+static inline bool CommandQueue_Merge(CommandQueue* queue)
+{
+    uint32_t total = 0;
+    for (int i = 0; i < queue->list_count; ++i)
+    {
+        if (queue->lists[i].overflow)
+            printf("Command list %d overflowed, some draws were dropped\n", i);
+        total += queue->lists[i].count;
+    }
+
+    if (total > queue->merged_capacity)
+    {
+        CommandPacket* merged = (CommandPacket*)realloc(queue->merged, sizeof(CommandPacket) * total);
+        if (merged)
+            queue->merged = merged;
+        CommandPacket* scratch = (CommandPacket*)realloc(queue->scratch, sizeof(CommandPacket) * total);
+        if (scratch)
+            queue->scratch = scratch;
+
+        if (!merged || !scratch)
+        {
+            fprintf(stderr, "Failed to grow command queue to %u packets\n", total);
+            return false;
+        }
+        queue->merged_capacity = total;
+    }
+
+    queue->merged_count = 0;
+    for (int i = 0; i < queue->list_count; ++i)
+    {
+        memcpy(queue->merged + queue->merged_count, queue->lists[i].packets, sizeof(CommandPacket) * queue->lists[i].count);
+        queue->merged_count += queue->lists[i].count;
+    }
+
+    CommandQueue_Sort(queue);
+    return true;
+}
+
+// Visits every command in sorted order, for backends other than GL and for inspection
+static inline void CommandQueue_ForEach(const CommandQueue* queue, void (*visit)(const CommandHeader* cmd, void* user), void* user)
+{
+    for (uint32_t p = 0; p < queue->merged_count; ++p)
+    {
+        const uint8_t* cmd = queue->merged[p].commands;
+        const uint8_t* end = cmd + queue->merged[p].size;
+        while (cmd < end)
+        {
+            const CommandHeader* header = (const CommandHeader*)cmd;
+            visit(header, user);
+            cmd += header->size;
+        }
+    }
+}
+
+// uploads the uniform staging of every list into one buffer
+static inline void CommandQueue_UploadUniforms(CommandQueue* queue)
+{
+    uint32_t total = 0;
+    for (int i = 0; i < queue->list_count; ++i)
+    {
+        queue->uniform_base[i] = total;
+        total += (uint32_t)ALIGN_UP((size_t)queue->lists[i].uniform_size, (size_t)COMMAND_UNIFORM_ALIGN);
+    }
+
+    if (total == 0)
+        return;
+
+    if (!queue->ubo)
+        glGenBuffers(1, &queue->ubo);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, queue->ubo);
+
+    // orphan the old storage every frame instead of waiting on draws still reading it
+    if (total > queue->ubo_size)
+        queue->ubo_size = total;
+    glBufferData(GL_UNIFORM_BUFFER, queue->ubo_size, NULL, GL_STREAM_DRAW);
+
+    for (int i = 0; i < queue->list_count; ++i)
+    {
+        if (queue->lists[i].uniform_size)
+            glBufferSubData(GL_UNIFORM_BUFFER, queue->uniform_base[i], queue->lists[i].uniform_size, queue->lists[i].uniforms);
+    }
+}
+
+// Replays the merged packets. GL thread only.
+static inline void CommandQueue_ReplayGL(CommandQueue* queue)
+{
+    uint32_t program = 0, vao = 0;
+    uint32_t textures[COMMAND_MAX_TEXTURE_UNITS];
+    uint32_t active_unit = 0;
+    uint32_t draws = 0, changes = 0, skipped = 0;
+
+    // whatever the caller left bound is unknown: start from no program and no vertex array, and
+    // treat every texture unit as unknown so its first bind is always issued
+    glUseProgram(0);
+    glBindVertexArray(0);
+    glActiveTexture(GL_TEXTURE0);
+    memset(textures, 0xFF, sizeof(textures));
+
+    for (uint32_t p = 0; p < queue->merged_count; ++p)
+    {
+        const uint8_t* cmd = queue->merged[p].commands;
+        const uint8_t* end = cmd + queue->merged[p].size;
+
+        while (cmd < end)
+        {
+            const CommandHeader* header = (const CommandHeader*)cmd;
+
+            switch (header->type)
+            {
+                case CMD_BIND_PROGRAM:
+                {
+                    const CmdBindProgram* c = (const CmdBindProgram*)cmd;
+                    if (c->program == program) { skipped++; break; }
+                    glUseProgram(c->program);
+                    program = c->program;
+                    changes++;
+                    break;
+                }
+                case CMD_BIND_TEXTURE:
+                {
+                    const CmdBindTexture* c = (const CmdBindTexture*)cmd;
+                    if (c->unit < COMMAND_MAX_TEXTURE_UNITS && textures[c->unit] == c->texture) { skipped++; break; }
+                    if (c->unit != active_unit)
+                    {
+                        glActiveTexture(GL_TEXTURE0 + c->unit);
+                        active_unit = c->unit;
+                    }
+                    glBindTexture(c->target, c->texture);
+                    if (c->unit < COMMAND_MAX_TEXTURE_UNITS)
+                        textures[c->unit] = c->texture;
+                    changes++;
+                    break;
+                }
+                case CMD_BIND_VERTEX_ARRAY:
+                {
+                    const CmdBindVertexArray* c = (const CmdBindVertexArray*)cmd;
+                    if (c->vao == vao) { skipped++; break; }
+                    glBindVertexArray(c->vao);
+                    vao = c->vao;
+                    changes++;
+                    break;
+                }
+                case CMD_UNIFORM_BLOCK:
+                {
+                    const CmdUniformBlock* c = (const CmdUniformBlock*)cmd;
+                    glBindBufferRange(GL_UNIFORM_BUFFER, c->binding, queue->ubo, queue->uniform_base[c->list] + c->offset, c->size);
+                    break;
+                }
+                case CMD_UNIFORM_MAT4:
+                {
+                    const CmdUniformMat4* c = (const CmdUniformMat4*)cmd;
+                    glUniformMatrix4fv(c->location, 1, GL_FALSE, c->m);
+                    break;
+                }
+                case CMD_DRAW_ARRAYS:
+                {
+                    const CmdDrawArrays* c = (const CmdDrawArrays*)cmd;
+                    if (c->instances > 1)
+                        glDrawArraysInstanced(c->mode, c->first, c->count, c->instances);
+                    else
+                        glDrawArrays(c->mode, c->first, c->count);
+                    draws++;
+                    break;
+                }
+                case CMD_DRAW_ELEMENTS:
+                {
+                    const CmdDrawElements* c = (const CmdDrawElements*)cmd;
+                    const void* offset = (const void*)(uintptr_t)c->offset;
+                    if (c->instances > 1)
+                        glDrawElementsInstancedBaseVertex(c->mode, c->count, c->type, offset, c->instances, c->base_vertex);
+                    else if (c->base_vertex)
+                        glDrawElementsBaseVertex(c->mode, c->count, c->type, (void*)offset, c->base_vertex);
+                    else
+                        glDrawElements(c->mode, c->count, c->type, offset);
+                    draws++;
+                    break;
+                }
+                default:
+                    break;
+            }
+
+            cmd += header->size;
+        }
+    }
+
+    if (active_unit != 0)
+        glActiveTexture(GL_TEXTURE0);
+
+    queue->draws = draws;
+    queue->state_changes = changes;
+    queue->skipped = skipped;
+}
+
+// Merge, upload and replay everything recorded this frame, then reset the lists. GL thread only.
+static inline void CommandQueue_Submit(CommandQueue* queue)
+{
+    if (CommandQueue_Merge(queue))
+    {
+        CommandQueue_UploadUniforms(queue);
+        CommandQueue_ReplayGL(queue);
+    }
+
+    CommandQueue_Reset(queue);
+}
+
+#endif
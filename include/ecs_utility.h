@@ -0,0 +1,483 @@
+#ifndef ECS_UTILITY_H
+#define ECS_UTILITY_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "math_utility.h"
+#include "transform_utility.h"
+#include "arena_utility.h"
+#include "darray_utility.h"
+
+// Sparse-set entity component storage. Every component type has a pool: a dense DArray of
+// component values, a parallel dense array of owning entities, and a sparse table mapping an
+// entity index to its dense slot. Systems stream the dense arrays front to back.
+//
+// The fixed size tables (sparse arrays, generations, free list) come out of one arena sized for
+// max_entities at creation; the dense arrays grow with malloc as components are added.
+//
+// Queries iterate the smallest pool of the set and look the entity up in the others. After
+// Ecs_SortPools the pools share one order, so those lookups hit the same slot and every array of
+// the query is read linearly.
+
+typedef uint32_t Entity;
+typedef int ComponentId;
+
+#define ECS_INDEX_BITS          24
+#define ECS_INDEX_MASK          ((1u << ECS_INDEX_BITS) - 1)
+#define ECS_NULL_ENTITY         0xFFFFFFFFu
+#define ECS_NONE                0xFFFFFFFFu
+#define ECS_MAX_COMPONENTS      16
+#define ECS_MAX_COMPONENT_SIZE  256
+#define ECS_QUERY_MAX           8
+
+static inline uint32_t Entity_Index(Entity e) { return e & ECS_INDEX_MASK; }
+static inline uint32_t Entity_Generation(Entity e) { return e >> ECS_INDEX_BITS; }
+
+/* ----- Built-in components ----- */
+
+// Meshes and materials are referenced by index into the application's own tables, which keeps this
+// module free of GL and gives render submission integer keys to sort on
+typedef struct
+{
+    uint32_t mesh;
+    uint32_t submesh;
+
+} MeshRef;
+
+typedef struct
+{
+    uint32_t shader;
+    uint32_t texture;
+
+} MaterialRef;
+
+// local space bounding sphere
+typedef struct
+{
+    Vector3 center;
+    float radius;
+
+} Bounds;
+
+typedef struct
+{
+    Vector3 linear;
+    Vector3 angular;    // axis * radians per second
+
+} Velocity;
+
+enum
+{
+    ECS_TRANSFORM = 0,
+    ECS_MODEL,          // Matrix4 world matrix written by the transform system
+    ECS_MESH,
+    ECS_MATERIAL,
+    ECS_BOUNDS,
+    ECS_VELOCITY,
+    ECS_BUILTIN_COUNT
+};
+
+/* ----- World ----- */
+
+typedef struct
+{
+    DArray data;            // component values, dense
+    DArray entities;        // Entity per dense slot
+    uint32_t* sparse;       // entity index -> dense slot or ECS_NONE
+
+} ComponentPool;
+
+typedef struct
+{
+    Arena arena;
+    uint32_t max_entities;
+
+    uint8_t* generation;    // per entity index
+    uint32_t* free_list;
+    uint32_t free_count;
+    uint32_t next_index;    // indices below this have been handed out once
+    uint32_t alive;
+
+    ComponentPool pools[ECS_MAX_COMPONENTS];
+    int pool_count;
+
+} EcsWorld;
+
+static inline ComponentId Ecs_RegisterComponent(EcsWorld* world, size_t size, size_t type_id)
+{
+    if (world->pool_count >= ECS_MAX_COMPONENTS || size > ECS_MAX_COMPONENT_SIZE)
+    {
+        fprintf(stderr, "Ecs_RegisterComponent: too many components or component too large (%zu bytes)\n", size);
+        return -1;
+    }
+
+    ComponentPool* pool = &world->pools[world->pool_count];
+    pool->sparse = (uint32_t*)Arena_Alloc(&world->arena, sizeof(uint32_t) * world->max_entities);
+    if (!pool->sparse)
+    {
+        fprintf(stderr, "Ecs_RegisterComponent: world arena exhausted\n");
+        return -1;
+    }
+
+    memset(pool->sparse, 0xFF, sizeof(uint32_t) * world->max_entities);
+    pool->data = DArray_Create(size, 64, NULL, type_id);
+    pool->entities = DArray_Create_T(Entity, 64, NULL);
+
+    return world->pool_count++;
+}
+
+#define Ecs_RegisterComponent_T(T, world) Ecs_RegisterComponent((world), sizeof(T), TYPE_ID(T))
+
+// max_entities must fit in ECS_INDEX_BITS
+static inline bool Ecs_Create(EcsWorld* world, uint32_t max_entities)
+{
+    memset(world, 0, sizeof(EcsWorld));
+
+    if (max_entities == 0 || max_entities > ECS_INDEX_MASK)
+    {
+        fprintf(stderr, "Ecs_Create: invalid entity count %u\n", max_entities);
+        return false;
+    }
+
+    // generations + free list + one sparse table per possible component, plus alignment slack
+    size_t bytes = (size_t)max_entities * (sizeof(uint8_t) + sizeof(uint32_t) + sizeof(uint32_t) * ECS_MAX_COMPONENTS)
+                 + 64 * (ECS_MAX_COMPONENTS + 2);
+
+    world->arena = Arena_Create(bytes);
+    if (!world->arena.start)
+    {
+        fprintf(stderr, "Ecs_Create: failed to allocate %zu bytes\n", bytes);
+        return false;
+    }
+
+    world->max_entities = max_entities;
+    world->generation = (uint8_t*)Arena_Alloc(&world->arena, max_entities);
+    world->free_list = (uint32_t*)Arena_Alloc(&world->arena, sizeof(uint32_t) * max_entities);
+    memset(world->generation, 0, max_entities);
+
+    // registration order must match the ECS_* ids
+    Ecs_RegisterComponent_T(Transform, world);
+    Ecs_RegisterComponent_T(Matrix4, world);
+    Ecs_RegisterComponent_T(MeshRef, world);
+    Ecs_RegisterComponent_T(MaterialRef, world);
+    Ecs_RegisterComponent_T(Bounds, world);
+    Ecs_RegisterComponent_T(Velocity, world);
+
+    return true;
+}
+
+static inline void Ecs_Delete(EcsWorld* world)
+{
+    for (int i = 0; i < world->pool_count; ++i)
+    {
+        DArray_Free(&world->pools[i].data);
+        DArray_Free(&world->pools[i].entities);
+    }
+
+    Arena_Free(&world->arena);
+    memset(world, 0, sizeof(EcsWorld));
+}
+
+/* ----- Entities ----- */
+
+static inline Entity Ecs_CreateEntity(EcsWorld* world)
+{
+    uint32_t index;
+    if (world->free_count > 0)
+        index = world->free_list[--world->free_count];
+    else if (world->next_index < world->max_entities)
+        index = world->next_index++;
+    else
+    {
+        fprintf(stderr, "Ecs_CreateEntity: entity limit reached (%u)\n", world->max_entities);
+        return ECS_NULL_ENTITY;
+    }
+
+    world->alive += 1;
+    return ((uint32_t)world->generation[index] << ECS_INDEX_BITS) | index;
+}
+
+static inline bool Ecs_IsAlive(const EcsWorld* world, Entity e)
+{
+    uint32_t index = Entity_Index(e);
+    return e != ECS_NULL_ENTITY && index < world->next_index && world->generation[index] == Entity_Generation(e);
+}
+
+/* ----- Components ----- */
+
+static inline uint32_t Ecs_PoolSize(const EcsWorld* world, ComponentId id)
+{
+    return (uint32_t)world->pools[id].data.size;
+}
+
+// dense arrays of a pool, valid until the next add/remove on it
+static inline void* Ecs_PoolData(EcsWorld* world, ComponentId id)
+{
+    return world->pools[id].data.data;
+}
+
+static inline const Entity* Ecs_PoolEntities(const EcsWorld* world, ComponentId id)
+{
+    return (const Entity*)world->pools[id].entities.data;
+}
+
+static inline uint32_t Ecs_Slot(const ComponentPool* pool, Entity e)
+{
+    uint32_t slot = pool->sparse[Entity_Index(e)];
+    if (slot == ECS_NONE || ((const Entity*)pool->entities.data)[slot] != e)
+        return ECS_NONE;
+    return slot;
+}
+
+static inline bool Ecs_Has(const EcsWorld* world, Entity e, ComponentId id)
+{
+    return Ecs_IsAlive(world, e) && Ecs_Slot(&world->pools[id], e) != ECS_NONE;
+}
+
+static inline void* Ecs_Get(EcsWorld* world, Entity e, ComponentId id)
+{
+    if (!Ecs_IsAlive(world, e))
+        return NULL;
+
+    ComponentPool* pool = &world->pools[id];
+    uint32_t slot = Ecs_Slot(pool, e);
+    return (slot == ECS_NONE) ? NULL : (char*)pool->data.data + (size_t)slot * pool->data.element_size;
+}
+
+#define Ecs_Get_T(T, world, e, id) ((T*)Ecs_Get((world), (e), (id)))
+
+// Adds (or overwrites) a component. value may be NULL for a zeroed component.
+static inline void* Ecs_Add(EcsWorld* world, Entity e, ComponentId id, const void* value)
+{
+    if (!Ecs_IsAlive(world, e))
+        return NULL;
+
+    ComponentPool* pool = &world->pools[id];
+    size_t size = pool->data.element_size;
+
+    uint32_t slot = Ecs_Slot(pool, e);
+    if (slot == ECS_NONE)
+    {
+        static const unsigned char zero[ECS_MAX_COMPONENT_SIZE] = {0};
+        size_t before = pool->data.size;
+
+        // data and entities must stay the same length: a failed push is undone on both
+        DArray_Push_T(Entity, &pool->entities, e);
+        if (pool->entities.size == before)
+            return NULL;
+
+        DArray_Push(&pool->data, value ? value : zero, pool->data.type_id);
+        if (pool->data.size == before)
+        {
+            pool->entities.size -= 1;
+            return NULL;
+        }
+
+        slot = (uint32_t)before;
+        pool->sparse[Entity_Index(e)] = slot;
+    }
+    else if (value)
+    {
+        memcpy((char*)pool->data.data + (size_t)slot * size, value, size);
+    }
+
+    return (char*)pool->data.data + (size_t)slot * size;
+}
+
+#define Ecs_Add_T(T, world, e, id, value)                   \
+    do {                                                    \
+        T ecs_temp_ = (value);                              \
+        Ecs_Add((world), (e), (id), &ecs_temp_);            \
+    } while (0)
+
+// swap-remove: the last component of the pool fills the hole
+static inline void Ecs_Remove(EcsWorld* world, Entity e, ComponentId id)
+{
+    ComponentPool* pool = &world->pools[id];
+    uint32_t slot = Ecs_Slot(pool, e);
+    if (slot == ECS_NONE)
+        return;
+
+    uint32_t last = (uint32_t)pool->data.size - 1;
+    size_t size = pool->data.element_size;
+    Entity* entities = (Entity*)pool->entities.data;
+
+    if (slot != last)
+    {
+        memcpy((char*)pool->data.data + (size_t)slot * size, (char*)pool->data.data + (size_t)last * size, size);
+        entities[slot] = entities[last];
+        pool->sparse[Entity_Index(entities[slot])] = slot;
+    }
+
+    pool->sparse[Entity_Index(e)] = ECS_NONE;
+    pool->data.size -= 1;
+    pool->entities.size -= 1;
+}
+
+static inline void Ecs_DestroyEntity(EcsWorld* world, Entity e)
+{
+    if (!Ecs_IsAlive(world, e))
+        return;
+
+    for (int i = 0; i < world->pool_count; ++i)
+        Ecs_Remove(world, e, i);
+
+    uint32_t index = Entity_Index(e);
+    world->generation[index] = (uint8_t)(world->generation[index] + 1);
+    world->free_list[world->free_count++] = index;
+    world->alive -= 1;
+}
+
+/* ----- Ordering ----- */
+
+// Reorders pool `id` so entities shared with `reference` come first and in the reference's order.
+static inline void Ecs_SortPoolLike(EcsWorld* world, ComponentId id, ComponentId reference)
+{
+    if (id == reference)
+        return;
+
+    ComponentPool* pool = &world->pools[id];
+    const ComponentPool* ref = &world->pools[reference];
+    uint32_t count = (uint32_t)pool->data.size;
+    size_t size = pool->data.element_size;
+
+    if (count == 0)
+        return;
+
+    uint32_t* order = (uint32_t*)malloc(sizeof(uint32_t) * count);
+    unsigned char* data = (unsigned char*)malloc(size * count);
+    Entity* entities = (Entity*)malloc(sizeof(Entity) * count);
+    if (!order || !data || !entities)
+    {
+        fprintf(stderr, "Ecs_SortPoolLike: out of memory\n");
+        free(order); free(data); free(entities);
+        return;
+    }
+
+    const Entity* ref_entities = (const Entity*)ref->entities.data;
+    const Entity* old_entities = (const Entity*)pool->entities.data;
+    uint32_t n = 0;
+
+    for (uint32_t i = 0; i < (uint32_t)ref->entities.size; ++i)
+    {
+        uint32_t slot = Ecs_Slot(pool, ref_entities[i]);
+        if (slot != ECS_NONE)
+            order[n++] = slot;
+    }
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (Ecs_Slot(ref, old_entities[i]) == ECS_NONE)
+            order[n++] = i;
+    }
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        memcpy(data + (size_t)i * size, (char*)pool->data.data + (size_t)order[i] * size, size);
+        entities[i] = old_entities[order[i]];
+    }
+
+    memcpy(pool->data.data, data, size * count);
+    memcpy(pool->entities.data, entities, sizeof(Entity) * count);
+    for (uint32_t i = 0; i < count; ++i)
+        pool->sparse[Entity_Index(entities[i])] = i;
+
+    free(order);
+    free(data);
+    free(entities);
+}
+
+// Brings every pool into the order of `reference`, typically after a burst of creates/destroys
+static inline void Ecs_SortPools(EcsWorld* world, ComponentId reference)
+{
+    for (int i = 0; i < world->pool_count; ++i)
+        Ecs_SortPoolLike(world, i, reference);
+}
+
+/* ----- Queries ----- */
+
+typedef struct
+{
+    EcsWorld* world;
+    ComponentId ids[ECS_QUERY_MAX];
+    int count;
+
+    int driver;             // position in ids of the smallest pool
+    uint32_t cursor;
+    uint32_t end;
+
+    Entity entity;
+    uint32_t slot[ECS_QUERY_MAX];
+
+} EcsQuery;
+
+static inline EcsQuery Ecs_Query(EcsWorld* world, const ComponentId* ids, int count)
+{
+    EcsQuery q;
+    memset(&q, 0, sizeof(EcsQuery));
+    q.world = world;
+    q.count = (count > ECS_QUERY_MAX) ? ECS_QUERY_MAX : count;
+    q.entity = ECS_NULL_ENTITY;
+
+    uint32_t smallest = ECS_NONE;
+    for (int i = 0; i < q.count; ++i)
+    {
+        q.ids[i] = ids[i];
+        uint32_t size = Ecs_PoolSize(world, ids[i]);
+        if (size < smallest)
+        {
+            smallest = size;
+            q.driver = i;
+        }
+    }
+
+    q.end = (q.count > 0) ? smallest : 0;
+    return q;
+}
+
+// Advances to the next entity having every component of the query
+static inline bool Ecs_QueryNext(EcsQuery* q)
+{
+    const ComponentPool* driver = &q->world->pools[q->ids[q->driver]];
+    const Entity* driver_entities = (const Entity*)driver->entities.data;
+
+    while (q->cursor < q->end)
+    {
+        uint32_t i = q->cursor++;
+        Entity e = driver_entities[i];
+        bool match = true;
+
+        for (int c = 0; c < q->count && match; ++c)
+        {
+            const ComponentPool* pool = &q->world->pools[q->ids[c]];
+
+            // pools sorted alike keep the entity in the same slot, skip the sparse lookup
+            if (i < pool->entities.size && ((const Entity*)pool->entities.data)[i] == e)
+                q->slot[c] = i;
+            else
+                match = (q->slot[c] = Ecs_Slot(pool, e)) != ECS_NONE;
+        }
+
+        if (match)
+        {
+            q->entity = e;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// component `index` (position in the query's id list) of the current entity
+static inline void* Ecs_QueryGet(const EcsQuery* q, int index)
+{
+    const ComponentPool* pool = &q->world->pools[q->ids[index]];
+    return (char*)pool->data.data + (size_t)q->slot[index] * pool->data.element_size;
+}
+
+#define Ecs_QueryGet_T(T, q, index) ((T*)Ecs_QueryGet((q), (index)))
+
+#endif
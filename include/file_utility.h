@@ -3,29 +3,192 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 #include "string_utility.h"
+#include "pack_utility.h"
 
+// Reads the whole file with a single allocation and a single fread (size comes from fstat).
+// Paths found in the mounted pack are read from it instead.
 static inline String File_Load(const char* name)
 {
-    String contents = String_Create(4096, NULL, NULL);
+    const PackEntry* entry = Pack_Find(Pack_Mounted, name);
+    if (entry)
+    {
+        String contents = String_Create((size_t)entry->raw_size + 1, NULL, NULL);
+        if (!contents.data)
+            return contents;
+
+        if (!Pack_Extract(Pack_Mounted, entry, contents.data))
+        {
+            String_Free(&contents);
+            return (String){0};
+        }
+
+        contents.length = (size_t)entry->raw_size;
+        contents.data[contents.length] = '\0';
+        return contents;
+    }
 
-    FILE* file = fopen(name, "r");
+    FILE* file = fopen(name, "rb");
     if (!file)
     {
         printf("Failed to open file: %s\n", name);
         return (String){0};
     }
 
-    char line[512];
+    struct stat st;
+    if (fstat(fileno(file), &st) != 0)
+    {
+        printf("Failed to stat file: %s\n", name);
+        fclose(file);
+        return (String){0};
+    }
 
-    while (fgets(line, sizeof(line), file))
+    size_t size = (size_t)st.st_size;
+    String contents = String_Create(size + 1, NULL, NULL);
+    if (!contents.data)
     {
-        String_Append(&contents, line);
+        fclose(file);
+        return contents;
     }
 
+    contents.length = fread(contents.data, 1, size, file);
+    contents.data[contents.length] = '\0';
+
     fclose(file);
 
     return contents;
 }
 
-#endif
\ No newline at end of file
+typedef enum
+{
+    FILE_VIEW_MAPPED,       // mmap of a loose file
+    FILE_VIEW_PACKED,       // points into the mounted pack, nothing to release
+    FILE_VIEW_HEAP          // decompressed pack entry
+
+} FileViewKind;
+
+// Read-only view of a file's contents. data is not NUL terminated.
+typedef struct
+{
+    const char* data;
+    size_t size;
+    FileViewKind kind;
+
+} FileView;
+
+// Maps the file on disk even when the mounted pack has an entry for it (hot reload edits loose files)
+static inline bool File_MapLoose(FileView* view, const char* name)
+{
+    view->data = NULL;
+    view->size = 0;
+    view->kind = FILE_VIEW_MAPPED;
+
+    int fd = open(name, O_RDONLY);
+    if (fd < 0)
+    {
+        printf("Failed to open file: %s\n", name);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        printf("Failed to stat file: %s\n", name);
+        close(fd);
+        return false;
+    }
+
+    // mmap rejects zero length, an empty file is a valid empty view
+    if (st.st_size > 0)
+    {
+        void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            printf("Failed to map file: %s\n", name);
+            close(fd);
+            return false;
+        }
+
+        // consumers mostly read front to back
+        posix_madvise(data, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+
+        view->data = (const char*)data;
+        view->size = (size_t)st.st_size;
+    }
+
+    // the mapping stays valid after the descriptor is closed
+    close(fd);
+
+    return true;
+}
+
+// Stored pack entries are returned in place, compressed ones are decompressed to the heap
+static inline bool File_Map(FileView* view, const char* name)
+{
+    const PackEntry* entry = Pack_Find(Pack_Mounted, name);
+    if (!entry)
+        return File_MapLoose(view, name);
+
+    if (entry->compression == PACK_COMPRESSION_NONE)
+    {
+        view->data = (const char*)Pack_EntryData(Pack_Mounted, entry);
+        view->size = (size_t)entry->raw_size;
+        view->kind = FILE_VIEW_PACKED;
+        return true;
+    }
+
+    view->data = NULL;
+    view->size = 0;
+    view->kind = FILE_VIEW_HEAP;
+
+    char* data = (char*)malloc((size_t)entry->raw_size ? (size_t)entry->raw_size : 1);
+    if (!data || !Pack_Extract(Pack_Mounted, entry, data))
+    {
+        free(data);
+        return false;
+    }
+
+    view->data = data;
+    view->size = (size_t)entry->raw_size;
+    return true;
+}
+
+static inline void File_Unmap(FileView* view)
+{
+    if (view->kind == FILE_VIEW_HEAP)
+        free((void*)view->data);
+    else if (view->kind == FILE_VIEW_MAPPED && view->data && view->size)
+        munmap((void*)view->data, view->size);
+
+    view->data = NULL;
+    view->size = 0;
+}
+
+// fgets over a view: copies the next line (including '\n') into line, false at the end.
+// Lines longer than max - 1 are split like fgets would.
+static inline bool FileView_ReadLine(const FileView* view, size_t* cursor, char* line, size_t max)
+{
+    if (*cursor >= view->size || max < 2)
+        return false;
+
+    size_t remaining = view->size - *cursor;
+    size_t limit = (remaining < max - 1) ? remaining : max - 1;
+
+    const char* start = view->data + *cursor;
+    const char* newline = (const char*)memchr(start, '\n', limit);
+    size_t length = newline ? (size_t)(newline - start) + 1 : limit;
+
+    memcpy(line, start, length);
+    line[length] = '\0';
+    *cursor += length;
+
+    return true;
+}
+
+#endif
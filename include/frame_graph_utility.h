@@ -0,0 +1,353 @@
+#ifndef FRAME_GRAPH_UTILITY_H
+#define FRAME_GRAPH_UTILITY_H
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <sched.h>
+#include "job_utility.h"
+
+// Per-frame task graph. Tasks (input, camera, physics, transforms, culling, command building, GL
+// submission...) are declared once with their dependencies; FrameGraph_Run then executes one frame,
+// starting every task as soon as the tasks it depends on are done. Worker tasks go through the job
+// system, tasks flagged FRAME_TASK_MAIN_THREAD (anything touching GL or GLFW) run on the thread
+// calling FrameGraph_Run.
+//
+// Pipelining: tasks flagged FRAME_TASK_RENDER form the render stage. With pipelining on, a Run call
+// simulates frame N while the render stage submits frame N-1, so dependencies of render tasks on
+// simulation tasks are dropped (they were satisfied by the previous Run). The data handed from
+// simulation to rendering must then be double-buffered: simulation tasks write slot
+// FrameContext.write_slot, render tasks read FrameContext.read_slot. Without pipelining both slots
+// are the same.
+
+#define FRAME_GRAPH_MAX_TASKS   32
+#define FRAME_GRAPH_MAX_DEPS    8
+
+enum
+{
+    FRAME_TASK_MAIN_THREAD  = 1 << 0,
+    FRAME_TASK_RENDER       = 1 << 1,
+};
+
+typedef struct
+{
+    uint64_t frame;     // frame being simulated
+    int write_slot;     // render data slot simulation writes
+    int read_slot;      // render data slot the render stage reads
+
+} FrameContext;
+
+typedef void (*FrameTaskFunc)(void* data, const FrameContext* ctx);
+
+typedef struct
+{
+    const char* name;
+    FrameTaskFunc func;
+    void* data;
+    int flags;
+
+    int deps[FRAME_GRAPH_MAX_DEPS];
+    int dep_count;
+
+    // built by FrameGraph_Compile from the active edges
+    int dependents[FRAME_GRAPH_MAX_TASKS];
+    int dependent_count;
+    int initial_pending;
+
+    // per run
+    int pending;
+    int ready;          // main thread tasks waiting to be picked up
+    bool active;
+
+    // timings in milliseconds
+    double begin_ms;    // relative to the start of the frame
+    double last_ms;
+    double avg_ms;
+
+} FrameTask;
+
+typedef struct
+{
+    JobSystem* jobs;
+    FrameTask tasks[FRAME_GRAPH_MAX_TASKS];
+    int count;
+
+    bool pipelined;
+    bool compiled;
+    bool has_previous;  // a simulated frame is waiting for the render stage
+    uint64_t frame;
+
+    int remaining;
+    double frame_start;
+    double last_frame_ms;
+    double avg_frame_ms;
+
+    FrameContext ctx;
+
+} FrameGraph;
+
+static inline double FrameGraph_Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec * 1e-6;
+}
+
+static inline void FrameGraph_Create(FrameGraph* graph, JobSystem* jobs)
+{
+    memset(graph, 0, sizeof(FrameGraph));
+    graph->jobs = jobs;
+}
+
+// returns the task index, -1 when the graph is full
+static inline int FrameGraph_AddTask(FrameGraph* graph, const char* name, FrameTaskFunc func, void* data, int flags)
+{
+    if (graph->count >= FRAME_GRAPH_MAX_TASKS)
+    {
+        printf("Frame graph full (%d tasks), dropping %s\n", FRAME_GRAPH_MAX_TASKS, name);
+        return -1;
+    }
+
+    FrameTask* task = &graph->tasks[graph->count];
+    memset(task, 0, sizeof(FrameTask));
+    task->name = name;
+    task->func = func;
+    task->data = data;
+    task->flags = flags;
+
+    graph->compiled = false;
+    return graph->count++;
+}
+
+// task runs after dependency
+static inline void FrameGraph_AddDependency(FrameGraph* graph, int task, int dependency)
+{
+    if (task < 0 || dependency < 0 || task >= graph->count || dependency >= graph->count)
+        return;
+
+    FrameTask* t = &graph->tasks[task];
+    for (int d = 0; d < t->dep_count; ++d)
+    {
+        // each edge once, so a task shows up at most once in a dependents list
+        if (t->deps[d] == dependency)
+            return;
+    }
+
+    if (t->dep_count >= FRAME_GRAPH_MAX_DEPS)
+    {
+        printf("Frame task %s has too many dependencies\n", t->name);
+        return;
+    }
+
+    t->deps[t->dep_count++] = dependency;
+    graph->compiled = false;
+}
+
+static inline void FrameGraph_SetPipelined(FrameGraph* graph, bool pipelined)
+{
+    if (graph->pipelined == pipelined)
+        return;
+
+    graph->pipelined = pipelined;
+    graph->has_previous = false;
+    graph->compiled = false;
+}
+
+static inline bool FrameGraph_EdgeActive(const FrameGraph* graph, int task, int dependency)
+{
+    // in a pipelined frame the render stage works on the previous frame's simulation
+    return !(graph->pipelined && (graph->tasks[task].flags & FRAME_TASK_RENDER) && !(graph->tasks[dependency].flags & FRAME_TASK_RENDER));
+}
+
+// Builds the dependent lists and rejects cycles. Run calls it when the graph changed.
+static inline bool FrameGraph_Compile(FrameGraph* graph)
+{
+    for (int i = 0; i < graph->count; ++i)
+    {
+        graph->tasks[i].dependent_count = 0;
+        graph->tasks[i].initial_pending = 0;
+    }
+
+    for (int i = 0; i < graph->count; ++i)
+    {
+        FrameTask* t = &graph->tasks[i];
+        for (int d = 0; d < t->dep_count; ++d)
+        {
+            if (!FrameGraph_EdgeActive(graph, i, t->deps[d]))
+                continue;
+
+            FrameTask* dep = &graph->tasks[t->deps[d]];
+            if (dep->dependent_count >= FRAME_GRAPH_MAX_TASKS)
+            {
+                printf("Frame task %s has too many dependents\n", dep->name);
+                return false;
+            }
+            dep->dependents[dep->dependent_count++] = i;
+            t->initial_pending += 1;
+        }
+    }
+
+    // Kahn's walk: every task must be reachable from the roots
+    int pending[FRAME_GRAPH_MAX_TASKS];
+    int queue[FRAME_GRAPH_MAX_TASKS];
+    int head = 0, tail = 0;
+
+    for (int i = 0; i < graph->count; ++i)
+    {
+        pending[i] = graph->tasks[i].initial_pending;
+        if (pending[i] == 0)
+            queue[tail++] = i;
+    }
+
+    while (head < tail)
+    {
+        const FrameTask* t = &graph->tasks[queue[head++]];
+        for (int d = 0; d < t->dependent_count; ++d)
+        {
+            if (--pending[t->dependents[d]] == 0)
+                queue[tail++] = t->dependents[d];
+        }
+    }
+
+    if (tail != graph->count)
+    {
+        printf("Frame graph has a dependency cycle\n");
+        return false;
+    }
+
+    graph->compiled = true;
+    return true;
+}
+
+static inline void FrameGraph_Dispatch(FrameGraph* graph, int index);
+
+static inline void FrameGraph_Execute(FrameGraph* graph, int index)
+{
+    FrameTask* task = &graph->tasks[index];
+
+    double begin = FrameGraph_Now();
+    {
+        PROFILE_ZONE(task->name);
+        task->func(task->data, &graph->ctx);
+    }
+    double end = FrameGraph_Now();
+
+    task->begin_ms = begin - graph->frame_start;
+    task->last_ms = end - begin;
+    task->avg_ms = (task->avg_ms == 0.0) ? task->last_ms : task->avg_ms * 0.9 + task->last_ms * 0.1;
+
+    for (int d = 0; d < task->dependent_count; ++d)
+    {
+        int dependent = task->dependents[d];
+        if (graph->tasks[dependent].active && __atomic_sub_fetch(&graph->tasks[dependent].pending, 1, __ATOMIC_ACQ_REL) == 0)
+            FrameGraph_Dispatch(graph, dependent);
+    }
+
+    // last touch of the task for this frame
+    __atomic_sub_fetch(&graph->remaining, 1, __ATOMIC_RELEASE);
+}
+
+static inline void FrameGraph_TaskJob(void* data, int begin, int end)
+{
+    (void)end;
+    FrameGraph_Execute((FrameGraph*)data, begin);
+}
+
+static inline void FrameGraph_Dispatch(FrameGraph* graph, int index)
+{
+    if (graph->tasks[index].flags & FRAME_TASK_MAIN_THREAD)
+        __atomic_store_n(&graph->tasks[index].ready, 1, __ATOMIC_RELEASE);
+    else
+        Job_Run(graph->jobs, FrameGraph_TaskJob, graph, index, index + 1, NULL);
+}
+
+// runs one main thread task that became ready, if any
+static inline bool FrameGraph_RunMainTask(FrameGraph* graph)
+{
+    for (int i = 0; i < graph->count; ++i)
+    {
+        if (__atomic_load_n(&graph->tasks[i].ready, __ATOMIC_ACQUIRE))
+        {
+            __atomic_store_n(&graph->tasks[i].ready, 0, __ATOMIC_RELAXED);
+            FrameGraph_Execute(graph, i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Runs one frame of the graph. Call from the thread that created the job system (and owns GL).
+static inline bool FrameGraph_Run(FrameGraph* graph)
+{
+    if (!graph->compiled && !FrameGraph_Compile(graph))
+        return false;
+
+    graph->ctx.frame = graph->frame;
+    graph->ctx.write_slot = (int)(graph->frame & 1);
+    graph->ctx.read_slot = graph->pipelined ? (int)((graph->frame + 1) & 1) : graph->ctx.write_slot;
+
+    // nothing to render before the first pipelined frame has been simulated
+    bool render = !graph->pipelined || graph->has_previous;
+
+    int active = 0;
+    for (int i = 0; i < graph->count; ++i)
+    {
+        FrameTask* t = &graph->tasks[i];
+        t->active = render || !(t->flags & FRAME_TASK_RENDER);
+        t->ready = 0;
+        active += t->active;
+    }
+
+    // skipped tasks count as done for whoever waits on them
+    for (int i = 0; i < graph->count; ++i)
+    {
+        FrameTask* t = &graph->tasks[i];
+        t->pending = 0;
+        for (int d = 0; d < t->dep_count; ++d)
+            t->pending += FrameGraph_EdgeActive(graph, i, t->deps[d]) && graph->tasks[t->deps[d]].active;
+    }
+
+    graph->remaining = active;
+    graph->frame_start = FrameGraph_Now();
+
+    for (int i = 0; i < graph->count; ++i)
+    {
+        if (graph->tasks[i].active && graph->tasks[i].pending == 0)
+            FrameGraph_Dispatch(graph, i);
+    }
+
+    int self = Job_WorkerIndex(graph->jobs);
+    while (__atomic_load_n(&graph->remaining, __ATOMIC_ACQUIRE) > 0)
+    {
+        if (FrameGraph_RunMainTask(graph))
+            continue;
+        if (!Job_RunOne(graph->jobs, self))
+            sched_yield();
+    }
+
+    graph->last_frame_ms = FrameGraph_Now() - graph->frame_start;
+    graph->avg_frame_ms = (graph->avg_frame_ms == 0.0) ? graph->last_frame_ms : graph->avg_frame_ms * 0.9 + graph->last_frame_ms * 0.1;
+    graph->has_previous = true;
+    graph->frame += 1;
+
+    return true;
+}
+
+// Per-stage timings of the last frame (start offset, duration, running average)
+static inline void FrameGraph_PrintTimings(const FrameGraph* graph)
+{
+    printf("frame %llu: %.3f ms (avg %.3f ms)%s\n", (unsigned long long)(graph->frame - 1), graph->last_frame_ms,
+           graph->avg_frame_ms, graph->pipelined ? " pipelined" : "");
+
+    for (int i = 0; i < graph->count; ++i)
+    {
+        const FrameTask* t = &graph->tasks[i];
+        printf("  %-16s %s%s  start %7.3f  took %7.3f  avg %7.3f ms\n", t->name,
+               (t->flags & FRAME_TASK_MAIN_THREAD) ? "M" : "-", (t->flags & FRAME_TASK_RENDER) ? "R" : "-",
+               t->begin_ms, t->last_ms, t->avg_ms);
+    }
+}
+
+#endif
@@ -10,8 +10,11 @@
 #include "shader_utility.h"
 #include "colour_utility.h"
 #include "input_utility.h"
+#include "replay_utility.h"
 #include "camera_utility.h"
 #include "transform_utility.h"
+#include "scene_utility.h"
+#include "ecs_utility.h"
 #include "time_utility.h"
 #include "texture_utility.h"
 #include "darray_utility.h"
@@ -19,5 +22,21 @@
 #include "arena_utility.h"
 #include "stack_utility.h"
 #include "model_utility.h"
+#include "thread_utility.h"
+#include "job_utility.h"
+#include "frame_graph_utility.h"
+#include "command_buffer_utility.h"
+#include "readback_utility.h"
+#include "gl_stats_utility.h"
+#include "profiler_utility.h"
+#include "gpu_profiler_utility.h"
+#include "texture_loader_utility.h"
+#include "gl_extension_utility.h"
+#include "mipmap_utility.h"
+#include "atlas_utility.h"
+#include "texture_array_utility.h"
+#include "texture_compress_utility.h"
+#include "pack_utility.h"
+#include "shader_watcher_utility.h"
 
 #endif
\ No newline at end of file
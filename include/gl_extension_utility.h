@@ -0,0 +1,104 @@
+#ifndef GL_EXTENSION_UTILITY_H
+#define GL_EXTENSION_UTILITY_H
+
+#include <string.h>
+#include <stdbool.h>
+#include <glad/glad.h>
+
+// glad is generated for core 3.3 without extensions, so the few extension
+// tokens the framework uses are declared here and queried at runtime
+
+// GL_EXT_texture_filter_anisotropic (core in 4.6 with the same values)
+#ifndef GL_TEXTURE_MAX_ANISOTROPY_EXT
+#define GL_TEXTURE_MAX_ANISOTROPY_EXT       0x84FE
+#endif
+#ifndef GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT   0x84FF
+#endif
+
+// GL_EXT_texture_compression_s3tc (BC1 / BC3)
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT    0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT    0x83F3
+#endif
+
+// GL_ARB_texture_compression_bptc (BC7, core in 4.2)
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM_ARB
+#define GL_COMPRESSED_RGBA_BPTC_UNORM_ARB   0x8E8C
+#endif
+
+// GL_ARB_get_program_binary (core in 4.1)
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT  0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH            0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS       0x87FE
+#endif
+
+typedef void (APIENTRYP GLExtGetProgramBinaryProc)(GLuint program, GLsizei buf_size, GLsizei* length, GLenum* format, void* binary);
+typedef void (APIENTRYP GLExtProgramBinaryProc)(GLuint program, GLenum format, const void* binary, GLsizei length);
+typedef void (APIENTRYP GLExtProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+
+// the loader glad was initialised with, used for entry points glad was not generated for
+static GLADloadproc GLExt_Loader = NULL;
+
+static inline void GLExt_SetLoader(GLADloadproc loader)
+{
+    GLExt_Loader = loader;
+}
+
+static inline void* GLExt_GetProcAddress(const char* name)
+{
+    return GLExt_Loader ? GLExt_Loader(name) : NULL;
+}
+
+// true if the context version is at least major.minor
+static inline bool GLExt_HasVersion(int major, int minor)
+{
+    GLint ctx_major = 0, ctx_minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &ctx_major);
+    glGetIntegerv(GL_MINOR_VERSION, &ctx_minor);
+    return ctx_major > major || (ctx_major == major && ctx_minor >= minor);
+}
+
+// true if the current context advertises the extension (requires a current context)
+static inline bool GLExt_IsSupported(const char* name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+    for (GLint i = 0; i < count; ++i)
+    {
+        const char* ext = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+        if (ext && strcmp(ext, name) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+// maximum supported anisotropy, 1.0 when the extension is missing. Queried once per translation unit.
+static inline float GLExt_MaxAnisotropy(void)
+{
+    static float max_anisotropy = 0.0f;
+
+    if (max_anisotropy == 0.0f)
+    {
+        max_anisotropy = 1.0f;
+
+        if (GLExt_IsSupported("GL_EXT_texture_filter_anisotropic") ||
+            GLExt_IsSupported("GL_ARB_texture_filter_anisotropic"))
+        {
+            glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &max_anisotropy);
+        }
+    }
+
+    return max_anisotropy;
+}
+
+#endif
@@ -0,0 +1,161 @@
+#ifndef GL_STATS_UTILITY_H
+#define GL_STATS_UTILITY_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <glad/glad.h>
+
+// Counts GL calls by swapping glad's function pointers for counting wrappers. GLStats_Install goes
+// after glad is loaded; everything calling GL through glad (all of the framework) is then counted
+// until GLStats_Uninstall. Covers draws, state binds, uniforms, uploads and clears, the calls that
+// say something about a frame's cost. GL thread only.
+
+typedef struct
+{
+    uint64_t calls;         // every wrapped call
+    uint64_t draws;
+    uint64_t vertices;      // vertices (or indices) submitted, times instance count
+    uint64_t state;         // programs, vertex arrays, textures, buffers, enables, viewport
+    uint64_t uniforms;      // uniform uploads
+    uint64_t queries;       // glGetUniformLocation: a lookup per call is worth knowing about
+    uint64_t uploads;       // buffer and texture data
+    uint64_t clears;
+
+} GLStats;
+
+static GLStats GLStats_Counters;
+static bool GLStats_Installed = false;
+
+static inline void GLStats_Reset(void) { memset(&GLStats_Counters, 0, sizeof(GLStats)); }
+static inline GLStats GLStats_Get(void) { return GLStats_Counters; }
+
+// one wrapper per entry point: Real_<name> keeps glad's pointer
+#define GLSTATS_WRAP(name, type, counter, params, args)     \
+    static type GLStats_Real_##name = NULL;                 \
+    static void APIENTRY GLStats_##name params              \
+    {                                                       \
+        GLStats_Counters.calls += 1;                        \
+        GLStats_Counters.counter += 1;                      \
+        GLStats_Real_##name args;                           \
+    }
+
+#define GLSTATS_WRAP_DRAW(name, type, submitted, params, args)  \
+    static type GLStats_Real_##name = NULL;                     \
+    static void APIENTRY GLStats_##name params                  \
+    {                                                           \
+        GLStats_Counters.calls += 1;                            \
+        GLStats_Counters.draws += 1;                            \
+        GLStats_Counters.vertices += (uint64_t)(submitted);     \
+        GLStats_Real_##name args;                               \
+    }
+
+GLSTATS_WRAP_DRAW(DrawArrays, PFNGLDRAWARRAYSPROC, count,
+                  (GLenum mode, GLint first, GLsizei count), (mode, first, count))
+GLSTATS_WRAP_DRAW(DrawElements, PFNGLDRAWELEMENTSPROC, count,
+                  (GLenum mode, GLsizei count, GLenum type, const void* indices), (mode, count, type, indices))
+GLSTATS_WRAP_DRAW(DrawArraysInstanced, PFNGLDRAWARRAYSINSTANCEDPROC, count * instances,
+                  (GLenum mode, GLint first, GLsizei count, GLsizei instances), (mode, first, count, instances))
+GLSTATS_WRAP_DRAW(DrawElementsInstanced, PFNGLDRAWELEMENTSINSTANCEDPROC, count * instances,
+                  (GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instances), (mode, count, type, indices, instances))
+GLSTATS_WRAP_DRAW(DrawElementsBaseVertex, PFNGLDRAWELEMENTSBASEVERTEXPROC, count,
+                  (GLenum mode, GLsizei count, GLenum type, const void* indices, GLint base), (mode, count, type, indices, base))
+GLSTATS_WRAP_DRAW(DrawElementsInstancedBaseVertex, PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXPROC, count * instances,
+                  (GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instances, GLint base),
+                  (mode, count, type, indices, instances, base))
+
+GLSTATS_WRAP(UseProgram, PFNGLUSEPROGRAMPROC, state, (GLuint program), (program))
+GLSTATS_WRAP(BindVertexArray, PFNGLBINDVERTEXARRAYPROC, state, (GLuint vao), (vao))
+GLSTATS_WRAP(BindTexture, PFNGLBINDTEXTUREPROC, state, (GLenum target, GLuint texture), (target, texture))
+GLSTATS_WRAP(ActiveTexture, PFNGLACTIVETEXTUREPROC, state, (GLenum unit), (unit))
+GLSTATS_WRAP(BindBuffer, PFNGLBINDBUFFERPROC, state, (GLenum target, GLuint buffer), (target, buffer))
+GLSTATS_WRAP(BindBufferRange, PFNGLBINDBUFFERRANGEPROC, state,
+             (GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size), (target, index, buffer, offset, size))
+GLSTATS_WRAP(BindFramebuffer, PFNGLBINDFRAMEBUFFERPROC, state, (GLenum target, GLuint fbo), (target, fbo))
+GLSTATS_WRAP(Enable, PFNGLENABLEPROC, state, (GLenum cap), (cap))
+GLSTATS_WRAP(Disable, PFNGLDISABLEPROC, state, (GLenum cap), (cap))
+GLSTATS_WRAP(Viewport, PFNGLVIEWPORTPROC, state, (GLint x, GLint y, GLsizei w, GLsizei h), (x, y, w, h))
+GLSTATS_WRAP(PolygonMode, PFNGLPOLYGONMODEPROC, state, (GLenum face, GLenum mode), (face, mode))
+
+GLSTATS_WRAP(Uniform1i, PFNGLUNIFORM1IPROC, uniforms, (GLint location, GLint v0), (location, v0))
+GLSTATS_WRAP(Uniform1f, PFNGLUNIFORM1FPROC, uniforms, (GLint location, GLfloat v0), (location, v0))
+GLSTATS_WRAP(Uniform2f, PFNGLUNIFORM2FPROC, uniforms, (GLint location, GLfloat v0, GLfloat v1), (location, v0, v1))
+GLSTATS_WRAP(Uniform3f, PFNGLUNIFORM3FPROC, uniforms, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2), (location, v0, v1, v2))
+GLSTATS_WRAP(Uniform4f, PFNGLUNIFORM4FPROC, uniforms,
+             (GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3), (location, v0, v1, v2, v3))
+GLSTATS_WRAP(Uniform1iv, PFNGLUNIFORM1IVPROC, uniforms, (GLint location, GLsizei count, const GLint* value), (location, count, value))
+GLSTATS_WRAP(UniformMatrix4fv, PFNGLUNIFORMMATRIX4FVPROC, uniforms,
+             (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value), (location, count, transpose, value))
+
+GLSTATS_WRAP(BufferData, PFNGLBUFFERDATAPROC, uploads,
+             (GLenum target, GLsizeiptr size, const void* data, GLenum usage), (target, size, data, usage))
+GLSTATS_WRAP(BufferSubData, PFNGLBUFFERSUBDATAPROC, uploads,
+             (GLenum target, GLintptr offset, GLsizeiptr size, const void* data), (target, offset, size, data))
+GLSTATS_WRAP(TexImage2D, PFNGLTEXIMAGE2DPROC, uploads,
+             (GLenum target, GLint level, GLint internal, GLsizei w, GLsizei h, GLint border, GLenum format, GLenum type, const void* pixels),
+             (target, level, internal, w, h, border, format, type, pixels))
+GLSTATS_WRAP(TexSubImage2D, PFNGLTEXSUBIMAGE2DPROC, uploads,
+             (GLenum target, GLint level, GLint x, GLint y, GLsizei w, GLsizei h, GLenum format, GLenum type, const void* pixels),
+             (target, level, x, y, w, h, format, type, pixels))
+
+GLSTATS_WRAP(Clear, PFNGLCLEARPROC, clears, (GLbitfield mask), (mask))
+
+static PFNGLGETUNIFORMLOCATIONPROC GLStats_Real_GetUniformLocation = NULL;
+static GLint APIENTRY GLStats_GetUniformLocation(GLuint program, const GLchar* name)
+{
+    GLStats_Counters.calls += 1;
+    GLStats_Counters.queries += 1;
+    return GLStats_Real_GetUniformLocation(program, name);
+}
+
+#undef GLSTATS_WRAP
+#undef GLSTATS_WRAP_DRAW
+
+// X-list of every wrapped entry point, used to install and uninstall in one place
+#define GLSTATS_ENTRY_POINTS(X)                                                                 \
+    X(DrawArrays) X(DrawElements) X(DrawArraysInstanced) X(DrawElementsInstanced)               \
+    X(DrawElementsBaseVertex) X(DrawElementsInstancedBaseVertex)                                \
+    X(UseProgram) X(BindVertexArray) X(BindTexture) X(ActiveTexture) X(BindBuffer)              \
+    X(BindBufferRange) X(BindFramebuffer) X(Enable) X(Disable) X(Viewport) X(PolygonMode)       \
+    X(Uniform1i) X(Uniform1f) X(Uniform2f) X(Uniform3f) X(Uniform4f) X(Uniform1iv)              \
+    X(UniformMatrix4fv) X(BufferData) X(BufferSubData) X(TexImage2D) X(TexSubImage2D)           \
+    X(Clear) X(GetUniformLocation)
+
+static inline void GLStats_Install(void)
+{
+    if (GLStats_Installed)
+        return;
+
+    #define GLSTATS_INSTALL(name)                   \
+        GLStats_Real_##name = glad_gl##name;        \
+        if (glad_gl##name)                          \
+            glad_gl##name = GLStats_##name;
+    GLSTATS_ENTRY_POINTS(GLSTATS_INSTALL)
+    #undef GLSTATS_INSTALL
+
+    GLStats_Installed = true;
+    GLStats_Reset();
+}
+
+static inline void GLStats_Uninstall(void)
+{
+    if (!GLStats_Installed)
+        return;
+
+    #define GLSTATS_UNINSTALL(name) glad_gl##name = GLStats_Real_##name;
+    GLSTATS_ENTRY_POINTS(GLSTATS_UNINSTALL)
+    #undef GLSTATS_UNINSTALL
+
+    GLStats_Installed = false;
+}
+
+static inline void GLStats_Print(const GLStats* stats)
+{
+    printf("GL calls: %llu | draws %llu (%llu vertices) | state %llu | uniforms %llu | uniform lookups %llu | uploads %llu | clears %llu\n",
+           (unsigned long long)stats->calls, (unsigned long long)stats->draws, (unsigned long long)stats->vertices,
+           (unsigned long long)stats->state, (unsigned long long)stats->uniforms, (unsigned long long)stats->queries,
+           (unsigned long long)stats->uploads, (unsigned long long)stats->clears);
+}
+
+#endif
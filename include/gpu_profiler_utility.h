@@ -0,0 +1,386 @@
+#ifndef GPU_PROFILER_UTILITY_H
+#define GPU_PROFILER_UTILITY_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <glad/glad.h>
+
+#include "profiler_utility.h"
+
+// GPU pass timing with timer queries. Scopes go around the GL work to time, on the GL thread:
+//
+//     GpuProfiler_BeginFrame();
+//     GpuProfiler_Begin("sky dome");   ...draws...   GpuProfiler_End();
+//     GpuProfiler_Begin("opaque");     ...draws...   GpuProfiler_End();
+//     GpuProfiler_EndFrame();
+//
+// Every scope writes a GL_TIMESTAMP when it opens and when it closes. Top-level scopes (passes) are
+// also wrapped in a GL_TIME_ELAPSED query, which gives their duration: timestamps only mark when the
+// GPU reached a point in the command stream, and a tiling renderer such as llvmpipe reaches all of
+// them before it rasterises anything. Elapsed queries cannot nest, so nested scopes fall back to
+// their timestamps. Frames rotate through GPU_PROFILER_FRAMES query sets and results are only read
+// once GL_QUERY_RESULT_AVAILABLE reports them, so timings arrive a few frames late and reading them
+// never waits on the GPU. A frame that finds its query set still in flight is not timed.
+//
+// Resolved scopes are moved onto the CPU clock and handed to the CPU profiler's GPU track, so a
+// Chrome trace shows each pass next to the frame that submitted it. Passes run in order on the one
+// queue, so each is placed no earlier than the end of the one before. Built with FRAMEWORK_PROFILE the
+// window layer places the frame boundaries and GPU_PROFILE_BEGIN / GPU_PROFILE_END are compiled in.
+// Scope names are stored as pointers, like CPU zone names.
+
+#define GPU_PROFILER_FRAMES     4       // query sets in flight
+#define GPU_PROFILER_SCOPES     32      // scopes per frame, also distinct names in the statistics
+#define GPU_PROFILER_DEPTH      8       // nesting
+
+typedef struct
+{
+    GLuint timestamps[GPU_PROFILER_SCOPES * 2];     // begin, end per scope
+    GLuint elapsed[GPU_PROFILER_SCOPES];            // GL_TIME_ELAPSED, top-level scopes only
+    const char* names[GPU_PROFILER_SCOPES];
+    uint32_t depths[GPU_PROFILER_SCOPES];
+    int parents[GPU_PROFILER_SCOPES];               // enclosing scope, -1 at the top level
+    int count;
+    bool pending;                                   // submitted, results not read back yet
+
+} GpuProfileFrame;
+
+typedef struct
+{
+    const char* name;
+    uint64_t samples;       // resolved frames the scope appeared in
+    double last_ms;         // summed over the scope's uses in the last resolved frame
+    double avg_ms;
+    double max_ms;
+
+} GpuScopeStats;
+
+typedef struct
+{
+    GpuProfileFrame frames[GPU_PROFILER_FRAMES];
+    GpuProfileFrame* current;   // set being recorded, NULL when this frame is not timed
+    int next;                   // set the next frame records into, also the oldest in flight
+    int stack[GPU_PROFILER_DEPTH];
+    int depth;
+
+    GpuScopeStats scopes[GPU_PROFILER_SCOPES];
+    int scope_count;
+
+    int64_t clock_offset_ns;    // CPU profiler clock minus GPU timestamp
+    uint64_t frame;
+    uint64_t resolved;
+    uint64_t skipped;
+    uint64_t overflow;          // scopes not timed: too many in a frame or nested too deep
+    double frame_ms;            // top-level scopes of the last resolved frame
+    double frame_avg_ms;
+
+    bool initialized;
+    bool supported;
+    bool open;                  // between BeginFrame and EndFrame
+
+} GpuProfiler;
+
+static GpuProfiler GpuProfiler_State;
+
+// GL and CPU clocks drift apart slowly; re-measured every few hundred frames
+static inline void GpuProfiler_Calibrate(void)
+{
+    GLint64 gpu = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpu);
+    GpuProfiler_State.clock_offset_ns = (int64_t)Profiler_Now() - (int64_t)gpu;
+}
+
+// Needs a current context; called by the first GpuProfiler_BeginFrame otherwise
+static inline bool GpuProfiler_Init(void)
+{
+    GpuProfiler* p = &GpuProfiler_State;
+    if (p->initialized)
+        return p->supported;
+
+    memset(p, 0, sizeof(GpuProfiler));
+    p->initialized = true;
+
+    // timer queries are core in 3.3 but a driver may still report a 0-bit timestamp counter
+    GLint bits = 0;
+    if (glQueryCounter && glGetQueryObjectui64v)
+        glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+    if (bits == 0)
+    {
+        printf("GPU profiler: timer queries are not supported, GPU timings disabled\n");
+        return false;
+    }
+
+    for (int i = 0; i < GPU_PROFILER_FRAMES; ++i)
+    {
+        glGenQueries(GPU_PROFILER_SCOPES * 2, p->frames[i].timestamps);
+        glGenQueries(GPU_PROFILER_SCOPES, p->frames[i].elapsed);
+    }
+
+    GpuProfiler_Calibrate();
+    p->supported = true;
+    return true;
+}
+
+static inline GpuScopeStats* GpuProfiler_FindScope(const char* name)
+{
+    GpuProfiler* p = &GpuProfiler_State;
+    for (int i = 0; i < p->scope_count; ++i)
+    {
+        if (p->scopes[i].name == name)
+            return &p->scopes[i];
+    }
+
+    if (p->scope_count == GPU_PROFILER_SCOPES)
+        return NULL;
+
+    GpuScopeStats* scope = &p->scopes[p->scope_count++];
+    memset(scope, 0, sizeof(GpuScopeStats));
+    scope->name = name;
+    return scope;
+}
+
+// Reads one submitted set back if all of its queries have finished, without waiting
+static inline bool GpuProfiler_Resolve(GpuProfileFrame* f)
+{
+    GpuProfiler* p = &GpuProfiler_State;
+
+    GLint available = 1;
+    for (int i = 0; available && i < f->count; ++i)
+    {
+        glGetQueryObjectiv(f->timestamps[i * 2 + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available && f->parents[i] < 0)
+            glGetQueryObjectiv(f->elapsed[i], GL_QUERY_RESULT_AVAILABLE, &available);
+    }
+    if (!available)
+        return false;
+
+    // scope intervals on the CPU clock
+    int64_t begins[GPU_PROFILER_SCOPES], ends[GPU_PROFILER_SCOPES], shifts[GPU_PROFILER_SCOPES];
+    double sums[GPU_PROFILER_SCOPES] = { 0 };
+    bool seen[GPU_PROFILER_SCOPES] = { false };
+    int64_t cursor = INT64_MIN;
+    double frame_ms = 0.0;
+
+    for (int i = 0; i < f->count; ++i)
+    {
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(f->timestamps[i * 2], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(f->timestamps[i * 2 + 1], GL_QUERY_RESULT, &end);
+        begins[i] = (int64_t)begin + p->clock_offset_ns;
+        ends[i] = (int64_t)end + p->clock_offset_ns;
+
+        int parent = f->parents[i];
+        if (parent < 0)
+        {
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(f->elapsed[i], GL_QUERY_RESULT, &elapsed);
+
+            int64_t start = begins[i] > cursor ? begins[i] : cursor;
+            shifts[i] = start - begins[i];
+            begins[i] = start;
+            ends[i] = start + (int64_t)elapsed;
+            cursor = ends[i];
+            frame_ms += (double)elapsed * 1e-6;
+        }
+        else
+        {
+            // move with the enclosing scope and stay inside it
+            shifts[i] = shifts[parent];
+            begins[i] += shifts[i];
+            ends[i] += shifts[i];
+            begins[i] = begins[i] < begins[parent] ? begins[parent] : begins[i];
+            begins[i] = begins[i] > ends[parent] ? ends[parent] : begins[i];
+            ends[i] = ends[i] > ends[parent] ? ends[parent] : ends[i];
+            ends[i] = ends[i] < begins[i] ? begins[i] : ends[i];
+        }
+
+        GpuScopeStats* scope = GpuProfiler_FindScope(f->names[i]);
+        if (scope)
+        {
+            sums[scope - p->scopes] += (double)(ends[i] - begins[i]) * 1e-6;
+            seen[scope - p->scopes] = true;
+        }
+
+#ifdef FRAMEWORK_PROFILE
+        Profiler_AddEvent(f->names[i], (uint64_t)begins[i], (uint64_t)ends[i], f->depths[i], PROFILER_GPU_TRACK);
+#endif
+    }
+
+    p->frame_ms = frame_ms;
+    p->frame_avg_ms = (p->resolved == 0) ? frame_ms : p->frame_avg_ms * 0.95 + frame_ms * 0.05;
+
+    for (int i = 0; i < p->scope_count; ++i)
+    {
+        if (!seen[i])
+            continue;
+
+        GpuScopeStats* scope = &p->scopes[i];
+        scope->last_ms = sums[i];
+        scope->avg_ms = (scope->samples == 0) ? sums[i] : scope->avg_ms * 0.95 + sums[i] * 0.05;
+        scope->max_ms = sums[i] > scope->max_ms ? sums[i] : scope->max_ms;
+        scope->samples += 1;
+    }
+
+    f->pending = false;
+    p->resolved += 1;
+    return true;
+}
+
+// Reads back every finished set, oldest first
+static inline void GpuProfiler_Poll(void)
+{
+    GpuProfiler* p = &GpuProfiler_State;
+    for (int i = 0; i < GPU_PROFILER_FRAMES; ++i)
+    {
+        GpuProfileFrame* f = &p->frames[(p->next + i) % GPU_PROFILER_FRAMES];
+        if (f->pending && !GpuProfiler_Resolve(f))
+            break;
+    }
+}
+
+// Opens a frame; does nothing when one is already open, so the window layer and a caller can both place boundaries
+static inline void GpuProfiler_BeginFrame(void)
+{
+    GpuProfiler* p = &GpuProfiler_State;
+    if (!GpuProfiler_Init() || p->open)
+        return;
+
+    GpuProfiler_Poll();
+    if ((p->frame & 255) == 255)
+        GpuProfiler_Calibrate();
+
+    p->open = true;
+    p->depth = 0;
+    p->frame += 1;
+
+    GpuProfileFrame* f = &p->frames[p->next];
+    if (f->pending)
+    {
+        p->current = NULL;
+        p->skipped += 1;
+        return;
+    }
+
+    f->count = 0;
+    p->current = f;
+}
+
+static inline void GpuProfiler_Begin(const char* name)
+{
+    GpuProfiler* p = &GpuProfiler_State;
+    if (!p->open)
+        return;
+
+    int index = -1;
+    GpuProfileFrame* f = p->current;
+    if (f && f->count < GPU_PROFILER_SCOPES && p->depth < GPU_PROFILER_DEPTH)
+    {
+        index = f->count++;
+        f->names[index] = name;
+        f->depths[index] = (uint32_t)p->depth;
+        f->parents[index] = -1;
+        for (int d = p->depth - 1; d >= 0 && f->parents[index] < 0; --d)
+            f->parents[index] = p->stack[d];
+
+        glQueryCounter(f->timestamps[index * 2], GL_TIMESTAMP);
+        if (f->parents[index] < 0)
+            glBeginQuery(GL_TIME_ELAPSED, f->elapsed[index]);
+    }
+    else if (f)
+    {
+        p->overflow += 1;
+    }
+
+    if (p->depth < GPU_PROFILER_DEPTH)
+        p->stack[p->depth] = index;
+    p->depth += 1;
+}
+
+static inline void GpuProfiler_End(void)
+{
+    GpuProfiler* p = &GpuProfiler_State;
+    if (!p->open || p->depth == 0)
+        return;
+
+    p->depth -= 1;
+    if (!p->current || p->depth >= GPU_PROFILER_DEPTH || p->stack[p->depth] < 0)
+        return;
+
+    int index = p->stack[p->depth];
+    if (p->current->parents[index] < 0)
+        glEndQuery(GL_TIME_ELAPSED);
+    glQueryCounter(p->current->timestamps[index * 2 + 1], GL_TIMESTAMP);
+}
+
+static inline void GpuProfiler_EndFrame(void)
+{
+    GpuProfiler* p = &GpuProfiler_State;
+    if (!p->open)
+        return;
+
+    // close anything left open so the set resolves
+    while (p->depth > 0)
+        GpuProfiler_End();
+
+    if (p->current)
+    {
+        p->current->pending = true;
+        p->next = (p->next + 1) % GPU_PROFILER_FRAMES;
+    }
+
+    p->current = NULL;
+    p->open = false;
+}
+
+// Waits for the GPU and reads every set still in flight, for the end of a run
+static inline void GpuProfiler_Flush(void)
+{
+    if (!GpuProfiler_State.supported)
+        return;
+
+    GpuProfiler_EndFrame();
+    glFinish();
+    GpuProfiler_Poll();
+}
+
+static inline void GpuProfiler_Print(void)
+{
+    const GpuProfiler* p = &GpuProfiler_State;
+    printf("GPU frame: last %7.3f  avg %7.3f ms | %llu frames timed, %llu skipped, %llu scopes dropped\n",
+           p->frame_ms, p->frame_avg_ms, (unsigned long long)p->resolved, (unsigned long long)p->skipped,
+           (unsigned long long)p->overflow);
+
+    for (int i = 0; i < p->scope_count; ++i)
+    {
+        const GpuScopeStats* s = &p->scopes[i];
+        printf("  %-24s last %8.3f  avg %8.3f  max %8.3f ms\n", s->name, s->last_ms, s->avg_ms, s->max_ms);
+    }
+}
+
+static inline void GpuProfiler_Delete(void)
+{
+    GpuProfiler* p = &GpuProfiler_State;
+    if (p->supported)
+    {
+        while (p->depth > 0)
+            GpuProfiler_End();
+
+        for (int i = 0; i < GPU_PROFILER_FRAMES; ++i)
+        {
+            glDeleteQueries(GPU_PROFILER_SCOPES * 2, p->frames[i].timestamps);
+            glDeleteQueries(GPU_PROFILER_SCOPES, p->frames[i].elapsed);
+        }
+    }
+    memset(p, 0, sizeof(GpuProfiler));
+}
+
+#ifdef FRAMEWORK_PROFILE
+#define GPU_PROFILE_BEGIN(name)     GpuProfiler_Begin(name)
+#define GPU_PROFILE_END()           GpuProfiler_End()
+#else
+#define GPU_PROFILE_BEGIN(name)     ((void)0)
+#define GPU_PROFILE_END()           ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,263 @@
+#ifndef HEADLESS_UTILITY_H
+#define HEADLESS_UTILITY_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <dlfcn.h>
+#include <glad/glad.h>
+
+// Offscreen GL 3.3 core context for machines without a display: CI, render farms, perf runs.
+// libEGL is opened at runtime, so nothing extra is needed to build and a windowed build never
+// touches it. The context is surfaceless (EGL_MESA_platform_surfaceless, works with llvmpipe and
+// GPU drivers alike) with a pbuffer display as the fallback; either way rendering goes into an
+// FBO the size of the requested window, which stays bound as the default target.
+
+typedef void* HeadlessEGLDisplay;
+typedef void* HeadlessEGLContext;
+typedef void* HeadlessEGLSurface;
+typedef void* HeadlessEGLConfig;
+typedef int32_t HeadlessEGLint;
+
+#define HEADLESS_EGL_NONE                           0x3038
+#define HEADLESS_EGL_OPENGL_API                     0x30A2
+#define HEADLESS_EGL_PLATFORM_SURFACELESS_MESA      0x31DD
+#define HEADLESS_EGL_CONTEXT_MAJOR_VERSION          0x3098
+#define HEADLESS_EGL_CONTEXT_MINOR_VERSION          0x30FB
+#define HEADLESS_EGL_CONTEXT_OPENGL_PROFILE_MASK    0x30FD
+#define HEADLESS_EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT 0x0001
+#define HEADLESS_EGL_SURFACE_TYPE                   0x3033
+#define HEADLESS_EGL_PBUFFER_BIT                    0x0001
+#define HEADLESS_EGL_RENDERABLE_TYPE                0x3040
+#define HEADLESS_EGL_OPENGL_BIT                     0x0008
+#define HEADLESS_EGL_WIDTH                          0x3057
+#define HEADLESS_EGL_HEIGHT                         0x3056
+#define HEADLESS_EGL_EXTENSIONS                     0x3055
+
+typedef struct
+{
+    void* library;
+    HeadlessEGLDisplay display;
+    HeadlessEGLContext context;
+    HeadlessEGLSurface surface;     // only with the pbuffer fallback
+
+    unsigned int fbo;
+    unsigned int colour_rb;
+    unsigned int depth_rb;
+    int width, height;
+
+    // EGL entry points
+    void* (*GetProcAddress)(const char* name);
+    HeadlessEGLDisplay (*GetDisplay)(void* native);
+    unsigned int (*Initialize)(HeadlessEGLDisplay, HeadlessEGLint*, HeadlessEGLint*);
+    unsigned int (*Terminate)(HeadlessEGLDisplay);
+    unsigned int (*BindAPI)(unsigned int);
+    unsigned int (*ChooseConfig)(HeadlessEGLDisplay, const HeadlessEGLint*, HeadlessEGLConfig*, HeadlessEGLint, HeadlessEGLint*);
+    HeadlessEGLContext (*CreateContext)(HeadlessEGLDisplay, HeadlessEGLConfig, HeadlessEGLContext, const HeadlessEGLint*);
+    unsigned int (*DestroyContext)(HeadlessEGLDisplay, HeadlessEGLContext);
+    HeadlessEGLSurface (*CreatePbufferSurface)(HeadlessEGLDisplay, HeadlessEGLConfig, const HeadlessEGLint*);
+    unsigned int (*DestroySurface)(HeadlessEGLDisplay, HeadlessEGLSurface);
+    unsigned int (*MakeCurrent)(HeadlessEGLDisplay, HeadlessEGLSurface, HeadlessEGLSurface, HeadlessEGLContext);
+    const char* (*QueryString)(HeadlessEGLDisplay, HeadlessEGLint);
+
+} HeadlessContext;
+
+// glad and GLExt load through this; EGL hands out core entry points too on Mesa and current drivers
+static HeadlessContext* Headless_Current = NULL;
+
+static inline void* Headless_GetProcAddress(const char* name)
+{
+    if (!Headless_Current)
+        return NULL;
+
+    void* proc = Headless_Current->GetProcAddress(name);
+    if (!proc)
+        proc = dlsym(Headless_Current->library, name);
+    return proc;
+}
+
+static inline bool Headless_LoadEGL(HeadlessContext* ctx)
+{
+    ctx->library = dlopen("libEGL.so.1", RTLD_NOW | RTLD_LOCAL);
+    if (!ctx->library)
+        ctx->library = dlopen("libEGL.so", RTLD_NOW | RTLD_LOCAL);
+    if (!ctx->library)
+    {
+        printf("Headless: libEGL not found (%s)\n", dlerror());
+        return false;
+    }
+
+    // POSIX allows the object pointer to function pointer conversion dlsym relies on
+    #define HEADLESS_LOAD(field, name) *(void**)(&ctx->field) = dlsym(ctx->library, name)
+    HEADLESS_LOAD(GetProcAddress, "eglGetProcAddress");
+    HEADLESS_LOAD(GetDisplay, "eglGetDisplay");
+    HEADLESS_LOAD(Initialize, "eglInitialize");
+    HEADLESS_LOAD(Terminate, "eglTerminate");
+    HEADLESS_LOAD(BindAPI, "eglBindAPI");
+    HEADLESS_LOAD(ChooseConfig, "eglChooseConfig");
+    HEADLESS_LOAD(CreateContext, "eglCreateContext");
+    HEADLESS_LOAD(DestroyContext, "eglDestroyContext");
+    HEADLESS_LOAD(CreatePbufferSurface, "eglCreatePbufferSurface");
+    HEADLESS_LOAD(DestroySurface, "eglDestroySurface");
+    HEADLESS_LOAD(MakeCurrent, "eglMakeCurrent");
+    HEADLESS_LOAD(QueryString, "eglQueryString");
+    #undef HEADLESS_LOAD
+
+    if (!ctx->GetProcAddress || !ctx->GetDisplay || !ctx->Initialize || !ctx->CreateContext || !ctx->MakeCurrent || !ctx->ChooseConfig)
+    {
+        printf("Headless: libEGL is missing entry points\n");
+        dlclose(ctx->library);
+        ctx->library = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+static inline void Headless_Destroy(HeadlessContext* ctx)
+{
+    if (ctx->fbo)
+    {
+        glDeleteFramebuffers(1, &ctx->fbo);
+        glDeleteRenderbuffers(1, &ctx->colour_rb);
+        glDeleteRenderbuffers(1, &ctx->depth_rb);
+    }
+
+    if (ctx->display)
+    {
+        ctx->MakeCurrent(ctx->display, NULL, NULL, NULL);
+        if (ctx->context)
+            ctx->DestroyContext(ctx->display, ctx->context);
+        if (ctx->surface)
+            ctx->DestroySurface(ctx->display, ctx->surface);
+        ctx->Terminate(ctx->display);
+    }
+
+    if (ctx->library)
+        dlclose(ctx->library);
+
+    if (Headless_Current == ctx)
+        Headless_Current = NULL;
+
+    memset(ctx, 0, sizeof(HeadlessContext));
+}
+
+static inline bool Headless_CreateFramebuffer(HeadlessContext* ctx)
+{
+    glGenFramebuffers(1, &ctx->fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, ctx->fbo);
+
+    glGenRenderbuffers(1, &ctx->colour_rb);
+    glBindRenderbuffer(GL_RENDERBUFFER, ctx->colour_rb);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, ctx->width, ctx->height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, ctx->colour_rb);
+
+    glGenRenderbuffers(1, &ctx->depth_rb);
+    glBindRenderbuffer(GL_RENDERBUFFER, ctx->depth_rb);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, ctx->width, ctx->height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, ctx->depth_rb);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        printf("Headless: offscreen framebuffer incomplete\n");
+        return false;
+    }
+
+    glViewport(0, 0, ctx->width, ctx->height);
+    return true;
+}
+
+// Creates a GL 3.3 core context and an offscreen width x height target, and loads glad through it
+static inline bool Headless_Create(HeadlessContext* ctx, int width, int height)
+{
+    memset(ctx, 0, sizeof(HeadlessContext));
+    ctx->width = width;
+    ctx->height = height;
+
+    if (!Headless_LoadEGL(ctx))
+        return false;
+
+    const HeadlessEGLint context_attribs[] = {
+        HEADLESS_EGL_CONTEXT_MAJOR_VERSION, 3,
+        HEADLESS_EGL_CONTEXT_MINOR_VERSION, 3,
+        HEADLESS_EGL_CONTEXT_OPENGL_PROFILE_MASK, HEADLESS_EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        HEADLESS_EGL_NONE
+    };
+
+    // surfaceless first: no config and no surface needed
+    HeadlessEGLDisplay (*GetPlatformDisplay)(unsigned int, void*, const intptr_t*) = NULL;
+    *(void**)(&GetPlatformDisplay) = ctx->GetProcAddress("eglGetPlatformDisplayEXT");
+
+    const char* client_extensions = ctx->QueryString ? ctx->QueryString(NULL, HEADLESS_EGL_EXTENSIONS) : NULL;
+    if (GetPlatformDisplay && client_extensions && strstr(client_extensions, "EGL_MESA_platform_surfaceless"))
+    {
+        HeadlessEGLint major, minor;
+        ctx->display = GetPlatformDisplay(HEADLESS_EGL_PLATFORM_SURFACELESS_MESA, NULL, NULL);
+        if (ctx->display && ctx->Initialize(ctx->display, &major, &minor) && ctx->BindAPI(HEADLESS_EGL_OPENGL_API))
+            ctx->context = ctx->CreateContext(ctx->display, NULL, NULL, context_attribs);
+
+        if (ctx->context && !ctx->MakeCurrent(ctx->display, NULL, NULL, ctx->context))
+        {
+            ctx->DestroyContext(ctx->display, ctx->context);
+            ctx->context = NULL;
+        }
+
+        if (!ctx->context && ctx->display)
+        {
+            ctx->Terminate(ctx->display);
+            ctx->display = NULL;
+        }
+    }
+
+    // pbuffer on the default display
+    if (!ctx->context)
+    {
+        const HeadlessEGLint config_attribs[] = {
+            HEADLESS_EGL_SURFACE_TYPE, HEADLESS_EGL_PBUFFER_BIT,
+            HEADLESS_EGL_RENDERABLE_TYPE, HEADLESS_EGL_OPENGL_BIT,
+            HEADLESS_EGL_NONE
+        };
+        const HeadlessEGLint pbuffer_attribs[] = { HEADLESS_EGL_WIDTH, width, HEADLESS_EGL_HEIGHT, height, HEADLESS_EGL_NONE };
+
+        HeadlessEGLint major, minor, count = 0;
+        HeadlessEGLConfig config = NULL;
+
+        ctx->display = ctx->GetDisplay(NULL);
+        if (ctx->display && ctx->Initialize(ctx->display, &major, &minor) && ctx->BindAPI(HEADLESS_EGL_OPENGL_API) &&
+            ctx->ChooseConfig(ctx->display, config_attribs, &config, 1, &count) && count > 0)
+        {
+            ctx->surface = ctx->CreatePbufferSurface(ctx->display, config, pbuffer_attribs);
+            ctx->context = ctx->CreateContext(ctx->display, config, NULL, context_attribs);
+        }
+
+        if (!ctx->context || !ctx->MakeCurrent(ctx->display, ctx->surface, ctx->surface, ctx->context))
+        {
+            printf("Headless: could not create an EGL GL 3.3 core context\n");
+            Headless_Destroy(ctx);
+            return false;
+        }
+    }
+
+    Headless_Current = ctx;
+
+    if (!gladLoadGLLoader((GLADloadproc)Headless_GetProcAddress))
+    {
+        printf("Failed to initialize GLAD\n");
+        Headless_Destroy(ctx);
+        return false;
+    }
+
+    if (!Headless_CreateFramebuffer(ctx))
+    {
+        Headless_Destroy(ctx);
+        return false;
+    }
+
+    printf("Headless context: %s (%s), %dx%d offscreen\n", (const char*)glGetString(GL_RENDERER),
+           ctx->surface ? "pbuffer" : "surfaceless", width, height);
+
+    return true;
+}
+
+#endif
@@ -0,0 +1,194 @@
+#ifndef IMAGE_WRITE_UTILITY_H
+#define IMAGE_WRITE_UTILITY_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+// Writes RGBA8 images to disk: PNG (deflate "stored" blocks, no compression, so writing costs
+// little more than the raw copy and any PNG reader, stb_image included, loads it back) and raw
+// RGBA. flip_vert writes the rows bottom-up, which is what glReadPixels returns.
+
+typedef enum
+{
+    IMAGE_FORMAT_PNG,
+    IMAGE_FORMAT_RAW,   // width * height * 4 bytes, top row first, no header
+
+} ImageFormat;
+
+typedef struct
+{
+    FILE* file;
+    uint32_t crc;
+    uint32_t crc_table[256];
+    uint32_t adler_a, adler_b;
+
+    size_t deflate_left;    // bytes of image data still to go through deflate
+    size_t block_left;      // bytes left in the current stored block
+
+} PngStream;
+
+static inline void PngStream_WriteU32(FILE* file, uint32_t value)
+{
+    uint8_t bytes[4] = { (uint8_t)(value >> 24), (uint8_t)(value >> 16), (uint8_t)(value >> 8), (uint8_t)value };
+    fwrite(bytes, 1, 4, file);
+}
+
+// bytes inside a chunk: written and added to the chunk CRC
+static inline void PngStream_Write(PngStream* png, const void* data, size_t size)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint32_t crc = png->crc;
+    for (size_t i = 0; i < size; ++i)
+        crc = png->crc_table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    png->crc = crc;
+
+    fwrite(data, 1, size, png->file);
+}
+
+static inline void PngStream_BeginChunk(PngStream* png, const char* type, uint32_t length)
+{
+    PngStream_WriteU32(png->file, length);
+    png->crc = 0xFFFFFFFFu;
+    PngStream_Write(png, type, 4);
+}
+
+static inline void PngStream_EndChunk(PngStream* png)
+{
+    PngStream_WriteU32(png->file, png->crc ^ 0xFFFFFFFFu);
+}
+
+// image data through zlib: stored blocks of at most 65535 bytes plus the running adler32
+static inline void PngStream_Deflate(PngStream* png, const uint8_t* data, size_t size)
+{
+    while (size > 0)
+    {
+        if (png->block_left == 0)
+        {
+            uint16_t length = (uint16_t)(png->deflate_left < 65535 ? png->deflate_left : 65535);
+            uint8_t header[5] = { (uint8_t)(png->deflate_left == length), (uint8_t)length, (uint8_t)(length >> 8),
+                                  (uint8_t)~length, (uint8_t)(~length >> 8) };
+            PngStream_Write(png, header, 5);
+            png->block_left = length;
+        }
+
+        size_t n = size < png->block_left ? size : png->block_left;
+
+        // adler32, reduced often enough that the sums cannot overflow
+        for (size_t i = 0; i < n; )
+        {
+            size_t end = (n - i > 5552) ? i + 5552 : n;
+            for (; i < end; ++i)
+            {
+                png->adler_a += data[i];
+                png->adler_b += png->adler_a;
+            }
+            png->adler_a %= 65521;
+            png->adler_b %= 65521;
+        }
+
+        PngStream_Write(png, data, n);
+        data += n;
+        size -= n;
+        png->block_left -= n;
+        png->deflate_left -= n;
+    }
+}
+
+static inline bool Image_WritePNG(const char* path, const uint8_t* pixels, int width, int height, bool flip_vert)
+{
+    FILE* file = fopen(path, "wb");
+    if (!file)
+    {
+        printf("Failed to open %s for writing\n", path);
+        return false;
+    }
+
+    PngStream png;
+    memset(&png, 0, sizeof(PngStream));
+    png.file = file;
+    png.adler_a = 1;
+
+    for (uint32_t n = 0; n < 256; ++n)
+    {
+        uint32_t c = n;
+        for (int k = 0; k < 8; ++k)
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        png.crc_table[n] = c;
+    }
+
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    fwrite(signature, 1, 8, file);
+
+    uint8_t ihdr[13] = { (uint8_t)(width >> 24), (uint8_t)(width >> 16), (uint8_t)(width >> 8), (uint8_t)width,
+                         (uint8_t)(height >> 24), (uint8_t)(height >> 16), (uint8_t)(height >> 8), (uint8_t)height,
+                         8, 6, 0, 0, 0 };   // 8 bit RGBA, no interlacing
+    PngStream_BeginChunk(&png, "IHDR", 13);
+    PngStream_Write(&png, ihdr, 13);
+    PngStream_EndChunk(&png);
+
+    // every row is prefixed with filter type 0 (none)
+    size_t row_size = (size_t)width * 4;
+    size_t data_size = (row_size + 1) * (size_t)height;
+    size_t block_count = (data_size + 65534) / 65535;
+
+    PngStream_BeginChunk(&png, "IDAT", (uint32_t)(2 + data_size + block_count * 5 + 4));
+    static const uint8_t zlib_header[2] = { 0x78, 0x01 };
+    PngStream_Write(&png, zlib_header, 2);
+
+    png.deflate_left = data_size;
+    for (int y = 0; y < height; ++y)
+    {
+        const uint8_t filter = 0;
+        int row = flip_vert ? height - 1 - y : y;
+        PngStream_Deflate(&png, &filter, 1);
+        PngStream_Deflate(&png, pixels + (size_t)row * row_size, row_size);
+    }
+
+    uint8_t adler[4] = { (uint8_t)(png.adler_b >> 8), (uint8_t)png.adler_b, (uint8_t)(png.adler_a >> 8), (uint8_t)png.adler_a };
+    PngStream_Write(&png, adler, 4);
+    PngStream_EndChunk(&png);
+
+    PngStream_BeginChunk(&png, "IEND", 0);
+    PngStream_EndChunk(&png);
+
+    bool ok = !ferror(file);
+    fclose(file);
+    if (!ok)
+        printf("Failed to write %s\n", path);
+    return ok;
+}
+
+static inline bool Image_WriteRaw(const char* path, const uint8_t* pixels, int width, int height, bool flip_vert)
+{
+    FILE* file = fopen(path, "wb");
+    if (!file)
+    {
+        printf("Failed to open %s for writing\n", path);
+        return false;
+    }
+
+    size_t row_size = (size_t)width * 4;
+    if (flip_vert)
+    {
+        for (int y = height - 1; y >= 0; --y)
+            fwrite(pixels + (size_t)y * row_size, 1, row_size, file);
+    }
+    else
+        fwrite(pixels, 1, row_size * (size_t)height, file);
+
+    bool ok = !ferror(file);
+    fclose(file);
+    if (!ok)
+        printf("Failed to write %s\n", path);
+    return ok;
+}
+
+static inline bool Image_Write(const char* path, ImageFormat format, const uint8_t* pixels, int width, int height, bool flip_vert)
+{
+    return format == IMAGE_FORMAT_PNG ? Image_WritePNG(path, pixels, width, height, flip_vert)
+                                      : Image_WriteRaw(path, pixels, width, height, flip_vert);
+}
+
+#endif
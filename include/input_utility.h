@@ -1,12 +1,231 @@
 #ifndef INPUT_UTILITY_H
 #define INPUT_UTILITY_H
 
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
 #include <GLFW/glfw3.h>
-#include "window_utility.h"
 
-static inline bool IsKeyPressed(const Window* window, int key)
+#include "math_utility.h"
+
+// Event-driven input. GLFW's key, mouse button, cursor and scroll callbacks push events into a
+// lock-free single-producer queue; Input_Update drains it once per frame into a snapshot of bitsets:
+// held keys plus the keys that went down or up since the previous snapshot (a tap shorter than a
+// frame still shows up as pressed and released). Queries are then a bit test, with no GLFW call.
+//
+// Window_PollEvents takes the snapshot after polling. A program that simulates on another thread
+// sets Input_State.manual and calls Input_Update from that thread instead; the callbacks only touch
+// the queue, so the two sides never share anything else. Snapshots are plain data and can be copied
+// out (Input_GetSnapshot) and substituted (Input_SetSnapshot).
+
+#define INPUT_QUEUE_SIZE        1024                    // events between two updates, power of two
+#define INPUT_KEY_WORDS         ((GLFW_KEY_LAST + 64) / 64)
+#define INPUT_MOUSE_BUTTONS     8
+
+typedef enum
+{
+    INPUT_EVENT_KEY,
+    INPUT_EVENT_MOUSE_BUTTON,
+    INPUT_EVENT_CURSOR,
+    INPUT_EVENT_SCROLL,
+
+} InputEventType;
+
+typedef struct
+{
+    uint8_t type;
+    uint8_t action;     // GLFW_PRESS, GLFW_RELEASE
+    int16_t code;       // key or mouse button
+    float x, y;         // cursor position or scroll offset
+
+} InputEvent;
+
+typedef struct
+{
+    uint64_t held[INPUT_KEY_WORDS];
+    uint64_t pressed[INPUT_KEY_WORDS];      // went down since the previous snapshot
+    uint64_t released[INPUT_KEY_WORDS];     // went up since the previous snapshot
+    uint8_t mouse_held;
+    uint8_t mouse_pressed;
+    uint8_t mouse_released;
+    Vector2 cursor;
+    Vector2 cursor_delta;
+    Vector2 scroll;                         // summed since the previous snapshot
+
+} InputSnapshot;
+
+typedef struct
+{
+    InputEvent events[INPUT_QUEUE_SIZE];
+    uint64_t write;         // advanced by the callbacks only
+    uint64_t read;          // advanced by Input_Update only
+    uint64_t dropped;       // events lost to a full queue
+
+    InputSnapshot current;
+    bool has_cursor;        // no delta for the first cursor event
+    bool manual;            // Window_PollEvents leaves Input_Update to the caller
+
+} Input;
+
+static Input Input_State;
+
+static inline void Input_Push(const InputEvent* event)
+{
+    Input* input = &Input_State;
+    uint64_t write = input->write;
+    if (write - __atomic_load_n(&input->read, __ATOMIC_ACQUIRE) >= INPUT_QUEUE_SIZE)
+    {
+        input->dropped += 1;
+        return;
+    }
+
+    input->events[write & (INPUT_QUEUE_SIZE - 1)] = *event;
+    __atomic_store_n(&input->write, write + 1, __ATOMIC_RELEASE);
+}
+
+static inline void Input_KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    (void)window; (void)scancode; (void)mods;
+    if (key < 0 || key > GLFW_KEY_LAST || (action != GLFW_PRESS && action != GLFW_RELEASE))
+        return;
+
+    InputEvent event = { INPUT_EVENT_KEY, (uint8_t)action, (int16_t)key, 0.0f, 0.0f };
+    Input_Push(&event);
+}
+
+static inline void Input_MouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
+{
+    (void)window; (void)mods;
+    if (button < 0 || button >= INPUT_MOUSE_BUTTONS)
+        return;
+
+    InputEvent event = { INPUT_EVENT_MOUSE_BUTTON, (uint8_t)action, (int16_t)button, 0.0f, 0.0f };
+    Input_Push(&event);
+}
+
+static inline void Input_CursorCallback(GLFWwindow* window, double x, double y)
+{
+    (void)window;
+    InputEvent event = { INPUT_EVENT_CURSOR, 0, 0, (float)x, (float)y };
+    Input_Push(&event);
+}
+
+static inline void Input_ScrollCallback(GLFWwindow* window, double x, double y)
+{
+    (void)window;
+    InputEvent event = { INPUT_EVENT_SCROLL, 0, 0, (float)x, (float)y };
+    Input_Push(&event);
+}
+
+// Called by Window_Init for GLFW windows
+static inline void Input_Install(GLFWwindow* window)
+{
+    memset(&Input_State, 0, sizeof(Input));
+    glfwSetKeyCallback(window, Input_KeyCallback);
+    glfwSetMouseButtonCallback(window, Input_MouseButtonCallback);
+    glfwSetCursorPosCallback(window, Input_CursorCallback);
+    glfwSetScrollCallback(window, Input_ScrollCallback);
+}
+
+// Drains the queue into a new snapshot; once per frame, on the thread that reads input
+static inline void Input_Update(void)
+{
+    Input* input = &Input_State;
+    InputSnapshot* s = &input->current;
+
+    memset(s->pressed, 0, sizeof(s->pressed));
+    memset(s->released, 0, sizeof(s->released));
+    s->mouse_pressed = 0;
+    s->mouse_released = 0;
+    s->cursor_delta = (Vector2){ 0.0f, 0.0f };
+    s->scroll = (Vector2){ 0.0f, 0.0f };
+
+    uint64_t read = input->read;
+    uint64_t write = __atomic_load_n(&input->write, __ATOMIC_ACQUIRE);
+    for (; read < write; ++read)
+    {
+        const InputEvent* event = &input->events[read & (INPUT_QUEUE_SIZE - 1)];
+        switch (event->type)
+        {
+        case INPUT_EVENT_KEY:
+        {
+            uint64_t bit = 1ull << (event->code & 63);
+            int word = event->code >> 6;
+            if (event->action == GLFW_PRESS)
+            {
+                s->pressed[word] |= bit;
+                s->held[word] |= bit;
+            }
+            else
+            {
+                s->released[word] |= bit;
+                s->held[word] &= ~bit;
+            }
+            break;
+        }
+        case INPUT_EVENT_MOUSE_BUTTON:
+        {
+            uint8_t bit = (uint8_t)(1u << event->code);
+            if (event->action == GLFW_PRESS)
+            {
+                s->mouse_pressed |= bit;
+                s->mouse_held |= bit;
+            }
+            else
+            {
+                s->mouse_released |= bit;
+                s->mouse_held &= (uint8_t)~bit;
+            }
+            break;
+        }
+        case INPUT_EVENT_CURSOR:
+            if (input->has_cursor)
+            {
+                s->cursor_delta.x += event->x - s->cursor.x;
+                s->cursor_delta.y += event->y - s->cursor.y;
+            }
+            s->cursor = (Vector2){ event->x, event->y };
+            input->has_cursor = true;
+            break;
+        case INPUT_EVENT_SCROLL:
+            s->scroll.x += event->x;
+            s->scroll.y += event->y;
+            break;
+        }
+    }
+    __atomic_store_n(&input->read, read, __ATOMIC_RELEASE);
+}
+
+static inline InputSnapshot Input_GetSnapshot(void) { return Input_State.current; }
+static inline void Input_SetSnapshot(const InputSnapshot* snapshot) { Input_State.current = *snapshot; }
+
+static inline bool Input_TestKey(const uint64_t* bits, int key)
+{
+    if (key < 0 || key > GLFW_KEY_LAST)
+        return false;
+    return (bits[key >> 6] >> (key & 63)) & 1;
+}
+
+static inline bool Input_KeyDown(int key)     { return Input_TestKey(Input_State.current.held, key); }
+static inline bool Input_KeyPressed(int key)  { return Input_TestKey(Input_State.current.pressed, key); }
+static inline bool Input_KeyReleased(int key) { return Input_TestKey(Input_State.current.released, key); }
+
+static inline bool Input_MouseDown(int button)     { return button >= 0 && button < INPUT_MOUSE_BUTTONS && ((Input_State.current.mouse_held >> button) & 1); }
+static inline bool Input_MousePressed(int button)  { return button >= 0 && button < INPUT_MOUSE_BUTTONS && ((Input_State.current.mouse_pressed >> button) & 1); }
+static inline bool Input_MouseReleased(int button) { return button >= 0 && button < INPUT_MOUSE_BUTTONS && ((Input_State.current.mouse_released >> button) & 1); }
+
+static inline Vector2 Input_CursorPosition(void) { return Input_State.current.cursor; }
+static inline Vector2 Input_CursorDelta(void)    { return Input_State.current.cursor_delta; }
+static inline Vector2 Input_ScrollDelta(void)    { return Input_State.current.scroll; }
+
+// defined in window_utility.h, which includes this file
+struct Window;
+
+// held down in the current snapshot; in headless runs only a replayed recording presses keys
+static inline bool IsKeyPressed(const struct Window* window, int key)
 {
-    return glfwGetKey(window->w, key) == GLFW_PRESS;
+    (void)window;
+    return Input_KeyDown(key);
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,551 @@
+#ifndef JOB_UTILITY_H
+#define JOB_UTILITY_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <sched.h>
+#include "thread_utility.h"
+#include "profiler_utility.h"
+
+// Work-stealing job system. Every worker (the thread calling Job_Create is worker 0, the rest are
+// spawned) owns a Chase-Lev deque: the owner pushes and pops at the bottom, idle workers steal from
+// the top. Jobs submitted from threads outside the system go through a small locked queue.
+//
+// Completion is tracked with JobCounters: every job started against a counter increments it, and
+// finishing decrements it. Job_Wait runs other jobs while the counter drains instead of blocking,
+// and Job_RunAfter queues a job to start once a counter reaches zero.
+//
+// Atomics are GCC __atomic builtins so the header builds unchanged as C99 and C++ and stays visible
+// to ThreadSanitizer.
+
+#define JOB_MAX_WORKERS         64
+#define JOB_DEQUE_SIZE          4096    // power of two
+#define JOB_INJECT_SIZE         1024
+#define JOB_COUNTER_WAITERS     16
+#define JOB_SPINS_BEFORE_SLEEP  64
+
+// a job covers the index range [begin, end); single jobs get [0, 1)
+typedef void (*JobFunc)(void* data, int begin, int end);
+
+typedef struct JobCounter JobCounter;
+
+typedef struct
+{
+    JobFunc func;
+    void* data;
+    int begin, end;
+    JobCounter* counter;
+
+} Job;
+
+struct JobCounter
+{
+    int value;
+    int lock;
+    Job waiting[JOB_COUNTER_WAITERS];   // started when value drops to zero
+    int waiting_count;
+};
+
+typedef struct
+{
+    int64_t top;
+    char pad0[64 - sizeof(int64_t)];    // owner and thieves hit different cache lines
+    int64_t bottom;
+    char pad1[64 - sizeof(int64_t)];
+    Job jobs[JOB_DEQUE_SIZE];
+
+} JobDeque;
+
+typedef struct JobSystem JobSystem;
+
+typedef struct
+{
+    JobSystem* system;
+    int index;
+    Thread thread;
+    JobDeque deque;
+    uint32_t rng;
+
+} JobWorker;
+
+struct JobSystem
+{
+    JobWorker* workers;
+    int worker_count;
+
+    // submissions from threads that are not workers
+    Mutex inject_lock;
+    Job inject[JOB_INJECT_SIZE];
+    int inject_head, inject_count;     // written under the lock, peeked without it
+
+    // sleeping workers wait for the epoch to change
+    Mutex sleep_lock;
+    CondVar sleep_cv;
+    int sleeping;
+    unsigned int epoch;
+    int quit;
+};
+
+// which worker of which system the calling thread is, if any
+static __thread JobSystem* Job_CurrentSystem = NULL;
+static __thread int Job_CurrentWorker = -1;
+
+/* -------------------------------------------------------------------------- */
+/*                                   COUNTERS                                 */
+/* -------------------------------------------------------------------------- */
+
+static inline void JobCounter_Create(JobCounter* counter)
+{
+    memset(counter, 0, sizeof(JobCounter));
+}
+
+// The finishing job drops the count under the lock and releases it as its last touch of the
+// counter, so once both read zero the counter (often on the waiter's stack) may go away
+static inline bool JobCounter_IsDone(JobCounter* counter)
+{
+    return __atomic_load_n(&counter->value, __ATOMIC_ACQUIRE) == 0 &&
+           __atomic_load_n(&counter->lock, __ATOMIC_ACQUIRE) == 0;
+}
+
+static inline void JobCounter_Lock(JobCounter* counter)
+{
+    while (__atomic_exchange_n(&counter->lock, 1, __ATOMIC_ACQUIRE))
+        sched_yield();
+}
+
+static inline void JobCounter_Unlock(JobCounter* counter)
+{
+    __atomic_store_n(&counter->lock, 0, __ATOMIC_RELEASE);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                CHASE-LEV DEQUE                             */
+/* -------------------------------------------------------------------------- */
+
+// slots are read by thieves while the owner may be writing a recycled one; the stale read is
+// discarded by the failed CAS on top, but every field still goes through an atomic access
+static inline void JobSlot_Store(Job* slot, const Job* job)
+{
+    __atomic_store_n(&slot->func, job->func, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->data, job->data, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->begin, job->begin, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->end, job->end, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->counter, job->counter, __ATOMIC_RELAXED);
+}
+
+static inline void JobSlot_Load(Job* slot, Job* job)
+{
+    job->func = __atomic_load_n(&slot->func, __ATOMIC_RELAXED);
+    job->data = __atomic_load_n(&slot->data, __ATOMIC_RELAXED);
+    job->begin = __atomic_load_n(&slot->begin, __ATOMIC_RELAXED);
+    job->end = __atomic_load_n(&slot->end, __ATOMIC_RELAXED);
+    job->counter = __atomic_load_n(&slot->counter, __ATOMIC_RELAXED);
+}
+
+// owner only
+static inline bool JobDeque_Push(JobDeque* d, const Job* job)
+{
+    int64_t b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED);
+    int64_t t = __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+
+    if (b - t >= JOB_DEQUE_SIZE)
+        return false;
+
+    JobSlot_Store(&d->jobs[b & (JOB_DEQUE_SIZE - 1)], job);
+    __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+// owner only, LIFO end
+static inline bool JobDeque_Pop(JobDeque* d, Job* job)
+{
+    int64_t b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED) - 1;
+    __atomic_store_n(&d->bottom, b, __ATOMIC_SEQ_CST);
+    int64_t t = __atomic_load_n(&d->top, __ATOMIC_SEQ_CST);
+
+    if (t > b)
+    {
+        __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+        return false;
+    }
+
+    JobSlot_Load(&d->jobs[b & (JOB_DEQUE_SIZE - 1)], job);
+    if (t == b)
+    {
+        // last job: race the thieves for it
+        bool won = __atomic_compare_exchange_n(&d->top, &t, t + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+        __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+        return won;
+    }
+
+    return true;
+}
+
+// any thread, FIFO end
+static inline bool JobDeque_Steal(JobDeque* d, Job* job)
+{
+    int64_t t = __atomic_load_n(&d->top, __ATOMIC_SEQ_CST);
+    int64_t b = __atomic_load_n(&d->bottom, __ATOMIC_SEQ_CST);
+
+    if (t >= b)
+        return false;
+
+    JobSlot_Load(&d->jobs[t & (JOB_DEQUE_SIZE - 1)], job);
+    return __atomic_compare_exchange_n(&d->top, &t, t + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  SCHEDULING                                */
+/* -------------------------------------------------------------------------- */
+
+static inline void Job_Wake(JobSystem* system)
+{
+    __atomic_add_fetch(&system->epoch, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&system->sleeping, __ATOMIC_SEQ_CST) > 0)
+    {
+        Mutex_Lock(&system->sleep_lock);
+        CondVar_Broadcast(&system->sleep_cv);
+        Mutex_Unlock(&system->sleep_lock);
+    }
+}
+
+static inline void Job_Execute(JobSystem* system, const Job* job);
+static inline bool Job_RunOne(JobSystem* system, int self);
+
+// index of the calling worker, -1 outside the system; handy for per-worker scratch buffers
+static inline int Job_WorkerIndex(const JobSystem* system)
+{
+    return (Job_CurrentSystem == system) ? Job_CurrentWorker : -1;
+}
+
+// Queues a job: on the calling worker's deque, or the shared queue for outside threads.
+// Runs it inline when every queue is full.
+static inline void Job_Submit(JobSystem* system, const Job* job)
+{
+    bool queued = false;
+
+    if (Job_CurrentSystem == system && Job_CurrentWorker >= 0)
+    {
+        queued = JobDeque_Push(&system->workers[Job_CurrentWorker].deque, job);
+    }
+    else
+    {
+        Mutex_Lock(&system->inject_lock);
+        if (system->inject_count < JOB_INJECT_SIZE)
+        {
+            system->inject[(system->inject_head + system->inject_count) % JOB_INJECT_SIZE] = *job;
+            __atomic_store_n(&system->inject_count, system->inject_count + 1, __ATOMIC_RELAXED);
+            queued = true;
+        }
+        Mutex_Unlock(&system->inject_lock);
+    }
+
+    if (queued)
+        Job_Wake(system);
+    else
+        Job_Execute(system, job);
+}
+
+// starts a job once `after` reaches zero (immediately if it already has)
+static inline void Job_RunAfter(JobSystem* system, JobCounter* after, JobFunc func, void* data, int begin, int end, JobCounter* counter)
+{
+    Job job;
+    job.func = func;
+    job.data = data;
+    job.begin = begin;
+    job.end = end;
+    job.counter = counter;
+
+    if (counter)
+        __atomic_add_fetch(&counter->value, 1, __ATOMIC_RELAXED);
+
+    if (after)
+    {
+        JobCounter_Lock(after);
+        if (__atomic_load_n(&after->value, __ATOMIC_ACQUIRE) > 0 && after->waiting_count < JOB_COUNTER_WAITERS)
+        {
+            after->waiting[after->waiting_count++] = job;
+            JobCounter_Unlock(after);
+            return;
+        }
+        JobCounter_Unlock(after);
+
+        // full waiter list: help out here rather than dropping the dependency
+        while (!JobCounter_IsDone(after))
+        {
+            if (!Job_RunOne(system, Job_WorkerIndex(system)))
+                sched_yield();
+        }
+    }
+
+    Job_Submit(system, &job);
+}
+
+static inline void Job_Run(JobSystem* system, JobFunc func, void* data, int begin, int end, JobCounter* counter)
+{
+    Job_RunAfter(system, NULL, func, data, begin, end, counter);
+}
+
+static inline void JobCounter_Finish(JobSystem* system, JobCounter* counter)
+{
+    Job waiting[JOB_COUNTER_WAITERS];
+    int count = 0;
+
+    JobCounter_Lock(counter);
+    if (__atomic_sub_fetch(&counter->value, 1, __ATOMIC_ACQ_REL) == 0)
+    {
+        count = counter->waiting_count;
+        memcpy(waiting, counter->waiting, sizeof(Job) * (size_t)count);
+        counter->waiting_count = 0;
+    }
+    JobCounter_Unlock(counter);
+
+    for (int i = 0; i < count; ++i)
+        Job_Submit(system, &waiting[i]);
+}
+
+static inline void Job_Execute(JobSystem* system, const Job* job)
+{
+    {
+        PROFILE_ZONE("job");
+        job->func(job->data, job->begin, job->end);
+    }
+
+    if (job->counter)
+        JobCounter_Finish(system, job->counter);
+}
+
+static inline bool Job_TakeInjected(JobSystem* system, Job* job)
+{
+    if (__atomic_load_n(&system->inject_count, __ATOMIC_RELAXED) == 0)
+        return false;
+
+    bool found = false;
+    Mutex_Lock(&system->inject_lock);
+    if (system->inject_count > 0)
+    {
+        *job = system->inject[system->inject_head];
+        system->inject_head = (system->inject_head + 1) % JOB_INJECT_SIZE;
+        __atomic_store_n(&system->inject_count, system->inject_count - 1, __ATOMIC_RELAXED);
+        found = true;
+    }
+    Mutex_Unlock(&system->inject_lock);
+
+    return found;
+}
+
+// Finds and runs one job: own deque first, then the shared queue, then a random victim onward
+static inline bool Job_RunOne(JobSystem* system, int self)
+{
+    Job job;
+
+    if (self >= 0 && JobDeque_Pop(&system->workers[self].deque, &job))
+    {
+        Job_Execute(system, &job);
+        return true;
+    }
+
+    if (Job_TakeInjected(system, &job))
+    {
+        Job_Execute(system, &job);
+        return true;
+    }
+
+    uint32_t start = 0;
+    if (self >= 0)
+    {
+        // xorshift, per worker
+        uint32_t x = system->workers[self].rng;
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        system->workers[self].rng = x;
+        start = x;
+    }
+
+    for (int i = 0; i < system->worker_count; ++i)
+    {
+        int victim = (int)((start + (uint32_t)i) % (uint32_t)system->worker_count);
+        if (victim != self && JobDeque_Steal(&system->workers[victim].deque, &job))
+        {
+            Job_Execute(system, &job);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static inline void* Job_WorkerMain(void* arg)
+{
+    JobWorker* worker = (JobWorker*)arg;
+    JobSystem* system = worker->system;
+
+    Job_CurrentSystem = system;
+    Job_CurrentWorker = worker->index;
+
+#ifdef FRAMEWORK_PROFILE
+    char thread_name[32];
+    snprintf(thread_name, sizeof(thread_name), "job worker %d", worker->index);
+    PROFILE_THREAD(thread_name);
+#endif
+
+    int idle = 0;
+    while (!__atomic_load_n(&system->quit, __ATOMIC_ACQUIRE))
+    {
+        unsigned int epoch = __atomic_load_n(&system->epoch, __ATOMIC_SEQ_CST);
+
+        if (Job_RunOne(system, worker->index))
+        {
+            idle = 0;
+            continue;
+        }
+
+        if (++idle < JOB_SPINS_BEFORE_SLEEP)
+        {
+            sched_yield();
+            continue;
+        }
+
+        // nothing was submitted since `epoch` was read: sleep until something is
+        Mutex_Lock(&system->sleep_lock);
+        __atomic_add_fetch(&system->sleeping, 1, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&system->epoch, __ATOMIC_SEQ_CST) == epoch && !__atomic_load_n(&system->quit, __ATOMIC_ACQUIRE))
+            CondVar_Wait(&system->sleep_cv, &system->sleep_lock);
+        __atomic_sub_fetch(&system->sleeping, 1, __ATOMIC_SEQ_CST);
+        Mutex_Unlock(&system->sleep_lock);
+        idle = 0;
+    }
+
+    return NULL;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                    SYSTEM                                  */
+/* -------------------------------------------------------------------------- */
+
+// threads <= 0 uses every core. The calling thread becomes worker 0.
+static inline bool Job_Create(JobSystem* system, int threads)
+{
+    memset(system, 0, sizeof(JobSystem));
+
+    if (threads <= 0)
+        threads = Thread_HardwareConcurrency();
+    if (threads > JOB_MAX_WORKERS)
+        threads = JOB_MAX_WORKERS;
+
+    system->workers = (JobWorker*)calloc((size_t)threads, sizeof(JobWorker));
+    if (!system->workers)
+    {
+        fprintf(stderr, "Failed to allocate %d job workers\n", threads);
+        return false;
+    }
+
+    Mutex_Create(&system->inject_lock);
+    Mutex_Create(&system->sleep_lock);
+    CondVar_Create(&system->sleep_cv);
+
+    system->worker_count = threads;
+    for (int i = 0; i < threads; ++i)
+    {
+        system->workers[i].system = system;
+        system->workers[i].index = i;
+        system->workers[i].rng = 0x9E3779B9u * (uint32_t)(i + 1);
+    }
+
+    // Job_Delete clears this again, a system living on main's stack is fine
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 12
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdangling-pointer"
+#endif
+    Job_CurrentSystem = system;
+    Job_CurrentWorker = 0;
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 12
+#pragma GCC diagnostic pop
+#endif
+
+    for (int i = 1; i < threads; ++i)
+    {
+        if (!Thread_Create(&system->workers[i].thread, Job_WorkerMain, &system->workers[i]))
+        {
+            // run with the workers that did start; nobody steals from or pushes to the rest
+            system->worker_count = i;
+            break;
+        }
+    }
+
+    return true;
+}
+
+static inline void Job_Delete(JobSystem* system)
+{
+    __atomic_store_n(&system->quit, 1, __ATOMIC_RELEASE);
+    Job_Wake(system);
+
+    for (int i = 1; i < system->worker_count; ++i)
+        Thread_Join(&system->workers[i].thread);
+
+    CondVar_Delete(&system->sleep_cv);
+    Mutex_Delete(&system->sleep_lock);
+    Mutex_Delete(&system->inject_lock);
+    free(system->workers);
+
+    if (Job_CurrentSystem == system)
+    {
+        Job_CurrentSystem = NULL;
+        Job_CurrentWorker = -1;
+    }
+
+    memset(system, 0, sizeof(JobSystem));
+}
+
+static inline int Job_WorkerCount(const JobSystem* system)
+{
+    return system->worker_count;
+}
+
+// Runs jobs until the counter reaches zero
+static inline void Job_Wait(JobSystem* system, JobCounter* counter)
+{
+    int self = Job_WorkerIndex(system);
+
+    while (!JobCounter_IsDone(counter))
+    {
+        if (!Job_RunOne(system, self))
+            sched_yield();
+    }
+}
+
+// Splits [0, count) into chunks of `grain` indices, runs them across the workers and waits.
+// grain <= 0 picks about four chunks per worker.
+static inline void Job_ParallelFor(JobSystem* system, int count, int grain, JobFunc func, void* data)
+{
+    if (count <= 0)
+        return;
+
+    if (grain <= 0)
+    {
+        grain = count / (system->worker_count * 4);
+        if (grain < 1)
+            grain = 1;
+    }
+
+    if (grain >= count || system->worker_count == 1)
+    {
+        func(data, 0, count);
+        return;
+    }
+
+    JobCounter counter;
+    JobCounter_Create(&counter);
+
+    // the first chunk stays on this thread
+    for (int begin = grain; begin < count; begin += grain)
+        Job_Run(system, func, data, begin, (begin + grain < count) ? begin + grain : count, &counter);
+
+    func(data, 0, grain);
+    Job_Wait(system, &counter);
+}
+
+#endif
@@ -36,8 +36,19 @@ typedef struct
     bool initialized;
     bool use_indices;
 
+    unsigned int instance_VBO;  // per-instance attributes, see Mesh_SetInstances
+    int instance_count;
+
 } Mesh;
 
+// Per-instance vertex data, bound at attribute locations 3-6 (model matrix) and 7 (params)
+typedef struct
+{
+    Matrix4 model;
+    Vector4 params;     // x = texture array layer, yzw free for per-instance data
+
+} InstanceData;
+
 // ALWAYS SET THE SHAPE BEFORE YOU INITIALIZE
 
 static inline void Mesh_CreateTriangle(Mesh* mesh, Arena* allocator)
@@ -55,6 +66,8 @@ static inline void Mesh_CreateTriangle(Mesh* mesh, Arena* allocator)
 
     mesh->use_indices = false;
     mesh->VAO = mesh->VBO = mesh->EBO = 0;
+    mesh->instance_VBO = 0;
+    mesh->instance_count = 0;
     mesh->initialized = true;
 }
 
@@ -77,6 +90,8 @@ static inline void Mesh_CreateRectangle(Mesh* mesh, Arena* allocator)
 
     mesh->use_indices = true;
     mesh->VAO = mesh->VBO = mesh->EBO = 0;
+    mesh->instance_VBO = 0;
+    mesh->instance_count = 0;
     mesh->initialized = true;
 }
 
@@ -110,6 +125,8 @@ static inline void Mesh_CreateCircle(Mesh* mesh, float radius, int sectors, Aren
 
     mesh->use_indices = true;
     mesh->VAO = mesh->VBO = mesh->EBO = 0;
+    mesh->instance_VBO = 0;
+    mesh->instance_count = 0;
     mesh->initialized = true;
 }
 
@@ -145,6 +162,8 @@ static inline void Mesh_CreateCube(Mesh* mesh, Arena* allocator)
 
     mesh->use_indices = true;
     mesh->VAO = mesh->VBO = mesh->EBO = 0;
+    mesh->instance_VBO = 0;
+    mesh->instance_count = 0;
     mesh->initialized = true;
 }
 
@@ -185,6 +204,8 @@ static inline void Mesh_CreateSphere(Mesh* mesh, float radius, int stacks, int s
 
     mesh->use_indices = true;
     mesh->VAO = mesh->VBO = mesh->EBO = 0;
+    mesh->instance_VBO = 0;
+    mesh->instance_count = 0;
     mesh->initialized = true;
 }
 
@@ -241,6 +262,8 @@ static inline void Mesh_CreateDome(Mesh* mesh, float radius, int stacks, int sec
 
     mesh->use_indices = true;
     mesh->VAO = mesh->VBO = mesh->EBO = 0;
+    mesh->instance_VBO = 0;
+    mesh->instance_count = 0;
     mesh->initialized = true;
 }
 
@@ -274,6 +297,44 @@ static inline void Mesh_Upload(Mesh* mesh)
 
     glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(5 * sizeof(float)));
     glEnableVertexAttribArray(2);
+
+    mesh->instance_VBO = 0;
+    mesh->instance_count = 0;
+}
+
+// Uploads per-instance data for Mesh_DrawInstanced. Call after Mesh_Upload; may be called every frame.
+static inline void Mesh_SetInstances(Mesh* mesh, const InstanceData* instances, int count)
+{
+    glBindVertexArray(mesh->VAO);
+
+    if (!mesh->instance_VBO)
+    {
+        glGenBuffers(1, &mesh->instance_VBO);
+        glBindBuffer(GL_ARRAY_BUFFER, mesh->instance_VBO);
+
+        // a mat4 attribute takes four consecutive vec4 locations
+        for (int i = 0; i < 4; ++i)
+        {
+            glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(i * 4 * sizeof(float)));
+            glEnableVertexAttribArray(3 + i);
+            glVertexAttribDivisor(3 + i, 1);
+        }
+
+        glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(16 * sizeof(float)));
+        glEnableVertexAttribArray(7);
+        glVertexAttribDivisor(7, 1);
+    }
+    else
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, mesh->instance_VBO);
+    }
+
+    // orphan then fill so per-frame updates do not stall on the previous draw
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(sizeof(InstanceData) * count), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)(sizeof(InstanceData) * count), instances);
+    mesh->instance_count = count;
+
+    glBindVertexArray(0);
 }
 
 static inline void Mesh_Draw(const Mesh* mesh)
@@ -294,6 +355,25 @@ static inline void Mesh_Draw(const Mesh* mesh)
     glBindVertexArray(0);
 }
 
+// Draws every instance set with Mesh_SetInstances in one call
+static inline void Mesh_DrawInstanced(const Mesh* mesh)
+{
+    if (!mesh->initialized)
+    {
+        printf("Mesh not initialized with shape\n");
+        return;
+    } 
+
+    glBindVertexArray(mesh->VAO);
+
+    if (mesh->use_indices)
+        glDrawElementsInstanced(GL_TRIANGLES, DArray_Size(&mesh->indices), GL_UNSIGNED_INT, 0, mesh->instance_count);
+    else
+        glDrawArraysInstanced(GL_TRIANGLES, 0, DArray_Size(&mesh->vertices), mesh->instance_count);
+
+    glBindVertexArray(0);
+}
+
 static inline void Mesh_DrawWireFrame(const Mesh* mesh)
 {
     if (!mesh->initialized)
@@ -312,6 +392,7 @@ static inline void Mesh_Delete(Mesh* mesh)
     if (mesh->EBO) glDeleteBuffers(1, &mesh->EBO);
     if (mesh->VAO) glDeleteVertexArrays(1, &mesh->VAO);
     if (mesh->VBO) glDeleteBuffers(1, &mesh->VBO);
+    if (mesh->instance_VBO) glDeleteBuffers(1, &mesh->instance_VBO);
     
     DArray_Free(&mesh->vertices);
     DArray_Free(&mesh->textures);
@@ -320,6 +401,8 @@ static inline void Mesh_Delete(Mesh* mesh)
     mesh->VAO = 0;
     mesh->VBO = 0;
     mesh->EBO = 0;
+    mesh->instance_VBO = 0;
+    mesh->instance_count = 0;
 }
 
 #endif
\ No newline at end of file
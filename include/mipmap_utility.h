@@ -0,0 +1,347 @@
+#ifndef MIPMAP_UTILITY_H
+#define MIPMAP_UTILITY_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include "math_utility.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// CPU mip chain generation for RGBA8 images. No GL calls, so chains can be
+// built offline (or on worker threads) and baked into a cache before upload.
+
+#define MIPMAP_MAX_LEVELS 16
+
+typedef enum
+{
+    MIP_FILTER_BOX,         // 2x2 average, SSE2 accelerated
+    MIP_FILTER_KAISER       // separable 6-tap Kaiser windowed sinc, sharper but slower
+
+} MipFilter;
+
+typedef struct
+{
+    int levels;
+    int width[MIPMAP_MAX_LEVELS];
+    int height[MIPMAP_MAX_LEVELS];
+    size_t offset[MIPMAP_MAX_LEVELS];   // byte offset of each level inside data
+    unsigned char* data;                // every level, level 0 first, tightly packed RGBA8
+    size_t size;
+
+} MipChain;
+
+static inline int MipChain_LevelCount(int width, int height)
+{
+    int levels = 1;
+    while ((width > 1 || height > 1) && levels < MIPMAP_MAX_LEVELS)
+    {
+        width = (width > 1) ? width / 2 : 1;
+        height = (height > 1) ? height / 2 : 1;
+        levels += 1;
+    }
+    return levels;
+}
+
+static inline unsigned char* MipChain_Level(const MipChain* chain, int level)
+{
+    return chain->data + chain->offset[level];
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 BOX FILTER                                 */
+/* -------------------------------------------------------------------------- */
+
+// Halves src into dst. Odd edges are clamped, matching the floor() sizes GL uses.
+static inline void Mip_DownsampleBox(const unsigned char* src, int sw, int sh, unsigned char* dst, int dw, int dh)
+{
+    for (int y = 0; y < dh; ++y)
+    {
+        const unsigned char* row0 = src + (size_t)(2 * y) * sw * 4;
+        const unsigned char* row1 = src + (size_t)((2 * y + 1 < sh) ? 2 * y + 1 : sh - 1) * sw * 4;
+        unsigned char* out = dst + (size_t)y * dw * 4;
+        int x = 0;
+
+#if defined(__SSE2__)
+        // 4 output pixels per iteration: 8 source pixels from each row
+        if (sw >= 2)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i two = _mm_set1_epi16(2);
+
+            for (; x + 4 <= dw && 2 * x + 8 <= sw; x += 4)
+            {
+                __m128i a = _mm_loadu_si128((const __m128i*)(row0 + 8 * x));
+                __m128i b = _mm_loadu_si128((const __m128i*)(row0 + 8 * x + 16));
+                __m128i c = _mm_loadu_si128((const __m128i*)(row1 + 8 * x));
+                __m128i d = _mm_loadu_si128((const __m128i*)(row1 + 8 * x + 16));
+
+                // vertical sums, 16 bit per channel
+                __m128i lo0 = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(c, zero));
+                __m128i hi0 = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(c, zero));
+                __m128i lo1 = _mm_add_epi16(_mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(d, zero));
+                __m128i hi1 = _mm_add_epi16(_mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(d, zero));
+
+                // horizontal pairs: each register holds two pixels (8 channels), add the halves
+                __m128i p0 = _mm_add_epi16(lo0, _mm_srli_si128(lo0, 8));
+                __m128i p1 = _mm_add_epi16(hi0, _mm_srli_si128(hi0, 8));
+                __m128i p2 = _mm_add_epi16(lo1, _mm_srli_si128(lo1, 8));
+                __m128i p3 = _mm_add_epi16(hi1, _mm_srli_si128(hi1, 8));
+
+                __m128i r01 = _mm_unpacklo_epi64(p0, p1);
+                __m128i r23 = _mm_unpacklo_epi64(p2, p3);
+                r01 = _mm_srli_epi16(_mm_add_epi16(r01, two), 2);
+                r23 = _mm_srli_epi16(_mm_add_epi16(r23, two), 2);
+
+                _mm_storeu_si128((__m128i*)(out + 4 * x), _mm_packus_epi16(r01, r23));
+            }
+        }
+#endif
+
+        for (; x < dw; ++x)
+        {
+            int x0 = 2 * x;
+            int x1 = (2 * x + 1 < sw) ? 2 * x + 1 : sw - 1;
+
+            for (int c = 0; c < 4; ++c)
+            {
+                int sum = row0[x0 * 4 + c] + row0[x1 * 4 + c] + row1[x0 * 4 + c] + row1[x1 * 4 + c];
+                out[x * 4 + c] = (unsigned char)((sum + 2) >> 2);
+            }
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                               KAISER FILTER                                */
+/* -------------------------------------------------------------------------- */
+
+#define MIP_KAISER_TAPS 6
+
+// zeroth order modified Bessel function of the first kind (series form)
+static inline float Mip_BesselI0(float x)
+{
+    float sum = 1.0f, term = 1.0f, half = x * 0.5f;
+    for (int k = 1; k < 16; ++k)
+    {
+        term *= (half / (float)k) * (half / (float)k);
+        sum += term;
+    }
+    return sum;
+}
+
+// normalized weights for a 2:1 decimation, taps at -2.5 .. 2.5 source texels around the output centre
+static inline void Mip_KaiserWeights(float weights[MIP_KAISER_TAPS])
+{
+    const float alpha = 4.0f;
+    const float radius = 3.0f;
+    float total = 0.0f;
+
+    for (int i = 0; i < MIP_KAISER_TAPS; ++i)
+    {
+        float x = (float)i - 2.5f;
+        float t = x * 0.5f * PI;
+        float sinc = (t == 0.0f) ? 1.0f : sinf(t) / t;
+        float r = x / radius;
+        float window = Mip_BesselI0(alpha * sqrtf(fmaxf(0.0f, 1.0f - r * r))) / Mip_BesselI0(alpha);
+
+        weights[i] = sinc * window;
+        total += weights[i];
+    }
+
+    for (int i = 0; i < MIP_KAISER_TAPS; ++i)
+        weights[i] /= total;
+}
+
+static inline void Mip_DownsampleKaiser(const unsigned char* src, int sw, int sh, unsigned char* dst, int dw, int dh)
+{
+    float w[MIP_KAISER_TAPS];
+    Mip_KaiserWeights(w);
+
+    // horizontal pass: sw x sh -> dw x sh (float)
+    float* tmp = (float*)malloc(sizeof(float) * 4 * (size_t)dw * (size_t)sh);
+    if (!tmp)
+    {
+        fprintf(stderr, "Mip_DownsampleKaiser: allocation failed, falling back to box filter\n");
+        Mip_DownsampleBox(src, sw, sh, dst, dw, dh);
+        return;
+    }
+
+    for (int y = 0; y < sh; ++y)
+    {
+        const unsigned char* row = src + (size_t)y * sw * 4;
+        float* out = tmp + (size_t)y * dw * 4;
+
+        for (int x = 0; x < dw; ++x)
+        {
+            float acc[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            for (int i = 0; i < MIP_KAISER_TAPS; ++i)
+            {
+                int sx = 2 * x - 2 + i;
+                sx = (sx < 0) ? 0 : ((sx >= sw) ? sw - 1 : sx);
+                for (int c = 0; c < 4; ++c)
+                    acc[c] += w[i] * (float)row[sx * 4 + c];
+            }
+            for (int c = 0; c < 4; ++c)
+                out[x * 4 + c] = acc[c];
+        }
+    }
+
+    // vertical pass: dw x sh -> dw x dh
+    for (int y = 0; y < dh; ++y)
+    {
+        unsigned char* out = dst + (size_t)y * dw * 4;
+
+        for (int x = 0; x < dw; ++x)
+        {
+            float acc[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            for (int i = 0; i < MIP_KAISER_TAPS; ++i)
+            {
+                int sy = 2 * y - 2 + i;
+                sy = (sy < 0) ? 0 : ((sy >= sh) ? sh - 1 : sy);
+                const float* in = tmp + ((size_t)sy * dw + x) * 4;
+                for (int c = 0; c < 4; ++c)
+                    acc[c] += w[i] * in[c];
+            }
+            for (int c = 0; c < 4; ++c)
+            {
+                float v = acc[c] + 0.5f;
+                out[x * 4 + c] = (unsigned char)(v < 0.0f ? 0.0f : (v > 255.0f ? 255.0f : v));
+            }
+        }
+    }
+
+    free(tmp);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   RESIZE                                   */
+/* -------------------------------------------------------------------------- */
+
+// Resizes an RGBA8 image to any size. Large reductions are box-halved first so the
+// final bilinear step never skips source texels.
+static inline bool Image_Resize(const unsigned char* src, int sw, int sh, unsigned char* dst, int dw, int dh)
+{
+    unsigned char* owned = NULL;
+    const unsigned char* cur = src;
+    int cw = sw, ch = sh;
+
+    while (cw >= 2 * dw && ch >= 2 * dh)
+    {
+        int nw = cw / 2, nh = ch / 2;
+        unsigned char* half = (unsigned char*)malloc((size_t)nw * nh * 4);
+        if (!half)
+        {
+            fprintf(stderr, "Image_Resize: allocation failed\n");
+            free(owned);
+            return false;
+        }
+
+        Mip_DownsampleBox(cur, cw, ch, half, nw, nh);
+        free(owned);
+        owned = half;
+        cur = half;
+        cw = nw;
+        ch = nh;
+    }
+
+    float sx = (float)cw / (float)dw;
+    float sy = (float)ch / (float)dh;
+
+    for (int y = 0; y < dh; ++y)
+    {
+        float fy = ((float)y + 0.5f) * sy - 0.5f;
+        if (fy < 0.0f) fy = 0.0f;
+        int y0 = (int)fy;
+        int y1 = (y0 + 1 < ch) ? y0 + 1 : ch - 1;
+        float ty = fy - (float)y0;
+
+        for (int x = 0; x < dw; ++x)
+        {
+            float fx = ((float)x + 0.5f) * sx - 0.5f;
+            if (fx < 0.0f) fx = 0.0f;
+            int x0 = (int)fx;
+            int x1 = (x0 + 1 < cw) ? x0 + 1 : cw - 1;
+            float tx = fx - (float)x0;
+
+            const unsigned char* a = cur + ((size_t)y0 * cw + x0) * 4;
+            const unsigned char* b = cur + ((size_t)y0 * cw + x1) * 4;
+            const unsigned char* c = cur + ((size_t)y1 * cw + x0) * 4;
+            const unsigned char* d = cur + ((size_t)y1 * cw + x1) * 4;
+            unsigned char* out = dst + ((size_t)y * dw + x) * 4;
+
+            for (int k = 0; k < 4; ++k)
+            {
+                float top = a[k] + (b[k] - a[k]) * tx;
+                float bottom = c[k] + (d[k] - c[k]) * tx;
+                out[k] = (unsigned char)(top + (bottom - top) * ty + 0.5f);
+            }
+        }
+    }
+
+    free(owned);
+    return true;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              MIP CHAIN FUNCTIONS                           */
+/* -------------------------------------------------------------------------- */
+
+// Builds the full chain down to 1x1. Level 0 is a copy of pixels.
+static inline bool MipChain_Build(MipChain* chain, const unsigned char* pixels, int width, int height, MipFilter filter)
+{
+    memset(chain, 0, sizeof(MipChain));
+    chain->levels = MipChain_LevelCount(width, height);
+
+    int w = width, h = height;
+    for (int level = 0; level < chain->levels; ++level)
+    {
+        chain->width[level] = w;
+        chain->height[level] = h;
+        chain->offset[level] = chain->size;
+        chain->size += (size_t)w * (size_t)h * 4;
+
+        w = (w > 1) ? w / 2 : 1;
+        h = (h > 1) ? h / 2 : 1;
+    }
+
+    chain->data = (unsigned char*)malloc(chain->size);
+    if (!chain->data)
+    {
+        fprintf(stderr, "Failed to allocate mip chain (%zu bytes)\n", chain->size);
+        chain->levels = 0;
+        chain->size = 0;
+        return false;
+    }
+
+    memcpy(chain->data, pixels, (size_t)width * (size_t)height * 4);
+
+    for (int level = 1; level < chain->levels; ++level)
+    {
+        const unsigned char* src = MipChain_Level(chain, level - 1);
+        unsigned char* dst = MipChain_Level(chain, level);
+
+        if (filter == MIP_FILTER_KAISER)
+            Mip_DownsampleKaiser(src, chain->width[level - 1], chain->height[level - 1], dst, chain->width[level], chain->height[level]);
+        else
+            Mip_DownsampleBox(src, chain->width[level - 1], chain->height[level - 1], dst, chain->width[level], chain->height[level]);
+    }
+
+    return true;
+}
+
+static inline void MipChain_Free(MipChain* chain)
+{
+    if (chain->data)
+        free(chain->data);
+
+    chain->data = NULL;
+    chain->levels = 0;
+    chain->size = 0;
+}
+
+#endif
@@ -4,6 +4,7 @@
 #include "mesh_utility.h"
 #include "darray_utility.h"
 #include "arena_utility.h"
+#include "file_utility.h"
 
 #ifdef __cplusplus
 
@@ -20,15 +21,35 @@
 
 static inline void Mesh_CreateModel(Mesh* mesh, const std::string& obj_path, Arena* allocator)
 {
+    // no GL objects until Mesh_Upload, also when loading fails
+    mesh->VAO = mesh->VBO = mesh->EBO = 0;
+    mesh->instance_VBO = 0;
+    mesh->instance_count = 0;
+
     Assimp::Importer importer;
-    const aiScene* scene = importer.ReadFile
-    (
-        obj_path,
-        aiProcess_Triangulate |
-        aiProcess_GenSmoothNormals |
-        aiProcess_JoinIdenticalVertices |
-        aiProcess_FlipUVs
-    );
+    const unsigned int flags = aiProcess_Triangulate |
+                               aiProcess_GenSmoothNormals |
+                               aiProcess_JoinIdenticalVertices |
+                               aiProcess_FlipUVs;
+
+    // packed models are parsed from memory, the extension is assimp's format hint
+    const aiScene* scene = NULL;
+    FileView packed;
+    packed.data = NULL;
+    packed.size = 0;
+    packed.kind = FILE_VIEW_MAPPED;
+
+    if (Pack_Find(Pack_Mounted, obj_path.c_str()) && File_Map(&packed, obj_path.c_str()))
+    {
+        size_t dot = obj_path.find_last_of('.');
+        std::string hint = (dot == std::string::npos) ? std::string() : obj_path.substr(dot + 1);
+        scene = importer.ReadFileFromMemory(packed.data, packed.size, flags, hint.c_str());
+        File_Unmap(&packed);    // the importer owns the scene, the buffer is only read during the call
+    }
+    else
+    {
+        scene = importer.ReadFile(obj_path, flags);
+    }
 
     if (!scene || !scene->HasMeshes())
     {
@@ -99,9 +120,6 @@ static inline void Mesh_CreateModel(Mesh* mesh, const std::string& obj_path, Are
     }
 
     mesh->use_indices = true;
-    mesh->VAO = 0;
-    mesh->VBO = 0;
-    mesh->EBO = 0;
     mesh->initialized = true;
 }
 #else
@@ -116,8 +134,14 @@ static inline void Mesh_CreateModel(Mesh* mesh, const std::string& obj_path, Are
 
 static inline void Mesh_CreateModel(Mesh* mesh, const char* obj_path, Arena* allocator)
 {
-    FILE* file = fopen(obj_path, "r");
-    if (!file)
+    // no GL objects until Mesh_Upload, also when loading fails
+    mesh->VAO = mesh->VBO = mesh->EBO = 0;
+    mesh->instance_VBO = 0;
+    mesh->instance_count = 0;
+
+    FileView file;
+    size_t cursor = 0;
+    if (!File_Map(&file, obj_path))
     {
         printf("Failed to open model file: %s\n", obj_path);
         mesh->initialized = false;
@@ -131,7 +155,7 @@ static inline void Mesh_CreateModel(Mesh* mesh, const char* obj_path, Arena* all
     unsigned int face_count   = 0;
 
     char line[256];
-    while (fgets(line, sizeof(line), file))
+    while (FileView_ReadLine(&file, &cursor, line, sizeof(line)))
     {
         if (strncmp(line, "v ", 2) == 0) vertex_count++;
         else if (strncmp(line, "vt ", 3) == 0) tex_count++;
@@ -145,7 +169,7 @@ static inline void Mesh_CreateModel(Mesh* mesh, const char* obj_path, Arena* all
     mesh->textures = DArray_Create_T(Texture, 4, allocator); // arbitrary small number
 
     // --- PASS 2: Read actual data ---
-    rewind(file);
+    cursor = 0;
 
     float vx[vertex_count][3];
     float vt[tex_count][2];
@@ -153,7 +177,7 @@ static inline void Mesh_CreateModel(Mesh* mesh, const char* obj_path, Arena* all
 
     unsigned int vCount = 0, vtCount = 0, vnCount = 0;
 
-    while (fgets(line, sizeof(line), file))
+    while (FileView_ReadLine(&file, &cursor, line, sizeof(line)))
     {
         if (strncmp(line, "v ", 2) == 0)
         {
@@ -195,7 +219,7 @@ static inline void Mesh_CreateModel(Mesh* mesh, const char* obj_path, Arena* all
         }
     }
 
-    fclose(file);
+    File_Unmap(&file);
 
     mesh->use_indices = true;
     mesh->initialized = true;
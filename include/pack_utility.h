@@ -0,0 +1,625 @@
+#ifndef PACK_UTILITY_H
+#define PACK_UTILITY_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+// Asset archive: one mmap'd file with a hash indexed table of contents.
+//
+// layout: PackHeader | PackEntry[entry_count] (sorted by hash) | uint32 buckets[2^bucket_bits + 1] | names | payloads
+//
+// The top bucket_bits of an entry's hash select a bucket, buckets[b]..buckets[b + 1] is the range of
+// entries in it, so a lookup is one bucket read plus a short scan (O(1) expected).
+// Payloads are PACK_ALIGNMENT aligned and either stored or compressed with the in-tree LZ4-style codec.
+
+#define PACK_MAGIC          0x4B415046u     // "FPAK"
+#define PACK_VERSION        1u
+#define PACK_ALIGNMENT      64
+
+typedef enum
+{
+    PACK_COMPRESSION_NONE,
+    PACK_COMPRESSION_LZ
+
+} PackCompression;
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t bucket_bits;
+    uint64_t entries_offset;
+    uint64_t buckets_offset;
+    uint64_t names_offset;
+    uint64_t total_size;
+
+} PackHeader;
+
+typedef struct
+{
+    uint64_t hash;
+    uint64_t offset;            // from the start of the archive
+    uint64_t stored_size;
+    uint64_t raw_size;
+    uint32_t name_offset;       // into the name table, names are NUL terminated
+    uint32_t name_length;
+    uint32_t compression;       // PackCompression
+    uint32_t reserved;
+
+} PackEntry;
+
+typedef struct
+{
+    const unsigned char* base;
+    size_t size;
+    const PackHeader* header;
+    const PackEntry* entries;
+    const uint32_t* buckets;
+    const char* names;
+
+} Pack;
+
+// the archive File_Load / File_Map / Image_Load resolve through, NULL = loose files only
+static const Pack* Pack_Mounted = NULL;
+
+// "./shaders/x.glsl" and "shaders/x.glsl" are the same entry
+static inline const char* Pack_NormalizePath(const char* path)
+{
+    while (path[0] == '.' && path[1] == '/')
+        path += 2;
+    return path;
+}
+
+// FNV-1a 64
+static inline uint64_t Pack_Hash(const char* path)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (const char* c = Pack_NormalizePath(path); *c; ++c)
+    {
+        hash ^= (unsigned char)*c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                           LZ4-STYLE BLOCK CODEC                            */
+/* -------------------------------------------------------------------------- */
+
+// Sequences of: token (literal length << 4 | match length - 4), extra length bytes, literals,
+// 16 bit match offset, extra match length bytes. The final sequence is literals only.
+
+#define PACK_LZ_HASH_BITS   14
+#define PACK_LZ_MIN_MATCH   4
+
+static inline size_t Pack_CompressBound(size_t size)
+{
+    return size + size / 255 + 16;
+}
+
+static inline uint32_t Pack_Read32(const unsigned char* p)
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static inline unsigned char* Pack_WriteLength(unsigned char* op, size_t length)
+{
+    while (length >= 255)
+    {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = (unsigned char)length;
+    return op;
+}
+
+// Returns the compressed size (dst must hold Pack_CompressBound(size) bytes)
+static inline size_t Pack_Compress(const unsigned char* src, size_t size, unsigned char* dst)
+{
+    uint32_t* table = (uint32_t*)calloc((size_t)1 << PACK_LZ_HASH_BITS, sizeof(uint32_t));
+    if (!table)
+        return 0;
+
+    unsigned char* op = dst;
+    size_t anchor = 0, ip = 0;
+
+    // matches must leave 12 bytes of input and end 5 bytes early, like LZ4, so the tail is literals
+    size_t match_start_limit = (size > 12) ? size - 12 : 0;
+    size_t match_end_limit = (size > 5) ? size - 5 : 0;
+
+    while (ip < match_start_limit)
+    {
+        uint32_t sequence = Pack_Read32(src + ip);
+        uint32_t h = (sequence * 2654435761u) >> (32 - PACK_LZ_HASH_BITS);
+        size_t ref = table[h];      // position + 1, 0 = empty
+        table[h] = (uint32_t)(ip + 1);
+
+        if (ref == 0 || ip - (ref - 1) > 65535 || Pack_Read32(src + ref - 1) != sequence)
+        {
+            ++ip;
+            continue;
+        }
+
+        ref -= 1;
+        size_t match = PACK_LZ_MIN_MATCH;
+        while (ip + match < match_end_limit && src[ref + match] == src[ip + match])
+            ++match;
+
+        size_t literals = ip - anchor;
+        size_t match_code = match - PACK_LZ_MIN_MATCH;
+        unsigned char* token = op++;
+        *token = (unsigned char)(((literals < 15) ? literals : 15) << 4 | ((match_code < 15) ? match_code : 15));
+
+        if (literals >= 15)
+            op = Pack_WriteLength(op, literals - 15);
+        memcpy(op, src + anchor, literals);
+        op += literals;
+
+        size_t offset = ip - ref;
+        *op++ = (unsigned char)(offset & 0xFF);
+        *op++ = (unsigned char)(offset >> 8);
+
+        if (match_code >= 15)
+            op = Pack_WriteLength(op, match_code - 15);
+
+        ip += match;
+        anchor = ip;
+    }
+
+    size_t literals = size - anchor;
+    *op++ = (unsigned char)(((literals < 15) ? literals : 15) << 4);
+    if (literals >= 15)
+        op = Pack_WriteLength(op, literals - 15);
+    memcpy(op, src + anchor, literals);
+    op += literals;
+
+    free(table);
+    return (size_t)(op - dst);
+}
+
+// Bounds checked; false on corrupt input or if the output is not exactly raw_size bytes
+static inline bool Pack_Decompress(const unsigned char* src, size_t size, unsigned char* dst, size_t raw_size)
+{
+    const unsigned char* ip = src;
+    const unsigned char* in_end = src + size;
+    unsigned char* op = dst;
+    unsigned char* out_end = dst + raw_size;
+
+    while (ip < in_end)
+    {
+        unsigned token = *ip++;
+
+        size_t literals = token >> 4;
+        if (literals == 15)
+        {
+            unsigned char b;
+            do
+            {
+                if (ip >= in_end)
+                    return false;
+                b = *ip++;
+                literals += b;
+            } while (b == 255);
+        }
+
+        if (literals > (size_t)(in_end - ip) || literals > (size_t)(out_end - op))
+            return false;
+        memcpy(op, ip, literals);
+        ip += literals;
+        op += literals;
+
+        if (ip >= in_end)
+            break;      // last sequence
+
+        if (in_end - ip < 2)
+            return false;
+        size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst))
+            return false;
+
+        size_t match = token & 15;
+        if (match == 15)
+        {
+            unsigned char b;
+            do
+            {
+                if (ip >= in_end)
+                    return false;
+                b = *ip++;
+                match += b;
+            } while (b == 255);
+        }
+        match += PACK_LZ_MIN_MATCH;
+
+        if (match > (size_t)(out_end - op))
+            return false;
+
+        // byte copy: the match may overlap its own output
+        const unsigned char* ref = op - offset;
+        for (size_t i = 0; i < match; ++i)
+            op[i] = ref[i];
+        op += match;
+    }
+
+    return op == out_end;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   READER                                   */
+/* -------------------------------------------------------------------------- */
+
+// true when offset + size lies within limit, without overflowing
+static inline bool Pack_InRange(uint64_t offset, uint64_t size, uint64_t limit)
+{
+    return offset <= limit && size <= limit - offset;
+}
+
+// Checks the header, every entry and every bucket against the mapped size once, so lookups and
+// extraction never leave the mapping. Sets the table pointers on success.
+static inline bool Pack_Validate(Pack* pack)
+{
+    const PackHeader* h = pack->header;
+    if (h->magic != PACK_MAGIC || h->version != PACK_VERSION || h->total_size != pack->size ||
+        h->bucket_bits == 0 || h->bucket_bits > 31)
+        return false;
+
+    uint64_t bucket_count = ((uint64_t)1 << h->bucket_bits) + 1;
+    if (!Pack_InRange(h->entries_offset, (uint64_t)h->entry_count * sizeof(PackEntry), pack->size) ||
+        !Pack_InRange(h->buckets_offset, bucket_count * sizeof(uint32_t), pack->size) ||
+        h->names_offset > pack->size)
+        return false;
+
+    // the tables are read in place
+    if (h->entries_offset % sizeof(uint64_t) != 0 || h->buckets_offset % sizeof(uint32_t) != 0)
+        return false;
+
+    pack->entries = (const PackEntry*)(pack->base + h->entries_offset);
+    pack->buckets = (const uint32_t*)(pack->base + h->buckets_offset);
+    pack->names = (const char*)(pack->base + h->names_offset);
+
+    // bucket ranges must be ascending and inside the entry table
+    for (uint64_t b = 0; b + 1 < bucket_count; ++b)
+    {
+        if (pack->buckets[b] > pack->buckets[b + 1] || pack->buckets[b + 1] > h->entry_count)
+            return false;
+    }
+
+    uint64_t names_size = pack->size - h->names_offset;
+    for (uint32_t i = 0; i < h->entry_count; ++i)
+    {
+        const PackEntry* entry = &pack->entries[i];
+
+        // the name and its terminator lie in the name table
+        if (!Pack_InRange(entry->name_offset, (uint64_t)entry->name_length + 1, names_size) ||
+            pack->names[entry->name_offset + entry->name_length] != '\0')
+            return false;
+
+        if (!Pack_InRange(entry->offset, entry->stored_size, pack->size))
+            return false;
+
+        // stored entries are copied out raw_size bytes at a time
+        if (entry->compression == PACK_COMPRESSION_NONE ? entry->raw_size != entry->stored_size
+                                                        : entry->compression != PACK_COMPRESSION_LZ)
+            return false;
+    }
+
+    return true;
+}
+
+static inline bool Pack_Open(Pack* pack, const char* path)
+{
+    memset(pack, 0, sizeof(Pack));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        printf("Failed to open pack: %s\n", path);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(PackHeader))
+    {
+        printf("Invalid pack: %s\n", path);
+        close(fd);
+        return false;
+    }
+
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        printf("Failed to map pack: %s\n", path);
+        return false;
+    }
+
+    pack->base = (const unsigned char*)data;
+    pack->size = (size_t)st.st_size;
+    pack->header = (const PackHeader*)data;
+
+    if (!Pack_Validate(pack))
+    {
+        printf("Invalid pack: %s\n", path);
+        munmap(data, pack->size);
+        memset(pack, 0, sizeof(Pack));
+        return false;
+    }
+
+    return true;
+}
+
+static inline void Pack_Close(Pack* pack)
+{
+    if (Pack_Mounted == pack)
+        Pack_Mounted = NULL;
+
+    if (pack->base)
+        munmap((void*)pack->base, pack->size);
+
+    memset(pack, 0, sizeof(Pack));
+}
+
+// Routes file loads through pack (NULL to go back to loose files)
+static inline void Pack_Mount(const Pack* pack)
+{
+    Pack_Mounted = pack;
+}
+
+static inline const PackEntry* Pack_Find(const Pack* pack, const char* path)
+{
+    if (!pack || !pack->base)
+        return NULL;
+
+    path = Pack_NormalizePath(path);
+    uint64_t hash = Pack_Hash(path);
+    uint64_t bucket = hash >> (64 - pack->header->bucket_bits);
+
+    for (uint32_t i = pack->buckets[bucket]; i < pack->buckets[bucket + 1]; ++i)
+    {
+        const PackEntry* entry = &pack->entries[i];
+        if (entry->hash == hash && strcmp(pack->names + entry->name_offset, path) == 0)
+            return entry;
+    }
+
+    return NULL;
+}
+
+static inline const unsigned char* Pack_EntryData(const Pack* pack, const PackEntry* entry)
+{
+    return pack->base + entry->offset;
+}
+
+// Writes the raw (decompressed) contents, dst must hold entry->raw_size bytes
+static inline bool Pack_Extract(const Pack* pack, const PackEntry* entry, void* dst)
+{
+    const unsigned char* data = Pack_EntryData(pack, entry);
+
+    if (entry->compression == PACK_COMPRESSION_NONE)
+    {
+        memcpy(dst, data, entry->raw_size);
+        return true;
+    }
+
+    if (!Pack_Decompress(data, entry->stored_size, (unsigned char*)dst, entry->raw_size))
+    {
+        printf("Corrupt pack entry: %s\n", pack->names + entry->name_offset);
+        return false;
+    }
+
+    return true;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   BUILDER                                  */
+/* -------------------------------------------------------------------------- */
+
+typedef struct
+{
+    PackEntry entry;
+    const char* path;
+    unsigned char* payload;
+
+} PackBuildItem;
+
+static inline int Pack_CompareHash(const void* a, const void* b)
+{
+    uint64_t ha = ((const PackBuildItem*)a)->entry.hash;
+    uint64_t hb = ((const PackBuildItem*)b)->entry.hash;
+    return (ha > hb) - (ha < hb);
+}
+
+static inline void Pack_WritePadding(FILE* file, uint64_t* cursor)
+{
+    static const unsigned char zeros[PACK_ALIGNMENT] = {0};
+    uint64_t padding = (PACK_ALIGNMENT - (*cursor % PACK_ALIGNMENT)) % PACK_ALIGNMENT;
+    fwrite(zeros, 1, (size_t)padding, file);
+    *cursor += padding;
+}
+
+// Writes an archive with the given files, stored under the paths as passed (normalized).
+// Entries are compressed when that saves at least 1/8 of their size and compress is set.
+static inline bool Pack_Build(const char* output, const char* const* paths, int count, bool compress)
+{
+    PackBuildItem* items = (PackBuildItem*)calloc((size_t)(count > 0 ? count : 1), sizeof(PackBuildItem));
+    if (!items)
+        return false;
+
+    bool ok = true;
+    uint64_t names_size = 0;
+
+    for (int i = 0; i < count && ok; ++i)
+    {
+        PackBuildItem* item = &items[i];
+        item->path = Pack_NormalizePath(paths[i]);
+        item->entry.hash = Pack_Hash(item->path);
+        item->entry.name_length = (uint32_t)strlen(item->path);
+        item->entry.name_offset = (uint32_t)names_size;
+        names_size += item->entry.name_length + 1;
+
+        // two entries under one name would make lookups depend on the sort order
+        for (int j = 0; j < i; ++j)
+        {
+            if (items[j].entry.hash == item->entry.hash && strcmp(items[j].path, item->path) == 0)
+            {
+                printf("Duplicate pack entry: %s\n", item->path);
+                ok = false;
+                break;
+            }
+        }
+        if (!ok)
+            break;
+
+        FILE* file = fopen(paths[i], "rb");
+        struct stat st;
+        if (!file || fstat(fileno(file), &st) != 0)
+        {
+            printf("Failed to open file: %s\n", paths[i]);
+            if (file)
+                fclose(file);
+            ok = false;
+            break;
+        }
+
+        size_t size = (size_t)st.st_size;
+        unsigned char* raw = (unsigned char*)malloc(size ? size : 1);
+        ok = raw && fread(raw, 1, size, file) == size;
+        fclose(file);
+
+        if (!ok)
+        {
+            printf("Failed to read file: %s\n", paths[i]);
+            free(raw);
+            break;
+        }
+
+        item->entry.raw_size = size;
+        item->entry.stored_size = size;
+        item->entry.compression = PACK_COMPRESSION_NONE;
+        item->payload = raw;
+
+        if (compress && size > 64)
+        {
+            unsigned char* packed = (unsigned char*)malloc(Pack_CompressBound(size));
+            size_t packed_size = packed ? Pack_Compress(raw, size, packed) : 0;
+
+            if (packed_size > 0 && packed_size < size - size / 8)
+            {
+                free(raw);
+                item->payload = packed;
+                item->entry.stored_size = packed_size;
+                item->entry.compression = PACK_COMPRESSION_LZ;
+            }
+            else
+            {
+                free(packed);
+            }
+        }
+    }
+
+    if (ok)
+    {
+        qsort(items, (size_t)count, sizeof(PackBuildItem), Pack_CompareHash);
+
+        // one bucket per entry (rounded to a power of two) keeps the expected scan length at ~1
+        uint32_t bucket_bits = 1;
+        while (((uint32_t)1 << bucket_bits) < (uint32_t)count && bucket_bits < 31)
+            ++bucket_bits;
+        size_t bucket_count = (size_t)1 << bucket_bits;
+
+        // the name table keeps input order (name_offset was assigned before sorting)
+        uint32_t* buckets = (uint32_t*)calloc(bucket_count + 1, sizeof(uint32_t));
+        char* names = (char*)calloc((size_t)names_size + 1, 1);
+        if (!buckets || !names)
+        {
+            fprintf(stderr, "Failed to allocate pack index for %d entries\n", count);
+            ok = false;
+        }
+        for (int i = 0; ok && i < count; ++i)
+            memcpy(names + items[i].entry.name_offset, items[i].path, items[i].entry.name_length);
+
+        PackHeader header;
+        memset(&header, 0, sizeof(header));
+        header.magic = PACK_MAGIC;
+        header.version = PACK_VERSION;
+        header.entry_count = (uint32_t)count;
+        header.bucket_bits = bucket_bits;
+        header.entries_offset = sizeof(PackHeader);
+        header.buckets_offset = header.entries_offset + (uint64_t)count * sizeof(PackEntry);
+        header.names_offset = header.buckets_offset + (bucket_count + 1) * sizeof(uint32_t);
+
+        uint64_t cursor = header.names_offset + names_size;
+        for (int i = 0; i < count && ok; ++i)
+        {
+            cursor += (PACK_ALIGNMENT - (cursor % PACK_ALIGNMENT)) % PACK_ALIGNMENT;
+            items[i].entry.offset = cursor;
+            cursor += items[i].entry.stored_size;
+        }
+        header.total_size = cursor;
+
+        // buckets[b] = first entry whose top bits are >= b (entries are sorted by hash)
+        for (size_t b = 0, e = 0; ok && b <= bucket_count; ++b)
+        {
+            while (e < (size_t)count && (items[e].entry.hash >> (64 - bucket_bits)) < b)
+                ++e;
+            buckets[b] = (uint32_t)e;
+        }
+
+        FILE* file = ok ? fopen(output, "wb") : NULL;
+        if (ok && !file)
+        {
+            printf("Failed to open file: %s\n", output);
+            ok = false;
+        }
+
+        if (ok)
+        {
+            fwrite(&header, sizeof(header), 1, file);
+            for (int i = 0; i < count; ++i)
+                fwrite(&items[i].entry, sizeof(PackEntry), 1, file);
+            fwrite(buckets, sizeof(uint32_t), bucket_count + 1, file);
+
+            uint64_t written = header.names_offset;
+            fwrite(names, 1, (size_t)names_size, file);
+            written += names_size;
+
+            for (int i = 0; i < count; ++i)
+            {
+                Pack_WritePadding(file, &written);
+                fwrite(items[i].payload, 1, (size_t)items[i].entry.stored_size, file);
+                written += items[i].entry.stored_size;
+            }
+
+            ok = ferror(file) == 0 && written == header.total_size;
+            ok = (fclose(file) == 0) && ok;
+
+            // never leave a truncated archive behind for Pack_Open to trip over
+            if (!ok)
+            {
+                printf("Failed to write file: %s\n", output);
+                remove(output);
+            }
+        }
+
+        free(names);
+        free(buckets);
+    }
+
+    for (int i = 0; i < count; ++i)
+        free(items[i].payload);
+    free(items);
+
+    return ok;
+}
+
+#endif
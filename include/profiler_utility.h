@@ -0,0 +1,457 @@
+#ifndef PROFILER_UTILITY_H
+#define PROFILER_UTILITY_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+// Hierarchical CPU profiler. Code is instrumented with scoped zones:
+//
+//     PROFILE_ZONE("culling");        // until the end of the enclosing block, C and C++
+//     PROFILE_FUNCTION();             // zone named after the function
+//     PROFILE_THREAD("worker");       // names the calling thread in traces
+//     PROFILE_FRAME_END();            // once per frame on the main thread (Window_SwapBuffers does it)
+//
+// The macros only exist when FRAMEWORK_PROFILE is defined (make PROFILE=1); otherwise they expand
+// to nothing and no profiler code is compiled in.
+//
+// Each thread writes finished zones into its own single-producer ring, so recording never takes a
+// lock. Profiler_FrameEnd drains every ring on the main thread, aggregates per zone name (calls,
+// time this frame, running average, max) and, while a capture is active, keeps the raw events for
+// Profiler_WriteChromeTrace: trace-event JSON that chrome://tracing and ui.perfetto.dev load.
+// Zone names must be string literals or otherwise outlive the profiler; they are stored as pointers.
+//
+// FRAMEWORK_TRACE=file.json captures FRAMEWORK_TRACE_FRAMES frames (default 120) of any program
+// using the window layer and writes the trace when the window is deleted.
+
+#define PROFILER_MAX_THREADS    64
+#define PROFILER_RING_EVENTS    16384   // power of two, per thread
+#define PROFILER_MAX_ZONES      256     // distinct zone names in the per-frame statistics
+#define PROFILER_GPU_TRACK      PROFILER_MAX_THREADS   // trace track for events injected with Profiler_AddEvent
+
+typedef struct
+{
+    const char* name;
+    uint64_t begin_ns;
+    uint64_t end_ns;
+    uint32_t depth;
+    uint32_t track;     // thread index, or PROFILER_GPU_TRACK
+
+} ProfileEvent;
+
+typedef struct
+{
+    ProfileEvent events[PROFILER_RING_EVENTS];
+    uint64_t write;     // advanced by the owning thread only
+    uint64_t read;      // advanced by Profiler_FrameEnd only
+    uint64_t dropped;   // events lost because the ring was full
+    uint32_t depth;
+    uint32_t index;
+    char name[32];
+
+} ProfileThread;
+
+typedef struct
+{
+    const char* name;
+    uint32_t calls;         // accumulating for the current frame
+    uint64_t frame_ns;      // accumulating for the current frame, summed over threads
+    uint32_t last_calls;
+    double last_ms;
+    double avg_ms;
+    double max_ms;
+
+} ProfileZoneStats;
+
+typedef struct
+{
+    const char* name;
+    uint64_t begin_ns;
+
+} ProfileZone;
+
+typedef struct
+{
+    bool initialized;
+    uint64_t start_ns;
+
+    ProfileThread* threads[PROFILER_MAX_THREADS];
+    uint32_t thread_count;
+
+    ProfileZoneStats zones[PROFILER_MAX_ZONES];
+    uint64_t frame;
+    uint64_t frame_begin_ns;
+    double frame_ms;
+
+    // capture
+    ProfileEvent* capture;
+    size_t capture_count, capture_capacity;
+    uint64_t* frame_marks;  // frame boundaries inside the capture
+    size_t mark_count, mark_capacity;
+    int capture_frames;     // frames left to capture, 0 when idle
+    char trace_path[256];   // written by Profiler_Shutdown when set
+
+} Profiler;
+
+static Profiler Profiler_State;
+static __thread ProfileThread* Profiler_Thread = NULL;
+
+static inline uint64_t Profiler_Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static inline void Profiler_Init(void)
+{
+    if (Profiler_State.initialized)
+        return;
+
+    Profiler_State.start_ns = Profiler_Now();
+    Profiler_State.frame_begin_ns = Profiler_State.start_ns;
+    Profiler_State.initialized = true;
+}
+
+// Registers the calling thread on first use. Registration is the only atomic read-modify-write.
+static inline ProfileThread* Profiler_GetThread(void)
+{
+    if (Profiler_Thread)
+        return Profiler_Thread;
+
+    uint32_t index = __atomic_fetch_add(&Profiler_State.thread_count, 1, __ATOMIC_ACQ_REL);
+    if (index >= PROFILER_MAX_THREADS)
+    {
+        __atomic_fetch_sub(&Profiler_State.thread_count, 1, __ATOMIC_ACQ_REL);
+        return NULL;
+    }
+
+    ProfileThread* thread = (ProfileThread*)calloc(1, sizeof(ProfileThread));
+    if (!thread)
+        return NULL;
+
+    thread->index = index;
+    snprintf(thread->name, sizeof(thread->name), "thread %u", index);
+    __atomic_store_n(&Profiler_State.threads[index], thread, __ATOMIC_RELEASE);
+
+    Profiler_Thread = thread;
+    return thread;
+}
+
+static inline void Profiler_SetThreadName(const char* name)
+{
+    ProfileThread* thread = Profiler_GetThread();
+    if (thread)
+        snprintf(thread->name, sizeof(thread->name), "%s", name);
+}
+
+static inline void Profiler_Push(ProfileThread* thread, const ProfileEvent* event)
+{
+    uint64_t write = thread->write;
+    if (write - __atomic_load_n(&thread->read, __ATOMIC_ACQUIRE) >= PROFILER_RING_EVENTS)
+    {
+        thread->dropped += 1;
+        return;
+    }
+
+    thread->events[write & (PROFILER_RING_EVENTS - 1)] = *event;
+    __atomic_store_n(&thread->write, write + 1, __ATOMIC_RELEASE);
+}
+
+static inline ProfileZone Profiler_ZoneBegin(const char* name)
+{
+    ProfileThread* thread = Profiler_GetThread();
+    if (thread)
+        thread->depth += 1;
+
+    ProfileZone zone = { name, Profiler_Now() };
+    return zone;
+}
+
+static inline void Profiler_ZoneEnd(ProfileZone* zone)
+{
+    uint64_t end = Profiler_Now();
+    ProfileThread* thread = Profiler_Thread;
+    if (!thread)
+        return;
+
+    thread->depth -= 1;
+    ProfileEvent event = { zone->name, zone->begin_ns, end, thread->depth, thread->index };
+    Profiler_Push(thread, &event);
+}
+
+// Adds an event recorded elsewhere (GPU timers) to the main thread's ring; track picks the trace row
+static inline void Profiler_AddEvent(const char* name, uint64_t begin_ns, uint64_t end_ns, uint32_t depth, uint32_t track)
+{
+    ProfileThread* thread = Profiler_GetThread();
+    if (!thread)
+        return;
+
+    ProfileEvent event = { name, begin_ns, end_ns, depth, track };
+    Profiler_Push(thread, &event);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                           AGGREGATION AND CAPTURE                          */
+/* -------------------------------------------------------------------------- */
+
+static inline ProfileZoneStats* Profiler_FindZone(const char* name)
+{
+    uint32_t hash = (uint32_t)(((uintptr_t)name >> 3) * 2654435761u);
+    for (uint32_t probe = 0; probe < PROFILER_MAX_ZONES; ++probe)
+    {
+        ProfileZoneStats* zone = &Profiler_State.zones[(hash + probe) & (PROFILER_MAX_ZONES - 1)];
+        if (zone->name == name)
+            return zone;
+        if (!zone->name)
+        {
+            zone->name = name;
+            return zone;
+        }
+    }
+    return NULL;
+}
+
+static inline void Profiler_CaptureEvent(const ProfileEvent* event)
+{
+    Profiler* p = &Profiler_State;
+    if (p->capture_count == p->capture_capacity)
+    {
+        size_t capacity = p->capture_capacity ? p->capture_capacity * 2 : 65536;
+        ProfileEvent* events = (ProfileEvent*)realloc(p->capture, capacity * sizeof(ProfileEvent));
+        if (!events)
+            return;
+        p->capture = events;
+        p->capture_capacity = capacity;
+    }
+    p->capture[p->capture_count++] = *event;
+}
+
+// Starts keeping raw events for the next `frames` frames (cleared from any previous capture)
+static inline void Profiler_BeginCapture(int frames)
+{
+    Profiler_Init();
+    Profiler_State.capture_count = 0;
+    Profiler_State.mark_count = 0;
+    Profiler_State.capture_frames = frames;
+}
+
+// Call once per frame on the main thread: drains the thread rings and updates the statistics
+static inline void Profiler_FrameEnd(void)
+{
+    Profiler* p = &Profiler_State;
+    Profiler_Init();
+
+    uint64_t now = Profiler_Now();
+    bool capturing = p->capture_frames > 0;
+
+    uint32_t count = __atomic_load_n(&p->thread_count, __ATOMIC_ACQUIRE);
+    for (uint32_t t = 0; t < count && t < PROFILER_MAX_THREADS; ++t)
+    {
+        ProfileThread* thread = __atomic_load_n(&p->threads[t], __ATOMIC_ACQUIRE);
+        if (!thread)
+            continue;
+
+        uint64_t read = thread->read;
+        uint64_t write = __atomic_load_n(&thread->write, __ATOMIC_ACQUIRE);
+        for (; read < write; ++read)
+        {
+            const ProfileEvent* event = &thread->events[read & (PROFILER_RING_EVENTS - 1)];
+
+            // GPU events arrive frames late and keep their own statistics (gpu_profiler_utility.h)
+            ProfileZoneStats* zone = (event->track == PROFILER_GPU_TRACK) ? NULL : Profiler_FindZone(event->name);
+            if (zone)
+            {
+                zone->calls += 1;
+                zone->frame_ns += event->end_ns - event->begin_ns;
+            }
+
+            if (capturing)
+                Profiler_CaptureEvent(event);
+        }
+        __atomic_store_n(&thread->read, read, __ATOMIC_RELEASE);
+    }
+
+    for (int i = 0; i < PROFILER_MAX_ZONES; ++i)
+    {
+        ProfileZoneStats* zone = &p->zones[i];
+        if (!zone->name)
+            continue;
+
+        zone->last_calls = zone->calls;
+        zone->last_ms = (double)zone->frame_ns * 1e-6;
+        zone->avg_ms = (p->frame == 0) ? zone->last_ms : zone->avg_ms * 0.95 + zone->last_ms * 0.05;
+        zone->max_ms = zone->last_ms > zone->max_ms ? zone->last_ms : zone->max_ms;
+        zone->calls = 0;
+        zone->frame_ns = 0;
+    }
+
+    if (capturing)
+    {
+        if (p->mark_count == p->mark_capacity)
+        {
+            size_t capacity = p->mark_capacity ? p->mark_capacity * 2 : 256;
+            uint64_t* marks = (uint64_t*)realloc(p->frame_marks, capacity * sizeof(uint64_t));
+            if (marks)
+            {
+                p->frame_marks = marks;
+                p->mark_capacity = capacity;
+            }
+        }
+        if (p->mark_count < p->mark_capacity)
+            p->frame_marks[p->mark_count++] = now;
+
+        p->capture_frames -= 1;
+    }
+
+    p->frame_ms = (double)(now - p->frame_begin_ns) * 1e-6;
+    p->frame_begin_ns = now;
+    p->frame += 1;
+}
+
+static inline int Profiler_CompareZones(const void* a, const void* b)
+{
+    const ProfileZoneStats* x = *(const ProfileZoneStats* const*)a;
+    const ProfileZoneStats* y = *(const ProfileZoneStats* const*)b;
+    return (x->avg_ms < y->avg_ms) - (x->avg_ms > y->avg_ms);
+}
+
+// Zones of the last frame, most expensive (running average) first
+static inline void Profiler_Print(int max_zones)
+{
+    const ProfileZoneStats* sorted[PROFILER_MAX_ZONES];
+    int count = 0;
+    for (int i = 0; i < PROFILER_MAX_ZONES; ++i)
+    {
+        if (Profiler_State.zones[i].name)
+            sorted[count++] = &Profiler_State.zones[i];
+    }
+    qsort(sorted, (size_t)count, sizeof(sorted[0]), Profiler_CompareZones);
+
+    printf("frame %llu: %.3f ms\n", (unsigned long long)Profiler_State.frame, Profiler_State.frame_ms);
+    for (int i = 0; i < count && i < max_zones; ++i)
+        printf("  %-24s %5u calls  last %8.3f  avg %8.3f  max %8.3f ms\n", sorted[i]->name, sorted[i]->last_calls,
+               sorted[i]->last_ms, sorted[i]->avg_ms, sorted[i]->max_ms);
+}
+
+static inline void Profiler_WriteJSONString(FILE* file, const char* text)
+{
+    fputc('"', file);
+    for (; *text; ++text)
+    {
+        if (*text == '"' || *text == '\\')
+            fputc('\\', file);
+        if ((unsigned char)*text >= 0x20)
+            fputc(*text, file);
+    }
+    fputc('"', file);
+}
+
+// Chrome trace-event JSON of the last capture (ts/dur in microseconds from profiler start)
+static inline bool Profiler_WriteChromeTrace(const char* path)
+{
+    Profiler* p = &Profiler_State;
+    FILE* file = fopen(path, "w");
+    if (!file)
+    {
+        printf("Failed to write trace %s\n", path);
+        return false;
+    }
+
+    fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    fprintf(file, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 0, \"args\": {\"name\": \"framework\"}}");
+
+    uint32_t count = __atomic_load_n(&p->thread_count, __ATOMIC_ACQUIRE);
+    for (uint32_t t = 0; t < count && t < PROFILER_MAX_THREADS; ++t)
+    {
+        ProfileThread* thread = __atomic_load_n(&p->threads[t], __ATOMIC_ACQUIRE);
+        if (!thread)
+            continue;
+        fprintf(file, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": ", t);
+        Profiler_WriteJSONString(file, thread->name);
+        fprintf(file, "}}");
+    }
+    fprintf(file, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"GPU\"}}", PROFILER_GPU_TRACK);
+
+    for (size_t i = 0; i < p->capture_count; ++i)
+    {
+        const ProfileEvent* e = &p->capture[i];
+        fprintf(file, ",\n{\"name\": ");
+        Profiler_WriteJSONString(file, e->name);
+        fprintf(file, ", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f}", e->track,
+                (double)(e->begin_ns - p->start_ns) * 1e-3, (double)(e->end_ns - e->begin_ns) * 1e-3);
+    }
+
+    for (size_t i = 0; i < p->mark_count; ++i)
+    {
+        fprintf(file, ",\n{\"name\": \"frame\", \"ph\": \"i\", \"s\": \"g\", \"pid\": 1, \"tid\": 0, \"ts\": %.3f}",
+                (double)(p->frame_marks[i] - p->start_ns) * 1e-3);
+    }
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    uint64_t dropped = 0;
+    for (uint32_t t = 0; t < count && t < PROFILER_MAX_THREADS; ++t)
+        dropped += p->threads[t] ? p->threads[t]->dropped : 0;
+
+    printf("Trace: %zu events over %zu frames written to %s%s\n", p->capture_count, p->mark_count, path,
+           dropped ? " (some events dropped, rings were full)" : "");
+    return true;
+}
+
+// FRAMEWORK_TRACE / FRAMEWORK_TRACE_FRAMES, see the top of the file
+static inline void Profiler_InitFromEnv(void)
+{
+    Profiler_Init();
+
+    const char* path = getenv("FRAMEWORK_TRACE");
+    if (!path || !path[0])
+        return;
+
+    const char* frames = getenv("FRAMEWORK_TRACE_FRAMES");
+    snprintf(Profiler_State.trace_path, sizeof(Profiler_State.trace_path), "%s", path);
+    Profiler_BeginCapture(frames ? atoi(frames) : 120);
+}
+
+// Writes the pending trace, if any, and frees everything. Other threads must be done recording.
+static inline void Profiler_Shutdown(void)
+{
+    Profiler* p = &Profiler_State;
+    if (p->trace_path[0])
+        Profiler_WriteChromeTrace(p->trace_path);
+
+    for (int t = 0; t < PROFILER_MAX_THREADS; ++t)
+        free(p->threads[t]);
+    free(p->capture);
+    free(p->frame_marks);
+
+    memset(p, 0, sizeof(Profiler));
+    Profiler_Thread = NULL;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   MACROS                                   */
+/* -------------------------------------------------------------------------- */
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#ifdef FRAMEWORK_PROFILE
+    // cleanup runs Profiler_ZoneEnd when the variable leaves scope, in C as well as C++
+    #define PROFILE_ZONE(name) \
+        ProfileZone PROFILE_CONCAT(profile_zone_, __LINE__) __attribute__((cleanup(Profiler_ZoneEnd), unused)) = Profiler_ZoneBegin(name)
+    #define PROFILE_FUNCTION()      PROFILE_ZONE(__func__)
+    #define PROFILE_THREAD(name)    Profiler_SetThreadName(name)
+    #define PROFILE_FRAME_END()     Profiler_FrameEnd()
+#else
+    #define PROFILE_ZONE(name)      ((void)0)
+    #define PROFILE_FUNCTION()      ((void)0)
+    #define PROFILE_THREAD(name)    ((void)0)
+    #define PROFILE_FRAME_END()     ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,380 @@
+#ifndef READBACK_UTILITY_H
+#define READBACK_UTILITY_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <glad/glad.h>
+
+#include "thread_utility.h"
+#include "image_write_utility.h"
+
+// Asynchronous framebuffer readback for frame capture, golden images and video export.
+//   ReadbackRing   - ring of pixel pack buffers with fences. Capture copies the framebuffer into the
+//                    next PBO without waiting; Poll hands over frames whose copy has finished, so
+//                    with 3 slots frame N is read while frames N+1 and N+2 render
+//   ReadbackWriter - thread that writes delivered frames to disk (PNG or raw), no GL calls
+//
+// Frames go to a callback on the GL thread (pixels point into the mapped PBO and are only valid
+// during the call) and/or to a writer. Pixels are RGBA8 in GL order, bottom row first.
+
+typedef struct
+{
+    const uint8_t* pixels;
+    int width, height;
+    uint64_t frame;
+
+} ReadbackImage;
+
+typedef void (*ReadbackCallback)(void* user, const ReadbackImage* image);
+
+/* -------------------------------------------------------------------------- */
+/*                              WRITER FUNCTIONS                              */
+/* -------------------------------------------------------------------------- */
+
+typedef struct ReadbackJob
+{
+    uint8_t* pixels;
+    int width, height;
+    uint64_t frame;
+
+    struct ReadbackJob* next;
+
+} ReadbackJob;
+
+typedef struct
+{
+    Thread thread;
+    Mutex lock;
+    CondVar work_ready;     // signalled when a frame is queued or on shutdown
+    CondVar work_done;      // signalled when a frame has been written
+
+    ReadbackJob* head;
+    ReadbackJob* tail;
+    int queued;
+    int max_queued;         // Push blocks above this, so a slow disk cannot eat all memory
+    bool running;
+
+    char prefix[256];       // files are <prefix>_<frame>.png / .rgba
+    ImageFormat format;
+
+    uint64_t written;
+    uint64_t failed;
+    size_t bytes;
+
+} ReadbackWriter;
+
+static inline void* ReadbackWriter_Main(void* arg)
+{
+    ReadbackWriter* writer = (ReadbackWriter*)arg;
+
+    for (;;)
+    {
+        Mutex_Lock(&writer->lock);
+
+        while (writer->running && !writer->head)
+            CondVar_Wait(&writer->work_ready, &writer->lock);
+
+        // queued frames are still written on shutdown
+        ReadbackJob* job = writer->head;
+        if (!job)
+        {
+            Mutex_Unlock(&writer->lock);
+            break;
+        }
+
+        writer->head = job->next;
+        if (!writer->head)
+            writer->tail = NULL;
+
+        Mutex_Unlock(&writer->lock);
+
+        char path[320];
+        snprintf(path, sizeof(path), "%s_%06llu.%s", writer->prefix, (unsigned long long)job->frame,
+                 writer->format == IMAGE_FORMAT_PNG ? "png" : "rgba");
+        bool ok = Image_Write(path, writer->format, job->pixels, job->width, job->height, true);
+
+        Mutex_Lock(&writer->lock);
+
+        writer->written += ok;
+        writer->failed += !ok;
+        writer->bytes += (size_t)job->width * (size_t)job->height * 4;
+        writer->queued -= 1;
+
+        CondVar_Broadcast(&writer->work_done);
+        Mutex_Unlock(&writer->lock);
+
+        free(job->pixels);
+        free(job);
+    }
+
+    return NULL;
+}
+
+static inline bool ReadbackWriter_Create(ReadbackWriter* writer, const char* prefix, ImageFormat format, int max_queued)
+{
+    memset(writer, 0, sizeof(ReadbackWriter));
+    snprintf(writer->prefix, sizeof(writer->prefix), "%s", prefix);
+    writer->format = format;
+    writer->max_queued = max_queued > 0 ? max_queued : 8;
+    writer->running = true;
+
+    Mutex_Create(&writer->lock);
+    CondVar_Create(&writer->work_ready);
+    CondVar_Create(&writer->work_done);
+
+    return Thread_Create(&writer->thread, ReadbackWriter_Main, writer);
+}
+
+// Takes ownership of pixels (malloc'd, GL row order)
+static inline void ReadbackWriter_Push(ReadbackWriter* writer, uint8_t* pixels, int width, int height, uint64_t frame)
+{
+    ReadbackJob* job = (ReadbackJob*)malloc(sizeof(ReadbackJob));
+    if (!job)
+    {
+        fprintf(stderr, "Failed to allocate readback job for frame %llu\n", (unsigned long long)frame);
+        free(pixels);
+        return;
+    }
+
+    job->pixels = pixels;
+    job->width = width;
+    job->height = height;
+    job->frame = frame;
+    job->next = NULL;
+
+    Mutex_Lock(&writer->lock);
+
+    while (writer->queued >= writer->max_queued)
+        CondVar_Wait(&writer->work_done, &writer->lock);
+
+    if (writer->tail)
+        writer->tail->next = job;
+    else
+        writer->head = job;
+    writer->tail = job;
+    writer->queued += 1;
+
+    CondVar_Signal(&writer->work_ready);
+    Mutex_Unlock(&writer->lock);
+}
+
+// Blocks until every queued frame is on disk
+static inline void ReadbackWriter_WaitIdle(ReadbackWriter* writer)
+{
+    Mutex_Lock(&writer->lock);
+
+    while (writer->queued > 0)
+        CondVar_Wait(&writer->work_done, &writer->lock);
+
+    Mutex_Unlock(&writer->lock);
+}
+
+// Writes what is still queued, then stops the thread
+static inline void ReadbackWriter_Delete(ReadbackWriter* writer)
+{
+    Mutex_Lock(&writer->lock);
+    writer->running = false;
+    CondVar_Broadcast(&writer->work_ready);
+    Mutex_Unlock(&writer->lock);
+
+    Thread_Join(&writer->thread);
+
+    CondVar_Delete(&writer->work_done);
+    CondVar_Delete(&writer->work_ready);
+    Mutex_Delete(&writer->lock);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                               RING FUNCTIONS                               */
+/* -------------------------------------------------------------------------- */
+
+typedef struct
+{
+    unsigned int pbo;
+    GLsync fence;
+    int width, height;
+    uint64_t frame;
+
+} ReadbackSlot;
+
+typedef struct
+{
+    ReadbackSlot* slots;
+    int slot_count;
+    int head;           // next slot to capture into
+    int in_flight;      // captured, not delivered yet; the oldest is at head - in_flight
+    int max_width, max_height;
+
+    ReadbackCallback callback;
+    void* user;
+    ReadbackWriter* writer;
+
+    uint64_t captured;
+    uint64_t delivered;
+    uint64_t stalls;    // captures that had to wait for the oldest slot
+
+} ReadbackRing;
+
+// Must be called on the GL thread. Captures are limited to max_width x max_height.
+static inline bool ReadbackRing_Create(ReadbackRing* ring, int slot_count, int max_width, int max_height)
+{
+    memset(ring, 0, sizeof(ReadbackRing));
+    if (slot_count < 1)
+        slot_count = 3;
+
+    ring->slots = (ReadbackSlot*)calloc((size_t)slot_count, sizeof(ReadbackSlot));
+    if (!ring->slots)
+    {
+        fprintf(stderr, "Failed to allocate readback ring\n");
+        return false;
+    }
+
+    ring->slot_count = slot_count;
+    ring->max_width = max_width;
+    ring->max_height = max_height;
+
+    for (int i = 0; i < slot_count; ++i)
+    {
+        glGenBuffers(1, &ring->slots[i].pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, ring->slots[i].pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)max_width * max_height * 4, NULL, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    return true;
+}
+
+// callback may be NULL, writer may be NULL
+static inline void ReadbackRing_SetCallback(ReadbackRing* ring, ReadbackCallback callback, void* user)
+{
+    ring->callback = callback;
+    ring->user = user;
+}
+
+static inline void ReadbackRing_SetWriter(ReadbackRing* ring, ReadbackWriter* writer)
+{
+    ring->writer = writer;
+}
+
+// Delivers the oldest capture. Without wait it returns false if its copy has not finished yet.
+static inline bool ReadbackRing_Complete(ReadbackRing* ring, bool wait)
+{
+    if (ring->in_flight == 0)
+        return false;
+
+    ReadbackSlot* slot = &ring->slots[(ring->head - ring->in_flight + ring->slot_count) % ring->slot_count];
+
+    GLenum status;
+    do
+        status = glClientWaitSync(slot->fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? 1000000000ull : 0);
+    while (wait && status == GL_TIMEOUT_EXPIRED);
+
+    if (status == GL_TIMEOUT_EXPIRED)
+        return false;
+
+    glDeleteSync(slot->fence);
+    slot->fence = NULL;
+    ring->in_flight -= 1;
+
+    if (status == GL_WAIT_FAILED)
+    {
+        printf("Readback of frame %llu failed\n", (unsigned long long)slot->frame);
+        return true;
+    }
+
+    size_t size = (size_t)slot->width * (size_t)slot->height * 4;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
+    const uint8_t* pixels = (const uint8_t*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)size, GL_MAP_READ_BIT);
+    if (pixels)
+    {
+        ReadbackImage image = { pixels, slot->width, slot->height, slot->frame };
+        if (ring->callback)
+            ring->callback(ring->user, &image);
+
+        if (ring->writer)
+        {
+            uint8_t* copy = (uint8_t*)malloc(size);
+            if (copy)
+            {
+                memcpy(copy, pixels, size);
+                ReadbackWriter_Push(ring->writer, copy, slot->width, slot->height, slot->frame);
+            }
+        }
+
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        ring->delivered += 1;
+    }
+    else
+        printf("Failed to map readback buffer for frame %llu\n", (unsigned long long)slot->frame);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return true;
+}
+
+// Queues a copy of the x, y, width x height region of the framebuffer bound for reading (the
+// window's by default). Only waits when every slot is still in flight.
+static inline bool ReadbackRing_Capture(ReadbackRing* ring, int x, int y, int width, int height, uint64_t frame)
+{
+    if (width > ring->max_width || height > ring->max_height)
+    {
+        printf("Readback region %dx%d larger than the ring (%dx%d)\n", width, height, ring->max_width, ring->max_height);
+        return false;
+    }
+
+    if (ring->in_flight == ring->slot_count)
+    {
+        ring->stalls += 1;
+        ReadbackRing_Complete(ring, true);
+    }
+
+    ReadbackSlot* slot = &ring->slots[ring->head];
+    slot->width = width;
+    slot->height = height;
+    slot->frame = frame;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
+    glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    ring->head = (ring->head + 1) % ring->slot_count;
+    ring->in_flight += 1;
+    ring->captured += 1;
+    return true;
+}
+
+// Call once per frame: delivers every capture whose copy has finished, oldest first. Returns the count.
+static inline int ReadbackRing_Poll(ReadbackRing* ring)
+{
+    int count = 0;
+    while (ReadbackRing_Complete(ring, false))
+        count += 1;
+    return count;
+}
+
+// Blocks until every capture has been delivered
+static inline void ReadbackRing_Flush(ReadbackRing* ring)
+{
+    while (ReadbackRing_Complete(ring, true))
+        ;
+}
+
+static inline void ReadbackRing_Delete(ReadbackRing* ring)
+{
+    for (int i = 0; i < ring->slot_count; ++i)
+    {
+        if (ring->slots[i].fence)
+            glDeleteSync(ring->slots[i].fence);
+        glDeleteBuffers(1, &ring->slots[i].pbo);
+    }
+
+    free(ring->slots);
+    ring->slots = NULL;
+    ring->slot_count = 0;
+    ring->in_flight = 0;
+}
+
+#endif
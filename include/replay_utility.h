@@ -0,0 +1,277 @@
+#ifndef REPLAY_UTILITY_H
+#define REPLAY_UTILITY_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "time_utility.h"
+#include "input_utility.h"
+
+// Input record and replay for repeatable benchmark runs. A recording holds one record per frame:
+// the frame's delta time and the input snapshot it consumed. During playback Time_Update hands out
+// the recorded deltas and the input snapshots come from the file, so IsKeyPressed, the cameras and
+// anything driven by Time_Delta/Time_Total follow the exact same path on every run and every build.
+// Frame times are still measured on the real clock and summarised when playback ends.
+//
+// The window layer drives it from the environment:
+//     FRAMEWORK_RECORD=path           record while running
+//     FRAMEWORK_REPLAY=path           play back; the window closes after the last recorded frame
+//     FRAMEWORK_REPLAY_REPORT=path    also write the playback frame-time statistics as JSON
+//
+// Recording reads the snapshot on the thread calling Window_PollEvents, so it expects that thread to
+// take the snapshots (Input_State.manual unset). Snapshots are stored as raw structs, which ties a
+// recording to the InputSnapshot layout; a file from a build with another layout is rejected.
+
+#define REPLAY_MAGIC    "FWREPLAY"
+#define REPLAY_VERSION  1
+
+typedef enum
+{
+    REPLAY_OFF,
+    REPLAY_RECORD,
+    REPLAY_PLAY,
+
+} ReplayMode;
+
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t snapshot_size;     // sizeof(InputSnapshot) of the recording build
+    uint64_t frames;
+
+} ReplayHeader;
+
+typedef struct
+{
+    int64_t delta_ns;
+    InputSnapshot input;
+
+} ReplayFrame;
+
+typedef struct
+{
+    ReplayMode mode;
+    FILE* file;                 // recording
+    uint64_t count;             // frames recorded, or in the playback file
+    uint64_t cursor;            // playback frame being consumed
+
+    ReplayFrame* frames;        // playback
+    float* frame_ms;            // measured frame times during playback
+    char report[256];
+
+} Replay;
+
+static Replay Replay_State;
+
+static inline bool Replay_StartRecording(const char* path)
+{
+    Replay* r = &Replay_State;
+    r->file = fopen(path, "wb");
+    if (!r->file)
+    {
+        printf("Replay: could not create %s\n", path);
+        return false;
+    }
+
+    // the frame count is filled in by Replay_Stop
+    ReplayHeader header = { { 'F', 'W', 'R', 'E', 'P', 'L', 'A', 'Y' }, REPLAY_VERSION, (uint32_t)sizeof(InputSnapshot), 0 };
+    fwrite(&header, sizeof(ReplayHeader), 1, r->file);
+
+    r->mode = REPLAY_RECORD;
+    r->count = 0;
+    printf("Replay: recording to %s\n", path);
+    return true;
+}
+
+static inline void Replay_RecordFrame(int64_t delta_ns, const InputSnapshot* input)
+{
+    Replay* r = &Replay_State;
+    if (r->mode != REPLAY_RECORD)
+        return;
+
+    ReplayFrame frame;
+    memset(&frame, 0, sizeof(ReplayFrame));
+    frame.delta_ns = delta_ns;
+    frame.input = *input;
+    if (fwrite(&frame, sizeof(ReplayFrame), 1, r->file) == 1)
+        r->count += 1;
+}
+
+// Hands frame `cursor` to the time and input layers
+static inline void Replay_Apply(void)
+{
+    const ReplayFrame* frame = &Replay_State.frames[Replay_State.cursor];
+    Time_State.delta_override_ns = frame->delta_ns;
+    Input_SetSnapshot(&frame->input);
+}
+
+static inline bool Replay_StartPlayback(const char* path)
+{
+    Replay* r = &Replay_State;
+    FILE* file = fopen(path, "rb");
+    if (!file)
+    {
+        printf("Replay: could not open %s\n", path);
+        return false;
+    }
+
+    ReplayHeader header;
+    if (fread(&header, sizeof(ReplayHeader), 1, file) != 1 || memcmp(header.magic, REPLAY_MAGIC, 8) != 0 ||
+        header.version != REPLAY_VERSION || header.snapshot_size != sizeof(InputSnapshot) || header.frames == 0)
+    {
+        printf("Replay: %s is not a recording from this build\n", path);
+        fclose(file);
+        return false;
+    }
+
+    // the frame count comes from the file, so it has to fit in what follows the header
+    long length = -1;
+    if (fseek(file, 0, SEEK_END) == 0)
+        length = ftell(file);
+    if (length < (long)sizeof(ReplayHeader) || fseek(file, sizeof(ReplayHeader), SEEK_SET) != 0 ||
+        header.frames > ((uint64_t)length - sizeof(ReplayHeader)) / sizeof(ReplayFrame))
+    {
+        printf("Replay: %s is truncated\n", path);
+        fclose(file);
+        return false;
+    }
+
+    r->frames = (ReplayFrame*)malloc(header.frames * sizeof(ReplayFrame));
+    r->frame_ms = (float*)malloc(header.frames * sizeof(float));
+    if (!r->frames || !r->frame_ms || fread(r->frames, sizeof(ReplayFrame), header.frames, file) != header.frames)
+    {
+        printf("Replay: %s is truncated\n", path);
+        free(r->frames);
+        free(r->frame_ms);
+        r->frames = NULL;
+        r->frame_ms = NULL;
+        fclose(file);
+        return false;
+    }
+    fclose(file);
+
+    r->mode = REPLAY_PLAY;
+    r->count = header.frames;
+    r->cursor = 0;
+    Replay_Apply();
+
+    printf("Replay: playing %llu frames from %s\n", (unsigned long long)r->count, path);
+    return true;
+}
+
+static inline bool Replay_Playing(void) { return Replay_State.mode == REPLAY_PLAY; }
+static inline bool Replay_Finished(void) { return Replay_State.mode == REPLAY_PLAY && Replay_State.cursor >= Replay_State.count; }
+
+// Once per frame from Window_PollEvents, before the next input snapshot is taken: records the frame
+// just run, or moves playback on to the next one
+static inline void Replay_EndFrame(void)
+{
+    Replay* r = &Replay_State;
+    if (r->mode == REPLAY_RECORD)
+    {
+        // still the snapshot this frame consumed; the caller takes the next one afterwards
+        Replay_RecordFrame(Time_State.delta_ns, &Input_State.current);
+    }
+    else if (r->mode == REPLAY_PLAY && r->cursor < r->count)
+    {
+        // the first frame has no measured time
+        r->frame_ms[r->cursor] = (float)(Time_State.real_delta * 1000.0);
+        r->cursor += 1;
+        if (r->cursor < r->count)
+            Replay_Apply();
+    }
+}
+
+// Statistics of the playback frame times, all frames rather than the last TIME_STAT_SAMPLES
+static inline TimeFrameStats Replay_GetFrameStats(void)
+{
+    Replay* r = &Replay_State;
+    TimeFrameStats stats;
+    memset(&stats, 0, sizeof(TimeFrameStats));
+
+    int count = r->cursor > 1 ? (int)r->cursor - 1 : 0;
+    if (count == 0)
+        return stats;
+
+    float* sorted = (float*)malloc((size_t)count * sizeof(float));
+    memcpy(sorted, r->frame_ms + 1, (size_t)count * sizeof(float));
+    qsort(sorted, (size_t)count, sizeof(float), Time_CompareFloat);
+
+    double sum = 0.0;
+    for (int i = 0; i < count; ++i)
+        sum += sorted[i];
+
+    int p99 = (count * 99 + 99) / 100 - 1;
+    stats.min_ms = sorted[0];
+    stats.avg_ms = sum / count;
+    stats.p99_ms = sorted[p99 < count ? p99 : count - 1];
+    stats.max_ms = sorted[count - 1];
+    stats.frames = count;
+
+    free(sorted);
+    return stats;
+}
+
+static inline void Replay_WriteReport(const char* path, const TimeFrameStats* s)
+{
+    FILE* file = fopen(path, "w");
+    if (!file)
+    {
+        printf("Replay: could not write %s\n", path);
+        return;
+    }
+
+    fprintf(file, "{\"frames\": %d, \"min_ms\": %.4f, \"avg_ms\": %.4f, \"p99_ms\": %.4f, \"max_ms\": %.4f}\n",
+            s->frames, s->min_ms, s->avg_ms, s->p99_ms, s->max_ms);
+    fclose(file);
+}
+
+// Finishes a recording, or reports and frees a playback
+static inline void Replay_Stop(void)
+{
+    Replay* r = &Replay_State;
+    if (r->mode == REPLAY_RECORD)
+    {
+        ReplayHeader header = { { 'F', 'W', 'R', 'E', 'P', 'L', 'A', 'Y' }, REPLAY_VERSION, (uint32_t)sizeof(InputSnapshot), r->count };
+        fseek(r->file, 0, SEEK_SET);
+        fwrite(&header, sizeof(ReplayHeader), 1, r->file);
+        fclose(r->file);
+        printf("Replay: recorded %llu frames\n", (unsigned long long)r->count);
+    }
+    else if (r->mode == REPLAY_PLAY)
+    {
+        TimeFrameStats s = Replay_GetFrameStats();
+        printf("Replay: %d frames, min %.3f  avg %.3f  p99 %.3f  max %.3f ms%s\n", s.frames, s.min_ms, s.avg_ms,
+               s.p99_ms, s.max_ms, Replay_Finished() ? "" : " (stopped early)");
+        if (r->report[0])
+            Replay_WriteReport(r->report, &s);
+
+        free(r->frames);
+        free(r->frame_ms);
+    }
+
+    memset(r, 0, sizeof(Replay));
+}
+
+static inline void Replay_InitFromEnv(void)
+{
+    const char* replay = getenv("FRAMEWORK_REPLAY");
+    const char* record = getenv("FRAMEWORK_RECORD");
+    const char* report = getenv("FRAMEWORK_REPLAY_REPORT");
+
+    if (replay && replay[0])
+    {
+        if (Replay_StartPlayback(replay) && report)
+            snprintf(Replay_State.report, sizeof(Replay_State.report), "%s", report);
+    }
+    else if (record && record[0])
+    {
+        Replay_StartRecording(record);
+    }
+}
+
+#endif
@@ -0,0 +1,542 @@
+#ifndef SCENE_UTILITY_H
+#define SCENE_UTILITY_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "math_utility.h"
+#include "transform_utility.h"
+
+// Scene graph with transforms stored as flat SoA arrays sorted by depth, so every parent sits
+// before its children. Scene_Update walks the arrays once from the first dirty slot and recomputes
+// world matrices only for dirty nodes and their descendants.
+//
+// Nodes are addressed by stable SceneNode handles; slots (array positions) move when the scene is
+// re-sorted after a reparent or compacted after a destroy. A handle carries a generation next to its
+// index, so once a node is destroyed its handle stays invalid even after the index is reused.
+
+typedef int SceneNode;
+
+#define SCENE_NO_NODE           (-1)
+#define SCENE_INDEX_BITS        24
+#define SCENE_INDEX_MASK        ((1 << SCENE_INDEX_BITS) - 1)
+#define SCENE_GENERATION_MASK   0x7F    // 7 bits keep every handle non-negative
+
+static inline int SceneNode_Index(SceneNode node) { return node & SCENE_INDEX_MASK; }
+static inline int SceneNode_Generation(SceneNode node) { return node >> SCENE_INDEX_BITS; }
+
+typedef struct
+{
+    int count, capacity;
+
+    // per slot, in depth order
+    int* parent;            // parent slot or SCENE_NO_NODE
+    int* depth;
+    SceneNode* node;        // slot -> handle
+    Vector3* position;
+    Quaternion* rotation;
+    Vector3* scale;
+    Matrix4* world;
+    unsigned char* dirty;
+
+    // per handle index
+    int* slot;              // index -> slot, SCENE_NO_NODE when free
+    unsigned char* generation;
+    int handle_capacity;    // indices handed out so far
+    int handle_reserved;
+    int* free_handles;      // released indices
+    int free_count;
+
+    int first_dirty;        // lowest dirty slot, count when clean
+    bool needs_sort;        // a reparent broke the depth order
+    int dead_count;         // destroyed slots waiting for compaction
+
+} Scene;
+
+static inline bool Scene_Reserve(Scene* scene, int capacity)
+{
+    if (capacity <= scene->capacity)
+        return true;
+
+    int n = capacity;
+    void* p[8];
+    p[0] = realloc(scene->parent,   sizeof(int) * n);           if (p[0]) scene->parent = (int*)p[0];
+    p[1] = realloc(scene->depth,    sizeof(int) * n);           if (p[1]) scene->depth = (int*)p[1];
+    p[2] = realloc(scene->node,     sizeof(SceneNode) * n);     if (p[2]) scene->node = (SceneNode*)p[2];
+    p[3] = realloc(scene->position, sizeof(Vector3) * n);       if (p[3]) scene->position = (Vector3*)p[3];
+    p[4] = realloc(scene->rotation, sizeof(Quaternion) * n);    if (p[4]) scene->rotation = (Quaternion*)p[4];
+    p[5] = realloc(scene->scale,    sizeof(Vector3) * n);       if (p[5]) scene->scale = (Vector3*)p[5];
+    p[6] = realloc(scene->world,    sizeof(Matrix4) * n);       if (p[6]) scene->world = (Matrix4*)p[6];
+    p[7] = realloc(scene->dirty,    sizeof(unsigned char) * n); if (p[7]) scene->dirty = (unsigned char*)p[7];
+
+    for (int i = 0; i < 8; ++i)
+    {
+        if (!p[i])
+        {
+            fprintf(stderr, "Failed to grow scene to %d nodes\n", capacity);
+            return false;
+        }
+    }
+
+    scene->capacity = capacity;
+    return true;
+}
+
+static inline bool Scene_Create(Scene* scene, int capacity)
+{
+    memset(scene, 0, sizeof(Scene));
+    return Scene_Reserve(scene, capacity > 0 ? capacity : 64);
+}
+
+static inline void Scene_Delete(Scene* scene)
+{
+    free(scene->parent);
+    free(scene->depth);
+    free(scene->node);
+    free(scene->position);
+    free(scene->rotation);
+    free(scene->scale);
+    free(scene->world);
+    free(scene->dirty);
+    free(scene->slot);
+    free(scene->generation);
+    free(scene->free_handles);
+    memset(scene, 0, sizeof(Scene));
+}
+
+static inline void Scene_MarkDirty(Scene* scene, int slot)
+{
+    scene->dirty[slot] = 1;
+    if (slot < scene->first_dirty)
+        scene->first_dirty = slot;
+}
+
+static inline SceneNode Scene_AllocHandle(Scene* scene)
+{
+    if (scene->free_count > 0)
+    {
+        int index = scene->free_handles[--scene->free_count];
+        return (scene->generation[index] << SCENE_INDEX_BITS) | index;
+    }
+
+    // no free index: the next one is the index count so far, the tables grow with the slot arrays
+    int next = scene->handle_capacity;
+    if (next > SCENE_INDEX_MASK)
+    {
+        fprintf(stderr, "Scene handle limit reached (%d)\n", SCENE_INDEX_MASK + 1);
+        return SCENE_NO_NODE;
+    }
+
+    if (next == scene->handle_reserved)
+    {
+        int reserve = scene->capacity > next ? scene->capacity : next * 2;
+        int* slot = (int*)realloc(scene->slot, sizeof(int) * (size_t)reserve);
+        if (slot)
+            scene->slot = slot;
+
+        unsigned char* generation = (unsigned char*)realloc(scene->generation, (size_t)reserve);
+        if (generation)
+            scene->generation = generation;
+
+        int* free_handles = (int*)realloc(scene->free_handles, sizeof(int) * (size_t)reserve);
+        if (free_handles)
+            scene->free_handles = free_handles;
+
+        if (!slot || !generation || !free_handles)
+        {
+            fprintf(stderr, "Failed to grow scene handle table to %d\n", reserve);
+            return SCENE_NO_NODE;
+        }
+
+        scene->handle_reserved = reserve;
+    }
+
+    scene->slot[next] = SCENE_NO_NODE;
+    scene->generation[next] = 0;
+    scene->handle_capacity = next + 1;
+    return next;
+}
+
+// Releases the index of a destroyed node; the generation bump invalidates every copy of its handle
+static inline void Scene_FreeHandle(Scene* scene, SceneNode node)
+{
+    int index = SceneNode_Index(node);
+    scene->slot[index] = SCENE_NO_NODE;
+    scene->generation[index] = (unsigned char)((scene->generation[index] + 1) & SCENE_GENERATION_MASK);
+    scene->free_handles[scene->free_count++] = index;
+}
+
+static inline bool Scene_IsValid(const Scene* scene, SceneNode node)
+{
+    if (node < 0)
+        return false;
+
+    int index = SceneNode_Index(node);
+    return index < scene->handle_capacity && scene->slot[index] != SCENE_NO_NODE &&
+           scene->generation[index] == SceneNode_Generation(node);
+}
+
+// slot of a live node, SCENE_NO_NODE for a destroyed or stale handle
+static inline int Scene_Slot(const Scene* scene, SceneNode node)
+{
+    return Scene_IsValid(scene, node) ? scene->slot[SceneNode_Index(node)] : SCENE_NO_NODE;
+}
+
+// Appends a node with an identity local transform. parent may be SCENE_NO_NODE for a root; a parent
+// that was destroyed is refused rather than silently turning the node into a root.
+static inline SceneNode Scene_CreateNode(Scene* scene, SceneNode parent)
+{
+    if (parent != SCENE_NO_NODE && !Scene_IsValid(scene, parent))
+    {
+        fprintf(stderr, "Scene_CreateNode: parent %d is not a live node\n", parent);
+        return SCENE_NO_NODE;
+    }
+
+    if (scene->count == scene->capacity && !Scene_Reserve(scene, scene->capacity * 2))
+        return SCENE_NO_NODE;
+
+    SceneNode handle = Scene_AllocHandle(scene);
+    if (handle == SCENE_NO_NODE)
+        return SCENE_NO_NODE;
+
+    int parent_slot = Scene_Slot(scene, parent);
+    int slot = scene->count++;
+
+    scene->parent[slot] = parent_slot;
+    scene->depth[slot] = (parent_slot == SCENE_NO_NODE) ? 0 : scene->depth[parent_slot] + 1;
+    scene->node[slot] = handle;
+    scene->position[slot] = (Vector3){0.0f, 0.0f, 0.0f};
+    scene->rotation[slot] = Math_QuatIdentity();
+    scene->scale[slot] = (Vector3){1.0f, 1.0f, 1.0f};
+    scene->world[slot] = Math_Mat4Identity();
+    scene->slot[SceneNode_Index(handle)] = slot;
+
+    // appending after the parent keeps parents first; only a strictly depth sorted layout needs a sort
+    if (slot > 0 && scene->depth[slot] < scene->depth[slot - 1])
+        scene->needs_sort = true;
+
+    scene->dirty[slot] = 0;
+    Scene_MarkDirty(scene, slot);
+
+    return handle;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                               LOCAL TRANSFORM                              */
+/* -------------------------------------------------------------------------- */
+
+// Setters ignore destroyed or stale handles, getters return identity / SCENE_NO_NODE for them
+
+static inline void Scene_SetPosition(Scene* scene, SceneNode node, Vector3 position)
+{
+    int slot = Scene_Slot(scene, node);
+    if (slot == SCENE_NO_NODE)
+        return;
+    scene->position[slot] = position;
+    Scene_MarkDirty(scene, slot);
+}
+
+static inline void Scene_SetRotation(Scene* scene, SceneNode node, Quaternion rotation)
+{
+    int slot = Scene_Slot(scene, node);
+    if (slot == SCENE_NO_NODE)
+        return;
+    scene->rotation[slot] = rotation;
+    Scene_MarkDirty(scene, slot);
+}
+
+static inline void Scene_SetScale(Scene* scene, SceneNode node, Vector3 scale)
+{
+    int slot = Scene_Slot(scene, node);
+    if (slot == SCENE_NO_NODE)
+        return;
+    scene->scale[slot] = scale;
+    Scene_MarkDirty(scene, slot);
+}
+
+static inline void Scene_SetLocal(Scene* scene, SceneNode node, Transform local)
+{
+    int slot = Scene_Slot(scene, node);
+    if (slot == SCENE_NO_NODE)
+        return;
+    scene->position[slot] = local.position;
+    scene->rotation[slot] = local.rotation;
+    scene->scale[slot] = local.scale;
+    Scene_MarkDirty(scene, slot);
+}
+
+static inline Transform Scene_GetLocal(const Scene* scene, SceneNode node)
+{
+    int slot = Scene_Slot(scene, node);
+    if (slot == SCENE_NO_NODE)
+        return (Transform){ {0.0f, 0.0f, 0.0f}, Math_QuatIdentity(), {1.0f, 1.0f, 1.0f} };
+    return (Transform){ scene->position[slot], scene->rotation[slot], scene->scale[slot] };
+}
+
+// valid after the last Scene_Update
+static inline Matrix4 Scene_GetWorld(const Scene* scene, SceneNode node)
+{
+    int slot = Scene_Slot(scene, node);
+    return (slot == SCENE_NO_NODE) ? Math_Mat4Identity() : scene->world[slot];
+}
+
+static inline SceneNode Scene_GetParent(const Scene* scene, SceneNode node)
+{
+    int slot = Scene_Slot(scene, node);
+    if (slot == SCENE_NO_NODE)
+        return SCENE_NO_NODE;
+
+    int parent_slot = scene->parent[slot];
+    return (parent_slot == SCENE_NO_NODE) ? SCENE_NO_NODE : scene->node[parent_slot];
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  HIERARCHY                                 */
+/* -------------------------------------------------------------------------- */
+
+// Moves node (and its subtree) under parent. The depth order is restored by the next Scene_Update.
+static inline void Scene_SetParent(Scene* scene, SceneNode node, SceneNode parent)
+{
+    int slot = Scene_Slot(scene, node);
+    int parent_slot = Scene_Slot(scene, parent);
+    if (slot == SCENE_NO_NODE || (parent != SCENE_NO_NODE && parent_slot == SCENE_NO_NODE))
+    {
+        fprintf(stderr, "Scene_SetParent: node %d or parent %d is not a live node\n", node, parent);
+        return;
+    }
+
+    // refuse cycles: parent must not be inside node's subtree
+    for (int s = parent_slot; s != SCENE_NO_NODE; s = scene->parent[s])
+    {
+        if (s == slot)
+        {
+            fprintf(stderr, "Scene_SetParent: node %d cannot be parented to its own descendant\n", node);
+            return;
+        }
+    }
+
+    scene->parent[slot] = parent_slot;
+    scene->needs_sort = true;
+    Scene_MarkDirty(scene, slot);
+}
+
+// Destroys node and its whole subtree. Slots are compacted by the next Scene_Update.
+static inline void Scene_DestroyNode(Scene* scene, SceneNode node)
+{
+    if (!Scene_IsValid(scene, node))
+        return;
+
+    int root = Scene_Slot(scene, node);
+
+    // descendants come after their ancestors only while the order is intact
+    if (scene->needs_sort)
+    {
+        for (int i = 0; i < scene->count; ++i)
+        {
+            for (int s = i; s != SCENE_NO_NODE; s = scene->parent[s])
+            {
+                if (s == root)
+                {
+                    scene->depth[i] = -1;
+                    break;
+                }
+            }
+        }
+    }
+    else
+    {
+        scene->depth[root] = -1;
+        for (int i = root + 1; i < scene->count; ++i)
+        {
+            if (scene->parent[i] != SCENE_NO_NODE && scene->depth[scene->parent[i]] == -1)
+                scene->depth[i] = -1;
+        }
+    }
+
+    // depth -1 marks dead slots; their handles are released right away
+    for (int i = root; i < scene->count; ++i)
+    {
+        if (scene->depth[i] == -1 && scene->node[i] != SCENE_NO_NODE)
+        {
+            Scene_FreeHandle(scene, scene->node[i]);
+            scene->node[i] = SCENE_NO_NODE;
+            scene->dead_count += 1;
+        }
+    }
+
+    for (int i = 0; i < root; ++i)
+    {
+        if (scene->depth[i] == -1 && scene->node[i] != SCENE_NO_NODE)
+        {
+            Scene_FreeHandle(scene, scene->node[i]);
+            scene->node[i] = SCENE_NO_NODE;
+            scene->dead_count += 1;
+        }
+    }
+
+    scene->needs_sort = true;
+}
+
+// Rebuilds the depth order (stable counting sort by depth) and drops dead slots.
+// Every node whose slot moved keeps its handle; the moved subtrees are marked dirty.
+static inline void Scene_Sort(Scene* scene)
+{
+    int n = scene->count;
+
+    // depths from scratch, the order may not be topological here
+    int max_depth = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        if (scene->node[i] == SCENE_NO_NODE)
+            continue;
+
+        int d = 0;
+        for (int s = scene->parent[i]; s != SCENE_NO_NODE; s = scene->parent[s])
+            ++d;
+        scene->depth[i] = d;
+        if (d > max_depth)
+            max_depth = d;
+    }
+
+    int* offsets = (int*)calloc((size_t)max_depth + 2, sizeof(int));
+    int* order = (int*)malloc(sizeof(int) * (size_t)(n > 0 ? n : 1));
+    int* remap = (int*)malloc(sizeof(int) * (size_t)(n > 0 ? n : 1));
+    // one scratch copy shared by every field, sized for the widest; all allocations happen before
+    // anything moves so a failure leaves the scene untouched
+    void* scratch = malloc(sizeof(Matrix4) * (size_t)(n > 0 ? n : 1));
+    if (!offsets || !order || !remap || !scratch)
+    {
+        fprintf(stderr, "Failed to sort scene\n");
+        free(offsets); free(order); free(remap); free(scratch);
+        return;
+    }
+
+    for (int i = 0; i < n; ++i)
+    {
+        if (scene->node[i] != SCENE_NO_NODE)
+            offsets[scene->depth[i] + 1] += 1;
+    }
+    for (int d = 0; d <= max_depth; ++d)
+        offsets[d + 1] += offsets[d];
+
+    int alive = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        remap[i] = SCENE_NO_NODE;
+        if (scene->node[i] != SCENE_NO_NODE)
+        {
+            int to = offsets[scene->depth[i]]++;
+            order[to] = i;
+            remap[i] = to;
+            alive += 1;
+        }
+    }
+
+    // permute every array through a scratch copy
+    #define SCENE_PERMUTE(T, field)                                             \
+    {                                                                           \
+        T* tmp = (T*)scratch;                                                   \
+        for (int i = 0; i < alive; ++i) tmp[i] = scene->field[order[i]];        \
+        memcpy(scene->field, tmp, sizeof(T) * (size_t)alive);                   \
+    }
+
+    SCENE_PERMUTE(int, parent)
+    SCENE_PERMUTE(int, depth)
+    SCENE_PERMUTE(SceneNode, node)
+    SCENE_PERMUTE(Vector3, position)
+    SCENE_PERMUTE(Quaternion, rotation)
+    SCENE_PERMUTE(Vector3, scale)
+    SCENE_PERMUTE(Matrix4, world)
+    SCENE_PERMUTE(unsigned char, dirty)
+
+    #undef SCENE_PERMUTE
+
+    scene->count = alive;
+    scene->first_dirty = alive;
+    for (int i = 0; i < alive; ++i)
+    {
+        if (scene->parent[i] != SCENE_NO_NODE)
+            scene->parent[i] = remap[scene->parent[i]];
+        scene->slot[SceneNode_Index(scene->node[i])] = i;
+        if (scene->dirty[i] && i < scene->first_dirty)
+            scene->first_dirty = i;
+    }
+
+    scene->needs_sort = false;
+    scene->dead_count = 0;
+
+    free(offsets);
+    free(order);
+    free(remap);
+    free(scratch);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   UPDATE                                   */
+/* -------------------------------------------------------------------------- */
+
+// a * b for affine matrices (bottom row 0 0 0 1), 36 multiplies instead of 64
+static inline Matrix4 Scene_AffineMultiply(const Matrix4* a, const Matrix4* b)
+{
+    Matrix4 r;
+
+    for (int col = 0; col < 4; ++col)
+    {
+        float b0 = b->m[col * 4 + 0], b1 = b->m[col * 4 + 1], b2 = b->m[col * 4 + 2];
+        for (int row = 0; row < 3; ++row)
+            r.m[col * 4 + row] = a->m[row] * b0 + a->m[4 + row] * b1 + a->m[8 + row] * b2;
+        r.m[col * 4 + 3] = 0.0f;
+    }
+
+    r.m[12] += a->m[12];
+    r.m[13] += a->m[13];
+    r.m[14] += a->m[14];
+    r.m[15] = 1.0f;
+
+    return r;
+}
+
+// Recomputes world matrices for dirty nodes and everything below them. Returns the number recomputed.
+static inline int Scene_Update(Scene* scene)
+{
+    if (scene->needs_sort)
+        Scene_Sort(scene);
+
+    int updated = 0;
+
+    // a node is dirty if it was touched or its parent was recomputed in this pass;
+    // parents precede children, so one forward walk settles everything
+    for (int i = scene->first_dirty; i < scene->count; ++i)
+    {
+        int p = scene->parent[i];
+        if (!scene->dirty[i] && (p == SCENE_NO_NODE || !scene->dirty[p]))
+            continue;
+
+        scene->dirty[i] = 1;
+
+        Transform t = { scene->position[i], scene->rotation[i], scene->scale[i] };
+        Matrix4 local = Transform_ToMatrix(&t);
+        scene->world[i] = (p == SCENE_NO_NODE) ? local : Scene_AffineMultiply(&scene->world[p], &local);
+        updated += 1;
+    }
+
+    if (scene->first_dirty < scene->count)
+        memset(scene->dirty + scene->first_dirty, 0, (size_t)(scene->count - scene->first_dirty));
+
+    scene->first_dirty = scene->count;
+
+    return updated;
+}
+
+// Marks every node dirty (the next update recomputes the whole scene)
+static inline void Scene_MarkAllDirty(Scene* scene)
+{
+    if (scene->count == 0)
+        return;
+
+    memset(scene->dirty, 1, (size_t)scene->count);
+    scene->first_dirty = 0;
+}
+
+#endif
@@ -2,11 +2,17 @@
 #define SHADER_UTILITY_H
 
 #include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include "string_utility.h"
 #include "file_utility.h"
 #include "math_utility.h"
+#include "gl_extension_utility.h"
+#include "texture_utility.h"
 
 typedef struct
 {
@@ -46,39 +52,609 @@ static inline void Shader_LinkErrors(unsigned int program)
     }
 }
 
-static inline void Shader_Create(Shader* shader, const char* vs_file, const char* fs_file)
+/* -------------------------------------------------------------------------- */
+/*                            PROGRAM BINARY CACHE                            */
+/* -------------------------------------------------------------------------- */
+
+// Linked programs are stored under Shader_CacheDir keyed by a hash of both sources and the
+// driver's vendor/renderer/version, so a driver update or source edit just misses the cache.
+// Set Shader_CacheDir to NULL to always compile.
+
+#define SHADER_CACHE_MAGIC  0x48434453u     // "SDCH"
+
+static const char* Shader_CacheDir = ".shader_cache";
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t format;        // driver binary format enum
+    uint32_t length;
+    uint32_t reserved;
+    uint64_t key;           // repeated here so a truncated or foreign file is rejected
+
+} ShaderCacheHeader;
+
+typedef struct
+{
+    GLExtGetProgramBinaryProc get_binary;
+    GLExtProgramBinaryProc binary;
+    GLExtProgramParameteriProc parameteri;
+    bool supported;
+    bool queried;
+
+} ShaderBinaryApi;
+
+static ShaderBinaryApi Shader_BinaryApi = { NULL, NULL, NULL, false, false };
+
+// resolves the program binary entry points once, needs a current context
+static inline bool Shader_BinarySupported(void)
+{
+    ShaderBinaryApi* api = &Shader_BinaryApi;
+    if (api->queried)
+        return api->supported;
+
+    api->queried = true;
+
+    if (!GLExt_HasVersion(4, 1) && !GLExt_IsSupported("GL_ARB_get_program_binary"))
+        return false;
+
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+
+    api->get_binary = (GLExtGetProgramBinaryProc)GLExt_GetProcAddress("glGetProgramBinary");
+    api->binary = (GLExtProgramBinaryProc)GLExt_GetProcAddress("glProgramBinary");
+    api->parameteri = (GLExtProgramParameteriProc)GLExt_GetProcAddress("glProgramParameteri");
+    api->supported = formats > 0 && api->get_binary && api->binary && api->parameteri;
+
+    return api->supported;
+}
+
+static inline uint64_t Shader_HashBytes(uint64_t hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// FNV-1a over both sources and the driver strings, each followed by a 0 separator
+static inline uint64_t Shader_CacheKey(const char* vs, size_t vs_length, const char* fs, size_t fs_length)
+{
+    const char* driver[3] = { (const char*)glGetString(GL_VENDOR), (const char*)glGetString(GL_RENDERER),
+                              (const char*)glGetString(GL_VERSION) };
+    const unsigned char zero = 0;
+
+    uint64_t hash = 14695981039346656037ULL;
+    hash = Shader_HashBytes(hash, vs, vs_length);
+    hash = Shader_HashBytes(hash, &zero, 1);
+    hash = Shader_HashBytes(hash, fs, fs_length);
+
+    for (int i = 0; i < 3; ++i)
+    {
+        hash = Shader_HashBytes(hash, &zero, 1);
+        if (driver[i])
+            hash = Shader_HashBytes(hash, driver[i], strlen(driver[i]));
+    }
+
+    return hash;
+}
+
+static inline void Shader_CachePath(char* out, size_t size, uint64_t key)
+{
+    snprintf(out, size, "%s/%016llx.bin", Shader_CacheDir, (unsigned long long)key);
+}
+
+// Returns a linked program from the cache or 0. A blob the driver rejects is deleted.
+static inline unsigned int Shader_LoadBinary(uint64_t key)
+{
+    if (!Shader_CacheDir || !Shader_BinarySupported())
+        return 0;
+
+    char path[512];
+    Shader_CachePath(path, sizeof(path), key);
+
+    FILE* file = fopen(path, "rb");
+    if (!file)
+        return 0;
+
+    ShaderCacheHeader header;
+    void* blob = NULL;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 && header.magic == SHADER_CACHE_MAGIC && header.key == key &&
+              (blob = malloc(header.length ? header.length : 1)) != NULL && fread(blob, 1, header.length, file) == header.length;
+    fclose(file);
+
+    unsigned int program = 0;
+    if (ok)
+    {
+        program = glCreateProgram();
+        Shader_BinaryApi.binary(program, header.format, blob, (GLsizei)header.length);
+
+        GLint linked = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked)
+        {
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+
+    free(blob);
+
+    if (!program)
+        remove(path);
+
+    return program;
+}
+
+static inline void Shader_SaveBinary(unsigned int program, uint64_t key)
 {
-    shader->program = 0;
+    if (!Shader_CacheDir || !Shader_BinarySupported())
+        return;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    void* blob = malloc((size_t)length);
+    if (!blob)
+        return;
+
+    GLenum format = 0;
+    GLsizei written = 0;
+    Shader_BinaryApi.get_binary(program, length, &written, &format, blob);
 
-    String vertex_program = File_Load(vs_file);
-    String frag_program = File_Load(fs_file);
+    mkdir(Shader_CacheDir, 0755);
 
-    const char* vp = vertex_program.data;
-    const char* fp = frag_program.data;
+    char path[512];
+    Shader_CachePath(path, sizeof(path), key);
 
+    FILE* file = fopen(path, "wb");
+    if (file)
+    {
+        ShaderCacheHeader header = { SHADER_CACHE_MAGIC, (uint32_t)format, (uint32_t)written, 0, key };
+        fwrite(&header, sizeof(header), 1, file);
+        fwrite(blob, 1, (size_t)written, file);
+        fclose(file);
+    }
+
+    free(blob);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  CREATION                                  */
+/* -------------------------------------------------------------------------- */
+
+static inline double Shader_Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static inline unsigned int Shader_CompileProgram(const char* vs, GLint vs_length, const char* fs, GLint fs_length)
+{
     unsigned int vertex_shader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex_shader, 1, &vp, NULL);
+    glShaderSource(vertex_shader, 1, &vs, &vs_length);
     glCompileShader(vertex_shader);
     // check compile errors
     Shader_CompileErrors(vertex_shader, GL_VERTEX_SHADER);
 
     unsigned int fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment_shader, 1, &fp, NULL);
+    glShaderSource(fragment_shader, 1, &fs, &fs_length);
     glCompileShader(fragment_shader);   
     Shader_CompileErrors(fragment_shader, GL_FRAGMENT_SHADER);
 
-    shader->program = glCreateProgram();
-    glAttachShader(shader->program, vertex_shader);
-    glAttachShader(shader->program, fragment_shader);
-    glLinkProgram(shader->program);
-    Shader_LinkErrors(shader->program);
+    unsigned int program = glCreateProgram();
+
+    // must be set before linking for glGetProgramBinary to return anything
+    if (Shader_CacheDir && Shader_BinarySupported())
+        Shader_BinaryApi.parameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+    glAttachShader(program, vertex_shader);
+    glAttachShader(program, fragment_shader);
+    glLinkProgram(program);
+    Shader_LinkErrors(program);
 
     glDeleteShader(vertex_shader);
     glDeleteShader(fragment_shader);
 
-    String_Free(&vertex_program);
-    String_Free(&frag_program);
-}   
+    return program;
+}
+
+// Builds a program from in-memory sources, going through the binary cache. label is used for the timing report.
+static inline void Shader_CreateFromSource(Shader* shader, const char* vs, size_t vs_length, const char* fs, size_t fs_length,
+                                           const char* label)
+{
+    double start = Shader_Now();
+    uint64_t key = Shader_CacheKey(vs, vs_length, fs, fs_length);
+
+    shader->program = Shader_LoadBinary(key);
+    if (shader->program)
+    {
+        printf("Shader %s: cache hit in %.2f ms\n", label, (Shader_Now() - start) * 1000.0);
+        return;
+    }
+
+    shader->program = Shader_CompileProgram(vs, (GLint)vs_length, fs, (GLint)fs_length);
+
+    GLint linked = 0;
+    glGetProgramiv(shader->program, GL_LINK_STATUS, &linked);
+    if (linked)
+        Shader_SaveBinary(shader->program, key);
+
+    printf("Shader %s: %s in %.2f ms\n", label, linked ? "compiled" : "failed to build", (Shader_Now() - start) * 1000.0);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                PREPROCESSOR                                */
+/* -------------------------------------------------------------------------- */
+
+// Expands #include "file" (relative to the including file) and injects #defines after #version.
+// defines is a space separated list, "USE_TEXTURE FOG_DENSITY=0.1" becomes
+// "#define USE_TEXTURE" and "#define FOG_DENSITY 0.1". #line directives keep error line numbers
+// pointing at the right line of each file.
+
+#define SHADER_PATH_MAX             128
+#define SHADER_MAX_DEPENDENCIES     16
+#define SHADER_MAX_INCLUDE_DEPTH    8
+
+// every file a program was built from, for the hot-reload watcher
+typedef struct
+{
+    char files[SHADER_MAX_DEPENDENCIES][SHADER_PATH_MAX];
+    int count;
+
+} ShaderDependencies;
+
+// what a program is built from: two files plus the variant defines
+typedef struct
+{
+    char vs_file[SHADER_PATH_MAX];
+    char fs_file[SHADER_PATH_MAX];
+    char defines[SHADER_PATH_MAX];
+    ShaderDependencies deps;
+    bool loose;             // read the files on disk even when a pack is mounted (hot reload)
+
+} ShaderSource;
+
+static inline void ShaderDependencies_Add(ShaderDependencies* deps, const char* path)
+{
+    if (!deps)
+        return;
+
+    for (int i = 0; i < deps->count; ++i)
+    {
+        if (strcmp(deps->files[i], path) == 0)
+            return;
+    }
+
+    if (deps->count < SHADER_MAX_DEPENDENCIES)
+        snprintf(deps->files[deps->count++], SHADER_PATH_MAX, "%s", path);
+}
+
+static inline void Shader_AppendDefines(String* out, const char* defines)
+{
+    const char* c = defines;
+    while (c && *c)
+    {
+        while (*c == ' ')
+            ++c;
+
+        const char* token = c;
+        while (*c && *c != ' ')
+            ++c;
+
+        if (c == token)
+            break;
+
+        const char* equals = (const char*)memchr(token, '=', (size_t)(c - token));
+        String_Append(out, "#define ");
+        if (equals)
+        {
+            String_AppendN(out, token, (size_t)(equals - token));
+            String_Append(out, " ");
+            String_AppendN(out, equals + 1, (size_t)(c - equals - 1));
+        }
+        else
+        {
+            String_AppendN(out, token, (size_t)(c - token));
+        }
+        String_Append(out, "\n");
+    }
+}
+
+static inline bool Shader_PreprocessFile(String* out, const char* path, const char* defines, int depth, ShaderDependencies* deps, bool loose)
+{
+    if (depth > SHADER_MAX_INCLUDE_DEPTH)
+    {
+        printf("ERROR::SHADER::PREPROCESS::INCLUDE_DEPTH %s\n", path);
+        return false;
+    }
+
+    FileView view;
+    if (!(loose ? File_MapLoose(&view, path) : File_Map(&view, path)))
+        return false;
+
+    ShaderDependencies_Add(deps, path);
+
+    bool ok = true;
+    size_t cursor = 0;
+    int line_number = 0;
+    char line_directive[32];
+
+    while (cursor < view.size && ok)
+    {
+        const char* line = view.data + cursor;
+        const char* newline = (const char*)memchr(line, '\n', view.size - cursor);
+        size_t length = newline ? (size_t)(newline - line) + 1 : view.size - cursor;
+        cursor += length;
+        ++line_number;
+
+        const char* c = line;
+        while (c < line + length && (*c == ' ' || *c == '\t'))
+            ++c;
+
+        if ((size_t)(line + length - c) > 8 && strncmp(c, "#include", 8) == 0)
+        {
+            const char* open = (const char*)memchr(c, '"', (size_t)(line + length - c));
+            const char* close = open ? (const char*)memchr(open + 1, '"', (size_t)(line + length - open - 1)) : NULL;
+            if (!close)
+            {
+                printf("ERROR::SHADER::PREPROCESS::BAD_INCLUDE %s:%d\n", path, line_number);
+                ok = false;
+                break;
+            }
+
+            // relative to the including file's directory
+            char include_path[SHADER_PATH_MAX];
+            const char* slash = strrchr(path, '/');
+            int dir_length = slash ? (int)(slash - path) + 1 : 0;
+            snprintf(include_path, sizeof(include_path), "%.*s%.*s", dir_length, path, (int)(close - open - 1), open + 1);
+
+            snprintf(line_directive, sizeof(line_directive), "#line 1\n");
+            String_Append(out, line_directive);
+            ok = Shader_PreprocessFile(out, include_path, NULL, depth + 1, deps, loose);
+
+            snprintf(line_directive, sizeof(line_directive), "#line %d\n", line_number + 1);
+            String_Append(out, line_directive);
+            continue;
+        }
+
+        String_AppendN(out, line, length);
+        if (!newline)
+            String_Append(out, "\n");
+
+        if (defines && *defines && strncmp(c, "#version", 8) == 0)
+        {
+            Shader_AppendDefines(out, defines);
+            snprintf(line_directive, sizeof(line_directive), "#line %d\n", line_number + 1);
+            String_Append(out, line_directive);
+        }
+    }
+
+    File_Unmap(&view);
+    return ok;
+}
+
+static inline String Shader_Preprocess(const char* path, const char* defines, ShaderDependencies* deps, bool loose)
+{
+    String out = String_Create(4096, NULL, NULL);
+    if (!Shader_PreprocessFile(&out, path, defines, 0, deps, loose))
+        out.length = 0;
+    return out;
+}
+
+// Preprocesses and builds source->vs_file / fs_file, filling source->deps.
+// Returns the program, or 0 if preprocessing, compiling or linking failed.
+static inline unsigned int Shader_Build(ShaderSource* source)
+{
+    source->deps.count = 0;
+
+    String vs = Shader_Preprocess(source->vs_file, source->defines, &source->deps, source->loose);
+    String fs = Shader_Preprocess(source->fs_file, source->defines, &source->deps, source->loose);
+
+    Shader shader = {0};
+    if (vs.length && fs.length)
+    {
+        char label[3 * SHADER_PATH_MAX + 16];
+        snprintf(label, sizeof(label), "%s + %s%s%s%s", source->vs_file, source->fs_file,
+                 source->defines[0] ? " [" : "", source->defines, source->defines[0] ? "]" : "");
+        Shader_CreateFromSource(&shader, vs.data, vs.length, fs.data, fs.length, label);
+    }
+
+    String_Free(&vs);
+    String_Free(&fs);
+
+    GLint linked = 0;
+    if (shader.program)
+        glGetProgramiv(shader.program, GL_LINK_STATUS, &linked);
+
+    if (!linked && shader.program)
+    {
+        glDeleteProgram(shader.program);
+        shader.program = 0;
+    }
+
+    return shader.program;
+}
+
+static inline void ShaderSource_Set(ShaderSource* source, const char* vs_file, const char* fs_file, const char* defines)
+{
+    snprintf(source->vs_file, SHADER_PATH_MAX, "%s", vs_file);
+    snprintf(source->fs_file, SHADER_PATH_MAX, "%s", fs_file);
+    snprintf(source->defines, SHADER_PATH_MAX, "%s", defines ? defines : "");
+    source->deps.count = 0;
+    source->loose = false;
+}
+
+// Shader_Create with variant defines (may be NULL)
+static inline void Shader_CreateEx(Shader* shader, const char* vs_file, const char* fs_file, const char* defines)
+{
+    ShaderSource source;
+    ShaderSource_Set(&source, vs_file, fs_file, defines);
+    shader->program = Shader_Build(&source);
+}
+
+static inline void Shader_Create(Shader* shader, const char* vs_file, const char* fs_file)
+{
+    Shader_CreateEx(shader, vs_file, fs_file, NULL);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                VARIANT CACHE                               */
+/* -------------------------------------------------------------------------- */
+
+// One program per (files, defines) combination, built on first use. Variants live in a fixed
+// array so the Shader pointers handed out stay valid (the hot-reload watcher swaps them in place).
+
+typedef struct
+{
+    ShaderSource source;
+    Shader shader;
+    bool dirty;         // a dependency changed, the watcher rebuilds it on its next poll
+
+} ShaderVariant;
+
+typedef struct
+{
+    ShaderVariant* variants;
+    int count, capacity;
+
+} ShaderVariantCache;
+
+static inline bool ShaderVariants_Create(ShaderVariantCache* cache, int capacity)
+{
+    cache->count = 0;
+    cache->capacity = capacity;
+    cache->variants = (ShaderVariant*)calloc((size_t)capacity, sizeof(ShaderVariant));
+    if (!cache->variants)
+    {
+        fprintf(stderr, "Failed to allocate shader variant cache\n");
+        cache->capacity = 0;
+        return false;
+    }
+    return true;
+}
+
+static inline Shader* ShaderVariants_Get(ShaderVariantCache* cache, const char* vs_file, const char* fs_file, const char* defines)
+{
+    if (!defines)
+        defines = "";
+
+    for (int i = 0; i < cache->count; ++i)
+    {
+        ShaderSource* source = &cache->variants[i].source;
+        if (strcmp(source->defines, defines) == 0 && strcmp(source->vs_file, vs_file) == 0 &&
+            strcmp(source->fs_file, fs_file) == 0)
+            return &cache->variants[i].shader;
+    }
+
+    if (cache->count >= cache->capacity)
+    {
+        fprintf(stderr, "Shader variant cache full (%d)\n", cache->capacity);
+        return NULL;
+    }
+
+    ShaderVariant* variant = &cache->variants[cache->count++];
+    ShaderSource_Set(&variant->source, vs_file, fs_file, defines);
+    variant->shader.program = Shader_Build(&variant->source);
+
+    return &variant->shader;
+}
+
+static inline void ShaderVariants_Delete(ShaderVariantCache* cache)
+{
+    for (int i = 0; i < cache->count; ++i)
+        glDeleteProgram(cache->variants[i].shader.program);
+
+    free(cache->variants);
+    cache->variants = NULL;
+    cache->count = cache->capacity = 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                PERMUTATIONS                                */
+/* -------------------------------------------------------------------------- */
+
+// Feature bits are compiled into #defines, so each combination is its own branch-free program
+// instead of a uniform tested per fragment. Every permutation also defines SHADER_PERMUTATION; a
+// shader built without it (plain Shader_Create) keeps its general form, e.g. fragment.glsl is then
+// always lit and tests uUseTexture like it did before permutations existed.
+
+typedef enum
+{
+    SHADER_FEATURE_TEXTURE  = 1 << 0,   // USE_TEXTURE: modulate by uTexture (slot 0)
+    SHADER_FEATURE_LIGHTING = 1 << 1    // USE_LIGHTING: ambient + diffuse + specular, else flat uColor
+
+} ShaderFeature;
+
+#define SHADER_FEATURE_COUNT        2
+#define SHADER_PERMUTATION_COUNT    (1 << SHADER_FEATURE_COUNT)
+
+static const char* const Shader_FeatureDefines[SHADER_FEATURE_COUNT] = { "USE_TEXTURE", "USE_LIGHTING" };
+
+// "SHADER_PERMUTATION USE_TEXTURE USE_LIGHTING" for both bits, always in bit order so the variant
+// key is stable
+static inline void Shader_FeaturesToDefines(unsigned int features, char* out, size_t size)
+{
+    size_t length = (size_t)snprintf(out, size, "SHADER_PERMUTATION");
+
+    for (int i = 0; i < SHADER_FEATURE_COUNT; ++i)
+    {
+        if ((features & (1u << i)) && length < size)
+            length += (size_t)snprintf(out + length, size - length, " %s", Shader_FeatureDefines[i]);
+    }
+}
+
+// A standalone program for one feature combination
+static inline void Shader_CreatePermutation(Shader* shader, const char* vs_file, const char* fs_file, unsigned int features)
+{
+    char defines[SHADER_PATH_MAX];
+    Shader_FeaturesToDefines(features, defines, sizeof(defines));
+    Shader_CreateEx(shader, vs_file, fs_file, defines);
+}
+
+// All permutations of one vertex/fragment pair. Programs are built on first use through the
+// variant cache (so the hot-reload watcher sees them) and then found with one table lookup.
+typedef struct
+{
+    ShaderVariantCache* cache;
+    char vs_file[SHADER_PATH_MAX];
+    char fs_file[SHADER_PATH_MAX];
+    Shader* programs[SHADER_PERMUTATION_COUNT];
+
+} ShaderPermutations;
+
+static inline void ShaderPermutations_Create(ShaderPermutations* perms, ShaderVariantCache* cache, const char* vs_file, const char* fs_file)
+{
+    perms->cache = cache;
+    snprintf(perms->vs_file, SHADER_PATH_MAX, "%s", vs_file);
+    snprintf(perms->fs_file, SHADER_PATH_MAX, "%s", fs_file);
+
+    for (int i = 0; i < SHADER_PERMUTATION_COUNT; ++i)
+        perms->programs[i] = NULL;
+}
+
+// NULL when the variant cache is full; nothing is remembered then, so a later call tries again
+static inline Shader* ShaderPermutations_Get(ShaderPermutations* perms, unsigned int features)
+{
+    features &= SHADER_PERMUTATION_COUNT - 1;
+
+    if (perms->programs[features])
+        return perms->programs[features];
+
+    char defines[SHADER_PATH_MAX];
+    Shader_FeaturesToDefines(features, defines, sizeof(defines));
+
+    Shader* shader = ShaderVariants_Get(perms->cache, perms->vs_file, perms->fs_file, defines);
+    if (shader)
+        perms->programs[features] = shader;
+    return shader;
+}
 
 static inline void Shader_SetUniform1i(Shader* shader, const char *name, int value)
 {
@@ -142,4 +718,24 @@ static inline void Shader_Delete(Shader* shader)
     }
 }
 
+// Enables the permutation a draw needs: passing a texture selects USE_TEXTURE and binds it to slot 0
+// for uTexture, so draws describe what they use instead of picking a program.
+// Returns NULL, with nothing enabled or bound, when the permutation cannot be created; skip the draw.
+static inline Shader* ShaderPermutations_Enable(ShaderPermutations* perms, unsigned int features, Texture* texture)
+{
+    Shader* shader = ShaderPermutations_Get(perms, texture ? (features | SHADER_FEATURE_TEXTURE) : (features & ~SHADER_FEATURE_TEXTURE));
+    if (!shader)
+        return NULL;
+
+    Shader_Enable(shader);
+
+    if (texture)
+    {
+        Texture_Enable(texture, 0);
+        Shader_SetUniform1i(shader, "uTexture", 0);
+    }
+
+    return shader;
+}
+
 #endif
\ No newline at end of file
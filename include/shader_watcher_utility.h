@@ -0,0 +1,268 @@
+#ifndef SHADER_WATCHER_UTILITY_H
+#define SHADER_WATCHER_UTILITY_H
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <glad/glad.h>
+#include "shader_utility.h"
+
+// Shader hot reload. Watches the directories of every file a registered program was built from
+// (includes too) with inotify. ShaderWatcher_Poll is non-blocking and meant to be called once per
+// frame on the GL thread: changed programs are rebuilt and the new program id replaces the old one
+// between draws. A program that fails to compile or link keeps the old one.
+// Reloads read the loose files even while a pack is mounted: the pack holds the copies from when it
+// was built, the edits happen on disk.
+
+#define SHADER_WATCH_MAX        64
+#define SHADER_WATCH_DIRS_MAX   16
+
+typedef struct
+{
+    Shader* shader;
+    ShaderSource source;
+    bool dirty;
+
+} ShaderWatch;
+
+typedef struct
+{
+    int fd;
+    int dir_wd[SHADER_WATCH_DIRS_MAX];
+    char dirs[SHADER_WATCH_DIRS_MAX][SHADER_PATH_MAX];
+    int dir_count;
+
+    ShaderWatch watches[SHADER_WATCH_MAX];
+    int count;
+
+    ShaderVariantCache* caches[4];  // variant caches are scanned on every poll, new variants included
+    int cache_count;
+
+} ShaderWatcher;
+
+static inline bool ShaderWatcher_Create(ShaderWatcher* watcher)
+{
+    memset(watcher, 0, sizeof(ShaderWatcher));
+
+    watcher->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watcher->fd < 0)
+    {
+        printf("Failed to create shader watcher (inotify)\n");
+        return false;
+    }
+
+    return true;
+}
+
+static inline void ShaderWatcher_Delete(ShaderWatcher* watcher)
+{
+    if (watcher->fd >= 0)
+        close(watcher->fd);
+
+    watcher->fd = -1;
+    watcher->count = 0;
+    watcher->dir_count = 0;
+    watcher->cache_count = 0;
+}
+
+// splits "a/b/c.glsl" into "a/b" and "c.glsl", a bare file name lives in "."
+static inline void ShaderWatcher_SplitPath(const char* path, char* dir, const char** name)
+{
+    const char* slash = strrchr(path, '/');
+    if (slash)
+    {
+        snprintf(dir, SHADER_PATH_MAX, "%.*s", (int)(slash - path), path);
+        *name = slash + 1;
+    }
+    else
+    {
+        snprintf(dir, SHADER_PATH_MAX, ".");
+        *name = path;
+    }
+}
+
+static inline void ShaderWatcher_WatchDependencies(ShaderWatcher* watcher, const ShaderDependencies* deps)
+{
+    for (int i = 0; i < deps->count; ++i)
+    {
+        char dir[SHADER_PATH_MAX];
+        const char* name;
+        ShaderWatcher_SplitPath(deps->files[i], dir, &name);
+
+        bool known = false;
+        for (int d = 0; d < watcher->dir_count && !known; ++d)
+            known = strcmp(watcher->dirs[d], dir) == 0;
+
+        if (known || watcher->dir_count >= SHADER_WATCH_DIRS_MAX)
+            continue;
+
+        // editors either rewrite in place (CLOSE_WRITE) or write a temp file and rename it over (MOVED_TO)
+        int wd = inotify_add_watch(watcher->fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd < 0)
+        {
+            printf("Failed to watch shader directory: %s\n", dir);
+            continue;
+        }
+
+        watcher->dir_wd[watcher->dir_count] = wd;
+        snprintf(watcher->dirs[watcher->dir_count], SHADER_PATH_MAX, "%s", dir);
+        watcher->dir_count += 1;
+    }
+}
+
+// Watches an existing shader. The sources are preprocessed once to learn their includes.
+static inline void ShaderWatcher_Add(ShaderWatcher* watcher, Shader* shader, const char* vs_file, const char* fs_file, const char* defines)
+{
+    if (watcher->count >= SHADER_WATCH_MAX)
+    {
+        printf("Shader watcher full (%d)\n", SHADER_WATCH_MAX);
+        return;
+    }
+
+    ShaderWatch* watch = &watcher->watches[watcher->count++];
+    watch->shader = shader;
+    watch->dirty = false;
+    ShaderSource_Set(&watch->source, vs_file, fs_file, defines);
+
+    // preprocess only, the program itself already exists
+    String vs = Shader_Preprocess(vs_file, watch->source.defines, &watch->source.deps, false);
+    String fs = Shader_Preprocess(fs_file, watch->source.defines, &watch->source.deps, false);
+    String_Free(&vs);
+    String_Free(&fs);
+
+    ShaderWatcher_WatchDependencies(watcher, &watch->source.deps);
+}
+
+// Every variant the cache holds or builds later is reloaded too
+static inline void ShaderWatcher_AddCache(ShaderWatcher* watcher, ShaderVariantCache* cache)
+{
+    if (watcher->cache_count < (int)(sizeof(watcher->caches) / sizeof(watcher->caches[0])))
+        watcher->caches[watcher->cache_count++] = cache;
+}
+
+static inline bool ShaderWatcher_DependsOn(const ShaderDependencies* deps, const char* dir, const char* name)
+{
+    for (int i = 0; i < deps->count; ++i)
+    {
+        char dep_dir[SHADER_PATH_MAX];
+        const char* dep_name;
+        ShaderWatcher_SplitPath(deps->files[i], dep_dir, &dep_name);
+
+        if (strcmp(dep_name, name) == 0 && strcmp(dep_dir, dir) == 0)
+            return true;
+    }
+    return false;
+}
+
+// rebuilds one program, swapping it in only on success
+static inline bool ShaderWatcher_Reload(Shader* shader, ShaderSource* source)
+{
+    ShaderSource rebuilt = *source;
+    rebuilt.loose = true;
+    unsigned int program = Shader_Build(&rebuilt);
+
+    if (!program)
+    {
+        printf("Shader reload failed, keeping the previous program: %s + %s [%s]\n", source->vs_file, source->fs_file, source->defines);
+        return false;
+    }
+
+    glDeleteProgram(shader->program);
+    shader->program = program;
+    *source = rebuilt;      // includes may have changed
+
+    return true;
+}
+
+// Drains pending file events and rebuilds affected programs. Returns the number reloaded.
+static inline int ShaderWatcher_Poll(ShaderWatcher* watcher)
+{
+    if (watcher->fd < 0)
+        return 0;
+
+    // pick up directories of variants built since the last poll
+    for (int c = 0; c < watcher->cache_count; ++c)
+    {
+        for (int i = 0; i < watcher->caches[c]->count; ++i)
+            ShaderWatcher_WatchDependencies(watcher, &watcher->caches[c]->variants[i].source.deps);
+    }
+
+    // one save often produces several events: collect them all, then rebuild each program once
+    bool any = false;
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    for (;;)
+    {
+        ssize_t length = read(watcher->fd, buffer, sizeof(buffer));
+        if (length <= 0)
+            break;
+
+        for (char* ptr = buffer; ptr < buffer + length; ptr += sizeof(struct inotify_event) + ((struct inotify_event*)ptr)->len)
+        {
+            const struct inotify_event* event = (const struct inotify_event*)ptr;
+            if (event->len == 0)
+                continue;
+
+            const char* dir = NULL;
+            for (int d = 0; d < watcher->dir_count; ++d)
+            {
+                if (watcher->dir_wd[d] == event->wd)
+                    dir = watcher->dirs[d];
+            }
+            if (!dir)
+                continue;
+
+            for (int i = 0; i < watcher->count; ++i)
+            {
+                if (ShaderWatcher_DependsOn(&watcher->watches[i].source.deps, dir, event->name))
+                    watcher->watches[i].dirty = any = true;
+            }
+
+            for (int c = 0; c < watcher->cache_count; ++c)
+            {
+                ShaderVariantCache* cache = watcher->caches[c];
+                for (int i = 0; i < cache->count; ++i)
+                {
+                    if (ShaderWatcher_DependsOn(&cache->variants[i].source.deps, dir, event->name))
+                        cache->variants[i].dirty = any = true;
+                }
+            }
+        }
+    }
+
+    if (!any)
+        return 0;
+
+    int reloaded = 0;
+
+    for (int i = 0; i < watcher->count; ++i)
+    {
+        ShaderWatch* watch = &watcher->watches[i];
+        if (watch->dirty)
+        {
+            watch->dirty = false;
+            reloaded += ShaderWatcher_Reload(watch->shader, &watch->source);
+        }
+    }
+
+    for (int c = 0; c < watcher->cache_count; ++c)
+    {
+        ShaderVariantCache* cache = watcher->caches[c];
+        for (int i = 0; i < cache->count; ++i)
+        {
+            ShaderVariant* variant = &cache->variants[i];
+            if (variant->dirty)
+            {
+                variant->dirty = false;
+                reloaded += ShaderWatcher_Reload(&variant->shader, &variant->source);
+            }
+        }
+    }
+
+    return reloaded;
+}
+
+#endif
@@ -16,7 +16,8 @@ typedef struct
 
 } String;
 
-static inline void String_Append(String* str, const char* suffix)
+// appends suffix_len bytes, suffix does not need to be NUL terminated
+static inline void String_AppendN(String* str, const char* suffix, size_t suffix_len)
 {
     if (!str || suffix == NULL)
     {
@@ -24,13 +25,6 @@ static inline void String_Append(String* str, const char* suffix)
         return;
     }
 
-    if (str->capacity < strlen(suffix))
-    {
-        fprintf(stderr, "Size of suffix exceeds the capacity of the str, abort!\n");
-        return;
-    }
-
-    size_t suffix_len = strlen(suffix);
     size_t needed = str->length + suffix_len + 1;
 
     // arena-based strings cannot grow dynamically
@@ -59,6 +53,17 @@ static inline void String_Append(String* str, const char* suffix)
     str->data[str->length] = '\0';
 }
 
+static inline void String_Append(String* str, const char* suffix)
+{
+    if (!str || suffix == NULL)
+    {
+        fprintf(stderr, "Cannot append NULL to a string or string is NULL\n");
+        return;
+    }
+
+    String_AppendN(str, suffix, strlen(suffix));
+}
+
 static inline String String_Create(size_t capacity, const char* c_str, Arena* allocator)
 {
     String str;
@@ -68,6 +73,7 @@ static inline String String_Create(size_t capacity, const char* c_str, Arena* al
 
     str.capacity = capacity;
     str.length = 0;
+    str.allocator = allocator;
 
     if (allocator)
     {
@@ -0,0 +1,148 @@
+#ifndef TEXTURE_ARRAY_UTILITY_H
+#define TEXTURE_ARRAY_UTILITY_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <glad/glad.h>
+
+#include "texture_utility.h"
+#include "mipmap_utility.h"
+
+// GL_TEXTURE_2D_ARRAY of same-size RGBA8 layers. Pair with Mesh_SetInstances/Mesh_DrawInstanced
+// (InstanceData.params.x = layer) and shaders/texture_array_*.glsl so differently textured
+// copies of a mesh collapse into a single draw.
+
+typedef struct
+{
+    unsigned int id;
+    int width, height;
+    int layers;
+    TextureParams params;
+
+} TextureArray;
+
+// Loads count images into layers. width/height of 0 use the first image's size; images of any
+// other size are resized on the CPU. params may be NULL for Texture_DefaultParams().
+static inline bool TextureArray_Create(TextureArray* arr, const char** paths, int count, int width, int height,
+                                       bool flip_vert, const TextureParams* params)
+{
+    arr->id = 0;
+    arr->width = width;
+    arr->height = height;
+    arr->layers = count;
+    arr->params = params ? *params : Texture_DefaultParams();
+
+    if (count <= 0)
+    {
+        printf("TextureArray needs at least one image\n");
+        return false;
+    }
+
+    unsigned char* resized = NULL;
+    stbi_set_flip_vertically_on_load(flip_vert);
+
+    for (int layer = 0; layer < count; ++layer)
+    {
+        int w = 0, h = 0, channels = 0;
+        unsigned char* pixels = Image_Load(paths[layer], &w, &h, &channels, 4);
+        if (!pixels)
+        {
+            printf("Failed to load texture: %s\n", paths[layer]);
+            continue;
+        }
+
+        if (!arr->id)
+        {
+            if (arr->width <= 0 || arr->height <= 0)
+            {
+                arr->width = w;
+                arr->height = h;
+            }
+
+            int levels = (arr->params.mips == TEXTURE_MIPS_NONE) ? 1 : MipChain_LevelCount(arr->width, arr->height);
+
+            glGenTextures(1, &arr->id);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, arr->id);
+            for (int level = 0, lw = arr->width, lh = arr->height; level < levels; ++level)
+            {
+                glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, lw, lh, count, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+                lw = (lw > 1) ? lw / 2 : 1;
+                lh = (lh > 1) ? lh / 2 : 1;
+            }
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+        }
+
+        const unsigned char* layer_pixels = pixels;
+        if (w != arr->width || h != arr->height)
+        {
+            if (!resized)
+                resized = (unsigned char*)malloc((size_t)arr->width * arr->height * 4);
+
+            if (!resized || !Image_Resize(pixels, w, h, resized, arr->width, arr->height))
+            {
+                printf("Failed to resize %s to %dx%d\n", paths[layer], arr->width, arr->height);
+                stbi_image_free(pixels);
+                continue;
+            }
+            layer_pixels = resized;
+        }
+
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, arr->width, arr->height, 1,
+                        GL_RGBA, GL_UNSIGNED_BYTE, layer_pixels);
+
+        stbi_image_free(pixels);
+    }
+
+    free(resized);
+
+    if (!arr->id)
+        return false;
+
+    const TextureParams* p = &arr->params;
+    bool has_mips = p->mips != TEXTURE_MIPS_NONE;
+
+    // CPU mip modes are not worth a per-layer chain here, the GPU generates all layers at once
+    if (has_mips)
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+    int min_filter = p->min_filter;
+    if (!has_mips && Texture_IsMipmapFilter(min_filter))
+        min_filter = GL_LINEAR;
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, min_filter);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, p->mag_filter);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, p->wrap_s);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, p->wrap_t);
+
+    if (p->anisotropy > 1.0f && GLExt_MaxAnisotropy() > 1.0f)
+    {
+        float max_anisotropy = GLExt_MaxAnisotropy();
+        glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_ANISOTROPY_EXT, p->anisotropy < max_anisotropy ? p->anisotropy : max_anisotropy);
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    return true;
+}
+
+static inline void TextureArray_Enable(const TextureArray* arr, unsigned int slot)
+{
+    glActiveTexture(GL_TEXTURE0 + slot);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, arr->id);
+}
+
+static inline void TextureArray_Disable(void)
+{
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+static inline void TextureArray_Delete(TextureArray* arr)
+{
+    if (arr->id)
+        glDeleteTextures(1, &arr->id);
+
+    arr->id = 0;
+    arr->layers = 0;
+}
+
+#endif
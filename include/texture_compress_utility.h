@@ -0,0 +1,1069 @@
+#ifndef TEXTURE_COMPRESS_UTILITY_H
+#define TEXTURE_COMPRESS_UTILITY_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include <sys/stat.h>
+#include <glad/glad.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "texture_utility.h"
+#include "mipmap_utility.h"
+#include "thread_utility.h"
+#include "gl_extension_utility.h"
+
+// CPU block compression (BC1 / BC3 / BC5 / BC7) with a small on-disk cache.
+// Encoding and decoding are pure CPU so quality and throughput can be measured headless;
+// only CompressedImage_Upload and Texture_CreateCompressed touch GL.
+
+typedef enum
+{
+    TEXTURE_FORMAT_RGBA8,
+    TEXTURE_FORMAT_BC1,     // RGB + 1 bit alpha, 8 bytes per 4x4 block
+    TEXTURE_FORMAT_BC3,     // RGBA, BC4 alpha + BC1 colour, 16 bytes per block
+    TEXTURE_FORMAT_BC5,     // two channel (RG), for normal maps, 16 bytes per block
+    TEXTURE_FORMAT_BC7      // RGBA, mode 6 only, 16 bytes per block
+
+} TextureFormat;
+
+static inline size_t TextureFormat_BlockBytes(TextureFormat format)
+{
+    switch (format)
+    {
+        case TEXTURE_FORMAT_BC1: return 8;
+        case TEXTURE_FORMAT_BC3: return 16;
+        case TEXTURE_FORMAT_BC5: return 16;
+        case TEXTURE_FORMAT_BC7: return 16;
+        default:                 return 0;
+    }
+}
+
+static inline size_t TextureFormat_LevelSize(TextureFormat format, int width, int height)
+{
+    if (format == TEXTURE_FORMAT_RGBA8)
+        return (size_t)width * (size_t)height * 4;
+
+    return (size_t)((width + 3) / 4) * (size_t)((height + 3) / 4) * TextureFormat_BlockBytes(format);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                               BLOCK HELPERS                                */
+/* -------------------------------------------------------------------------- */
+
+// 4x4 block as float channel planes, the layout the SIMD projection wants
+typedef struct
+{
+    float c[4][16];
+
+} BlockPlanes;
+
+// gathers a 4x4 block at (bx, by) in blocks, clamping at the image edge
+static inline void Block_Fetch(const unsigned char* pixels, int width, int height, int bx, int by, unsigned char out[64])
+{
+    for (int y = 0; y < 4; ++y)
+    {
+        int sy = by * 4 + y;
+        if (sy >= height) sy = height - 1;
+
+        for (int x = 0; x < 4; ++x)
+        {
+            int sx = bx * 4 + x;
+            if (sx >= width) sx = width - 1;
+            memcpy(out + (y * 4 + x) * 4, pixels + ((size_t)sy * width + sx) * 4, 4);
+        }
+    }
+}
+
+static inline void Block_ToPlanes(const unsigned char block[64], BlockPlanes* planes)
+{
+    for (int i = 0; i < 16; ++i)
+        for (int c = 0; c < 4; ++c)
+            planes->c[c][i] = (float)block[i * 4 + c];
+}
+
+// principal axis of the first `channels` channels (power iteration on the covariance)
+static inline void Block_PrincipalAxis(const BlockPlanes* p, int channels, float mean[4], float axis[4])
+{
+    float cov[4][4] = {{0}};
+
+    for (int c = 0; c < 4; ++c)
+    {
+        mean[c] = 0.0f;
+        axis[c] = 0.0f;
+    }
+
+    for (int c = 0; c < channels; ++c)
+    {
+        for (int i = 0; i < 16; ++i)
+            mean[c] += p->c[c][i];
+        mean[c] *= 1.0f / 16.0f;
+    }
+
+    for (int i = 0; i < 16; ++i)
+    {
+        for (int a = 0; a < channels; ++a)
+        {
+            float da = p->c[a][i] - mean[a];
+            for (int b = a; b < channels; ++b)
+                cov[a][b] += da * (p->c[b][i] - mean[b]);
+        }
+    }
+
+    for (int a = 0; a < channels; ++a)
+        for (int b = 0; b < a; ++b)
+            cov[a][b] = cov[b][a];
+
+    // start from the widest channel range, 8 iterations is plenty for a 4x4 block
+    for (int c = 0; c < channels; ++c)
+        axis[c] = 1.0f;
+
+    for (int iter = 0; iter < 8; ++iter)
+    {
+        float next[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        float length = 0.0f;
+
+        for (int a = 0; a < channels; ++a)
+        {
+            for (int b = 0; b < channels; ++b)
+                next[a] += cov[a][b] * axis[b];
+            length += next[a] * next[a];
+        }
+
+        if (length < 1e-8f)
+            break;
+
+        length = 1.0f / sqrtf(length);
+        for (int a = 0; a < channels; ++a)
+            axis[a] = next[a] * length;
+    }
+}
+
+// t[i] = dot(pixel_i - origin, dir) for all 16 pixels over `channels` channels
+static inline void Block_Project(const BlockPlanes* p, int channels, const float origin[4], const float dir[4], float t[16])
+{
+#if defined(__SSE2__)
+    for (int i = 0; i < 16; i += 4)
+    {
+        __m128 acc = _mm_setzero_ps();
+        for (int c = 0; c < channels; ++c)
+        {
+            __m128 v = _mm_sub_ps(_mm_loadu_ps(&p->c[c][i]), _mm_set1_ps(origin[c]));
+            acc = _mm_add_ps(acc, _mm_mul_ps(v, _mm_set1_ps(dir[c])));
+        }
+        _mm_storeu_ps(&t[i], acc);
+    }
+#else
+    for (int i = 0; i < 16; ++i)
+    {
+        float acc = 0.0f;
+        for (int c = 0; c < channels; ++c)
+            acc += (p->c[c][i] - origin[c]) * dir[c];
+        t[i] = acc;
+    }
+#endif
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                    BC1                                     */
+/* -------------------------------------------------------------------------- */
+
+static inline uint16_t BC_Pack565(const float c[3])
+{
+    int r = (int)(Math_Clamp(c[0], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+    int g = (int)(Math_Clamp(c[1], 0.0f, 255.0f) * 63.0f / 255.0f + 0.5f);
+    int b = (int)(Math_Clamp(c[2], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static inline void BC_Unpack565(uint16_t v, int out[3])
+{
+    int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+    out[0] = (r << 3) | (r >> 2);
+    out[1] = (g << 2) | (g >> 4);
+    out[2] = (b << 3) | (b >> 2);
+}
+
+// out: 8 bytes. Always uses the opaque 4 colour mode.
+static inline void BC1_EncodeBlock(const BlockPlanes* p, unsigned char out[8])
+{
+    float mean[4], axis[4];
+    Block_PrincipalAxis(p, 3, mean, axis);
+
+    float t[16];
+    Block_Project(p, 3, mean, axis, t);
+
+    float tmin = t[0], tmax = t[0];
+    for (int i = 1; i < 16; ++i)
+    {
+        if (t[i] < tmin) tmin = t[i];
+        if (t[i] > tmax) tmax = t[i];
+    }
+
+    // inset the endpoints slightly, the extremes are rarely worth a full palette slot
+    float inset = (tmax - tmin) / 32.0f;
+    tmin += inset;
+    tmax -= inset;
+
+    float e0[3], e1[3];
+    for (int c = 0; c < 3; ++c)
+    {
+        e0[c] = mean[c] + axis[c] * tmax;
+        e1[c] = mean[c] + axis[c] * tmin;
+    }
+
+    uint16_t c0 = BC_Pack565(e0);
+    uint16_t c1 = BC_Pack565(e1);
+    if (c0 < c1)
+    {
+        uint16_t tmp = c0; c0 = c1; c1 = tmp;
+    }
+
+    uint32_t indices = 0;
+
+    if (c0 != c1)
+    {
+        int q0[3], q1[3];
+        BC_Unpack565(c0, q0);
+        BC_Unpack565(c1, q1);
+
+        float origin[4] = { (float)q0[0], (float)q0[1], (float)q0[2], 0.0f };
+        float dir[4] = { (float)(q1[0] - q0[0]), (float)(q1[1] - q0[1]), (float)(q1[2] - q0[2]), 0.0f };
+        float length_sq = dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2];
+
+        Block_Project(p, 3, origin, dir, t);
+
+        // position along c0 -> c1 in thirds, mapped to the BC1 palette order
+        static const uint32_t remap[4] = { 0, 2, 3, 1 };
+        float scale = 3.0f / length_sq;
+
+        for (int i = 0; i < 16; ++i)
+        {
+            int k = (int)(t[i] * scale + 0.5f);
+            k = (k < 0) ? 0 : ((k > 3) ? 3 : k);
+            indices |= remap[k] << (2 * i);
+        }
+    }
+
+    out[0] = (unsigned char)(c0 & 0xFF);
+    out[1] = (unsigned char)(c0 >> 8);
+    out[2] = (unsigned char)(c1 & 0xFF);
+    out[3] = (unsigned char)(c1 >> 8);
+    out[4] = (unsigned char)(indices & 0xFF);
+    out[5] = (unsigned char)((indices >> 8) & 0xFF);
+    out[6] = (unsigned char)((indices >> 16) & 0xFF);
+    out[7] = (unsigned char)(indices >> 24);
+}
+
+// writes RGBA for 16 pixels; force_four_colour is set for the colour half of BC3
+static inline void BC1_DecodeBlock(const unsigned char in[8], unsigned char out[64], bool force_four_colour)
+{
+    uint16_t c0 = (uint16_t)(in[0] | (in[1] << 8));
+    uint16_t c1 = (uint16_t)(in[2] | (in[3] << 8));
+    uint32_t indices = (uint32_t)in[4] | ((uint32_t)in[5] << 8) | ((uint32_t)in[6] << 16) | ((uint32_t)in[7] << 24);
+
+    int palette[4][4];
+    BC_Unpack565(c0, palette[0]);
+    BC_Unpack565(c1, palette[1]);
+    palette[0][3] = palette[1][3] = 255;
+
+    if (c0 > c1 || force_four_colour)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        palette[2][3] = palette[3][3] = 255;
+    }
+    else
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+        palette[2][3] = 255;
+        palette[3][3] = 0;
+    }
+
+    for (int i = 0; i < 16; ++i)
+    {
+        int k = (indices >> (2 * i)) & 3;
+        for (int c = 0; c < 4; ++c)
+            out[i * 4 + c] = (unsigned char)palette[k][c];
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                    BC4                                     */
+/* -------------------------------------------------------------------------- */
+
+// single channel block (used for BC3 alpha and both BC5 channels), out: 8 bytes
+static inline void BC4_EncodeBlock(const float values[16], unsigned char out[8])
+{
+    float vmin = values[0], vmax = values[0];
+    for (int i = 1; i < 16; ++i)
+    {
+        if (values[i] < vmin) vmin = values[i];
+        if (values[i] > vmax) vmax = values[i];
+    }
+
+    int a0 = (int)(vmax + 0.5f);
+    int a1 = (int)(vmin + 0.5f);
+
+    uint64_t bits = 0;
+
+    if (a0 != a1)
+    {
+        // 8 level mode (a0 > a1): palette runs a0, 6 interpolants, a1
+        float scale = 7.0f / (float)(a1 - a0);
+
+        for (int i = 0; i < 16; ++i)
+        {
+            int k = (int)((values[i] - (float)a0) * scale + 0.5f);
+            k = (k < 0) ? 0 : ((k > 7) ? 7 : k);
+            uint64_t index = (k == 0) ? 0 : ((k == 7) ? 1 : (uint64_t)(k + 1));
+            bits |= index << (3 * i);
+        }
+    }
+
+    out[0] = (unsigned char)a0;
+    out[1] = (unsigned char)a1;
+    for (int i = 0; i < 6; ++i)
+        out[2 + i] = (unsigned char)((bits >> (8 * i)) & 0xFF);
+}
+
+// writes one channel of 16 RGBA pixels (stride 4)
+static inline void BC4_DecodeBlock(const unsigned char in[8], unsigned char* out, int channel)
+{
+    int a0 = in[0], a1 = in[1];
+    uint64_t bits = 0;
+    for (int i = 0; i < 6; ++i)
+        bits |= (uint64_t)in[2 + i] << (8 * i);
+
+    int palette[8];
+    palette[0] = a0;
+    palette[1] = a1;
+
+    if (a0 > a1)
+    {
+        for (int k = 1; k < 7; ++k)
+            palette[k + 1] = ((7 - k) * a0 + k * a1) / 7;
+    }
+    else
+    {
+        for (int k = 1; k < 5; ++k)
+            palette[k + 1] = ((5 - k) * a0 + k * a1) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    for (int i = 0; i < 16; ++i)
+        out[i * 4 + channel] = (unsigned char)palette[(bits >> (3 * i)) & 7];
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                BC7 (MODE 6)                                */
+/* -------------------------------------------------------------------------- */
+
+static const int BC7_Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+typedef struct
+{
+    unsigned char bytes[16];
+    int bit;
+
+} BitWriter;
+
+static inline void BitWriter_Write(BitWriter* w, uint32_t value, int count)
+{
+    for (int i = 0; i < count; ++i, ++w->bit)
+    {
+        if ((value >> i) & 1)
+            w->bytes[w->bit >> 3] |= (unsigned char)(1 << (w->bit & 7));
+    }
+}
+
+static inline uint32_t BitReader_Read(const unsigned char* bytes, int* bit, int count)
+{
+    uint32_t value = 0;
+    for (int i = 0; i < count; ++i, ++(*bit))
+        value |= (uint32_t)((bytes[*bit >> 3] >> (*bit & 7)) & 1) << i;
+    return value;
+}
+
+// 7 bit endpoint + shared p-bit: picks the p-bit with the smaller RGBA error
+static inline void BC7_QuantizeEndpoint(const float e[4], int q[4], int* pbit)
+{
+    float best_err = 1e30f;
+
+    for (int p = 0; p < 2; ++p)
+    {
+        int cand[4];
+        float err = 0.0f;
+
+        for (int c = 0; c < 4; ++c)
+        {
+            int v = (int)((Math_Clamp(e[c], 0.0f, 255.0f) - (float)p) / 2.0f + 0.5f);
+            cand[c] = (v < 0) ? 0 : ((v > 127) ? 127 : v);
+            float d = (float)((cand[c] << 1) | p) - e[c];
+            err += d * d;
+        }
+
+        if (err < best_err)
+        {
+            best_err = err;
+            *pbit = p;
+            memcpy(q, cand, sizeof(cand));
+        }
+    }
+}
+
+// out: 16 bytes. Mode 6 = one subset, RGBA 7.7.7.7 + p-bit endpoints, 4 bit indices.
+static inline void BC7_EncodeBlock(const BlockPlanes* p, unsigned char out[16])
+{
+    float mean[4], axis[4];
+    Block_PrincipalAxis(p, 4, mean, axis);
+
+    float t[16];
+    Block_Project(p, 4, mean, axis, t);
+
+    float tmin = t[0], tmax = t[0];
+    for (int i = 1; i < 16; ++i)
+    {
+        if (t[i] < tmin) tmin = t[i];
+        if (t[i] > tmax) tmax = t[i];
+    }
+
+    float e0[4], e1[4];
+    for (int c = 0; c < 4; ++c)
+    {
+        e0[c] = mean[c] + axis[c] * tmin;
+        e1[c] = mean[c] + axis[c] * tmax;
+    }
+
+    int q0[4], q1[4], p0 = 0, p1 = 0;
+    BC7_QuantizeEndpoint(e0, q0, &p0);
+    BC7_QuantizeEndpoint(e1, q1, &p1);
+
+    float origin[4], dir[4], length_sq = 0.0f;
+    for (int c = 0; c < 4; ++c)
+    {
+        origin[c] = (float)((q0[c] << 1) | p0);
+        dir[c] = (float)((q1[c] << 1) | p1) - origin[c];
+        length_sq += dir[c] * dir[c];
+    }
+
+    int indices[16] = {0};
+    if (length_sq > 0.0f)
+    {
+        Block_Project(p, 4, origin, dir, t);
+
+        for (int i = 0; i < 16; ++i)
+        {
+            // nearest of the non-uniform BC7 weights
+            float w = Math_Clamp(t[i] / length_sq, 0.0f, 1.0f) * 64.0f;
+            int k = (int)(w * 15.0f / 64.0f);
+            if (k < 15 && fabsf((float)BC7_Weights4[k + 1] - w) < fabsf((float)BC7_Weights4[k] - w))
+                k += 1;
+            indices[i] = k;
+        }
+    }
+
+    // the anchor (pixel 0) index drops its top bit, so it must be < 8: swap the endpoints if not
+    if (indices[0] >= 8)
+    {
+        int tmp[4];
+        memcpy(tmp, q0, sizeof(tmp)); memcpy(q0, q1, sizeof(tmp)); memcpy(q1, tmp, sizeof(tmp));
+        int tp = p0; p0 = p1; p1 = tp;
+        for (int i = 0; i < 16; ++i)
+            indices[i] = 15 - indices[i];
+    }
+
+    BitWriter w;
+    memset(&w, 0, sizeof(w));
+
+    BitWriter_Write(&w, 1u << 6, 7);                // mode 6
+    for (int c = 0; c < 4; ++c)
+    {
+        BitWriter_Write(&w, (uint32_t)q0[c], 7);
+        BitWriter_Write(&w, (uint32_t)q1[c], 7);
+    }
+    BitWriter_Write(&w, (uint32_t)p0, 1);
+    BitWriter_Write(&w, (uint32_t)p1, 1);
+
+    BitWriter_Write(&w, (uint32_t)indices[0], 3);
+    for (int i = 1; i < 16; ++i)
+        BitWriter_Write(&w, (uint32_t)indices[i], 4);
+
+    memcpy(out, w.bytes, 16);
+}
+
+// decodes mode 6 blocks only (the only mode this encoder emits), other modes decode as black
+static inline void BC7_DecodeBlock(const unsigned char in[16], unsigned char out[64])
+{
+    if ((in[0] & 0x7F) != (1 << 6))
+    {
+        memset(out, 0, 64);
+        return;
+    }
+
+    int bit = 7;
+    int q0[4], q1[4];
+    for (int c = 0; c < 4; ++c)
+    {
+        q0[c] = (int)BitReader_Read(in, &bit, 7);
+        q1[c] = (int)BitReader_Read(in, &bit, 7);
+    }
+    int p0 = (int)BitReader_Read(in, &bit, 1);
+    int p1 = (int)BitReader_Read(in, &bit, 1);
+
+    for (int i = 0; i < 16; ++i)
+    {
+        int k = (int)BitReader_Read(in, &bit, (i == 0) ? 3 : 4);
+        int w = BC7_Weights4[k];
+
+        for (int c = 0; c < 4; ++c)
+        {
+            int a = (q0[c] << 1) | p0;
+            int b = (q1[c] << 1) | p1;
+            out[i * 4 + c] = (unsigned char)(((64 - w) * a + w * b + 32) >> 6);
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              IMAGE ENCODE/DECODE                           */
+/* -------------------------------------------------------------------------- */
+
+static inline void TextureCompress_EncodeBlock(TextureFormat format, const unsigned char block[64], unsigned char* out)
+{
+    BlockPlanes planes;
+    Block_ToPlanes(block, &planes);
+
+    switch (format)
+    {
+        case TEXTURE_FORMAT_BC1:
+            BC1_EncodeBlock(&planes, out);
+            break;
+        case TEXTURE_FORMAT_BC3:
+            BC4_EncodeBlock(planes.c[3], out);
+            BC1_EncodeBlock(&planes, out + 8);
+            break;
+        case TEXTURE_FORMAT_BC5:
+            BC4_EncodeBlock(planes.c[0], out);
+            BC4_EncodeBlock(planes.c[1], out + 8);
+            break;
+        case TEXTURE_FORMAT_BC7:
+            BC7_EncodeBlock(&planes, out);
+            break;
+        default:
+            break;
+    }
+}
+
+static inline void TextureCompress_DecodeBlock(TextureFormat format, const unsigned char* in, unsigned char block[64])
+{
+    switch (format)
+    {
+        case TEXTURE_FORMAT_BC1:
+            BC1_DecodeBlock(in, block, false);
+            break;
+        case TEXTURE_FORMAT_BC3:
+            BC1_DecodeBlock(in + 8, block, true);
+            BC4_DecodeBlock(in, block, 3);
+            break;
+        case TEXTURE_FORMAT_BC5:
+            memset(block, 0, 64);
+            BC4_DecodeBlock(in, block, 0);
+            BC4_DecodeBlock(in + 8, block, 1);
+            for (int i = 0; i < 16; ++i)
+                block[i * 4 + 3] = 255;
+            break;
+        case TEXTURE_FORMAT_BC7:
+            BC7_DecodeBlock(in, block);
+            break;
+        default:
+            memset(block, 0, 64);
+            break;
+    }
+}
+
+typedef struct
+{
+    TextureFormat format;
+    const unsigned char* pixels;
+    int width, height;
+    unsigned char* out;
+    int first_row, last_row;    // block rows [first, last)
+
+} CompressJob;
+
+static inline void* TextureCompress_Worker(void* arg)
+{
+    CompressJob* job = (CompressJob*)arg;
+    int blocks_x = (job->width + 3) / 4;
+    size_t block_bytes = TextureFormat_BlockBytes(job->format);
+    unsigned char block[64];
+
+    for (int by = job->first_row; by < job->last_row; ++by)
+    {
+        for (int bx = 0; bx < blocks_x; ++bx)
+        {
+            Block_Fetch(job->pixels, job->width, job->height, bx, by, block);
+            TextureCompress_EncodeBlock(job->format, block, job->out + ((size_t)by * blocks_x + bx) * block_bytes);
+        }
+    }
+
+    return NULL;
+}
+
+// Encodes an RGBA8 image into out (TextureFormat_LevelSize bytes) using thread_count threads
+// (0 = one per core). Block rows are split evenly between threads.
+static inline void TextureCompress_Encode(TextureFormat format, const unsigned char* pixels, int width, int height,
+                                          unsigned char* out, int thread_count)
+{
+    int blocks_y = (height + 3) / 4;
+
+    if (thread_count <= 0)
+        thread_count = Thread_HardwareConcurrency();
+    if (thread_count > blocks_y)
+        thread_count = blocks_y;
+    if (thread_count < 1)
+        thread_count = 1;
+
+    CompressJob jobs[64];
+    Thread threads[64];
+    if (thread_count > 64)
+        thread_count = 64;
+
+    for (int i = 0; i < thread_count; ++i)
+    {
+        jobs[i].format = format;
+        jobs[i].pixels = pixels;
+        jobs[i].width = width;
+        jobs[i].height = height;
+        jobs[i].out = out;
+        jobs[i].first_row = blocks_y * i / thread_count;
+        jobs[i].last_row = blocks_y * (i + 1) / thread_count;
+    }
+
+    // the calling thread takes the first slice itself
+    for (int i = 1; i < thread_count; ++i)
+    {
+        if (!Thread_Create(&threads[i], TextureCompress_Worker, &jobs[i]))
+            TextureCompress_Worker(&jobs[i]);
+    }
+
+    TextureCompress_Worker(&jobs[0]);
+
+    for (int i = 1; i < thread_count; ++i)
+        Thread_Join(&threads[i]);
+}
+
+// Decodes a compressed level back to RGBA8 (used for quality checks and as the upload
+// fallback when the driver lacks the format)
+static inline void TextureCompress_Decode(TextureFormat format, const unsigned char* in, int width, int height, unsigned char* pixels)
+{
+    int blocks_x = (width + 3) / 4;
+    int blocks_y = (height + 3) / 4;
+    size_t block_bytes = TextureFormat_BlockBytes(format);
+    unsigned char block[64];
+
+    for (int by = 0; by < blocks_y; ++by)
+    {
+        for (int bx = 0; bx < blocks_x; ++bx)
+        {
+            TextureCompress_DecodeBlock(format, in + ((size_t)by * blocks_x + bx) * block_bytes, block);
+
+            for (int y = 0; y < 4 && by * 4 + y < height; ++y)
+            {
+                int w = (bx * 4 + 4 <= width) ? 4 : width - bx * 4;
+                memcpy(pixels + ((size_t)(by * 4 + y) * width + bx * 4) * 4, block + y * 16, (size_t)w * 4);
+            }
+        }
+    }
+}
+
+// PSNR in dB over the first `channels` channels of two RGBA8 images
+static inline double TextureCompress_PSNR(const unsigned char* a, const unsigned char* b, int width, int height, int channels)
+{
+    double sum = 0.0;
+    size_t count = (size_t)width * height;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        for (int c = 0; c < channels; ++c)
+        {
+            double d = (double)a[i * 4 + c] - (double)b[i * 4 + c];
+            sum += d * d;
+        }
+    }
+
+    double mse = sum / ((double)count * channels);
+    return (mse <= 0.0) ? 99.0 : 10.0 * log10(255.0 * 255.0 / mse);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                            COMPRESSED IMAGE / CACHE                        */
+/* -------------------------------------------------------------------------- */
+
+#define COMPRESSED_IMAGE_MAGIC      0x58455446u     // "FTEX"
+#define COMPRESSED_IMAGE_VERSION    2u
+
+typedef struct
+{
+    TextureFormat format;
+    int levels;
+    int width[MIPMAP_MAX_LEVELS];
+    int height[MIPMAP_MAX_LEVELS];
+    size_t offset[MIPMAP_MAX_LEVELS];
+    size_t level_size[MIPMAP_MAX_LEVELS];
+    unsigned char* data;
+    size_t size;
+
+} CompressedImage;
+
+// on-disk layout: header, one CompressedLevelHeader per level, then the level payloads
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t format;
+    uint32_t levels;
+    uint32_t build;             // CompressedBuild_Make of the settings the levels were built with
+    uint32_t reserved;
+    uint64_t source_size;       // size and mtime of the source image, a mismatch invalidates the cache
+    int64_t source_mtime;
+
+} CompressedFileHeader;
+
+// What besides the source decides the cached pixels: vertical flip in bit 0, mip filter above it
+static inline uint32_t CompressedBuild_Make(bool flip_vert, MipFilter filter)
+{
+    return (flip_vert ? 1u : 0u) | ((uint32_t)filter << 1);
+}
+
+typedef struct
+{
+    uint32_t width, height;
+    uint64_t offset, size;
+
+} CompressedLevelHeader;
+
+// Encodes every level of a mip chain
+static inline bool CompressedImage_Encode(CompressedImage* image, const MipChain* chain, TextureFormat format, int thread_count)
+{
+    memset(image, 0, sizeof(CompressedImage));
+    image->format = format;
+    image->levels = chain->levels;
+
+    for (int level = 0; level < chain->levels; ++level)
+    {
+        image->width[level] = chain->width[level];
+        image->height[level] = chain->height[level];
+        image->offset[level] = image->size;
+        image->level_size[level] = TextureFormat_LevelSize(format, chain->width[level], chain->height[level]);
+        image->size += image->level_size[level];
+    }
+
+    image->data = (unsigned char*)malloc(image->size);
+    if (!image->data)
+    {
+        fprintf(stderr, "Failed to allocate compressed image (%zu bytes)\n", image->size);
+        return false;
+    }
+
+    for (int level = 0; level < chain->levels; ++level)
+    {
+        TextureCompress_Encode(format, MipChain_Level(chain, level), chain->width[level], chain->height[level],
+                               image->data + image->offset[level], thread_count);
+    }
+
+    return true;
+}
+
+static inline void CompressedImage_Free(CompressedImage* image)
+{
+    free(image->data);
+    image->data = NULL;
+    image->size = 0;
+    image->levels = 0;
+}
+
+// A failed or short write removes the file, so a partial cache is never picked up later
+static inline bool CompressedImage_Save(const CompressedImage* image, const char* path, uint32_t build, uint64_t source_size, int64_t source_mtime)
+{
+    FILE* file = fopen(path, "wb");
+    if (!file)
+    {
+        printf("Failed to open file: %s\n", path);
+        return false;
+    }
+
+    CompressedFileHeader header = { COMPRESSED_IMAGE_MAGIC, COMPRESSED_IMAGE_VERSION, (uint32_t)image->format,
+                                    (uint32_t)image->levels, build, 0, source_size, source_mtime };
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    for (int level = 0; ok && level < image->levels; ++level)
+    {
+        CompressedLevelHeader lh = { (uint32_t)image->width[level], (uint32_t)image->height[level],
+                                     (uint64_t)image->offset[level], (uint64_t)image->level_size[level] };
+        ok = fwrite(&lh, sizeof(lh), 1, file) == 1;
+    }
+
+    ok = ok && fwrite(image->data, 1, image->size, file) == image->size;
+    ok = (fclose(file) == 0) && ok;
+
+    if (!ok)
+    {
+        printf("Failed to write file: %s\n", path);
+        remove(path);
+    }
+    return ok;
+}
+
+#define COMPRESSED_IMAGE_MAX_SIZE   32768       // texels per side accepted from a cache file
+
+// Loads a cache file. When expected_source_size is non zero the stored source stamp and build
+// settings must match.
+// The level table must describe a mip chain of the stored format laid out back to back within the
+// file; anything else (a corrupt or truncated cache) is rejected so it gets rebuilt.
+static inline bool CompressedImage_Load(CompressedImage* image, const char* path, uint32_t expected_build, uint64_t expected_source_size, int64_t expected_source_mtime)
+{
+    memset(image, 0, sizeof(CompressedImage));
+
+    FILE* file = fopen(path, "rb");
+    if (!file)
+        return false;
+
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    CompressedFileHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != COMPRESSED_IMAGE_MAGIC ||
+        header.version != COMPRESSED_IMAGE_VERSION || header.format > TEXTURE_FORMAT_BC7 ||
+        header.levels == 0 || header.levels > MIPMAP_MAX_LEVELS ||
+        (expected_source_size && (header.build != expected_build || header.source_size != expected_source_size ||
+                                  header.source_mtime != expected_source_mtime)))
+    {
+        fclose(file);
+        return false;
+    }
+
+    image->format = (TextureFormat)header.format;
+    image->levels = (int)header.levels;
+
+    for (int level = 0; level < image->levels; ++level)
+    {
+        CompressedLevelHeader lh;
+        if (fread(&lh, sizeof(lh), 1, file) != 1)
+        {
+            fclose(file);
+            return false;
+        }
+
+        // level 0 sets the size, every further level halves it like MipChain_Build
+        bool valid;
+        if (level == 0)
+        {
+            valid = lh.width >= 1 && lh.width <= COMPRESSED_IMAGE_MAX_SIZE && lh.height >= 1 && lh.height <= COMPRESSED_IMAGE_MAX_SIZE;
+        }
+        else
+        {
+            int w = image->width[level - 1], h = image->height[level - 1];
+            valid = (int)lh.width == ((w > 1) ? w / 2 : 1) && (int)lh.height == ((h > 1) ? h / 2 : 1);
+        }
+
+        image->width[level] = (int)lh.width;
+        image->height[level] = (int)lh.height;
+        image->offset[level] = image->size;
+        image->level_size[level] = valid ? TextureFormat_LevelSize(image->format, image->width[level], image->height[level]) : 0;
+
+        if (!valid || lh.offset != image->offset[level] || lh.size != image->level_size[level])
+        {
+            fclose(file);
+            return false;
+        }
+        image->size += image->level_size[level];
+    }
+
+    long payload_start = ftell(file);
+    if (file_size < payload_start || (uint64_t)(file_size - payload_start) < image->size)
+    {
+        fclose(file);
+        return false;
+    }
+
+    image->data = (unsigned char*)malloc(image->size);
+    if (!image->data || fread(image->data, 1, image->size, file) != image->size)
+    {
+        fclose(file);
+        CompressedImage_Free(image);
+        return false;
+    }
+
+    fclose(file);
+    return true;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  GL UPLOAD                                 */
+/* -------------------------------------------------------------------------- */
+
+// GL internal format for a compressed format, 0 if the current context cannot sample it
+static inline GLenum TextureFormat_GLInternal(TextureFormat format)
+{
+    switch (format)
+    {
+        case TEXTURE_FORMAT_BC1:
+            return GLExt_IsSupported("GL_EXT_texture_compression_s3tc") ? GL_COMPRESSED_RGBA_S3TC_DXT1_EXT : 0;
+        case TEXTURE_FORMAT_BC3:
+            return GLExt_IsSupported("GL_EXT_texture_compression_s3tc") ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : 0;
+        case TEXTURE_FORMAT_BC5:
+            return GL_COMPRESSED_RG_RGTC2;
+        case TEXTURE_FORMAT_BC7:
+            return GLExt_IsSupported("GL_ARB_texture_compression_bptc") ? GL_COMPRESSED_RGBA_BPTC_UNORM_ARB : 0;
+        default:
+            return 0;
+    }
+}
+
+// Uploads every level with glCompressedTexImage2D, or decodes to RGBA8 when the format is unsupported
+static inline void CompressedImage_Upload(Texture* tex, const CompressedImage* image)
+{
+    tex->width = image->width[0];
+    tex->height = image->height[0];
+    tex->bits_per_pixel = 4;
+
+    GLenum internal = TextureFormat_GLInternal(image->format);
+    if (!internal)
+        printf("Compressed format %d unsupported by the driver, uploading decoded RGBA8\n", (int)image->format);
+
+    glGenTextures(1, &tex->id);
+    glBindTexture(GL_TEXTURE_2D, tex->id);
+    tex->state = TEXTURE_READY;
+
+    unsigned char* decoded = NULL;
+
+    for (int level = 0; level < image->levels; ++level)
+    {
+        const unsigned char* data = image->data + image->offset[level];
+        int w = image->width[level], h = image->height[level];
+
+        if (internal)
+        {
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, internal, w, h, 0, (GLsizei)image->level_size[level], data);
+        }
+        else
+        {
+            if (!decoded)
+                decoded = (unsigned char*)malloc((size_t)w * h * 4);    // level 0 is the largest
+            if (!decoded)
+                break;
+
+            TextureCompress_Decode(image->format, data, w, h, decoded);
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, decoded);
+        }
+    }
+
+    free(decoded);
+
+    Texture_ApplyParams(tex, image->levels);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// Texture_CreateEx for compressed textures. Loads cache_path when its stored source stamp (size and
+// mtime), flip and mip filter match this call and it holds the requested format, otherwise decodes
+// the image, builds the mips, encodes them and writes the cache.
+// params may be NULL. The cache always stores a full chain; params->mips only picks the filter
+// (Kaiser for TEXTURE_MIPS_CPU_KAISER, box otherwise).
+static inline void Texture_CreateCompressed(Texture* tex, const char* path, bool flip_vert, TextureFormat format,
+                                            const char* cache_path, const TextureParams* params)
+{
+    tex->path = String_Create(512, path, NULL);
+    tex->local_buffer = NULL;
+    tex->width = 0;
+    tex->height = 0;
+    tex->bits_per_pixel = 0;
+    tex->params = params ? *params : Texture_DefaultParams();
+    tex->id = 0;
+    tex->state = TEXTURE_FAILED;    // until the upload succeeds
+
+    MipFilter filter = (tex->params.mips == TEXTURE_MIPS_CPU_KAISER) ? MIP_FILTER_KAISER : MIP_FILTER_BOX;
+    uint32_t build = CompressedBuild_Make(flip_vert, filter);
+
+    // source stamp for cache invalidation, packed sources have no mtime so only their size counts
+    uint64_t source_size = 0;
+    int64_t source_mtime = 0;
+    const PackEntry* entry = Pack_Find(Pack_Mounted, path);
+    struct stat st;
+
+    if (entry)
+    {
+        source_size = entry->raw_size;
+    }
+    else if (stat(path, &st) == 0)
+    {
+        source_size = (uint64_t)st.st_size;
+        source_mtime = (int64_t)st.st_mtime;
+    }
+    else
+    {
+        printf("Failed to load texture: %s\n", path);
+        return;
+    }
+
+    CompressedImage image;
+    if (cache_path && CompressedImage_Load(&image, cache_path, build, source_size, source_mtime))
+    {
+        if (image.format == format)
+        {
+            CompressedImage_Upload(tex, &image);
+            CompressedImage_Free(&image);
+            return;
+        }
+
+        // cached in another format, rebuilt below
+        CompressedImage_Free(&image);
+    }
+
+    stbi_set_flip_vertically_on_load(flip_vert);
+    tex->local_buffer = Image_Load(path, &tex->width, &tex->height, &tex->bits_per_pixel, 4);
+    if (!tex->local_buffer)
+    {
+        printf("Failed to load texture: %s\n", path);
+        return;
+    }
+
+    MipChain chain;
+    bool ok = MipChain_Build(&chain, tex->local_buffer, tex->width, tex->height, filter) &&
+              CompressedImage_Encode(&image, &chain, format, 0);
+
+    if (ok)
+    {
+        if (cache_path)
+            CompressedImage_Save(&image, cache_path, build, source_size, source_mtime);
+
+        CompressedImage_Upload(tex, &image);
+        CompressedImage_Free(&image);
+    }
+    else
+    {
+        Texture_Upload(tex, tex->local_buffer);
+    }
+
+    MipChain_Free(&chain);
+    stbi_image_free(tex->local_buffer);
+    tex->local_buffer = NULL;
+}
+
+#endif
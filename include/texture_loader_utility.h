@@ -0,0 +1,432 @@
+#ifndef TEXTURE_LOADER_UTILITY_H
+#define TEXTURE_LOADER_UTILITY_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <glad/glad.h>
+
+#include "texture_utility.h"
+#include "thread_utility.h"
+#include "string_utility.h"
+
+// Asynchronous texture loading, split in two layers:
+//   TextureDecodePool - worker threads that run stbi_load, no GL calls (usable headless)
+//   TextureLoader     - owns a pool and uploads finished images on the GL thread under a byte budget
+
+typedef struct DecodedImage
+{
+    String path;
+    bool flip_vert;
+    void* user;                 // caller data, the loader stores the target Texture* here
+    unsigned int request;       // caller tag, the loader matches it against Texture.request
+
+    unsigned char* pixels;      // RGBA8, allocated by stb_image (NULL if decoding failed)
+    int width, height;
+
+    struct DecodedImage* next;
+
+} DecodedImage;
+
+typedef struct
+{
+    Thread* workers;
+    int worker_count;
+
+    Mutex lock;
+    CondVar work_ready;         // signalled when a request is queued or on shutdown
+    CondVar work_done;          // signalled when a request finishes decoding
+
+    DecodedImage* pending_head; // FIFO of requests waiting for a worker
+    DecodedImage* pending_tail;
+    DecodedImage* done_head;    // FIFO of decoded images waiting to be consumed
+    DecodedImage* done_tail;
+
+    int in_flight;              // submitted but not yet decoded
+    bool running;
+
+} TextureDecodePool;
+
+/* -------------------------------------------------------------------------- */
+/*                           DECODE POOL FUNCTIONS                            */
+/* -------------------------------------------------------------------------- */
+
+static inline void DecodedImage_Free(DecodedImage* image)
+{
+    if (!image)
+        return;
+
+    if (image->pixels)
+        stbi_image_free(image->pixels);
+
+    String_Free(&image->path);
+    free(image);
+}
+
+static inline void* TextureDecodePool_Worker(void* arg)
+{
+    TextureDecodePool* pool = (TextureDecodePool*)arg;
+
+    for (;;)
+    {
+        Mutex_Lock(&pool->lock);
+
+        while (pool->running && !pool->pending_head)
+            CondVar_Wait(&pool->work_ready, &pool->lock);
+
+        if (!pool->running)
+        {
+            Mutex_Unlock(&pool->lock);
+            break;
+        }
+
+        DecodedImage* image = pool->pending_head;
+        pool->pending_head = image->next;
+        if (!pool->pending_head)
+            pool->pending_tail = NULL;
+
+        Mutex_Unlock(&pool->lock);
+
+        // the flip flag is thread local in stb_image, so workers never race on it
+        int channels = 0;
+        stbi_set_flip_vertically_on_load_thread(image->flip_vert);
+        image->pixels = Image_Load(image->path.data, &image->width, &image->height, &channels, 4);
+        image->next = NULL;
+
+        if (!image->pixels)
+            printf("Failed to load texture: %s\n", image->path.data);
+
+        Mutex_Lock(&pool->lock);
+
+        if (pool->done_tail)
+            pool->done_tail->next = image;
+        else
+            pool->done_head = image;
+        pool->done_tail = image;
+        pool->in_flight -= 1;
+
+        CondVar_Broadcast(&pool->work_done);
+        Mutex_Unlock(&pool->lock);
+    }
+
+    return NULL;
+}
+
+static inline bool TextureDecodePool_Create(TextureDecodePool* pool, int worker_count)
+{
+    if (worker_count <= 0)
+        worker_count = Thread_HardwareConcurrency();
+
+    pool->worker_count = 0;
+    pool->pending_head = pool->pending_tail = NULL;
+    pool->done_head = pool->done_tail = NULL;
+    pool->in_flight = 0;
+    pool->running = true;
+
+    Mutex_Create(&pool->lock);
+    CondVar_Create(&pool->work_ready);
+    CondVar_Create(&pool->work_done);
+
+    pool->workers = (Thread*)malloc(sizeof(Thread) * worker_count);
+    if (!pool->workers)
+    {
+        fprintf(stderr, "Failed to allocate texture decode workers\n");
+        return false;
+    }
+
+    for (int i = 0; i < worker_count; ++i)
+    {
+        if (!Thread_Create(&pool->workers[i], TextureDecodePool_Worker, pool))
+            break;
+        pool->worker_count += 1;
+    }
+
+    return pool->worker_count > 0;
+}
+
+static inline void TextureDecodePool_Submit(TextureDecodePool* pool, const char* path, bool flip_vert, void* user, unsigned int request)
+{
+    DecodedImage* image = (DecodedImage*)calloc(1, sizeof(DecodedImage));
+    if (!image)
+    {
+        fprintf(stderr, "Failed to allocate decode request for %s\n", path);
+        return;
+    }
+
+    image->path = String_Create(strlen(path) + 1, path, NULL);
+    image->flip_vert = flip_vert;
+    image->user = user;
+    image->request = request;
+
+    Mutex_Lock(&pool->lock);
+
+    if (pool->pending_tail)
+        pool->pending_tail->next = image;
+    else
+        pool->pending_head = image;
+    pool->pending_tail = image;
+    pool->in_flight += 1;
+
+    CondVar_Signal(&pool->work_ready);
+    Mutex_Unlock(&pool->lock);
+}
+
+// Pops one decoded image (FIFO order), the caller owns it and frees it with DecodedImage_Free
+static inline DecodedImage* TextureDecodePool_Pop(TextureDecodePool* pool)
+{
+    Mutex_Lock(&pool->lock);
+
+    DecodedImage* image = pool->done_head;
+    if (image)
+    {
+        pool->done_head = image->next;
+        if (!pool->done_head)
+            pool->done_tail = NULL;
+        image->next = NULL;
+    }
+
+    Mutex_Unlock(&pool->lock);
+    return image;
+}
+
+// Blocks until every submitted request has been decoded
+static inline void TextureDecodePool_WaitIdle(TextureDecodePool* pool)
+{
+    Mutex_Lock(&pool->lock);
+
+    while (pool->in_flight > 0)
+        CondVar_Wait(&pool->work_done, &pool->lock);
+
+    Mutex_Unlock(&pool->lock);
+}
+
+static inline void TextureDecodePool_Delete(TextureDecodePool* pool)
+{
+    Mutex_Lock(&pool->lock);
+    pool->running = false;
+    CondVar_Broadcast(&pool->work_ready);
+    Mutex_Unlock(&pool->lock);
+
+    for (int i = 0; i < pool->worker_count; ++i)
+        Thread_Join(&pool->workers[i]);
+
+    free(pool->workers);
+    pool->workers = NULL;
+    pool->worker_count = 0;
+
+    DecodedImage* lists[2] = { pool->pending_head, pool->done_head };
+    for (int i = 0; i < 2; ++i)
+    {
+        DecodedImage* image = lists[i];
+        while (image)
+        {
+            DecodedImage* next = image->next;
+            DecodedImage_Free(image);
+            image = next;
+        }
+    }
+
+    pool->pending_head = pool->pending_tail = NULL;
+    pool->done_head = pool->done_tail = NULL;
+    pool->in_flight = 0;
+
+    CondVar_Delete(&pool->work_done);
+    CondVar_Delete(&pool->work_ready);
+    Mutex_Delete(&pool->lock);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                          TEXTURE LOADER FUNCTIONS                          */
+/* -------------------------------------------------------------------------- */
+
+typedef struct
+{
+    TextureDecodePool pool;
+
+    size_t bytes_per_frame;     // upload budget for TextureLoader_Update, 0 = unlimited
+    int pending;                // requests not decoded and consumed yet
+    unsigned int next_request;  // tags requests so stale images can be told apart
+
+    bool use_pbo;
+    unsigned int pbo;
+    size_t pbo_size;
+
+} TextureLoader;
+
+// Must be called on the GL thread
+static inline bool TextureLoader_Create(TextureLoader* loader, int worker_count, size_t bytes_per_frame, bool use_pbo)
+{
+    loader->bytes_per_frame = bytes_per_frame;
+    loader->pending = 0;
+    loader->next_request = 0;
+    loader->use_pbo = use_pbo;
+    loader->pbo = 0;
+    loader->pbo_size = 0;
+
+    if (use_pbo)
+        glGenBuffers(1, &loader->pbo);
+
+    return TextureDecodePool_Create(&loader->pool, worker_count);
+}
+
+// Queues path for decoding. tex is usable immediately: it gets its own texture holding a 2x2
+// checker until TextureLoader_Update uploads the real image, and keeps the checker with state
+// TEXTURE_FAILED when decoding fails. tex must stay alive until then; Texture_Delete on a texture
+// still loading is fine, and so is requesting it again: only the image of its latest request is
+// uploaded, older ones are dropped when they arrive. params may be NULL.
+static inline void TextureLoader_RequestEx(TextureLoader* loader, Texture* tex, const char* path, bool flip_vert, const TextureParams* params)
+{
+    static const unsigned char checker[16] = {
+        255, 0, 255, 255,     0, 0, 0, 255,
+          0, 0,   0, 255,   255, 0, 255, 255
+    };
+
+    glGenTextures(1, &tex->id);
+    glBindTexture(GL_TEXTURE_2D, tex->id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, checker);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    tex->state = TEXTURE_LOADING;
+    tex->params = params ? *params : Texture_DefaultParams();
+    tex->path = String_Create(512, path, NULL);
+    tex->local_buffer = NULL;
+    tex->width = 0;
+    tex->height = 0;
+    tex->bits_per_pixel = 0;
+
+    // 0 means no request, skipped when the counter wraps
+    if (++loader->next_request == 0)
+        loader->next_request = 1;
+    tex->request = loader->next_request;
+
+    loader->pending += 1;
+    TextureDecodePool_Submit(&loader->pool, path, flip_vert, tex, tex->request);
+}
+
+static inline void TextureLoader_Request(TextureLoader* loader, Texture* tex, const char* path, bool flip_vert)
+{
+    TextureLoader_RequestEx(loader, tex, path, flip_vert, NULL);
+}
+
+static inline bool TextureLoader_IsReady(const TextureLoader* loader, const Texture* tex)
+{
+    (void)loader;
+    return tex->state == TEXTURE_READY;
+}
+
+static inline bool TextureLoader_IsFailed(const TextureLoader* loader, const Texture* tex)
+{
+    (void)loader;
+    return tex->state == TEXTURE_FAILED;
+}
+
+static inline bool TextureLoader_IsIdle(const TextureLoader* loader)
+{
+    return loader->pending == 0;
+}
+
+static inline void TextureLoader_UploadImage(TextureLoader* loader, Texture* tex, const DecodedImage* image)
+{
+    // Texture_Upload creates a new texture, the placeholder goes
+    glDeleteTextures(1, &tex->id);
+
+    tex->width = image->width;
+    tex->height = image->height;
+    tex->bits_per_pixel = 4;
+
+    size_t size = (size_t)image->width * (size_t)image->height * 4;
+
+    if (!loader->use_pbo)
+    {
+        Texture_Upload(tex, image->pixels);
+        return;
+    }
+
+    // orphan the PBO every upload so the driver never waits on the previous transfer
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, loader->pbo);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+    loader->pbo_size = size;
+
+    void* dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (dst)
+    {
+        memcpy(dst, image->pixels, size);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        Texture_Upload(tex, NULL);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    else
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        Texture_Upload(tex, image->pixels);
+    }
+}
+
+// Call once per frame on the GL thread. Uploads finished images until bytes_per_frame is spent;
+// at least one image is uploaded per call so large textures cannot starve. Returns bytes uploaded.
+static inline size_t TextureLoader_Update(TextureLoader* loader)
+{
+    size_t uploaded = 0;
+
+    while (loader->bytes_per_frame == 0 || uploaded < loader->bytes_per_frame)
+    {
+        DecodedImage* image = TextureDecodePool_Pop(&loader->pool);
+        if (!image)
+            break;
+
+        Texture* tex = (Texture*)image->user;
+        loader->pending -= 1;
+
+        if (tex->request != image->request)
+        {
+            // deleted or requested again while loading
+        }
+        else if (image->pixels)
+        {
+            tex->request = 0;
+            TextureLoader_UploadImage(loader, tex, image);
+            uploaded += (size_t)image->width * (size_t)image->height * 4;
+        }
+        else
+        {
+            tex->request = 0;
+            tex->state = TEXTURE_FAILED;
+        }
+
+        DecodedImage_Free(image);
+    }
+
+    return uploaded;
+}
+
+// Blocks until every requested texture is decoded and uploaded, ignoring the per-frame budget
+static inline void TextureLoader_Flush(TextureLoader* loader)
+{
+    size_t budget = loader->bytes_per_frame;
+    loader->bytes_per_frame = 0;
+
+    while (loader->pending > 0)
+    {
+        TextureDecodePool_WaitIdle(&loader->pool);
+        TextureLoader_Update(loader);
+    }
+
+    loader->bytes_per_frame = budget;
+}
+
+static inline void TextureLoader_Delete(TextureLoader* loader)
+{
+    TextureDecodePool_Delete(&loader->pool);
+
+    if (loader->pbo)
+        glDeleteBuffers(1, &loader->pbo);
+
+    loader->pbo = 0;
+    loader->pending = 0;
+}
+
+#endif
@@ -6,54 +6,217 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include "string_utility.h"
+#include "file_utility.h"
+#include "mipmap_utility.h"
+#include "gl_extension_utility.h"
 #include <stdio.h>
 #include <stdbool.h>
 
+typedef enum
+{
+    TEXTURE_MIPS_NONE,          // level 0 only
+    TEXTURE_MIPS_GPU,           // glGenerateMipmap after upload
+    TEXTURE_MIPS_CPU_BOX,       // MipChain_Build with the box filter, every level uploaded
+    TEXTURE_MIPS_CPU_KAISER     // MipChain_Build with the Kaiser filter, every level uploaded
+
+} TextureMipMode;
+
+typedef struct
+{
+    int min_filter;             // GL_LINEAR_MIPMAP_LINEAR = trilinear
+    int mag_filter;
+    int wrap_s, wrap_t;         // GL_CLAMP_TO_EDGE, GL_REPEAT, GL_MIRRORED_REPEAT
+    float anisotropy;           // 1 = off, clamped to the driver maximum
+    TextureMipMode mips;
+
+} TextureParams;
+
+typedef enum
+{
+    TEXTURE_READY,              // uploaded
+    TEXTURE_LOADING,            // requested from a TextureLoader, samples a placeholder until uploaded
+    TEXTURE_FAILED              // loading failed: loader textures keep the placeholder, others have id 0
+
+} TextureState;
+
 typedef struct
 {
     unsigned int id;
     String path;
     unsigned char* local_buffer;    // buffer data for the texture
     int width, height, bits_per_pixel;
+    TextureParams params;
+    TextureState state;
+    unsigned int request;           // tag of the TextureLoader request in flight, 0 when none
 
 } Texture;
 
-static inline void Texture_Create(Texture* tex, const char* path, bool flip_vert)
+// stbi_load through File_Map, so images resolve through the mounted pack like every other file.
+// The flip flag is whatever stbi_set_flip_vertically_on_load(_thread) last set.
+static inline unsigned char* Image_Load(const char* path, int* width, int* height, int* channels, int desired_channels)
+{
+    FileView view;
+    if (!File_Map(&view, path))
+        return NULL;
+
+    unsigned char* pixels = stbi_load_from_memory((const stbi_uc*)view.data, (int)view.size, width, height, channels, desired_channels);
+    File_Unmap(&view);
+
+    return pixels;
+}
+
+// trilinear, clamped, GPU generated mips
+static inline TextureParams Texture_DefaultParams(void)
+{
+    TextureParams params;
+    params.min_filter = GL_LINEAR_MIPMAP_LINEAR;
+    params.mag_filter = GL_LINEAR;
+    params.wrap_s = GL_CLAMP_TO_EDGE;
+    params.wrap_t = GL_CLAMP_TO_EDGE;
+    params.anisotropy = 1.0f;
+    params.mips = TEXTURE_MIPS_GPU;
+    return params;
+}
+
+static inline bool Texture_IsMipmapFilter(int filter)
+{
+    return filter == GL_NEAREST_MIPMAP_NEAREST || filter == GL_LINEAR_MIPMAP_NEAREST ||
+           filter == GL_NEAREST_MIPMAP_LINEAR  || filter == GL_LINEAR_MIPMAP_LINEAR;
+}
+
+// Applies tex->params to the texture currently bound to GL_TEXTURE_2D
+static inline void Texture_ApplyParams(const Texture* tex, int levels)
+{
+    const TextureParams* p = &tex->params;
+
+    // a mipmap min filter on a single level texture makes it incomplete (samples black)
+    int min_filter = p->min_filter;
+    if (levels <= 1 && Texture_IsMipmapFilter(min_filter))
+        min_filter = (min_filter == GL_NEAREST_MIPMAP_NEAREST || min_filter == GL_NEAREST_MIPMAP_LINEAR) ? GL_NEAREST : GL_LINEAR;
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, min_filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, p->mag_filter);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, p->wrap_s);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, p->wrap_t);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+
+    if (p->anisotropy > 1.0f)
+    {
+        float max_anisotropy = GLExt_MaxAnisotropy();
+        if (max_anisotropy > 1.0f)
+            glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, p->anisotropy < max_anisotropy ? p->anisotropy : max_anisotropy);
+    }
+}
+
+// Changes the sampling state of an existing texture
+static inline void Texture_SetParams(Texture* tex, const TextureParams* params)
+{
+    tex->params = *params;
+
+    glBindTexture(GL_TEXTURE_2D, tex->id);
+
+    int max_level = 0;
+    glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, &max_level);
+    Texture_ApplyParams(tex, max_level + 1);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// Uploads a prebuilt chain (e.g. baked offline) as every level of a new texture
+static inline void Texture_UploadMipChain(Texture* tex, const MipChain* chain)
+{
+    tex->width = chain->width[0];
+    tex->height = chain->height[0];
+
+    glGenTextures(1, &tex->id);
+    glBindTexture(GL_TEXTURE_2D, tex->id);
+    tex->state = TEXTURE_READY;
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    for (int level = 0; level < chain->levels; ++level)
+    {
+        glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, chain->width[level], chain->height[level], 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, MipChain_Level(chain, level));
+    }
+
+    Texture_ApplyParams(tex, chain->levels);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// Creates the GL texture for tex->width x tex->height RGBA8 pixels using tex->params.
+// pixels may be NULL when a GL_PIXEL_UNPACK_BUFFER is bound (data is read from offset 0),
+// in which case CPU mip modes fall back to glGenerateMipmap.
+static inline void Texture_Upload(Texture* tex, const unsigned char* pixels)
+{
+    TextureMipMode mips = tex->params.mips;
+
+    if ((mips == TEXTURE_MIPS_CPU_BOX || mips == TEXTURE_MIPS_CPU_KAISER) && pixels)
+    {
+        MipChain chain;
+        MipFilter filter = (mips == TEXTURE_MIPS_CPU_KAISER) ? MIP_FILTER_KAISER : MIP_FILTER_BOX;
+
+        if (MipChain_Build(&chain, pixels, tex->width, tex->height, filter))
+        {
+            Texture_UploadMipChain(tex, &chain);
+            MipChain_Free(&chain);
+            return;
+        }
+    }
+
+    int levels = (mips == TEXTURE_MIPS_NONE) ? 1 : MipChain_LevelCount(tex->width, tex->height);
+
+    glGenTextures(1, &tex->id);
+    glBindTexture(GL_TEXTURE_2D, tex->id);
+    tex->state = TEXTURE_READY;
+
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, tex->width, tex->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+    if (levels > 1)
+        glGenerateMipmap(GL_TEXTURE_2D);
+
+    Texture_ApplyParams(tex, levels);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// params may be NULL for Texture_DefaultParams()
+static inline void Texture_CreateEx(Texture* tex, const char* path, bool flip_vert, const TextureParams* params)
 {
     tex->path = String_Create(512, path, NULL);
     tex->local_buffer = NULL;
     tex->width = 0;
     tex->height = 0;
     tex->bits_per_pixel = 0;
+    tex->params = params ? *params : Texture_DefaultParams();
+    tex->id = 0;
+    tex->state = TEXTURE_FAILED;    // until the upload succeeds
 
     stbi_set_flip_vertically_on_load(flip_vert);
-    tex->local_buffer = stbi_load(path, &tex->width, &tex->height, &tex->bits_per_pixel, 4);
+    tex->local_buffer = Image_Load(path, &tex->width, &tex->height, &tex->bits_per_pixel, 4);
     if (!tex->local_buffer)
     {
         printf("Failed to load texture: %s\n", path);
         return;
     }
 
-    glGenTextures(1, &tex->id);
-    glBindTexture(GL_TEXTURE_2D, tex->id);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    Texture_Upload(tex, tex->local_buffer);
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, tex->width, tex->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, tex->local_buffer);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    stbi_image_free(tex->local_buffer);
+    tex->local_buffer = NULL;
+}
 
-    if (tex->local_buffer)
-        stbi_image_free(tex->local_buffer);
+static inline void Texture_Create(Texture* tex, const char* path, bool flip_vert)
+{
+    Texture_CreateEx(tex, path, flip_vert, NULL);
 }
 
 static inline void Texture_Delete(Texture* tex)
 {
     glDeleteTextures(1, &tex->id);
     tex->id = 0;
+    tex->request = 0;   // a load still in flight is dropped when it arrives
     String_Free(&tex->path);
 }
 
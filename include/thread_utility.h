@@ -0,0 +1,120 @@
+#ifndef THREAD_UTILITY_H
+#define THREAD_UTILITY_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// Thin wrappers over pthreads so the rest of the framework never touches them directly
+
+typedef void* (*ThreadFunc)(void* arg);
+
+typedef struct
+{
+    pthread_t handle;
+    bool running;
+
+} Thread;
+
+typedef struct
+{
+    pthread_mutex_t handle;
+
+} Mutex;
+
+typedef struct
+{
+    pthread_cond_t handle;
+
+} CondVar;
+
+/* -------------------------------------------------------------------------- */
+/*                              THREAD FUNCTIONS                              */
+/* -------------------------------------------------------------------------- */
+
+static inline bool Thread_Create(Thread* thread, ThreadFunc func, void* arg)
+{
+    thread->running = false;
+
+    if (pthread_create(&thread->handle, NULL, func, arg) != 0)
+    {
+        fprintf(stderr, "Failed to create thread\n");
+        return false;
+    }
+
+    thread->running = true;
+    return true;
+}
+
+static inline void Thread_Join(Thread* thread)
+{
+    if (!thread->running)
+        return;
+
+    pthread_join(thread->handle, NULL);
+    thread->running = false;
+}
+
+// number of logical cores, never less than 1
+static inline int Thread_HardwareConcurrency(void)
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (count > 0) ? (int)count : 1;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              MUTEX FUNCTIONS                               */
+/* -------------------------------------------------------------------------- */
+
+static inline void Mutex_Create(Mutex* mutex)
+{
+    pthread_mutex_init(&mutex->handle, NULL);
+}
+
+static inline void Mutex_Lock(Mutex* mutex)
+{
+    pthread_mutex_lock(&mutex->handle);
+}
+
+static inline void Mutex_Unlock(Mutex* mutex)
+{
+    pthread_mutex_unlock(&mutex->handle);
+}
+
+static inline void Mutex_Delete(Mutex* mutex)
+{
+    pthread_mutex_destroy(&mutex->handle);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                          CONDITION VARIABLE FUNCTIONS                      */
+/* -------------------------------------------------------------------------- */
+
+static inline void CondVar_Create(CondVar* cv)
+{
+    pthread_cond_init(&cv->handle, NULL);
+}
+
+// mutex must be locked by the caller
+static inline void CondVar_Wait(CondVar* cv, Mutex* mutex)
+{
+    pthread_cond_wait(&cv->handle, &mutex->handle);
+}
+
+static inline void CondVar_Signal(CondVar* cv)
+{
+    pthread_cond_signal(&cv->handle);
+}
+
+static inline void CondVar_Broadcast(CondVar* cv)
+{
+    pthread_cond_broadcast(&cv->handle);
+}
+
+static inline void CondVar_Delete(CondVar* cv)
+{
+    pthread_cond_destroy(&cv->handle);
+}
+
+#endif
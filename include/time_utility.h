@@ -1,22 +1,266 @@
 #ifndef TIME_UTILITY_H
 #define TIME_UTILITY_H
 
-#include <GLFW/glfw3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
 
-static float Time_LastFrame = 0.0f;
-static float Time_DeltaTime = 0.0f;
-static float Time_TotalTime = 0.0f;
+// Frame clock on CLOCK_MONOTONIC nanosecond ticks. Totals are kept as integer ticks and handed out
+// as doubles, so animation driven by Time_Total() stays smooth after days of uptime (a float total
+// is down to ~2 ms steps after a few hours). Call Time_Update once per frame.
+//
+// Fixed-timestep simulation:
+//
+//     Time_SetFixedStep(1.0 / 120.0, 8);
+//     while (Time_FixedStep())
+//         Simulate(Time_FixedDelta());
+//     Render(Time_Alpha());               // blend previous and current simulation state
+//
+// Frame pacing: Time_SetTargetFPS (or FRAMEWORK_FPS=N for the window layer) makes Time_Pace sleep
+// until the next frame slot, finishing the last fraction of a millisecond spinning so frames land on
+// time. The window layer calls Time_Pace before presenting.
+//
+// All state lives in Time_State. Like every header in include/ it is static, so each translation
+// unit that includes this file has its own clock; the demos are single translation units.
+
+#define TIME_STAT_SAMPLES   256         // frames kept for Time_GetFrameStats
+#define TIME_MAX_DELTA      0.25        // seconds fed to the fixed-step accumulator per frame at most
+#define TIME_SPIN_NS        500000      // pacing spins for the last 0.5 ms instead of sleeping
+
+typedef struct
+{
+    double min_ms;
+    double avg_ms;
+    double p99_ms;
+    double max_ms;
+    int frames;
+
+} TimeFrameStats;
+
+typedef struct
+{
+    int64_t start_ns;           // first reading, everything is relative to it
+    int64_t last_ns;            // previous Time_Update
+    int64_t total_ns;
+    double delta;               // seconds between the last two updates
+    double smooth_delta;        // exponential average of the measured delta
+    uint64_t frame;
+
+    double fixed_step;          // seconds per simulation step
+    double accumulator;
+    int max_steps;              // per frame, beyond that the backlog is dropped
+    int steps;                  // taken this frame
+    uint64_t dropped_steps;
+
+    int64_t target_ns;          // frame period for Time_Pace, 0 when unpaced
+    int64_t next_frame_ns;
+
+    float samples[TIME_STAT_SAMPLES];   // frame times in ms
+    int sample_count;
+    int sample_next;
+
+    int64_t delta_ns;           // delta as handed out
+    double real_delta;          // measured, differs from delta when it is overridden
+    int64_t delta_override_ns;  // used by the next Time_Update instead of the clock when >= 0 (replay)
+
+} TimeState;
+
+static TimeState Time_State = { -1, 0, 0, 0.0, 0.0, 0, 1.0 / 60.0, 0.0, 8, 0, 0, 0, 0, { 0 }, 0, 0, 0, 0.0, -1 };
+
+// raw monotonic nanoseconds
+static inline int64_t Time_Ticks(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000ll + (int64_t)ts.tv_nsec;
+}
+
+// nanoseconds since the first call
+static inline int64_t Time_NowTicks(void)
+{
+    int64_t now = Time_Ticks();
+    if (Time_State.start_ns < 0)
+        Time_State.start_ns = now;
+    return now - Time_State.start_ns;
+}
+
+// seconds since the first call; monotonic clock so it also works without GLFW (headless)
+static inline double Time_Now(void)
+{
+    return (double)Time_NowTicks() * 1e-9;
+}
 
 // update the time
 static inline void Time_Update()
 {
-    float now = (float)glfwGetTime();
-    Time_DeltaTime = now - Time_LastFrame;
-    Time_LastFrame = now;
-    Time_TotalTime += Time_DeltaTime;
+    TimeState* t = &Time_State;
+    int64_t now = Time_NowTicks();
+
+    // the first update has nothing to measure against
+    int64_t real_ns = (t->frame == 0) ? 0 : now - t->last_ns;
+    int64_t delta_ns = (t->delta_override_ns >= 0) ? t->delta_override_ns : real_ns;
+    t->delta_override_ns = -1;
+
+    t->last_ns = now;
+    t->total_ns += delta_ns;
+    t->delta_ns = delta_ns;
+    t->delta = (double)delta_ns * 1e-9;
+    t->real_delta = (double)real_ns * 1e-9;
+    t->frame += 1;
+
+    // statistics describe the real frame rate
+    if (t->frame > 1)
+    {
+        t->smooth_delta = (t->frame == 2) ? t->real_delta : t->smooth_delta * 0.9 + t->real_delta * 0.1;
+        t->samples[t->sample_next] = (float)(t->real_delta * 1000.0);
+        t->sample_next = (t->sample_next + 1) % TIME_STAT_SAMPLES;
+        t->sample_count += t->sample_count < TIME_STAT_SAMPLES;
+    }
+
+    // a long stall (breakpoint, window drag) must not turn into a burst of simulation steps
+    t->accumulator += t->delta < TIME_MAX_DELTA ? t->delta : TIME_MAX_DELTA;
+    t->steps = 0;
+}
+
+static inline float Time_Delta(void) { return (float)Time_State.delta; }
+static inline double Time_Total(void) { return (double)Time_State.total_ns * 1e-9; }
+static inline float Time_SmoothDelta(void) { return (float)Time_State.smooth_delta; }
+static inline uint64_t Time_FrameCount(void) { return Time_State.frame; }
+
+// Total time folded into [0, period): keeps float angles and phases exact however long the run
+static inline float Time_TotalWrapped(double period)
+{
+    return (float)fmod(Time_Total(), period);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                               FIXED TIMESTEP                               */
+/* -------------------------------------------------------------------------- */
+
+static inline void Time_SetFixedStep(double step, int max_steps)
+{
+    if (step <= 0.0)
+    {
+        printf("Time_SetFixedStep: step must be positive\n");
+        return;
+    }
+
+    Time_State.fixed_step = step;
+    Time_State.max_steps = max_steps > 0 ? max_steps : 1;
 }
 
-static inline float Time_Delta(void) { return Time_DeltaTime; }
-static inline float Time_Total(void) { return Time_TotalTime; }
+// True while a simulation step is due; consumes it from the accumulator
+static inline bool Time_FixedStep(void)
+{
+    TimeState* t = &Time_State;
+    if (t->accumulator < t->fixed_step)
+        return false;
+
+    if (t->steps == t->max_steps)
+    {
+        // cannot keep up: drop the backlog rather than spiral
+        t->dropped_steps += (uint64_t)(t->accumulator / t->fixed_step);
+        t->accumulator = fmod(t->accumulator, t->fixed_step);
+        return false;
+    }
+
+    t->accumulator -= t->fixed_step;
+    t->steps += 1;
+    return true;
+}
+
+static inline float Time_FixedDelta(void) { return (float)Time_State.fixed_step; }
+
+// How far rendering is between the last two simulation steps, [0, 1)
+static inline float Time_Alpha(void)
+{
+    return (float)(Time_State.accumulator / Time_State.fixed_step);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   PACING                                   */
+/* -------------------------------------------------------------------------- */
+
+// 0 turns pacing off
+static inline void Time_SetTargetFPS(double fps)
+{
+    Time_State.target_ns = fps > 0.0 ? (int64_t)(1e9 / fps) : 0;
+    Time_State.next_frame_ns = 0;
+}
+
+// Waits for the next frame slot
+static inline void Time_Pace(void)
+{
+    TimeState* t = &Time_State;
+    if (t->target_ns == 0)
+        return;
+
+    int64_t now = Time_NowTicks();
+    if (t->next_frame_ns == 0)
+        t->next_frame_ns = now;
+
+    int64_t deadline = t->next_frame_ns + t->target_ns;
+    if (deadline > now + TIME_SPIN_NS)
+    {
+        int64_t wake = t->start_ns + deadline - TIME_SPIN_NS;
+        struct timespec ts = { (time_t)(wake / 1000000000ll), (long)(wake % 1000000000ll) };
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0)
+            ;
+    }
+    while (Time_NowTicks() < deadline)
+        ;
+
+    // a late frame starts a new schedule instead of rushing the next ones to catch up
+    now = Time_NowTicks();
+    t->next_frame_ns = (now - deadline > t->target_ns) ? now : deadline;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 STATISTICS                                 */
+/* -------------------------------------------------------------------------- */
+
+static inline int Time_CompareFloat(const void* a, const void* b)
+{
+    float x = *(const float*)a, y = *(const float*)b;
+    return (x > y) - (x < y);
+}
+
+// Over the last TIME_STAT_SAMPLES frames
+static inline TimeFrameStats Time_GetFrameStats(void)
+{
+    TimeFrameStats stats;
+    memset(&stats, 0, sizeof(TimeFrameStats));
+
+    int count = Time_State.sample_count;
+    if (count == 0)
+        return stats;
+
+    float sorted[TIME_STAT_SAMPLES];
+    memcpy(sorted, Time_State.samples, (size_t)count * sizeof(float));
+    qsort(sorted, (size_t)count, sizeof(float), Time_CompareFloat);
+
+    double sum = 0.0;
+    for (int i = 0; i < count; ++i)
+        sum += sorted[i];
+
+    int p99 = (count * 99 + 99) / 100 - 1;
+    stats.min_ms = sorted[0];
+    stats.avg_ms = sum / count;
+    stats.p99_ms = sorted[p99 < count ? p99 : count - 1];
+    stats.max_ms = sorted[count - 1];
+    stats.frames = count;
+    return stats;
+}
+
+static inline void Time_PrintFrameStats(void)
+{
+    TimeFrameStats s = Time_GetFrameStats();
+    printf("Frame time over %d frames: min %.3f  avg %.3f  p99 %.3f  max %.3f ms (%.1f fps)\n",
+           s.frames, s.min_ms, s.avg_ms, s.p99_ms, s.max_ms, s.avg_ms > 0.0 ? 1000.0 / s.avg_ms : 0.0);
+}
 
-#endif
\ No newline at end of file
+#endif
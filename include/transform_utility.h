@@ -6,70 +6,187 @@
 extern "C" {
 #endif
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
 #include "math_utility.h"
-#include "stack_utility.h"
 
 /* ----- Types ----- */
 typedef struct
 {
     Vector3 position;
-    Vector3 rotation;
+    Quaternion rotation;
     Vector3 scale;
 } Transform;
 
-/* ----- Stack type for matrices ----- */
-STACK_DEFINE(Matrix4, MatrixStack, 256);
+static inline Transform Transform_Identity(void)
+{
+    return (Transform){ (Vector3){0.0f, 0.0f, 0.0f}, Math_QuatIdentity(), (Vector3){1.0f, 1.0f, 1.0f} };
+}
 
-/* ----- Globals ----- */
-extern MatrixStack stack;
-extern Matrix4 current_mat4;
+// T * R * S, built straight from the quaternion instead of multiplying three matrices
+static inline Matrix4 Transform_ToMatrix(const Transform* t)
+{
+    Matrix4 m = Math_QuatConvertToMat4(t->rotation);
 
-/* ----- Implementation ----- */
+    for (int r = 0; r < 3; ++r)
+    {
+        m.m[0 + r] *= t->scale.x;
+        m.m[4 + r] *= t->scale.y;
+        m.m[8 + r] *= t->scale.z;
+    }
 
-/* define globals once */
-MatrixStack stack;
-Matrix4 current_mat4;
+    m.m[12] = t->position.x;
+    m.m[13] = t->position.y;
+    m.m[14] = t->position.z;
 
-/* ----- Functions ----- */
-static inline void Transform_Init(void) 
-{ 
-    current_mat4 = Math_Mat4Identity(); 
+    return m;
 }
 
-static inline void Transform_PushMatrix(void) 
-{ 
-    MatrixStack_Push(&stack, current_mat4); 
+/* ----- Transform context ----- */
+
+// Current matrix plus a growable stack of saved matrices. Contexts share nothing, so every thread
+// building transforms (e.g. recording its own command list) owns one. The Transform_* functions
+// further down wrap a default context for the main thread.
+typedef struct
+{
+    Matrix4 current;
+    Matrix4* stack;
+    int top;
+    int capacity;
+
+} TransformContext;
+
+static inline void TransformContext_Create(TransformContext* ctx, int capacity)
+{
+    ctx->current = Math_Mat4Identity();
+    ctx->stack = NULL;
+    ctx->top = 0;
+    ctx->capacity = 0;
+
+    if (capacity > 0)
+    {
+        ctx->stack = (Matrix4*)malloc(sizeof(Matrix4) * (size_t)capacity);
+        if (ctx->stack)
+            ctx->capacity = capacity;
+        else
+            printf("Failed to allocate transform stack (%d)\n", capacity);
+    }
 }
 
-static inline void Transform_PopMatrix(void) 
-{ 
-    if(!MatrixStack_IsEmpty(&stack)) 
-        current_mat4 = MatrixStack_Pop(&stack); 
+static inline void TransformContext_Delete(TransformContext* ctx)
+{
+    free(ctx->stack);
+    ctx->stack = NULL;
+    ctx->top = 0;
+    ctx->capacity = 0;
 }
 
-static inline void Transform_Translate(Vector3 t) 
-{ 
-    current_mat4 = Math_Mat4Multiply(current_mat4, Math_Mat4Translate(t)); 
+static inline bool TransformContext_Push(TransformContext* ctx)
+{
+    if (ctx->top == ctx->capacity)
+    {
+        int capacity = (ctx->capacity > 0) ? ctx->capacity * 2 : 32;
+        Matrix4* stack = (Matrix4*)realloc(ctx->stack, sizeof(Matrix4) * (size_t)capacity);
+        if (!stack)
+        {
+            printf("Failed to grow transform stack to %d\n", capacity);
+            return false;
+        }
+
+        ctx->stack = stack;
+        ctx->capacity = capacity;
+    }
+
+    ctx->stack[ctx->top++] = ctx->current;
+    return true;
 }
 
-static inline void Transform_Rotate(float thetaRads, Vector3 axis) 
-{ 
-    current_mat4 = Math_Mat4Multiply(current_mat4, Math_Mat4Rotate(thetaRads, axis)); 
+static inline void TransformContext_Pop(TransformContext* ctx)
+{
+    if (ctx->top > 0)
+        ctx->current = ctx->stack[--ctx->top];
 }
 
-static inline void Transform_Scale(Vector3 s) 
-{ 
-    current_mat4 = Math_Mat4Multiply(current_mat4, Math_Mat4Scale(s)); 
+static inline void TransformContext_Translate(TransformContext* ctx, Vector3 t)
+{
+    ctx->current = Math_Mat4Multiply(ctx->current, Math_Mat4Translate(t));
 }
 
-static inline Matrix4 Transform_ModelMatrix(void) 
-{ 
-    return current_mat4; 
+static inline void TransformContext_Rotate(TransformContext* ctx, float thetaRads, Vector3 axis)
+{
+    ctx->current = Math_Mat4Multiply(ctx->current, Math_Mat4Rotate(thetaRads, axis));
 }
 
-static inline void Transform_LoadIdentity(void) 
-{ 
-    current_mat4 = Math_Mat4Identity(); 
+static inline void TransformContext_Scale(TransformContext* ctx, Vector3 s)
+{
+    ctx->current = Math_Mat4Multiply(ctx->current, Math_Mat4Scale(s));
+}
+
+static inline void TransformContext_MultMatrix(TransformContext* ctx, Matrix4 m)
+{
+    ctx->current = Math_Mat4Multiply(ctx->current, m);
+}
+
+static inline void TransformContext_LoadIdentity(TransformContext* ctx)
+{
+    ctx->current = Math_Mat4Identity();
+}
+
+static inline Matrix4 TransformContext_ModelMatrix(const TransformContext* ctx)
+{
+    return ctx->current;
+}
+
+/* ----- Default context ----- */
+
+// one per translation unit, like the other file-scope state in this framework
+static TransformContext Transform_Default;
+
+static inline TransformContext* Transform_DefaultContext(void)
+{
+    return &Transform_Default;
+}
+
+static inline void Transform_Init(void)
+{
+    TransformContext_Delete(&Transform_Default);
+    TransformContext_Create(&Transform_Default, 256);
+}
+
+static inline void Transform_PushMatrix(void)
+{
+    TransformContext_Push(&Transform_Default);
+}
+
+static inline void Transform_PopMatrix(void)
+{
+    TransformContext_Pop(&Transform_Default);
+}
+
+static inline void Transform_Translate(Vector3 t)
+{
+    TransformContext_Translate(&Transform_Default, t);
+}
+
+static inline void Transform_Rotate(float thetaRads, Vector3 axis)
+{
+    TransformContext_Rotate(&Transform_Default, thetaRads, axis);
+}
+
+static inline void Transform_Scale(Vector3 s)
+{
+    TransformContext_Scale(&Transform_Default, s);
+}
+
+static inline Matrix4 Transform_ModelMatrix(void)
+{
+    return TransformContext_ModelMatrix(&Transform_Default);
+}
+
+static inline void Transform_LoadIdentity(void)
+{
+    TransformContext_LoadIdentity(&Transform_Default);
 }
 
 /* ----- End of C++ linkage ----- */
@@ -77,4 +194,4 @@ static inline void Transform_LoadIdentity(void)
 }
 #endif
 
-#endif /* TRANSFORM_UTILITY_H */
\ No newline at end of file
+#endif /* TRANSFORM_UTILITY_H */
@@ -2,30 +2,81 @@
 #define WINDOW_UTILITY_H
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdbool.h>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
 #include "math_utility.h"
 #include "time_utility.h"
+#include "gl_extension_utility.h"
+#include "headless_utility.h"
+#include "input_utility.h"
+#include "replay_utility.h"
+#include "profiler_utility.h"
+#include "gpu_profiler_utility.h"
+
+// Headless mode renders into an offscreen framebuffer through EGL instead of opening a GLFW window,
+// with the rest of the API unchanged, so the demos run as benchmarks on CI. It is picked with
+// WINDOW_MODE_HEADLESS or, for Window_Create, FRAMEWORK_HEADLESS=1 in the environment.
+// FRAMEWORK_FRAMES=N closes the window after N frames (headless runs default to 600).
+// FRAMEWORK_FPS=N paces frames to N per second (Time_Pace).
+// FRAMEWORK_RECORD / FRAMEWORK_REPLAY record and play back input and frame deltas (replay_utility.h).
+
+typedef enum
+{
+    WINDOW_MODE_DEFAULT,    // windowed unless FRAMEWORK_HEADLESS is set
+    WINDOW_MODE_WINDOWED,
+    WINDOW_MODE_HEADLESS,
+
+} WindowMode;
+
+static HeadlessContext Window_HeadlessContext;
+static long Window_FrameCount = 0;
+static long Window_FrameLimit = 0;     // 0: no limit
+static double Window_FirstFrame = 0.0;
 
 static inline void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
     glViewport(0, 0, width, height);
 }
 
-typedef struct
+typedef struct Window
 {
     GLFWwindow* w;
     int width, height;
     const char* title;
     float fov;
     float aspect;
+    bool headless;
 
 } Window;
 
 static inline bool Window_Init(Window* window)
 {
+#ifdef FRAMEWORK_PROFILE
+    Profiler_InitFromEnv();
+    PROFILE_THREAD("main");
+#endif
+
+    const char* frames = getenv("FRAMEWORK_FRAMES");
+    Window_FrameLimit = frames ? atol(frames) : (window->headless ? 600 : 0);
+    Window_FrameCount = 0;
+
+    const char* fps = getenv("FRAMEWORK_FPS");
+    if (fps)
+        Time_SetTargetFPS(atof(fps));
+
+    if (window->headless)
+    {
+        if (!Headless_Create(&Window_HeadlessContext, window->width, window->height))
+            return false;
+        GLExt_SetLoader((GLADloadproc)Headless_GetProcAddress);
+
+        Window_FirstFrame = Time_Now();
+        return true;
+    }
+
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -47,44 +98,128 @@ static inline bool Window_Init(Window* window)
         glfwTerminate();
         return false;
     }
+    GLExt_SetLoader((GLADloadproc)glfwGetProcAddress);
 
     glfwSetFramebufferSizeCallback(window->w, framebuffer_size_callback);
+    Input_Install(window->w);
 
+    Window_FirstFrame = Time_Now();
     return true;
 }
 
-static inline bool Window_Create(Window* window, int w, int h, float fov, const char* t)
+static inline bool Window_CreateEx(Window* window, int w, int h, float fov, const char* t, WindowMode mode)
 {
+    const char* env = getenv("FRAMEWORK_HEADLESS");
+
     window->w = NULL;
     window->width = w;
     window->height = h;
     window->title = t;
     window->fov = Math_DegToRad(fov);
     window->aspect = (float)window->width / (float)window->height;
+    window->headless = mode == WINDOW_MODE_HEADLESS || (mode == WINDOW_MODE_DEFAULT && env && env[0] == '1');
+
+    if (!Window_Init(window))
+        return false;
+
+    // a replay runs to its last frame unless FRAMEWORK_FRAMES says otherwise
+    Replay_InitFromEnv();
+    if (Replay_Playing() && !getenv("FRAMEWORK_FRAMES"))
+        Window_FrameLimit = 0;
+    return true;
+}
 
-    return Window_Init(window);
+static inline bool Window_Create(Window* window, int w, int h, float fov, const char* t)
+{
+    return Window_CreateEx(window, w, h, fov, t, WINDOW_MODE_DEFAULT);
 }
 
 static inline bool Window_IsOpen(Window window)
 {
-    return !glfwWindowShouldClose(window.w);
+    if (Window_FrameLimit > 0 && Window_FrameCount >= Window_FrameLimit)
+        return false;
+    if (Replay_Finished())
+        return false;
+    return window.headless || !glfwWindowShouldClose(window.w);
 }
 
 static inline void Window_SwapBuffers(Window window)
 {
-    glfwSwapBuffers(window.w);
+    Window_FrameCount += 1;
+
+#ifdef FRAMEWORK_PROFILE
+    GpuProfiler_EndFrame();
+#endif
+
+    {
+        PROFILE_ZONE("pace");
+        Time_Pace();
+    }
+
+    {
+        PROFILE_ZONE("swap");
+
+        // nothing to present: hand the frame to the driver and keep drawing into the same target
+        if (window.headless)
+            glFlush();
+        else
+            glfwSwapBuffers(window.w);
+    }
+
+    PROFILE_FRAME_END();
+
+#ifdef FRAMEWORK_PROFILE
+    GpuProfiler_BeginFrame();
+#endif
 }
 
 static inline void Window_PollEvents()
 {
-    glfwPollEvents();
+    if (Window_HeadlessContext.context == NULL)
+        glfwPollEvents();
+
+    // record the frame's snapshot before the next one is taken; playback supplies its own
+    Replay_EndFrame();
+    if (!Input_State.manual && !Replay_Playing())
+        Input_Update();
 }
 
 static inline void Window_Delete()
 {
+    Replay_Stop();
+
+#ifdef FRAMEWORK_PROFILE
+    // last GPU timings into the trace while the context is still alive
+    GpuProfiler_Flush();
+    GpuProfiler_Delete();
+    Profiler_FrameEnd();
+    Profiler_Shutdown();
+#endif
+
+    if (Window_HeadlessContext.context)
+    {
+        // wait for the last frame so the average covers the GPU work too
+        glFinish();
+        double elapsed = Time_Now() - Window_FirstFrame;
+        if (Window_FrameCount > 0)
+            printf("Headless: %ld frames in %.3f s, %.3f ms/frame\n", Window_FrameCount, elapsed, elapsed * 1000.0 / Window_FrameCount);
+        if (Time_State.sample_count > 0)
+            Time_PrintFrameStats();
+
+        Headless_Destroy(&Window_HeadlessContext);
+        return;
+    }
+
     glfwTerminate();
 }
 
+// Framebuffer the window renders into: the offscreen target when headless, 0 otherwise.
+// Bind it again after rendering into another framebuffer.
+static inline unsigned int Window_Framebuffer(const Window* window)
+{
+    return window->headless ? Window_HeadlessContext.fbo : 0;
+}
+
 static inline void Window_EnableDepthTest()
 {
     glEnable(GL_DEPTH_TEST);
@@ -107,7 +242,10 @@ static inline void Window_PrintFPS(void)
 }
 
 static inline Vector2 Window_GetWindowSize(const Window* window)
-{   
+{
+    if (window->headless)
+        return (Vector2) {(float)window->width, (float)window->height};
+
     int width, height;
     glfwGetWindowSize(window->w, &width, &height);
     return (Vector2) {(float)width, (float)height};
@@ -9,13 +9,24 @@ uniform vec3 lightColor;
 uniform vec3 viewPos;
 
 uniform vec4 uColor;
-uniform sampler2D uTexture;
+
+// Permutation features (see ShaderFeature): USE_LIGHTING, USE_TEXTURE. Built without them (plain
+// Shader_Create) the shader is always lit and samples uTexture when uUseTexture is set.
+#ifndef SHADER_PERMUTATION
+#define USE_LIGHTING
+#define USE_TEXTURE_UNIFORM
 uniform int uUseTexture;
+#endif
+
+#if defined(USE_TEXTURE) || defined(USE_TEXTURE_UNIFORM)
+uniform sampler2D uTexture;
+#endif
 
 out vec4 FragColor;
 
 void main()
 {
+#ifdef USE_LIGHTING
     vec3 N = normalize(vNormal);
     vec3 L = normalize(lightPos - fragPos);
     vec3 V = normalize(viewPos - fragPos);
@@ -35,9 +46,18 @@ void main()
 
     vec3 lighting = (ambient + diffuse + specular);
     vec3 result = lighting * uColor.rgb;
+#else
+    vec3 result = uColor.rgb;
+#endif
 
+#if defined(USE_TEXTURE)
+    FragColor = texture(uTexture, vTexCoord) * vec4(result, 1.0);
+#elif defined(USE_TEXTURE_UNIFORM)
     if (uUseTexture != 0)
         FragColor = texture(uTexture, vTexCoord) * vec4(result, 1.0);
     else
         FragColor = vec4(result, 1.0);
+#else
+    FragColor = vec4(result, 1.0);
+#endif
 }
\ No newline at end of file
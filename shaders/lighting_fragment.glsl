@@ -6,8 +6,16 @@ in vec3 vNormal;
 
 uniform vec3 viewPos;
 uniform vec4 uColor;
-uniform sampler2D uTexture;
+
+// Permutation feature USE_TEXTURE; built without it (plain Shader_Create) uUseTexture decides
+#ifndef SHADER_PERMUTATION
+#define USE_TEXTURE_UNIFORM
 uniform int uUseTexture;
+#endif
+
+#if defined(USE_TEXTURE) || defined(USE_TEXTURE_UNIFORM)
+uniform sampler2D uTexture;
+#endif
 
 out vec4 FragColor;
 
@@ -32,8 +40,14 @@ void main()
     vec3 lighting = (ambient + diffuse + specular);
     vec3 result = lighting * uColor.rgb;
 
+#if defined(USE_TEXTURE)
+    FragColor = texture(uTexture, vTexCoord) * vec4(result, 1.0);
+#elif defined(USE_TEXTURE_UNIFORM)
     if (uUseTexture != 0)
         FragColor = texture(uTexture, vTexCoord) * vec4(result, 1.0);
     else
         FragColor = vec4(result, 1.0);
+#else
+    FragColor = vec4(result, 1.0);
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,18 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aTexCoord;
+layout (location = 2) in vec3 aNormal;
+
+uniform mat4 uModel;
+uniform mat4 uView;
+uniform mat4 uProjection;
+uniform vec4 uUVRect;   // atlas sub-rectangle, xy = min uv, zw = size
+
+out vec2 vTexCoord;
+
+void main()
+{
+    vTexCoord = uUVRect.xy + aTexCoord * uUVRect.zw;
+    gl_Position = uProjection * uView * uModel * vec4(aPos, 1.0);
+}
@@ -0,0 +1,13 @@
+#version 330 core
+
+in vec2 vTexCoord;
+flat in float vLayer;
+
+uniform sampler2DArray uTextureArray;
+
+out vec4 FragColor;
+
+void main()
+{
+    FragColor = texture(uTextureArray, vec3(vTexCoord, vLayer));
+}
@@ -0,0 +1,22 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aTexCoord;
+layout (location = 2) in vec3 aNormal;
+
+// per-instance (Mesh_SetInstances)
+layout (location = 3) in mat4 aInstanceModel;
+layout (location = 7) in vec4 aInstanceParams;   // x = texture array layer
+
+uniform mat4 uView;
+uniform mat4 uProjection;
+
+out vec2 vTexCoord;
+flat out float vLayer;
+
+void main()
+{
+    vTexCoord = aTexCoord;
+    vLayer = aInstanceParams.x;
+    gl_Position = uProjection * uView * aInstanceModel * vec4(aPos, 1.0);
+}
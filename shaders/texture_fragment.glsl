@@ -3,7 +3,6 @@
 in vec2 vTexCoord;
 
 uniform sampler2D uTexture;
-uniform bool uUseTexture;
 
 out vec4 FragColor;
 
@@ -8,12 +8,22 @@ int main(void)
     if (!Window_Create(&window, 1280, 720, 60.0f, "C_Framework")) 
         return -1;
 
+    // Load assets from the archive built by `make pack` when there is one
+    Pack pack;
+    if (access("assets.pak", F_OK) == 0 && Pack_Open(&pack, "assets.pak"))
+        Pack_Mount(&pack);
+
     Window_DisableDepthTest();
 
     // Create texture shader
     Shader tex_shader;
     Shader_Create(&tex_shader, "shaders/texture_vertex.glsl", "shaders/texture_fragment.glsl");
 
+    // Reload shaders when their files change
+    ShaderWatcher shader_watcher;
+    ShaderWatcher_Create(&shader_watcher);
+    ShaderWatcher_Add(&shader_watcher, &tex_shader, "shaders/texture_vertex.glsl", "shaders/texture_fragment.glsl", NULL);
+
     // Lets create an arena to handle the mesh data
     Arena arena = Arena_Create(4096*4096); // 4MB
 
@@ -37,6 +47,7 @@ int main(void)
     while (Window_IsOpen(window))
     {
         Time_Update();
+        ShaderWatcher_Poll(&shader_watcher);
         //Window_PrintFPS();
 
         // Update the camera (2D)
@@ -60,7 +71,6 @@ int main(void)
             Math_GetOrthoMatrix(-1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f));
 
 
-        Shader_SetUniform1i(&tex_shader, "uUseTexture", 1);
         Shader_SetUniform1i(&tex_shader, "uTexture", 0);
 
         Mesh_Draw(&rectangle);
@@ -75,6 +85,7 @@ int main(void)
     }
 
     // Here we delete any meshes, shaders, textures, and the window
+    ShaderWatcher_Delete(&shader_watcher);
     Shader_Delete(&tex_shader);
 
     Texture_Delete(&georgia_texture);
@@ -82,6 +93,9 @@ int main(void)
     // Free up the memory for the meshes being contained in the arena
     Arena_Free(&arena);
 
+    if (Pack_Mounted)
+        Pack_Close(&pack);
+
     Window_Delete();
 
     return 0;
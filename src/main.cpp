@@ -7,17 +7,31 @@ int main(void)
     Window window;
     if (!Window_Create(&window, 1280, 720, 60.0f, "C_Framework")) return -1;
 
+    // Load assets from the archive built by `make pack` when there is one
+    Pack pack;
+    if (access("assets.pak", F_OK) == 0 && Pack_Open(&pack, "assets.pak"))
+        Pack_Mount(&pack);
+
     // Enable depth testing
     Window_EnableDepthTest();
 
-    // Create lighting shader
-    Shader light_shader;
-    Shader_Create(&light_shader, "shaders/vertex.glsl", "shaders/fragment.glsl");
+    // Lighting shader permutations, built per feature combination on first use
+    ShaderVariantCache shader_variants;
+    ShaderVariants_Create(&shader_variants, 16);
+
+    ShaderPermutations light_shaders;
+    ShaderPermutations_Create(&light_shaders, &shader_variants, "shaders/vertex.glsl", "shaders/fragment.glsl");
 
     // Create texture shader
     Shader tex_shader;
     Shader_Create(&tex_shader, "shaders/texture_vertex.glsl", "shaders/texture_fragment.glsl");
 
+    // Reload shaders when their files change
+    ShaderWatcher shader_watcher;
+    ShaderWatcher_Create(&shader_watcher);
+    ShaderWatcher_AddCache(&shader_watcher, &shader_variants);
+    ShaderWatcher_Add(&shader_watcher, &tex_shader, "shaders/texture_vertex.glsl", "shaders/texture_fragment.glsl", NULL);
+
     // Lets create an arena to handle the mesh data
     Arena allocator = Arena_Create(8096*8096); // 4MB
 
@@ -72,6 +86,10 @@ int main(void)
     while (Window_IsOpen(window))
     {
         Time_Update();
+        ShaderWatcher_Poll(&shader_watcher);
+
+        // each draw enables the lighting permutation that matches what it binds
+        Shader* lit;
         //Window_PrintFPS();
 
         // Update the camera
@@ -80,6 +98,7 @@ int main(void)
         Window_Clear(Colour_Crimson);
 
         // // Draw the Dome which will represent the world itself
+        GPU_PROFILE_BEGIN("sky dome");
         Transform_PushMatrix();
 
             Transform_Translate(camera.position);
@@ -93,7 +112,6 @@ int main(void)
             Shader_SetUniformMat4(&tex_shader, "uView",       Camera3D_ViewMatrix(&camera));
             Shader_SetUniformMat4(&tex_shader, "uProjection", Math_GetProjMatrix(window.fov, window.aspect, 0.1f, 100.0f));
 
-            Shader_SetUniform1i(&tex_shader, "uUseTexture", 1);
             Shader_SetUniform1i(&tex_shader, "uTexture", 0);
             
             Mesh_Draw(&dome);
@@ -102,28 +120,30 @@ int main(void)
             Shader_Disable();
 
         Transform_PopMatrix();
+        GPU_PROFILE_END();
 
         // Drawing the triangle
+        GPU_PROFILE_BEGIN("opaque");
         Transform_PushMatrix();
 
             Transform_Translate((Vector3){0.0f,0.0f,-5.0f});
             Transform_Rotate(Math_DegToRad(30.0f)*Time_Total(), (Vector3){1,1,0});
 
-            Shader_Enable(&light_shader);
-            Texture_Enable(&georgia_texture, 0);
+            lit = ShaderPermutations_Enable(&light_shaders, SHADER_FEATURE_LIGHTING, &georgia_texture);
 
-            // model, view, projection
-            Shader_SetUniformMat4(&light_shader, "uModel",      Transform_ModelMatrix());
-            Shader_SetUniformMat4(&light_shader, "uView",       Camera3D_ViewMatrix(&camera));
-            Shader_SetUniformMat4(&light_shader, "uProjection", Math_GetProjMatrix(window.fov, window.aspect, 0.1f, 100.0f));
-
-            Shader_SetUniform3f(&light_shader, "lightPos", light_pos_world);
-            Shader_SetUniform3f(&light_shader, "lightColor", light_color);
-            Shader_SetUniform3f(&light_shader, "viewPos", camera.position);
-            Shader_SetUniform1i(&light_shader, "uUseTexture", 1);
-            Shader_SetUniform1i(&light_shader, "uTexture", 0);
-            Shader_SetUniform4f(&light_shader, "uColor", Colour_White);
-            Mesh_Draw(&triangle);
+            if (lit)
+            {
+                // model, view, projection
+                Shader_SetUniformMat4(lit, "uModel",      Transform_ModelMatrix());
+                Shader_SetUniformMat4(lit, "uView",       Camera3D_ViewMatrix(&camera));
+                Shader_SetUniformMat4(lit, "uProjection", Math_GetProjMatrix(window.fov, window.aspect, 0.1f, 100.0f));
+
+                Shader_SetUniform3f(lit, "lightPos", light_pos_world);
+                Shader_SetUniform3f(lit, "lightColor", light_color);
+                Shader_SetUniform3f(lit, "viewPos", camera.position);
+                Shader_SetUniform4f(lit, "uColor", Colour_White);
+                Mesh_Draw(&triangle);
+            }
 
             Texture_Disable();
             Shader_Disable();
@@ -136,21 +156,21 @@ int main(void)
             Transform_Translate((Vector3){-10.0f,0.0f,0.0f});
             Transform_Rotate(Math_DegToRad(24.0f)*Time_Total(), (Vector3){1,1,1});
 
-            Shader_Enable(&light_shader);
-            Texture_Enable(&georgia_texture, 0);
+            lit = ShaderPermutations_Enable(&light_shaders, SHADER_FEATURE_LIGHTING, &georgia_texture);
 
-            // model, view, projection
-            Shader_SetUniformMat4(&light_shader, "uModel",      Transform_ModelMatrix());
-            Shader_SetUniformMat4(&light_shader, "uView",       Camera3D_ViewMatrix(&camera));
-            Shader_SetUniformMat4(&light_shader, "uProjection", Math_GetProjMatrix(window.fov, window.aspect, 0.1f, 100.0f));
-
-            Shader_SetUniform3f(&light_shader, "lightPos", light_pos_world);
-            Shader_SetUniform3f(&light_shader, "lightColor", light_color);
-            Shader_SetUniform3f(&light_shader, "viewPos", camera.position);
-            Shader_SetUniform1i(&light_shader, "uUseTexture", 1);
-            Shader_SetUniform1i(&light_shader, "uTexture", 0);
-            Shader_SetUniform4f(&light_shader, "uColor", Colour_White);
-            Mesh_Draw(&cube);
+            if (lit)
+            {
+                // model, view, projection
+                Shader_SetUniformMat4(lit, "uModel",      Transform_ModelMatrix());
+                Shader_SetUniformMat4(lit, "uView",       Camera3D_ViewMatrix(&camera));
+                Shader_SetUniformMat4(lit, "uProjection", Math_GetProjMatrix(window.fov, window.aspect, 0.1f, 100.0f));
+
+                Shader_SetUniform3f(lit, "lightPos", light_pos_world);
+                Shader_SetUniform3f(lit, "lightColor", light_color);
+                Shader_SetUniform3f(lit, "viewPos", camera.position);
+                Shader_SetUniform4f(lit, "uColor", Colour_White);
+                Mesh_Draw(&cube);
+            }
 
             Texture_Disable();
             Shader_Disable();
@@ -163,21 +183,21 @@ int main(void)
             Transform_Translate((Vector3){10.0f,0.0f,0.0f});
             Transform_Rotate(Math_DegToRad(24.0f)*Time_Total(), (Vector3){1,1,1});
 
-            Shader_Enable(&light_shader);
-            Texture_Enable(&georgia_texture, 0);
+            lit = ShaderPermutations_Enable(&light_shaders, SHADER_FEATURE_LIGHTING, &georgia_texture);
 
-            // model, view, projection
-            Shader_SetUniformMat4(&light_shader, "uModel",      Transform_ModelMatrix());
-            Shader_SetUniformMat4(&light_shader, "uView",       Camera3D_ViewMatrix(&camera));
-            Shader_SetUniformMat4(&light_shader, "uProjection", Math_GetProjMatrix(window.fov, window.aspect, 0.1f, 100.0f));
-
-            Shader_SetUniform3f(&light_shader, "lightPos", light_pos_world);
-            Shader_SetUniform3f(&light_shader, "lightColor", light_color);
-            Shader_SetUniform3f(&light_shader, "viewPos", camera.position);
-            Shader_SetUniform1i(&light_shader, "uUseTexture", 1);
-            Shader_SetUniform1i(&light_shader, "uTexture", 0);
-            Shader_SetUniform4f(&light_shader, "uColor", Colour_White);
-            Mesh_Draw(&rectangle);
+            if (lit)
+            {
+                // model, view, projection
+                Shader_SetUniformMat4(lit, "uModel",      Transform_ModelMatrix());
+                Shader_SetUniformMat4(lit, "uView",       Camera3D_ViewMatrix(&camera));
+                Shader_SetUniformMat4(lit, "uProjection", Math_GetProjMatrix(window.fov, window.aspect, 0.1f, 100.0f));
+
+                Shader_SetUniform3f(lit, "lightPos", light_pos_world);
+                Shader_SetUniform3f(lit, "lightColor", light_color);
+                Shader_SetUniform3f(lit, "viewPos", camera.position);
+                Shader_SetUniform4f(lit, "uColor", Colour_White);
+                Mesh_Draw(&rectangle);
+            }
 
             Texture_Disable();
             Shader_Disable();
@@ -190,21 +210,21 @@ int main(void)
             Transform_Translate((Vector3){0.0f,0.0f,-20.0f});
             Transform_Rotate(Math_DegToRad(24.0f)*Time_Total(), (Vector3){1,1,1});
 
-            Shader_Enable(&light_shader);
-            Texture_Enable(&georgia_texture, 0);
+            lit = ShaderPermutations_Enable(&light_shaders, SHADER_FEATURE_LIGHTING, &georgia_texture);
 
-            // model, view, projection
-            Shader_SetUniformMat4(&light_shader, "uModel",      Transform_ModelMatrix());
-            Shader_SetUniformMat4(&light_shader, "uView",       Camera3D_ViewMatrix(&camera));
-            Shader_SetUniformMat4(&light_shader, "uProjection", Math_GetProjMatrix(window.fov, window.aspect, 0.1f, 100.0f));
-
-            Shader_SetUniform3f(&light_shader, "lightPos", light_pos_world);
-            Shader_SetUniform3f(&light_shader, "lightColor", light_color);
-            Shader_SetUniform3f(&light_shader, "viewPos", camera.position);
-            Shader_SetUniform1i(&light_shader, "uUseTexture", 1);
-            Shader_SetUniform1i(&light_shader, "uTexture", 0);
-            Shader_SetUniform4f(&light_shader, "uColor", Colour_White);
-            Mesh_Draw(&circle);
+            if (lit)
+            {
+                // model, view, projection
+                Shader_SetUniformMat4(lit, "uModel",      Transform_ModelMatrix());
+                Shader_SetUniformMat4(lit, "uView",       Camera3D_ViewMatrix(&camera));
+                Shader_SetUniformMat4(lit, "uProjection", Math_GetProjMatrix(window.fov, window.aspect, 0.1f, 100.0f));
+
+                Shader_SetUniform3f(lit, "lightPos", light_pos_world);
+                Shader_SetUniform3f(lit, "lightColor", light_color);
+                Shader_SetUniform3f(lit, "viewPos", camera.position);
+                Shader_SetUniform4f(lit, "uColor", Colour_White);
+                Mesh_Draw(&circle);
+            }
 
             Texture_Disable();
             Shader_Disable();
@@ -218,43 +238,38 @@ int main(void)
             Transform_Translate((Vector3){20.0f, 0.0f, 10.0f});
             Transform_Scale((Vector3){5.0f,5.0f,5.0f});
 
-            Shader_Enable(&light_shader);
-
-            // model, view, projection
-            Shader_SetUniformMat4(&light_shader, "uModel",      Transform_ModelMatrix());
-            Shader_SetUniformMat4(&light_shader, "uView",       Camera3D_ViewMatrix(&camera));
-            Shader_SetUniformMat4(&light_shader, "uProjection", Math_GetProjMatrix(window.fov, window.aspect, 0.1f, 100.0f));
+            // the textured/untextured permutation follows from whether the model has a texture
+            Texture* boombox_texture = boombox.textures.data ? &DArray_Get_T(Texture, &boombox.textures, 0) : NULL;
+            Shader* boombox_shader = ShaderPermutations_Enable(&light_shaders, SHADER_FEATURE_LIGHTING, boombox_texture);
 
-            Shader_SetUniform3f(&light_shader, "lightPos", light_pos_world);
-            Shader_SetUniform3f(&light_shader, "lightColor", light_color);
-            Shader_SetUniform3f(&light_shader, "viewPos", camera.position);
+            if (boombox_shader)
+            {
+                // model, view, projection
+                Shader_SetUniformMat4(boombox_shader, "uModel",      Transform_ModelMatrix());
+                Shader_SetUniformMat4(boombox_shader, "uView",       Camera3D_ViewMatrix(&camera));
+                Shader_SetUniformMat4(boombox_shader, "uProjection", Math_GetProjMatrix(window.fov, window.aspect, 0.1f, 100.0f));
 
-            if (boombox.textures.data)
-            {  
-                Shader_SetUniform1i(&light_shader, "uUseTexture", 1);
-                Shader_SetUniform1i(&light_shader, "uTexture", 0);
+                Shader_SetUniform3f(boombox_shader, "lightPos", light_pos_world);
+                Shader_SetUniform3f(boombox_shader, "lightColor", light_color);
+                Shader_SetUniform3f(boombox_shader, "viewPos", camera.position);
+                Shader_SetUniform4f(boombox_shader, "uColor", boombox_texture ? Colour_White : Colour_Brick);
 
-                Texture_Enable(&DArray_Get_T(Texture, &boombox.textures, 0), 0);
-            }
-            else
-            {
-                Shader_SetUniform1i(&light_shader, "uUseTexture", 0);
-                Shader_SetUniform4f(&light_shader, "uColor", Colour_Brick);
+                Mesh_Draw(&boombox);
             }
 
-            Mesh_Draw(&boombox);
-
             Texture_Disable();
             Shader_Disable();
 
         Transform_PopMatrix();
+        GPU_PROFILE_END();
 
         Window_PollEvents();
         Window_SwapBuffers(window);
     }
 
     // Here we delete any meshes, shaders, textures, and the window
-    Shader_Delete(&light_shader);
+    ShaderWatcher_Delete(&shader_watcher);
+    ShaderVariants_Delete(&shader_variants);
     Shader_Delete(&tex_shader);
 
     Arena_Free(&allocator);
@@ -262,6 +277,9 @@ int main(void)
     Texture_Delete(&georgia_texture);
     Texture_Delete(&ocean);
 
+    if (Pack_Mounted)
+        Pack_Close(&pack);
+
     Window_Delete();
 
     return 0;
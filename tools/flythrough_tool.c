@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "replay_utility.h"
+
+// Writes a scripted camera fly-through as an input recording, so benchmark runs can replay the same
+// path without anyone recording one by hand. Every frame is a fixed 1/rate seconds; the keys are the
+// ones Camera3D_Update reads (WASD/QE to move, IJKL to look) plus a right-drag mouse look.
+//
+// usage: flythrough_tool output.rec [rate]
+
+typedef struct
+{
+    float seconds;
+    int keys[3];            // 0 terminated
+    float look_x, look_y;   // cursor pixels per frame with the right button held
+
+} FlySegment;
+
+static const FlySegment FlyScript[] = {
+    { 3.0f, { GLFW_KEY_W },                  0.0f, 0.0f },
+    { 1.5f, { GLFW_KEY_L },                  0.0f, 0.0f },
+    { 2.0f, { GLFW_KEY_W, GLFW_KEY_E },      0.0f, 0.0f },
+    { 2.0f, { 0 },                           6.0f, 0.0f },
+    { 1.0f, { GLFW_KEY_I },                  0.0f, 0.0f },
+    { 2.5f, { GLFW_KEY_S, GLFW_KEY_A },      0.0f, 0.0f },
+    { 1.0f, { GLFW_KEY_K },                  0.0f, 0.0f },
+    { 2.0f, { GLFW_KEY_J, GLFW_KEY_W },      0.0f, 0.0f },
+    { 1.5f, { GLFW_KEY_D, GLFW_KEY_Q },      0.0f, 2.0f },
+    { 2.0f, { GLFW_KEY_S },                  -4.0f, 0.0f },
+};
+
+static void SetKey(uint64_t* bits, int key, bool on)
+{
+    uint64_t bit = 1ull << (key & 63);
+    if (on)
+        bits[key >> 6] |= bit;
+    else
+        bits[key >> 6] &= ~bit;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        printf("usage: flythrough_tool output.rec [rate]\n");
+        return -1;
+    }
+
+    double rate = argc > 2 ? atof(argv[2]) : 60.0;
+    if (rate <= 0.0)
+        return -1;
+    int64_t delta_ns = (int64_t)(1e9 / rate);
+
+    if (!Replay_StartRecording(argv[1]))
+        return -1;
+
+    InputSnapshot previous, snapshot;
+    memset(&previous, 0, sizeof(InputSnapshot));
+    Vector2 cursor = { 640.0f, 360.0f };
+
+    // frame 0 consumes an empty snapshot and no time, like a live run
+    Replay_RecordFrame(0, &previous);
+
+    const int segments = (int)(sizeof(FlyScript) / sizeof(FlyScript[0]));
+    for (int s = 0; s < segments; ++s)
+    {
+        const FlySegment* segment = &FlyScript[s];
+        int frames = (int)(segment->seconds * rate + 0.5);
+        bool look = segment->look_x != 0.0f || segment->look_y != 0.0f;
+
+        for (int f = 0; f < frames; ++f)
+        {
+            memset(&snapshot, 0, sizeof(InputSnapshot));
+            for (int k = 0; k < 3 && segment->keys[k]; ++k)
+                SetKey(snapshot.held, segment->keys[k], true);
+
+            if (look)
+            {
+                snapshot.mouse_held = 1u << GLFW_MOUSE_BUTTON_RIGHT;
+                snapshot.cursor_delta = (Vector2){ segment->look_x, segment->look_y };
+                cursor.x += segment->look_x;
+                cursor.y += segment->look_y;
+            }
+            snapshot.cursor = cursor;
+
+            // edges against the previous frame
+            for (int w = 0; w < INPUT_KEY_WORDS; ++w)
+            {
+                snapshot.pressed[w] = snapshot.held[w] & ~previous.held[w];
+                snapshot.released[w] = previous.held[w] & ~snapshot.held[w];
+            }
+            snapshot.mouse_pressed = (uint8_t)(snapshot.mouse_held & ~previous.mouse_held);
+            snapshot.mouse_released = (uint8_t)(previous.mouse_held & ~snapshot.mouse_held);
+
+            Replay_RecordFrame(delta_ns, &snapshot);
+            previous = snapshot;
+        }
+    }
+
+    Replay_Stop();
+    return 0;
+}
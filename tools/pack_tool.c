@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "pack_utility.h"
+#include "darray_utility.h"
+
+// Builds an asset archive from files and directories (walked recursively).
+// Entries are stored under the relative paths as given, so run it from the project root:
+//
+// usage: pack_tool [-n] output.pak path...
+//   -n  store every entry uncompressed
+
+static void CollectFiles(const char* path, DArray* files)
+{
+    struct stat st;
+    if (stat(path, &st) != 0)
+    {
+        printf("Failed to stat: %s\n", path);
+        return;
+    }
+
+    if (S_ISREG(st.st_mode))
+    {
+        char* copy = strdup(path);
+        DArray_Push_T(char*, files, copy);
+        return;
+    }
+
+    if (!S_ISDIR(st.st_mode))
+        return;
+
+    DIR* dir = opendir(path);
+    if (!dir)
+    {
+        printf("Failed to open directory: %s\n", path);
+        return;
+    }
+
+    struct dirent* ent;
+    while ((ent = readdir(dir)) != NULL)
+    {
+        if (ent->d_name[0] == '.')
+            continue;
+
+        char child[1024];
+        snprintf(child, sizeof(child), "%s/%s", path, ent->d_name);
+        CollectFiles(child, files);
+    }
+
+    closedir(dir);
+}
+
+int main(int argc, char** argv)
+{
+    int arg = 1;
+    bool compress = true;
+
+    if (arg < argc && strcmp(argv[arg], "-n") == 0)
+    {
+        compress = false;
+        ++arg;
+    }
+
+    if (argc - arg < 2)
+    {
+        printf("usage: %s [-n] output.pak path...\n", argv[0]);
+        return -1;
+    }
+
+    const char* output = argv[arg++];
+
+    DArray files = DArray_Create_T(char*, 64, NULL);
+    for (; arg < argc; ++arg)
+        CollectFiles(argv[arg], &files);
+
+    int count = (int)DArray_Size(&files);
+    char** paths = (char**)files.data;
+
+    if (!Pack_Build(output, (const char* const*)paths, count, compress))
+    {
+        printf("Failed to build pack: %s\n", output);
+        return -1;
+    }
+
+    // report what went in
+    Pack pack;
+    if (Pack_Open(&pack, output))
+    {
+        uint64_t raw = 0, stored = 0;
+        for (uint32_t i = 0; i < pack.header->entry_count; ++i)
+        {
+            raw += pack.entries[i].raw_size;
+            stored += pack.entries[i].stored_size;
+        }
+
+        printf("%s: %d files, %.2f MB -> %.2f MB payload, %.2f MB archive\n", output, count,
+               raw / 1048576.0, stored / 1048576.0, pack.size / 1048576.0);
+        Pack_Close(&pack);
+    }
+
+    for (int i = 0; i < count; ++i)
+        free(paths[i]);
+    DArray_Free(&files);
+
+    return 0;
+}